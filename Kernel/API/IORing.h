@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+// An I/O ring is shared between a process and the kernel by mapping the ring's file descriptor.
+// The mapping starts with an IORingHeader, followed by the submission queue at submission_offset
+// and the completion queue at completion_offset. Both queues are single-producer, single-consumer
+// rings whose indices only ever increase, and are masked to get to the entry.
+//
+// Userspace fills in submissions, advances submission_tail, and calls io_ring_enter() to hand them
+// over to the kernel, which advances submission_head as it takes them. Completions are posted to
+// the completion queue by io_ring_enter(), and userspace advances completion_head once it is done
+// with them.
+
+enum class IORingOpcode : u8 {
+    Read,    // fd, address = buffer, length, offset (-1 for the current file offset)
+    Write,   // fd, address = buffer, length, offset (-1 for the current file offset)
+    Readv,   // fd, address = iovec array, length = iovec count, offset (-1 for the current file offset)
+    Pwritev, // fd, address = iovec array, length = iovec count, offset (-1 for the current file offset)
+    Accept4, // fd, address = sockaddr (may be null), address2 = socklen_t, flags = SOCK_* flags
+    Recvmsg, // fd, address = msghdr, flags = MSG_* flags
+    Sendmsg, // fd, address = msghdr, flags = MSG_* flags
+    Fsync,   // fd
+};
+
+struct IORingSubmission {
+    IORingOpcode opcode;
+    u8 reserved[3];
+    i32 fd;
+    i64 offset;
+    u64 address;
+    u64 address2;
+    u64 length;
+    u32 flags;
+    u32 reserved2;
+    // Passed back as is in the completion.
+    u64 user_data;
+};
+
+struct IORingCompletion {
+    u64 user_data;
+    // What the equivalent syscall would have returned, or a negated errno.
+    i64 result;
+};
+
+struct IORingHeader {
+    u32 submission_head;
+    u32 submission_tail;
+    u32 submission_mask;
+    u32 submission_offset;
+    u32 completion_head;
+    u32 completion_tail;
+    u32 completion_mask;
+    u32 completion_offset;
+};
+
+#define IO_RING_MAX_ENTRIES 4096
+#define IO_RING_CLOEXEC 1
+
+// The completion queue is twice as large as the submission queue,
+// so that there's room for the completions of one queue's worth of requests while the next is submitted.
+constexpr u32 io_ring_completion_entries(u32 submission_entries)
+{
+    return submission_entries * 2;
+}
+
+constexpr u32 io_ring_submission_offset()
+{
+    return (sizeof(IORingHeader) + 63) & ~63u;
+}
+
+constexpr u32 io_ring_completion_offset(u32 submission_entries)
+{
+    return io_ring_submission_offset() + submission_entries * sizeof(IORingSubmission);
+}
+
+constexpr u32 io_ring_size(u32 submission_entries)
+{
+    return io_ring_completion_offset(submission_entries) + io_ring_completion_entries(submission_entries) * sizeof(IORingCompletion);
+}
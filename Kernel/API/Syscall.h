@@ -14,6 +14,7 @@ constexpr int syscall_vector = 0x82;
 
 extern "C" {
 struct pollfd;
+struct epoll_event;
 struct timeval;
 struct timespec;
 struct sockaddr;
@@ -65,6 +66,9 @@ enum class NeedsBigProcessLock {
     S(dump_backtrace, NeedsBigProcessLock::No)              \
     S(dup2, NeedsBigProcessLock::No)                        \
     S(emuctl, NeedsBigProcessLock::No)                      \
+    S(epoll_create, NeedsBigProcessLock::Yes)               \
+    S(epoll_ctl, NeedsBigProcessLock::Yes)                  \
+    S(epoll_wait, NeedsBigProcessLock::No)                  \
     S(execve, NeedsBigProcessLock::Yes)                     \
     S(exit, NeedsBigProcessLock::Yes)                       \
     S(exit_thread, NeedsBigProcessLock::Yes)                \
@@ -106,6 +110,8 @@ enum class NeedsBigProcessLock {
     S(getuid, NeedsBigProcessLock::No)                      \
     S(inode_watcher_add_watch, NeedsBigProcessLock::Yes)    \
     S(inode_watcher_remove_watch, NeedsBigProcessLock::Yes) \
+    S(io_ring_create, NeedsBigProcessLock::Yes)             \
+    S(io_ring_enter, NeedsBigProcessLock::No)               \
     S(ioctl, NeedsBigProcessLock::Yes)                      \
     S(join_thread, NeedsBigProcessLock::Yes)                \
     S(jail_create, NeedsBigProcessLock::No)                 \
@@ -151,6 +157,7 @@ enum class NeedsBigProcessLock {
     S(scheduler_get_parameters, NeedsBigProcessLock::No)    \
     S(scheduler_set_parameters, NeedsBigProcessLock::No)    \
     S(sendfd, NeedsBigProcessLock::No)                      \
+    S(sendfile, NeedsBigProcessLock::Yes)                   \
     S(sendmsg, NeedsBigProcessLock::Yes)                    \
     S(set_coredump_metadata, NeedsBigProcessLock::No)       \
     S(set_mmap_name, NeedsBigProcessLock::Yes)              \
@@ -257,6 +264,21 @@ struct SC_poll_params {
     u32 const* sigmask;
 };
 
+struct SC_epoll_ctl_params {
+    int epoll_fd;
+    int op;
+    int fd;
+    struct epoll_event const* event;
+};
+
+struct SC_epoll_wait_params {
+    int epoll_fd;
+    struct epoll_event* events;
+    int max_events;
+    const struct timespec* timeout;
+    u32 const* sigmask;
+};
+
 struct SC_clock_nanosleep_params {
     int clock_id;
     int flags;
@@ -292,6 +314,13 @@ struct SC_setsockopt_params {
     socklen_t value_size;
 };
 
+struct SC_sendfile_params {
+    int out_fd;
+    int in_fd;
+    off_t* offset;
+    size_t count;
+};
+
 struct SC_getsockname_params {
     int sockfd;
     sockaddr* addr;
@@ -18,12 +18,28 @@ namespace Kernel {
 
 inline bool time_page_supports(clockid_t clock_id)
 {
-    return clock_id == CLOCK_REALTIME_COARSE || clock_id == CLOCK_MONOTONIC_COARSE;
+    return clock_id >= 0 && clock_id < CLOCK_ID_COUNT;
+}
+
+// The precise clocks are only as precise as the coarse ones in the time page, unless
+// they can be interpolated with the time stamp counter (see TimePage::tsc_multiplier).
+inline bool time_page_clock_needs_interpolation(clockid_t clock_id)
+{
+    return clock_id == CLOCK_REALTIME || clock_id == CLOCK_MONOTONIC || clock_id == CLOCK_MONOTONIC_RAW;
 }
 
 struct TimePage {
     volatile u32 update1;
+    // For the precise clocks, this is the time at which the time stamp counter read tsc_base.
     struct timespec clocks[CLOCK_ID_COUNT];
+    // The nanoseconds that passed since the last update are ((tsc - tsc_base) * tsc_multiplier) >> tsc_shift,
+    // where (tsc - tsc_base) is clamped to tsc_max_delta, so that the clocks never run past the next update.
+    // A multiplier of 0 means that the time stamp counter can't be used (yet), and the precise clocks have to
+    // be queried from the kernel.
+    u64 tsc_base;
+    u64 tsc_multiplier;
+    u64 tsc_max_delta;
+    u32 tsc_shift;
     volatile u32 update2;
 };
 
@@ -7,6 +7,7 @@
 
 #include <Kernel/Arch/aarch64/InterruptManagement.h>
 #include <Kernel/Arch/aarch64/RPi/InterruptController.h>
+#include <Kernel/Interrupts/MSIxIRQHandler.h>
 
 namespace Kernel {
 
@@ -59,4 +60,15 @@ void InterruptManagement::enumerate_interrupt_handlers(Function<void(GenericInte
     TODO_AARCH64();
 }
 
+ErrorOr<MessageSignalledInterrupt> InterruptManagement::allocate_message_signalled_interrupt(u32)
+{
+    return ENOTSUP;
+}
+
+void InterruptManagement::free_message_signalled_interrupt(MessageSignalledInterrupt const&)
+{
+    // Nothing is ever allocated, so there is nothing to give back.
+    VERIFY_NOT_REACHED();
+}
+
 }
@@ -6,12 +6,15 @@
 
 #pragma once
 
+#include <AK/Error.h>
 #include <AK/Vector.h>
 #include <Kernel/Arch/aarch64/IRQController.h>
 #include <Kernel/Library/LockRefPtr.h>
 
 namespace Kernel {
 
+struct MessageSignalledInterrupt;
+
 class InterruptManagement {
 public:
     static InterruptManagement& the();
@@ -25,6 +28,10 @@ public:
 
     void enumerate_interrupt_handlers(Function<void(GenericInterruptHandler&)>);
 
+    bool supports_message_signalled_interrupts() const { return false; }
+    ErrorOr<MessageSignalledInterrupt> allocate_message_signalled_interrupt(u32 target_cpu);
+    void free_message_signalled_interrupt(MessageSignalledInterrupt const&);
+
 private:
     InterruptManagement() = default;
     void find_controllers();
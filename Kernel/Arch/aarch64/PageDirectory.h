@@ -81,6 +81,9 @@ public:
     bool is_execute_disabled() const { TODO_AARCH64(); }
     void set_execute_disabled(bool) { }
 
+    bool is_accessed() const { TODO_AARCH64(); }
+    void set_accessed(bool) { }
+
 private:
     void set_bit(u64 bit, bool value)
     {
@@ -137,6 +140,9 @@ public:
     bool is_pat() const { TODO_AARCH64(); }
     void set_pat(bool) { }
 
+    bool is_accessed() const { TODO_AARCH64(); }
+    void set_accessed(bool) { }
+
     bool is_null() const { return m_raw == 0; }
     void clear() { m_raw = 0; }
 
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/Function.h>
 #include <AK/NonnullOwnPtr.h>
 #include <AK/OwnPtr.h>
@@ -15,9 +16,12 @@
 #include <Kernel/Firmware/ACPI/Definitions.h>
 #include <Kernel/Interrupts/GenericInterruptHandler.h>
 #include <Kernel/Library/LockRefPtr.h>
+#include <Kernel/Locking/Spinlock.h>
 
 namespace Kernel {
 
+struct MessageSignalledInterrupt;
+
 class ISAInterruptOverrideMetadata {
 public:
     ISAInterruptOverrideMetadata(u8 bus, u8 source, u32 global_system_interrupt, u16 flags)
@@ -42,6 +46,11 @@ private:
 
 class InterruptManagement {
 public:
+    // Message signalled interrupts get vectors 0x90-0xfb, which are above anything the
+    // I/O APICs (and the syscall gate) use and below the local APIC's own vectors.
+    static constexpr u8 first_message_signalled_interrupt_number = 0x90 - IRQ_VECTOR_BASE;
+    static constexpr u8 last_message_signalled_interrupt_number = 0xfb - IRQ_VECTOR_BASE;
+
     static InterruptManagement& the();
     static void initialize();
     static bool initialized();
@@ -59,6 +68,10 @@ public:
     u8 get_mapped_interrupt_vector(u8 original_irq);
     u8 get_irq_vector(u8 mapped_interrupt_vector);
 
+    bool supports_message_signalled_interrupts() const;
+    ErrorOr<MessageSignalledInterrupt> allocate_message_signalled_interrupt(u32 target_cpu);
+    void free_message_signalled_interrupt(MessageSignalledInterrupt const&);
+
     void enumerate_interrupt_handlers(Function<void(GenericInterruptHandler&)>);
     IRQController& get_interrupt_controller(size_t index);
 
@@ -73,6 +86,8 @@ private:
     Vector<ISAInterruptOverrideMetadata> m_isa_interrupt_overrides;
     Vector<PCIInterruptOverrideMetadata> m_pci_interrupt_overrides;
     PhysicalAddress m_madt;
+    Spinlock m_message_signalled_interrupts_lock { LockRank::None };
+    Array<bool, last_message_signalled_interrupt_number - first_message_signalled_interrupt_number + 1> m_message_signalled_interrupt_in_use {};
 };
 
 }
@@ -34,6 +34,7 @@ public:
         UserSupervisor = 1 << 2,
         WriteThrough = 1 << 3,
         CacheDisabled = 1 << 4,
+        Accessed = 1 << 5,
         Huge = 1 << 7,
         Global = 1 << 8,
         NoExecute = 0x8000000000000000ULL,
@@ -48,6 +49,9 @@ public:
     bool is_huge() const { return (raw() & Huge) == Huge; }
     void set_huge(bool b) { set_bit(Huge, b); }
 
+    bool is_accessed() const { return (raw() & Accessed) == Accessed; }
+    void set_accessed(bool b) { set_bit(Accessed, b); }
+
     bool is_writable() const { return (raw() & ReadWrite) == ReadWrite; }
     void set_writable(bool b) { set_bit(ReadWrite, b); }
 
@@ -93,6 +97,7 @@ public:
         UserSupervisor = 1 << 2,
         WriteThrough = 1 << 3,
         CacheDisabled = 1 << 4,
+        Accessed = 1 << 5,
         PAT = 1 << 7,
         Global = 1 << 8,
         NoExecute = 0x8000000000000000ULL,
@@ -122,6 +127,9 @@ public:
     bool is_pat() const { return (raw() & PAT) == PAT; }
     void set_pat(bool b) { set_bit(PAT, b); }
 
+    bool is_accessed() const { return (raw() & Accessed) == Accessed; }
+    void set_accessed(bool b) { set_bit(Accessed, b); }
+
     bool is_null() const { return m_raw == 0; }
     void clear() { m_raw = 0; }
 
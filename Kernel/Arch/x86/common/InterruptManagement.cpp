@@ -14,6 +14,7 @@
 #include <Kernel/CommandLine.h>
 #include <Kernel/Firmware/MultiProcessor/Parser.h>
 #include <Kernel/InterruptDisabler.h>
+#include <Kernel/Interrupts/MSIxIRQHandler.h>
 #include <Kernel/Interrupts/SharedIRQHandler.h>
 #include <Kernel/Interrupts/SpuriousInterruptHandler.h>
 #include <Kernel/Memory/TypedMapping.h>
@@ -96,6 +97,38 @@ u8 InterruptManagement::get_irq_vector(u8 mapped_interrupt_vector)
     return mapped_interrupt_vector;
 }
 
+bool InterruptManagement::supports_message_signalled_interrupts() const
+{
+    // NOTE: Messages are delivered to the local APICs, which aren't set up in PIC mode.
+    return APIC::initialized();
+}
+
+ErrorOr<MessageSignalledInterrupt> InterruptManagement::allocate_message_signalled_interrupt(u32 target_cpu)
+{
+    if (!supports_message_signalled_interrupts())
+        return ENOTSUP;
+    auto message_address = TRY(APIC::the().message_signalled_interrupt_address(target_cpu));
+
+    SpinlockLocker locker(m_message_signalled_interrupts_lock);
+    for (u8 interrupt_number = first_message_signalled_interrupt_number; interrupt_number <= last_message_signalled_interrupt_number; ++interrupt_number) {
+        auto& in_use = m_message_signalled_interrupt_in_use[interrupt_number - first_message_signalled_interrupt_number];
+        if (in_use || get_interrupt_handler(interrupt_number).type() != HandlerType::UnhandledInterruptHandler)
+            continue;
+        in_use = true;
+        return MessageSignalledInterrupt { interrupt_number, message_address, static_cast<u32>(IRQ_VECTOR_BASE + interrupt_number) };
+    }
+    return ENOSPC;
+}
+
+void InterruptManagement::free_message_signalled_interrupt(MessageSignalledInterrupt const& interrupt)
+{
+    VERIFY(interrupt.interrupt_number >= first_message_signalled_interrupt_number && interrupt.interrupt_number <= last_message_signalled_interrupt_number);
+    SpinlockLocker locker(m_message_signalled_interrupts_lock);
+    auto& in_use = m_message_signalled_interrupt_in_use[interrupt.interrupt_number - first_message_signalled_interrupt_number];
+    VERIFY(in_use);
+    in_use = false;
+}
+
 NonnullLockRefPtr<IRQController> InterruptManagement::get_responsible_irq_controller(IRQControllerType controller_type, u8 interrupt_vector)
 {
     for (auto& irq_controller : m_interrupt_controllers) {
@@ -472,8 +472,10 @@ UNMAP_AFTER_INIT void APIC::enable(u32 cpu)
     } else {
         dbgln_if(APIC_DEBUG, "Setting logical xAPIC ID for CPU #{}", cpu);
 
+        VERIFY(cpu < m_xapic_physical_ids.size());
+        m_xapic_physical_ids[cpu] = read_register(APIC_REG_ID) >> 24;
+
         // Use the CPU# as logical apic id
-        VERIFY(cpu <= 8);
         write_register(APIC_REG_LD, (read_register(APIC_REG_LD) & 0x00ffffff) | (cpu << 24));
 
         // read it back to make sure it's actually set
@@ -565,6 +567,17 @@ void APIC::send_ipi(u32 cpu)
     write_icr({ IRQ_APIC_IPI + IRQ_VECTOR_BASE, m_is_x2 ? Processor::by_id(cpu).info().apic_id() : cpu, ICRReg::Fixed, m_is_x2 ? ICRReg::Physical : ICRReg::Logical, ICRReg::Assert, ICRReg::TriggerMode::Edge, ICRReg::NoShorthand });
 }
 
+ErrorOr<u64> APIC::message_signalled_interrupt_address(u32 cpu) const
+{
+    VERIFY(cpu < Processor::count());
+    u32 apic_id = m_is_x2 ? Processor::by_id(cpu).info().apic_id() : m_xapic_physical_ids[cpu];
+    // Without interrupt remapping, a message can only name one of the first 256 APIC IDs.
+    if (apic_id > 0xff)
+        return ENOTSUP;
+    // Fixed delivery to a single processor in physical destination mode.
+    return 0xfee00000 | (apic_id << 12);
+}
+
 UNMAP_AFTER_INIT APICTimer* APIC::initialize_timers(HardwareTimerBase& calibration_timer)
 {
     if (!m_apic_base && !m_is_x2)
@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <AK/Array.h>
+#include <AK/Error.h>
 #include <AK/Types.h>
 #include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Time/HardwareTimer.h>
@@ -32,6 +34,7 @@ public:
     void init_finished(u32 cpu);
     void broadcast_ipi();
     void send_ipi(u32 cpu);
+    ErrorOr<u64> message_signalled_interrupt_address(u32 cpu) const;
     static u8 spurious_interrupt_vector();
     Thread* get_idle_thread(u32 cpu) const;
     u32 enabled_processor_count() const { return m_processor_enabled_cnt; }
@@ -98,6 +101,8 @@ private:
     Atomic<u8> m_apic_ap_continue { 0 };
     u32 m_processor_cnt { 0 };
     u32 m_processor_enabled_cnt { 0 };
+    // NOTE: In xAPIC mode, the processors' APIC IDs in ProcessorInfo are the logical ones.
+    Array<u8, 8> m_xapic_physical_ids {};
     APICTimer* m_apic_timer { nullptr };
     bool m_is_x2 { false };
 
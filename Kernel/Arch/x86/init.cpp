@@ -56,6 +56,7 @@
 #include <Kernel/TTY/PTYMultiplexer.h>
 #include <Kernel/TTY/VirtualConsole.h>
 #include <Kernel/Tasks/FinalizerTask.h>
+#include <Kernel/Tasks/PageCompressionTask.h>
 #include <Kernel/Tasks/SyncTask.h>
 #include <Kernel/Time/TimeManagement.h>
 #include <Kernel/WorkQueue.h>
@@ -308,6 +309,7 @@ void init_stage2(void*)
         // core may send too many and end up deadlocking once the pool is
         // exhausted
         APIC::the().boot_aps();
+        TimeManagement::the().check_time_stamp_counter_synchronization();
     }
 
     // Initialize the PCI Bus as early as possible, for early boot (PCI based) serial logging
@@ -332,6 +334,7 @@ void init_stage2(void*)
 
     SyncTask::spawn();
     FinalizerTask::spawn();
+    PageCompressionTask::spawn();
 
     auto boot_profiling = kernel_command_line().is_boot_profiling_enabled();
 
@@ -124,6 +124,27 @@ enum ID {
 };
 }
 
+namespace MSIx {
+
+// Layout of the MSI-X capability and of the table it points to.
+static constexpr u8 message_control_offset = 0x2;
+static constexpr u8 table_offset_offset = 0x4;
+static constexpr u16 message_control_table_size_mask = 0x7ff;
+static constexpr u16 message_control_function_mask = 1 << 14;
+static constexpr u16 message_control_enable = 1 << 15;
+static constexpr u32 table_bir_mask = 0x7;
+static constexpr u32 vector_control_masked = 1 << 0;
+
+struct [[gnu::packed]] TableEntry {
+    u32 message_address_low;
+    u32 message_address_high;
+    u32 message_data;
+    u32 vector_control;
+};
+static_assert(sizeof(TableEntry) == 16);
+
+}
+
 struct HardwareID {
     u16 vendor_id { 0 };
     u16 device_id { 0 };
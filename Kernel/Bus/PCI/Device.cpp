@@ -7,6 +7,7 @@
 #include <AK/AnyOf.h>
 #include <Kernel/Bus/PCI/API.h>
 #include <Kernel/Bus/PCI/Device.h>
+#include <Kernel/Memory/TypedMapping.h>
 
 namespace Kernel::PCI {
 
@@ -47,11 +48,84 @@ void Device::disable_message_signalled_interrupts()
 }
 void Device::enable_extended_message_signalled_interrupts()
 {
-    TODO();
+    auto capability = msix_capability();
+    VERIFY(capability.has_value());
+    // NOTE: Once MSI-X is enabled, the device stops using its interrupt pin.
+    disable_pin_based_interrupts();
+    auto message_control = capability->read16(MSIx::message_control_offset);
+    message_control |= MSIx::message_control_enable;
+    message_control &= ~MSIx::message_control_function_mask;
+    capability->write16(MSIx::message_control_offset, message_control);
 }
 void Device::disable_extended_message_signalled_interrupts()
 {
-    TODO();
+    auto capability = msix_capability();
+    VERIFY(capability.has_value());
+    auto message_control = capability->read16(MSIx::message_control_offset);
+    capability->write16(MSIx::message_control_offset, message_control & ~MSIx::message_control_enable);
+    enable_pin_based_interrupts();
+}
+
+Optional<Capability> Device::msix_capability() const
+{
+    for (auto const& capability : PCI::get_device_identifier(pci_address()).capabilities()) {
+        if (capability.id().value() == PCI::Capabilities::ID::MSIX)
+            return capability;
+    }
+    return {};
+}
+
+size_t Device::msix_table_size() const
+{
+    auto capability = msix_capability();
+    if (!capability.has_value())
+        return 0;
+    // The table size is encoded as N-1.
+    return (capability->read16(MSIx::message_control_offset) & MSIx::message_control_table_size_mask) + 1;
+}
+
+ErrorOr<PhysicalAddress> Device::msix_table_entry_address(size_t index) const
+{
+    auto capability = msix_capability();
+    if (!capability.has_value())
+        return ENOTSUP;
+    if (index >= msix_table_size())
+        return EINVAL;
+
+    auto table_offset = capability->read32(MSIx::table_offset_offset);
+    auto bar = static_cast<HeaderType0BaseRegister>(table_offset & MSIx::table_bir_mask);
+    auto bar_value = PCI::get_BAR(pci_address(), bar);
+    auto bar_space_type = PCI::get_BAR_space_type(bar_value);
+    if (bar_space_type == BARSpaceType::IOSpace)
+        return ENOTSUP;
+
+    PhysicalPtr bar_address = bar_value & 0xfffffff0;
+    if (bar_space_type == BARSpaceType::Memory64BitSpace)
+        bar_address |= static_cast<PhysicalPtr>(PCI::get_BAR(pci_address(), static_cast<HeaderType0BaseRegister>(to_underlying(bar) + 1))) << 32;
+    return PhysicalAddress(bar_address + (table_offset & ~MSIx::table_bir_mask) + index * sizeof(MSIx::TableEntry));
+}
+
+ErrorOr<void> Device::set_msix_table_entry(size_t index, u64 message_address, u32 message_data, bool masked)
+{
+    auto entry = TRY(Memory::map_typed_writable<MSIx::TableEntry volatile>(TRY(msix_table_entry_address(index))));
+    // NOTE: Mask the entry while it's being rewritten, so the device never sees half of it.
+    entry->vector_control = entry->vector_control | MSIx::vector_control_masked;
+    entry->message_address_low = message_address & 0xffffffff;
+    entry->message_address_high = message_address >> 32;
+    entry->message_data = message_data;
+    if (!masked)
+        entry->vector_control = entry->vector_control & ~MSIx::vector_control_masked;
+    return {};
+}
+
+ErrorOr<void> Device::set_msix_table_entry_masked(size_t index, bool masked)
+{
+    auto entry = TRY(Memory::map_typed_writable<MSIx::TableEntry volatile>(TRY(msix_table_entry_address(index))));
+    if (masked)
+        entry->vector_control = entry->vector_control | MSIx::vector_control_masked;
+    else
+        entry->vector_control = entry->vector_control & ~MSIx::vector_control_masked;
+    return {};
 }
 
 }
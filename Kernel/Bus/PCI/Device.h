@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <AK/Error.h>
+#include <AK/Optional.h>
 #include <AK/Types.h>
 #include <Kernel/Bus/PCI/Definitions.h>
 
@@ -28,10 +30,17 @@ public:
     void enable_extended_message_signalled_interrupts();
     void disable_extended_message_signalled_interrupts();
 
+    size_t msix_table_size() const;
+    ErrorOr<void> set_msix_table_entry(size_t index, u64 message_address, u32 message_data, bool masked);
+    ErrorOr<void> set_msix_table_entry_masked(size_t index, bool masked);
+
 protected:
     explicit Device(Address pci_address);
 
 private:
+    Optional<Capability> msix_capability() const;
+    ErrorOr<PhysicalAddress> msix_table_entry_address(size_t index) const;
+
     Address m_pci_address;
 };
 
@@ -248,7 +248,8 @@ ErrorOr<void> Coredump::write_regions()
             for (size_t i = 0; i < region.page_count(); i++) {
                 auto page = real_region->physical_page(i);
                 auto src_buffer = [&]() -> ErrorOr<UserOrKernelBuffer> {
-                    if (page)
+                    // NOTE: Anonymous pages without a physical page are compressed, and reading them brings them back.
+                    if (page || real_region->vmobject().is_anonymous())
                         return UserOrKernelBuffer::for_user_buffer(reinterpret_cast<uint8_t*>((region.vaddr().as_ptr() + (i * PAGE_SIZE))), PAGE_SIZE);
                     // If the current page is not backed by a physical page, we zero it in the coredump file.
                     return UserOrKernelBuffer::for_kernel_buffer(zero_buffer);
@@ -5,9 +5,13 @@
  */
 
 #include <AK/IntrusiveList.h>
+#include <AK/QuickSort.h>
+#include <AK/ScopeGuard.h>
 #include <Kernel/Debug.h>
 #include <Kernel/FileSystem/BlockBasedFileSystem.h>
+#include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Process.h>
+#include <Kernel/WorkQueue.h>
 
 namespace Kernel {
 
@@ -16,43 +20,64 @@ struct CacheEntry {
     BlockBasedFileSystem::BlockIndex block_index { 0 };
     u8* data { nullptr };
     bool has_data { false };
+    bool is_dirty { false };
 };
 
+// Consecutive blocks are read and written together, up to this many at a time.
+static constexpr size_t maximum_merged_blocks = 64;
+
+// The cache is made up of chunks of entries, so it can grow while there is plenty
+// of free memory and give chunks back when the system is running low on memory.
 class DiskCache {
 public:
-    static constexpr size_t EntryCount = 10000;
-    explicit DiskCache(BlockBasedFileSystem& fs, NonnullOwnPtr<KBuffer> cached_block_data, NonnullOwnPtr<KBuffer> entries_buffer)
-        : m_fs(fs)
-        , m_cached_block_data(move(cached_block_data))
-        , m_entries(move(entries_buffer))
+    static constexpr size_t EntriesPerChunk = 1024;
+    // How many cache misses we take before checking whether the cache should be resized.
+    static constexpr size_t ResizeCheckInterval = 64;
+
+    static ErrorOr<NonnullOwnPtr<DiskCache>> try_create(BlockBasedFileSystem& fs)
     {
-        for (size_t i = 0; i < EntryCount; ++i) {
-            entries()[i].data = m_cached_block_data->data() + i * m_fs->block_size();
-            m_clean_list.append(entries()[i]);
-        }
+        auto merge_buffer = TRY(KBuffer::try_create_with_size("BlockBasedFS: Merged write"sv, maximum_merged_blocks * fs.block_size()));
+        auto cache = TRY(adopt_nonnull_own_or_enomem(new (nothrow) DiskCache(fs, move(merge_buffer))));
+        TRY(cache->try_grow());
+        return cache;
     }
 
     ~DiskCache() = default;
 
     bool is_dirty() const { return !m_dirty_list.is_empty(); }
-    bool entry_is_dirty(CacheEntry const& entry) const { return m_dirty_list.contains(entry); }
+    bool entry_is_dirty(CacheEntry const& entry) const { return entry.is_dirty; }
+
+    size_t capacity() const { return m_chunks.size() * EntriesPerChunk; }
+
+    // Runs of dirty blocks are gathered here on their way to the device.
+    u8* merge_buffer() { return m_merge_buffer->data(); }
 
     void mark_all_clean()
     {
-        while (auto* entry = m_dirty_list.first())
+        while (auto* entry = m_dirty_list.first()) {
+            entry->is_dirty = false;
             m_clean_list.prepend(*entry);
+        }
     }
 
     void mark_dirty(CacheEntry& entry)
     {
+        entry.is_dirty = true;
         m_dirty_list.prepend(entry);
     }
 
     void mark_clean(CacheEntry& entry)
     {
+        entry.is_dirty = false;
         m_clean_list.prepend(entry);
     }
 
+    void mark_for_eviction(CacheEntry& entry)
+    {
+        if (!entry.is_dirty)
+            m_clean_list.append(entry);
+    }
+
     CacheEntry* get(BlockBasedFileSystem::BlockIndex block_index) const
     {
         auto it = m_hash.find(block_index);
@@ -68,6 +93,11 @@ public:
         if (auto* entry = get(block_index))
             return entry;
 
+        if (++m_misses_since_resize_check >= ResizeCheckInterval) {
+            m_misses_since_resize_check = 0;
+            resize_for_available_memory();
+        }
+
         if (m_clean_list.is_empty()) {
             // Not a single clean entry! Flush writes and try again.
             // NOTE: We want to make sure we only call FileBackedFileSystem flush here,
@@ -80,7 +110,7 @@ public:
         auto& new_entry = *m_clean_list.last();
         m_clean_list.prepend(new_entry);
 
-        m_hash.remove(new_entry.block_index);
+        forget_entry(new_entry);
         TRY(m_hash.try_set(block_index, &new_entry));
 
         new_entry.block_index = block_index;
@@ -89,9 +119,6 @@ public:
         return &new_entry;
     }
 
-    CacheEntry const* entries() const { return (CacheEntry const*)m_entries->data(); }
-    CacheEntry* entries() { return (CacheEntry*)m_entries->data(); }
-
     template<typename Callback>
     void for_each_dirty_entry(Callback callback)
     {
@@ -100,12 +127,97 @@ public:
     }
 
 private:
+    struct Chunk {
+        NonnullOwnPtr<KBuffer> block_data;
+        NonnullOwnPtr<KBuffer> entries_data;
+
+        CacheEntry* entries() { return (CacheEntry*)entries_data->data(); }
+    };
+
+    DiskCache(BlockBasedFileSystem& fs, NonnullOwnPtr<KBuffer> merge_buffer)
+        : m_fs(fs)
+        , m_merge_buffer(move(merge_buffer))
+    {
+    }
+
+    void forget_entry(CacheEntry& entry) const
+    {
+        // NOTE: Entries that were never used still have block index 0, which may well be cached in some other entry.
+        if (auto it = m_hash.find(entry.block_index); it != m_hash.end() && it->value == &entry)
+            m_hash.remove(it);
+    }
+
+    ErrorOr<void> try_grow() const
+    {
+        auto block_data = TRY(KBuffer::try_create_with_size("BlockBasedFS: Cache blocks"sv, EntriesPerChunk * m_fs->block_size()));
+        auto entries_data = TRY(KBuffer::try_create_with_size("BlockBasedFS: Cache entries"sv, EntriesPerChunk * sizeof(CacheEntry)));
+        auto chunk = TRY(adopt_nonnull_own_or_enomem(new (nothrow) Chunk { move(block_data), move(entries_data) }));
+        TRY(m_hash.try_ensure_capacity(capacity() + EntriesPerChunk));
+        TRY(m_chunks.try_append(move(chunk)));
+
+        auto& new_chunk = *m_chunks.last();
+        for (size_t i = 0; i < EntriesPerChunk; ++i) {
+            auto& entry = new_chunk.entries()[i];
+            entry.data = new_chunk.block_data->data() + i * m_fs->block_size();
+            // Fresh entries go to the eviction end of the list, so they get used before anything with data in it.
+            m_clean_list.append(entry);
+        }
+        return {};
+    }
+
+    void shrink() const
+    {
+        VERIFY(m_chunks.size() > 1);
+        auto& chunk = *m_chunks.last();
+
+        // Dirty entries have to make it to disk before we can let go of them.
+        for (size_t i = 0; i < EntriesPerChunk; ++i) {
+            if (chunk.entries()[i].is_dirty) {
+                m_fs->flush_writes_impl();
+                break;
+            }
+        }
+
+        for (size_t i = 0; i < EntriesPerChunk; ++i) {
+            auto& entry = chunk.entries()[i];
+            VERIFY(!entry.is_dirty);
+            m_clean_list.remove(entry);
+            forget_entry(entry);
+        }
+        m_chunks.remove(m_chunks.size() - 1);
+    }
+
+    void resize_for_available_memory() const
+    {
+        auto memory_info = MM.get_system_memory_info();
+        auto free_pages = memory_info.physical_pages_uncommitted;
+
+        if (free_pages < memory_info.physical_pages / 16) {
+            if (m_chunks.size() > 1) {
+                dbgln_if(BBFS_DEBUG, "DiskCache: Low on memory, shrinking to {} entries", capacity() - EntriesPerChunk);
+                shrink();
+            }
+            return;
+        }
+
+        // Only grow once every entry is holding a block, and never past an eighth of physical memory.
+        if (m_hash.size() < capacity() || free_pages < memory_info.physical_pages / 4)
+            return;
+        auto maximum_cache_size = memory_info.physical_pages * PAGE_SIZE / 8;
+        if ((capacity() + EntriesPerChunk) * m_fs->block_size() > maximum_cache_size)
+            return;
+        if (try_grow().is_error())
+            return;
+        dbgln_if(BBFS_DEBUG, "DiskCache: Grew to {} entries", capacity());
+    }
+
     mutable NonnullRefPtr<BlockBasedFileSystem> m_fs;
     mutable IntrusiveList<&CacheEntry::list_node> m_dirty_list;
     mutable IntrusiveList<&CacheEntry::list_node> m_clean_list;
     mutable HashMap<BlockBasedFileSystem::BlockIndex, CacheEntry*> m_hash;
-    NonnullOwnPtr<KBuffer> m_cached_block_data;
-    NonnullOwnPtr<KBuffer> m_entries;
+    mutable Vector<NonnullOwnPtr<Chunk>> m_chunks;
+    NonnullOwnPtr<KBuffer> m_merge_buffer;
+    mutable size_t m_misses_since_resize_check { 0 };
 };
 
 BlockBasedFileSystem::BlockBasedFileSystem(OpenFileDescription& file_description)
@@ -129,9 +241,7 @@ ErrorOr<void> BlockBasedFileSystem::initialize_while_locked()
     VERIFY(m_lock.is_locked());
     VERIFY(!is_initialized_while_locked());
     VERIFY(block_size() != 0);
-    auto cached_block_data = TRY(KBuffer::try_create_with_size("BlockBasedFS: Cache blocks"sv, DiskCache::EntryCount * block_size()));
-    auto entries_data = TRY(KBuffer::try_create_with_size("BlockBasedFS: Cache entries"sv, DiskCache::EntryCount * sizeof(CacheEntry)));
-    auto disk_cache = TRY(adopt_nonnull_own_or_enomem(new (nothrow) DiskCache(*this, move(cached_block_data), move(entries_data))));
+    auto disk_cache = TRY(DiskCache::try_create(*this));
 
     m_cache.with_exclusive([&](auto& cache) {
         cache = move(disk_cache);
@@ -155,6 +265,7 @@ ErrorOr<void> BlockBasedFileSystem::write_block(BlockIndex index, UserOrKernelBu
     return m_cache.with_exclusive([&](auto& cache) -> ErrorOr<void> {
         if (!allow_cache) {
             flush_specific_block_if_needed(index);
+            ++m_uncached_write_generation;
             u64 base_offset = index.value() * block_size() + offset;
             auto nwritten = TRY(file_description().write(base_offset, data, count));
             VERIFY(nwritten == count);
@@ -184,6 +295,7 @@ ErrorOr<void> BlockBasedFileSystem::raw_read(BlockIndex index, UserOrKernelBuffe
 
 ErrorOr<void> BlockBasedFileSystem::raw_write(BlockIndex index, UserOrKernelBuffer const& buffer)
 {
+    ++m_uncached_write_generation;
     auto base_offset = index.value() * m_logical_block_size;
     auto nwritten = TRY(file_description().write(base_offset, buffer, m_logical_block_size));
     VERIFY(nwritten == m_logical_block_size);
@@ -192,20 +304,35 @@ ErrorOr<void> BlockBasedFileSystem::raw_write(BlockIndex index, UserOrKernelBuff
 
 ErrorOr<void> BlockBasedFileSystem::raw_read_blocks(BlockIndex index, size_t count, UserOrKernelBuffer& buffer)
 {
-    auto current = buffer;
-    for (auto block = index.value(); block < (index.value() + count); block++) {
-        TRY(raw_read(BlockIndex { block }, current));
-        current = current.offset(logical_block_size());
+    return read_from_device(index.value() * m_logical_block_size, buffer, count * m_logical_block_size);
+}
+
+ErrorOr<void> BlockBasedFileSystem::raw_write_blocks(BlockIndex index, size_t count, UserOrKernelBuffer const& buffer)
+{
+    ++m_uncached_write_generation;
+    return write_to_device(index.value() * m_logical_block_size, buffer, count * m_logical_block_size);
+}
+
+ErrorOr<void> BlockBasedFileSystem::read_from_device(u64 offset, UserOrKernelBuffer& buffer, size_t size) const
+{
+    // NOTE: The device may cut large transfers short, so we keep going until we have everything.
+    for (size_t nread = 0; nread < size;) {
+        auto remaining_buffer = buffer.offset(nread);
+        auto result = TRY(file_description().read(remaining_buffer, offset + nread, size - nread));
+        if (result == 0)
+            return EIO;
+        nread += result;
     }
     return {};
 }
 
-ErrorOr<void> BlockBasedFileSystem::raw_write_blocks(BlockIndex index, size_t count, UserOrKernelBuffer const& buffer)
+ErrorOr<void> BlockBasedFileSystem::write_to_device(u64 offset, UserOrKernelBuffer const& buffer, size_t size) const
 {
-    auto current = buffer;
-    for (auto block = index.value(); block < (index.value() + count); block++) {
-        TRY(raw_write(block, current));
-        current = current.offset(logical_block_size());
+    for (size_t nwritten = 0; nwritten < size;) {
+        auto result = TRY(file_description().write(offset + nwritten, buffer.offset(nwritten), size - nwritten));
+        if (result == 0)
+            return EIO;
+        nwritten += result;
     }
     return {};
 }
@@ -249,6 +376,28 @@ ErrorOr<void> BlockBasedFileSystem::read_block(BlockIndex index, UserOrKernelBuf
     });
 }
 
+ErrorOr<void> BlockBasedFileSystem::read_block_for_page_cache(BlockIndex index, UserOrKernelBuffer& buffer, size_t count, u64 offset) const
+{
+    VERIFY(offset + count <= block_size());
+    return m_cache.with_exclusive([&](auto& cache) -> ErrorOr<void> {
+        if (auto* entry = cache->get(index); entry && entry->has_data) {
+            TRY(buffer.write(entry->data + offset, count));
+            cache->mark_for_eviction(*entry);
+            return {};
+        }
+        return read_block(index, &buffer, count, offset, false);
+    });
+}
+
+ErrorOr<void> BlockBasedFileSystem::read_blocks_for_page_cache(BlockIndex index, unsigned count, UserOrKernelBuffer& buffer) const
+{
+    if (!count)
+        return EINVAL;
+    if (count == 1)
+        return read_block_for_page_cache(index, buffer, block_size(), 0);
+    return read_blocks_through_cache(index, count, buffer, true);
+}
+
 ErrorOr<void> BlockBasedFileSystem::read_blocks(BlockIndex index, unsigned count, UserOrKernelBuffer& buffer, bool allow_cache) const
 {
     VERIFY(m_logical_block_size);
@@ -256,13 +405,137 @@ ErrorOr<void> BlockBasedFileSystem::read_blocks(BlockIndex index, unsigned count
         return EINVAL;
     if (count == 1)
         return read_block(index, &buffer, block_size(), 0, allow_cache);
-    auto out = buffer;
-    for (unsigned i = 0; i < count; ++i) {
-        TRY(read_block(BlockIndex { index.value() + i }, &out, block_size(), 0, allow_cache));
-        out = out.offset(block_size());
+    if (allow_cache)
+        return read_blocks_through_cache(index, count, buffer, false);
+
+    return m_cache.with_exclusive([&](auto&) -> ErrorOr<void> {
+        for (unsigned i = 0; i < count; ++i)
+            const_cast<BlockBasedFileSystem*>(this)->flush_specific_block_if_needed(BlockIndex { index.value() + i });
+        return read_from_device(index.value() * block_size(), buffer, count * block_size());
+    });
+}
+
+ErrorOr<void> BlockBasedFileSystem::read_blocks_through_cache(BlockIndex index, unsigned count, UserOrKernelBuffer& buffer, bool for_page_cache) const
+{
+    return m_cache.with_exclusive([&](auto& cache) -> ErrorOr<void> {
+        auto cached_entry = [&](unsigned i) -> CacheEntry* {
+            auto* entry = cache->get(BlockIndex { index.value() + i });
+            return entry && entry->has_data ? entry : nullptr;
+        };
+
+        for (unsigned i = 0; i < count;) {
+            if (auto* entry = cached_entry(i)) {
+                TRY(buffer.write(entry->data, i * block_size(), block_size()));
+                if (for_page_cache)
+                    cache->mark_for_eviction(*entry);
+                ++i;
+                continue;
+            }
+
+            unsigned run_length = 1;
+            while (i + run_length < count && run_length < maximum_merged_blocks && !cached_entry(i + run_length))
+                ++run_length;
+            u64 run_offset = (index.value() + i) * block_size();
+            size_t run_size = run_length * block_size();
+
+            if (for_page_cache) {
+                // The page cache keeps its own copy, so the blocks can go straight into its buffer.
+                auto run_buffer = buffer.offset(i * block_size());
+                TRY(read_from_device(run_offset, run_buffer, run_size));
+            } else {
+                // The caller's buffer may be in userspace, so we can't cache what we read from there.
+                auto run_data = TRY(KBuffer::try_create_with_size("BlockBasedFS: Merged read"sv, run_size));
+                auto run_buffer = UserOrKernelBuffer::for_kernel_buffer(run_data->data());
+                TRY(read_from_device(run_offset, run_buffer, run_size));
+                for (unsigned j = 0; j < run_length; ++j) {
+                    auto* entry = TRY(cache->ensure(BlockIndex { index.value() + i + j }));
+                    memcpy(entry->data, run_data->data() + j * block_size(), block_size());
+                    entry->has_data = true;
+                }
+                TRY(buffer.write(run_data->data(), i * block_size(), run_size));
+            }
+            i += run_length;
+        }
+        return {};
+    });
+}
+
+void BlockBasedFileSystem::read_ahead_blocks(Span<BlockIndex const> blocks) const
+{
+    static constexpr u32 maximum_read_ahead_runs_in_flight = 4;
+    static constexpr size_t maximum_read_ahead_run_length = 64;
+
+    Vector<BlockIndex, 64> uncached_blocks;
+    m_cache.with_exclusive([&](auto& cache) {
+        if (!cache)
+            return;
+        for (auto block : blocks) {
+            if (!cache->get(block) && uncached_blocks.try_append(block).is_error())
+                return;
+        }
+    });
+
+    // Coalesce physically consecutive blocks, so each run is a single multi-block device request.
+    for (size_t i = 0; i < uncached_blocks.size();) {
+        auto first_block = uncached_blocks[i];
+        size_t count = 1;
+        while (i + count < uncached_blocks.size() && count < maximum_read_ahead_run_length
+            && uncached_blocks[i + count].value() == first_block.value() + count)
+            ++count;
+        i += count;
+
+        if (m_read_ahead_runs_in_flight.fetch_add(1) >= maximum_read_ahead_runs_in_flight) {
+            --m_read_ahead_runs_in_flight;
+            return;
+        }
+        auto result = g_io_work->try_queue([fs = NonnullRefPtr<BlockBasedFileSystem const>(*this), first_block, count] {
+            fs->read_ahead_run(first_block, count);
+        });
+        if (result.is_error()) {
+            --m_read_ahead_runs_in_flight;
+            return;
+        }
     }
+}
 
-    return {};
+void BlockBasedFileSystem::read_ahead_run(BlockIndex first_block, size_t count) const
+{
+    ScopeGuard decrement_runs_in_flight = [&] { --m_read_ahead_runs_in_flight; };
+    dbgln_if(BBFS_DEBUG, "BlockBasedFileSystem::read_ahead_run {}, count={}", first_block, count);
+
+    auto write_generation = m_uncached_write_generation.load();
+    auto buffer_or_error = KBuffer::try_create_with_size("BlockBasedFS: Read-ahead"sv, count * block_size());
+    if (buffer_or_error.is_error())
+        return;
+    auto buffer = buffer_or_error.release_value();
+
+    // NOTE: We go through the backing description (and not straight to the device), since partitions
+    //       translate offsets on the way. The device read turns this into AsyncBlockDeviceRequests.
+    size_t nread = 0;
+    while (nread < buffer->size()) {
+        auto data_buffer = UserOrKernelBuffer::for_kernel_buffer(buffer->data() + nread);
+        auto result = file_description().read(data_buffer, first_block.value() * block_size() + nread, buffer->size() - nread);
+        if (result.is_error() || result.value() == 0)
+            break;
+        nread += result.value();
+    }
+
+    m_cache.with_exclusive([&](auto& cache) {
+        if (!cache || write_generation != m_uncached_write_generation.load())
+            return;
+        for (size_t i = 0; i < nread / block_size(); ++i) {
+            BlockIndex index { first_block.value() + i };
+            // Whatever got into the cache while we were reading is at least as new as what we have.
+            if (cache->get(index))
+                continue;
+            auto entry_or_error = cache->ensure(index);
+            if (entry_or_error.is_error())
+                return;
+            auto* entry = entry_or_error.release_value();
+            memcpy(entry->data, buffer->data() + i * block_size(), block_size());
+            entry->has_data = true;
+        }
+    });
 }
 
 void BlockBasedFileSystem::flush_specific_block_if_needed(BlockIndex index)
@@ -275,6 +548,8 @@ void BlockBasedFileSystem::flush_specific_block_if_needed(BlockIndex index)
             return;
         if (!cache->entry_is_dirty(*entry))
             return;
+        // Read-ahead may have read the old contents of this block from the device, which it mustn't cache.
+        ++m_uncached_write_generation;
         size_t base_offset = entry->block_index.value() * block_size();
         auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry->data);
         (void)file_description().write(base_offset, entry_data_buffer, block_size());
@@ -284,17 +559,61 @@ void BlockBasedFileSystem::flush_specific_block_if_needed(BlockIndex index)
 void BlockBasedFileSystem::flush_writes_impl()
 {
     size_t count = 0;
+    size_t request_count = 0;
     m_cache.with_exclusive([&](auto& cache) {
         if (!cache->is_dirty())
             return;
-        cache->for_each_dirty_entry([&](CacheEntry& entry) {
+
+        // Once these blocks are clean, they can be evicted, after which read-ahead that read their old contents
+        // from the device while they were dirty would put that back in the cache.
+        ++m_uncached_write_generation;
+
+        auto write_entry = [&](CacheEntry& entry) {
             auto base_offset = entry.block_index.value() * block_size();
             auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry.data);
             [[maybe_unused]] auto rc = file_description().write(base_offset, entry_data_buffer, block_size());
             ++count;
+            ++request_count;
+        };
+
+        // The dirty blocks go out in ascending order, so the device sees a single sweep across the disk,
+        // and runs of consecutive blocks are merged into one request.
+        Vector<CacheEntry*> dirty_entries;
+        bool can_merge = true;
+        cache->for_each_dirty_entry([&](CacheEntry& entry) {
+            if (can_merge && dirty_entries.try_append(&entry).is_error())
+                can_merge = false;
         });
+        if (!can_merge) {
+            cache->for_each_dirty_entry(write_entry);
+            cache->mark_all_clean();
+            dbgln("{}: Flushed {} blocks to disk", class_name(), count);
+            return;
+        }
+        auto* merge_buffer = cache->merge_buffer();
+
+        quick_sort(dirty_entries, [](auto* a, auto* b) { return a->block_index < b->block_index; });
+        for (size_t i = 0; i < dirty_entries.size();) {
+            auto first_block = dirty_entries[i]->block_index;
+            size_t run_length = 1;
+            while (i + run_length < dirty_entries.size() && run_length < maximum_merged_blocks
+                && dirty_entries[i + run_length]->block_index.value() == first_block.value() + run_length)
+                ++run_length;
+
+            if (run_length == 1) {
+                write_entry(*dirty_entries[i++]);
+                continue;
+            }
+            for (size_t j = 0; j < run_length; ++j)
+                memcpy(merge_buffer + j * block_size(), dirty_entries[i + j]->data, block_size());
+            auto merge_data_buffer = UserOrKernelBuffer::for_kernel_buffer(merge_buffer);
+            [[maybe_unused]] auto rc = write_to_device(first_block.value() * block_size(), merge_data_buffer, run_length * block_size());
+            count += run_length;
+            ++request_count;
+            i += run_length;
+        }
         cache->mark_all_clean();
-        dbgln("{}: Flushed {} blocks to disk", class_name(), count);
+        dbgln("{}: Flushed {} blocks to disk in {} requests", class_name(), count, request_count);
     });
 }
 
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
 #include <Kernel/FileSystem/FileBackedFileSystem.h>
 #include <Kernel/Locking/MutexProtected.h>
 
@@ -30,6 +31,11 @@ protected:
     ErrorOr<void> read_block(BlockIndex, UserOrKernelBuffer*, size_t count, u64 offset = 0, bool allow_cache = true) const;
     ErrorOr<void> read_blocks(BlockIndex, unsigned count, UserOrKernelBuffer&, bool allow_cache = true) const;
 
+    // Reads a block on behalf of the page cache, which keeps its own copy of the data. A cached block
+    // is used and then made the next one to evict, and a block that isn't cached doesn't get cached.
+    ErrorOr<void> read_block_for_page_cache(BlockIndex, UserOrKernelBuffer&, size_t count, u64 offset) const;
+    ErrorOr<void> read_blocks_for_page_cache(BlockIndex, unsigned count, UserOrKernelBuffer&) const;
+
     ErrorOr<void> raw_read(BlockIndex, UserOrKernelBuffer&);
     ErrorOr<void> raw_write(BlockIndex, UserOrKernelBuffer const&);
 
@@ -39,6 +45,9 @@ protected:
     ErrorOr<void> write_block(BlockIndex, UserOrKernelBuffer const&, size_t count, u64 offset = 0, bool allow_cache = true);
     ErrorOr<void> write_blocks(BlockIndex, unsigned count, UserOrKernelBuffer const&, bool allow_cache = true);
 
+    // Asynchronously pulls the given blocks into the cache, unless they are cached already.
+    void read_ahead_blocks(Span<BlockIndex const>) const;
+
     u64 m_logical_block_size { 512 };
 
     void remove_disk_cache_before_last_unmount();
@@ -46,8 +55,21 @@ protected:
 private:
     DiskCache& cache() const;
     void flush_specific_block_if_needed(BlockIndex index);
+    void read_ahead_run(BlockIndex first_block, size_t count) const;
+
+    // Serves what it can from the cache, and reads each run of consecutive blocks that aren't cached with a single request.
+    ErrorOr<void> read_blocks_through_cache(BlockIndex, unsigned count, UserOrKernelBuffer&, bool for_page_cache) const;
+
+    // These go straight to the device, in as few requests as it takes.
+    ErrorOr<void> read_from_device(u64 offset, UserOrKernelBuffer&, size_t size) const;
+    ErrorOr<void> write_to_device(u64 offset, UserOrKernelBuffer const&, size_t size) const;
 
     mutable MutexProtected<OwnPtr<DiskCache>> m_cache;
+
+    mutable Atomic<u32> m_read_ahead_runs_in_flight { 0 };
+    // Bumped by every write that bypasses the cache, and whenever dirty blocks are flushed, so read-ahead doesn't
+    // insert data that went stale while it was in flight.
+    mutable Atomic<u64> m_uncached_write_generation { 0 };
 };
 
 }
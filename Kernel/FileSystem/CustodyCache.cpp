@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Singleton.h>
+#include <AK/Vector.h>
+#include <Kernel/FileSystem/CustodyCache.h>
+#include <Kernel/FileSystem/FileSystem.h>
+#include <Kernel/FileSystem/Inode.h>
+
+namespace Kernel {
+
+static Singleton<CustodyCache> s_the;
+
+CustodyCache& CustodyCache::the()
+{
+    return *s_the;
+}
+
+Optional<RefPtr<Custody>> CustodyCache::lookup(Custody& parent, StringView name)
+{
+    return m_state.with([&](auto& state) -> Optional<RefPtr<Custody>> {
+        auto it = state.entries.find(Key { &parent.inode(), name });
+        if (it == state.entries.end()) {
+            ++state.statistics.misses;
+            return {};
+        }
+        auto& entry = *it->value;
+        // The same directory can be reached through more than one custody (e.g. through a bind mount),
+        // but the child custody only belongs to one of them.
+        if (entry.child && entry.child->parent() != &parent) {
+            ++state.statistics.misses;
+            return {};
+        }
+        state.lru_list.append(entry);
+        if (entry.child)
+            ++state.statistics.hits;
+        else
+            ++state.statistics.negative_hits;
+        return entry.child;
+    });
+}
+
+u64 CustodyCache::generation()
+{
+    return m_state.with([](auto& state) { return state.generation; });
+}
+
+void CustodyCache::add(Custody& parent, StringView name, RefPtr<Custody> child, u64 generation)
+{
+    // Only file systems that tell us about every change to their directories can be cached.
+    if (!parent.inode().fs().supports_lookup_caching())
+        return;
+
+    auto name_or_error = KString::try_create(name);
+    if (name_or_error.is_error())
+        return;
+    auto new_entry_or_error = adopt_nonnull_own_or_enomem(new (nothrow) Entry { parent.inode(), name_or_error.release_value(), move(child), {} });
+    if (new_entry_or_error.is_error())
+        return;
+    auto new_entry = new_entry_or_error.release_value();
+
+    // NOTE: Dropping the last reference to an inode may call into its file system,
+    //       so entries that we replace or evict are destroyed after we've let go of our lock.
+    Vector<NonnullOwnPtr<Entry>, 2> dropped_entries;
+    m_state.with([&](auto& state) {
+        if (state.generation != generation)
+            return;
+        if (dropped_entries.try_ensure_capacity(2).is_error())
+            return;
+
+        auto key = new_entry->key();
+        if (auto it = state.entries.find(key); it != state.entries.end()) {
+            it->value->lru_list_node.remove();
+            dropped_entries.unchecked_append(move(it->value));
+            state.entries.remove(it);
+        }
+        if (state.entries.size() >= max_entries) {
+            auto& least_recently_used = *state.lru_list.take_first();
+            auto it = state.entries.find(least_recently_used.key());
+            VERIFY(it != state.entries.end());
+            dropped_entries.unchecked_append(move(it->value));
+            state.entries.remove(it);
+        }
+
+        auto& entry = *new_entry;
+        if (state.entries.try_set(key, move(new_entry)).is_error())
+            return;
+        state.lru_list.append(entry);
+    });
+}
+
+void CustodyCache::invalidate(Inode const& directory, StringView name)
+{
+    OwnPtr<Entry> dropped_entry;
+    m_state.with([&](auto& state) {
+        ++state.generation;
+        auto it = state.entries.find(Key { &directory, name });
+        if (it == state.entries.end())
+            return;
+        it->value->lru_list_node.remove();
+        dropped_entry = move(it->value);
+        state.entries.remove(it);
+        ++state.statistics.invalidations;
+    });
+}
+
+void CustodyCache::invalidate_all()
+{
+    HashMap<Key, NonnullOwnPtr<Entry>, KeyTraits> dropped_entries;
+    m_state.with([&](auto& state) {
+        ++state.generation;
+        state.statistics.invalidations += state.entries.size();
+        swap(dropped_entries, state.entries);
+        state.lru_list.clear();
+    });
+}
+
+CustodyCache::Statistics CustodyCache::statistics()
+{
+    return m_state.with([](auto& state) {
+        auto statistics = state.statistics;
+        statistics.entries = state.entries.size();
+        return statistics;
+    });
+}
+
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/IntrusiveList.h>
+#include <AK/Optional.h>
+#include <AK/RefPtr.h>
+#include <Kernel/FileSystem/Custody.h>
+#include <Kernel/Forward.h>
+#include <Kernel/KString.h>
+#include <Kernel/Library/NonnullLockRefPtr.h>
+#include <Kernel/Locking/SpinlockProtected.h>
+
+namespace Kernel {
+
+// The custody cache remembers what each name in a directory resolved to during path
+// resolution, so that resolving the same path again needs neither Inode::lookup() nor
+// a new Custody. Names that don't exist are remembered as well. Entries are dropped
+// when the directory changes, and the whole cache is flushed whenever mounts change.
+class CustodyCache {
+public:
+    static CustodyCache& the();
+
+    struct Statistics {
+        u64 hits { 0 };
+        u64 negative_hits { 0 };
+        u64 misses { 0 };
+        u64 invalidations { 0 };
+        size_t entries { 0 };
+    };
+
+    // Returns an empty Optional if nothing is known about the name, a null custody
+    // if it is known not to exist, and the child custody otherwise.
+    Optional<RefPtr<Custody>> lookup(Custody& parent, StringView name);
+
+    // Anything that invalidates entries bumps the generation. Callers take it before
+    // looking up the name on their own, and only the result of a lookup that didn't
+    // race with an invalidation is added.
+    u64 generation();
+    void add(Custody& parent, StringView name, RefPtr<Custody> child, u64 generation);
+
+    void invalidate(Inode const& directory, StringView name);
+    void invalidate_all();
+
+    Statistics statistics();
+
+private:
+    static constexpr size_t max_entries = 4096;
+
+    struct Key {
+        Inode const* directory { nullptr };
+        StringView name;
+
+        bool operator==(Key const&) const = default;
+    };
+
+    struct KeyTraits : public GenericTraits<Key> {
+        static unsigned hash(Key const& key) { return pair_int_hash(ptr_hash(key.directory), key.name.hash()); }
+        static bool equals(Key const& a, Key const& b) { return a == b; }
+    };
+
+    struct Entry {
+        NonnullLockRefPtr<Inode> directory;
+        NonnullOwnPtr<KString> name;
+        // A null child means the name doesn't exist.
+        RefPtr<Custody> child;
+        IntrusiveListNode<Entry> lru_list_node;
+
+        Key key() const { return { directory.ptr(), name->view() }; }
+    };
+
+    struct State {
+        HashMap<Key, NonnullOwnPtr<Entry>, KeyTraits> entries;
+        // Least recently used first.
+        IntrusiveList<&Entry::lru_list_node> lru_list;
+        u64 generation { 0 };
+        Statistics statistics;
+    };
+    SpinlockProtected<State> m_state { LockRank::None };
+};
+
+}
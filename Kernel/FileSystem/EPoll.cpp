@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/Debug.h>
+#include <Kernel/FileSystem/EPoll.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+using BlockFlags = Thread::FileBlocker::BlockFlags;
+
+BlockFlags EPollWatch::block_flags() const
+{
+    auto block_flags = BlockFlags::None;
+    if (m_event.events & EPOLLIN)
+        block_flags |= BlockFlags::Read;
+    if (m_event.events & EPOLLOUT)
+        block_flags |= BlockFlags::Write;
+    if (m_event.events & EPOLLPRI)
+        block_flags |= BlockFlags::ReadPriority;
+    if (m_event.events & EPOLLRDHUP)
+        block_flags |= BlockFlags::ReadHangUp;
+    return block_flags;
+}
+
+ErrorOr<NonnullLockRefPtr<EPoll>> EPoll::try_create()
+{
+    return adopt_nonnull_lock_ref_or_enomem(new (nothrow) EPoll);
+}
+
+EPoll::~EPoll()
+{
+    // A watched description may be going away concurrently, in which case it
+    // removes its watch on its own. So we always have to go through the
+    // FileBlockerSet lock first, just like the description does.
+    for (;;) {
+        LockRefPtr<File> file;
+        EPollWatchKey key;
+        EPollWatch* watch = nullptr;
+        {
+            SpinlockLocker lock(m_lock);
+            if (m_watches.is_empty())
+                break;
+            auto it = m_watches.begin();
+            key = it->key;
+            watch = it->value.ptr();
+            file = watch->description().file();
+        }
+
+        auto& blocker_set = file->blocker_set();
+        SpinlockLocker blocker_set_locker(blocker_set.m_lock);
+        SpinlockLocker lock(m_lock);
+        auto it = m_watches.find(key);
+        if (it != m_watches.end() && it->value.ptr() == watch)
+            remove_watch_locked(blocker_set, *watch);
+    }
+}
+
+bool EPoll::can_read(OpenFileDescription const&, u64) const
+{
+    SpinlockLocker lock(m_lock);
+    return !m_ready_list.is_empty();
+}
+
+ErrorOr<NonnullOwnPtr<KString>> EPoll::pseudo_path(OpenFileDescription const&) const
+{
+    SpinlockLocker lock(m_lock);
+    return KString::formatted("EPoll:({})", m_watches.size());
+}
+
+void EPoll::mark_ready_locked(EPollWatch& watch)
+{
+    VERIFY(m_lock.is_locked());
+    if (!watch.m_ready_list_node.is_in_list())
+        m_ready_list.append(watch);
+}
+
+void EPoll::remove_watch_locked(FileBlockerSet& blocker_set, EPollWatch& watch)
+{
+    VERIFY(blocker_set.m_lock.is_locked());
+    VERIFY(m_lock.is_locked());
+    blocker_set.m_epoll_watches.remove_first_matching([&](auto* entry) { return entry == &watch; });
+    if (watch.m_ready_list_node.is_in_list())
+        m_ready_list.remove(watch);
+    m_watches.remove(watch.key());
+}
+
+ErrorOr<void> EPoll::add_watch(int fd, OpenFileDescription& description, epoll_event const& event)
+{
+    // Watching another EPoll could create cycles of watches.
+    if (description.is_epoll())
+        return EINVAL;
+
+    auto watch = TRY(adopt_nonnull_own_or_enomem(new (nothrow) EPollWatch(*this, description, fd, event)));
+    auto& blocker_set = description.blocker_set();
+    {
+        SpinlockLocker blocker_set_locker(blocker_set.m_lock);
+        SpinlockLocker lock(m_lock);
+        if (m_watches.contains(watch->key()))
+            return EEXIST;
+        TRY(blocker_set.m_epoll_watches.try_ensure_capacity(blocker_set.m_epoll_watches.size() + 1));
+        auto& watch_ref = *watch;
+        TRY(m_watches.try_set(watch_ref.key(), move(watch)));
+        blocker_set.m_epoll_watches.unchecked_append(&watch_ref);
+
+        // The description may already be ready, in which case no state change
+        // would ever tell us about it. Let the next wait() check it.
+        mark_ready_locked(watch_ref);
+    }
+
+    m_wait_queue.wake_all();
+    evaluate_block_conditions();
+    return {};
+}
+
+ErrorOr<void> EPoll::modify_watch(int fd, OpenFileDescription& description, epoll_event const& event)
+{
+    auto& blocker_set = description.blocker_set();
+    {
+        SpinlockLocker blocker_set_locker(blocker_set.m_lock);
+        SpinlockLocker lock(m_lock);
+        auto it = m_watches.find({ fd, &description });
+        if (it == m_watches.end())
+            return ENOENT;
+        it->value->m_event = event;
+        mark_ready_locked(*it->value);
+    }
+
+    m_wait_queue.wake_all();
+    evaluate_block_conditions();
+    return {};
+}
+
+ErrorOr<void> EPoll::remove_watch(int fd, OpenFileDescription& description)
+{
+    auto& blocker_set = description.blocker_set();
+    SpinlockLocker blocker_set_locker(blocker_set.m_lock);
+    SpinlockLocker lock(m_lock);
+    auto it = m_watches.find({ fd, &description });
+    if (it == m_watches.end())
+        return ENOENT;
+    remove_watch_locked(blocker_set, *it->value);
+    return {};
+}
+
+void EPoll::watched_description_did_change(Badge<FileBlockerSet>, EPollWatch& watch)
+{
+    {
+        SpinlockLocker lock(m_lock);
+        if (watch.block_flags() == BlockFlags::None)
+            return;
+        mark_ready_locked(watch);
+    }
+
+    m_wait_queue.wake_all();
+    evaluate_block_conditions();
+}
+
+void EPoll::watched_description_will_be_destroyed(Badge<FileBlockerSet>, EPollWatch& watch)
+{
+    // NOTE: The FileBlockerSet removes the watch from its own list.
+    SpinlockLocker lock(m_lock);
+    if (watch.m_ready_list_node.is_in_list())
+        m_ready_list.remove(watch);
+    m_watches.remove(watch.key());
+}
+
+size_t EPoll::collect_ready_events(Span<epoll_event> events)
+{
+    SpinlockLocker lock(m_lock);
+    size_t count = 0;
+    for (auto it = m_ready_list.begin(); it != m_ready_list.end() && count < events.size();) {
+        auto& watch = *it;
+        ++it;
+
+        auto unblocked_flags = watch.description().should_unblock(watch.block_flags());
+        if (unblocked_flags == BlockFlags::None) {
+            // Level-triggered watches stay on the ready list for as long as they
+            // are ready, so this is where they are dropped again.
+            m_ready_list.remove(watch);
+            continue;
+        }
+
+        u32 revents = 0;
+        if (has_flag(unblocked_flags, BlockFlags::Read))
+            revents |= EPOLLIN;
+        if (has_flag(unblocked_flags, BlockFlags::Write))
+            revents |= EPOLLOUT;
+        if (has_flag(unblocked_flags, BlockFlags::ReadPriority))
+            revents |= EPOLLPRI;
+        if (has_flag(unblocked_flags, BlockFlags::ReadHangUp))
+            revents |= EPOLLRDHUP;
+        events[count++] = { revents, watch.m_event.data };
+
+        if (watch.m_event.events & EPOLLONESHOT) {
+            // Disable the watch until it is re-armed with EPOLL_CTL_MOD.
+            watch.m_event.events = 0;
+            m_ready_list.remove(watch);
+        } else if (watch.m_event.events & EPOLLET) {
+            m_ready_list.remove(watch);
+        }
+    }
+    return count;
+}
+
+ErrorOr<size_t> EPoll::wait(Span<epoll_event> events, Thread::BlockTimeout const& timeout)
+{
+    for (;;) {
+        auto count = collect_ready_events(events);
+        if (count > 0)
+            return count;
+
+        auto result = m_wait_queue.wait_on(timeout, "EPoll"sv);
+        if (result.was_interrupted())
+            return EINTR;
+        if (result == Thread::BlockResult::InterruptedByTimeout)
+            return collect_ready_events(events);
+    }
+}
+
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Badge.h>
+#include <AK/HashMap.h>
+#include <AK/IntrusiveList.h>
+#include <AK/NonnullOwnPtr.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/Forward.h>
+#include <Kernel/Locking/Spinlock.h>
+#include <Kernel/UnixTypes.h>
+#include <Kernel/WaitQueue.h>
+
+namespace Kernel {
+
+// Like on Linux, a watch belongs to a file descriptor *and* the description it referred to when it was added.
+// Closing the fd leaves the watch in place for as long as the description is open elsewhere (after a dup() or
+// fork()), so the fd number alone isn't enough to tell it apart from a description that reuses that number.
+struct EPollWatchKey {
+    int fd { -1 };
+    OpenFileDescription const* description { nullptr };
+
+    bool operator==(EPollWatchKey const&) const = default;
+};
+
+}
+
+namespace AK {
+
+template<>
+struct Traits<Kernel::EPollWatchKey> : public GenericTraits<Kernel::EPollWatchKey> {
+    static unsigned hash(Kernel::EPollWatchKey const& key) { return pair_int_hash(key.fd, ptr_hash(key.description)); }
+};
+
+}
+
+namespace Kernel {
+
+// A registration of one file descriptor in an EPoll's interest set.
+class EPollWatch {
+    AK_MAKE_NONCOPYABLE(EPollWatch);
+    AK_MAKE_NONMOVABLE(EPollWatch);
+
+public:
+    EPoll& epoll() { return m_epoll; }
+    OpenFileDescription& description() { return m_description; }
+
+private:
+    friend class EPoll;
+
+    EPollWatch(EPoll& epoll, OpenFileDescription& description, int fd, epoll_event const& event)
+        : m_epoll(epoll)
+        , m_description(description)
+        , m_fd(fd)
+        , m_event(event)
+    {
+    }
+
+    Thread::FileBlocker::BlockFlags block_flags() const;
+    EPollWatchKey key() const { return { m_fd, &m_description }; }
+
+    EPoll& m_epoll;
+    // NOTE: This is not a strong reference, as watching a description must not keep it open.
+    //       The description removes all of its watches when it is destroyed.
+    OpenFileDescription& m_description;
+    int m_fd { -1 };
+    epoll_event m_event {};
+    IntrusiveListNode<EPollWatch> m_ready_list_node;
+
+public:
+    using ReadyList = IntrusiveList<&EPollWatch::m_ready_list_node>;
+};
+
+// EPoll is a persistent interest set of file descriptors. Instead of
+// re-registering every descriptor on every wait like poll() does, the
+// watched files push themselves onto a ready list whenever their state
+// changes, so waiting only has to look at descriptors that may be ready.
+class EPoll final : public File {
+public:
+    static constexpr size_t max_events_per_wait = 1024;
+
+    static ErrorOr<NonnullLockRefPtr<EPoll>> try_create();
+    virtual ~EPoll() override;
+
+    virtual bool can_read(OpenFileDescription const&, u64) const override;
+    virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    virtual bool can_write(OpenFileDescription const&, u64) const override { return false; }
+    virtual ErrorOr<size_t> write(OpenFileDescription&, u64, UserOrKernelBuffer const&, size_t) override { return EINVAL; }
+
+    virtual ErrorOr<NonnullOwnPtr<KString>> pseudo_path(OpenFileDescription const&) const override;
+    virtual StringView class_name() const override { return "EPoll"sv; }
+    virtual bool is_epoll() const override { return true; }
+
+    ErrorOr<void> add_watch(int fd, OpenFileDescription&, epoll_event const&);
+    ErrorOr<void> modify_watch(int fd, OpenFileDescription&, epoll_event const&);
+    ErrorOr<void> remove_watch(int fd, OpenFileDescription&);
+
+    // Blocks until at least one watched descriptor is ready or the timeout expires.
+    ErrorOr<size_t> wait(Span<epoll_event>, Thread::BlockTimeout const&);
+
+    void watched_description_did_change(Badge<FileBlockerSet>, EPollWatch&);
+    void watched_description_will_be_destroyed(Badge<FileBlockerSet>, EPollWatch&);
+
+private:
+    EPoll() = default;
+
+    size_t collect_ready_events(Span<epoll_event>);
+    void mark_ready_locked(EPollWatch&);
+    void remove_watch_locked(FileBlockerSet&, EPollWatch&);
+
+    mutable Spinlock m_lock { LockRank::None };
+    HashMap<EPollWatchKey, NonnullOwnPtr<EPollWatch>> m_watches;
+    EPollWatch::ReadyList m_ready_list;
+    WaitQueue m_wait_queue;
+};
+
+}
@@ -10,6 +10,7 @@
 #include <Kernel/Debug.h>
 #include <Kernel/FileSystem/Ext2FS/Inode.h>
 #include <Kernel/FileSystem/InodeMetadata.h>
+#include <Kernel/Memory/PageCache.h>
 #include <Kernel/UnixTypes.h>
 
 namespace Kernel {
@@ -524,6 +525,18 @@ ErrorOr<void> Ext2FSInode::compute_block_list_with_exclusive_locking()
 }
 
 ErrorOr<size_t> Ext2FSInode::read_bytes_locked(off_t offset, size_t count, UserOrKernelBuffer& buffer, OpenFileDescription* description) const
+{
+    bool allow_cache = !description || !description->is_direct();
+    return read_bytes_from_blocks(offset, count, buffer, allow_cache ? BlockReadMode::Cached : BlockReadMode::Uncached);
+}
+
+ErrorOr<size_t> Ext2FSInode::read_bytes_for_page_cache(off_t offset, size_t count, UserOrKernelBuffer& buffer) const
+{
+    MutexLocker inode_locker(m_inode_lock, Mutex::Mode::Shared);
+    return read_bytes_from_blocks(offset, count, buffer, BlockReadMode::PageCache);
+}
+
+ErrorOr<size_t> Ext2FSInode::read_bytes_from_blocks(off_t offset, size_t count, UserOrKernelBuffer& buffer, BlockReadMode mode) const
 {
     VERIFY(m_inode_lock.is_locked());
     VERIFY(offset >= 0);
@@ -554,8 +567,6 @@ ErrorOr<size_t> Ext2FSInode::read_bytes_locked(off_t offset, size_t count, UserO
         return EIO;
     }
 
-    bool allow_cache = !description || !description->is_direct();
-
     int const block_size = fs().block_size();
 
     BlockBasedFileSystem::BlockIndex first_block_logical_index = offset / block_size;
@@ -578,8 +589,27 @@ ErrorOr<size_t> Ext2FSInode::read_bytes_locked(off_t offset, size_t count, UserO
         if (block_index.value() == 0) {
             // This is a hole, act as if it's filled with zeroes.
             TRY(buffer_offset.memset(0, num_bytes_to_copy));
+        } else if (num_bytes_to_copy == (size_t)block_size) {
+            // Whole blocks that follow each other on disk are read together, so they can become a single device request.
+            unsigned block_count = 1;
+            while (bi.value() + block_count <= last_block_logical_index.value()
+                && (size_t)remaining_count >= (block_count + 1) * block_size
+                && m_block_list[bi.value() + block_count].value() == block_index.value() + block_count)
+                ++block_count;
+            auto result = mode == BlockReadMode::PageCache
+                ? fs().read_blocks_for_page_cache(block_index, block_count, buffer_offset)
+                : fs().read_blocks(block_index, block_count, buffer_offset, mode == BlockReadMode::Cached);
+            if (result.is_error()) {
+                dmesgln("Ext2FSInode[{}]::read_bytes(): Failed to read {} blocks at {} (index {})", identifier(), block_count, block_index.value(), bi);
+                return result.release_error();
+            }
+            num_bytes_to_copy = block_count * block_size;
+            bi = bi.value() + block_count - 1;
         } else {
-            if (auto result = fs().read_block(block_index, &buffer_offset, num_bytes_to_copy, offset_into_block, allow_cache); result.is_error()) {
+            auto result = mode == BlockReadMode::PageCache
+                ? fs().read_block_for_page_cache(block_index, buffer_offset, num_bytes_to_copy, offset_into_block)
+                : fs().read_block(block_index, &buffer_offset, num_bytes_to_copy, offset_into_block, mode == BlockReadMode::Cached);
+            if (result.is_error()) {
                 dmesgln("Ext2FSInode[{}]::read_bytes(): Failed to read block {} (index {})", identifier(), block_index.value(), bi);
                 return result.release_error();
             }
@@ -591,6 +621,24 @@ ErrorOr<size_t> Ext2FSInode::read_bytes_locked(off_t offset, size_t count, UserO
     return nread;
 }
 
+void Ext2FSInode::read_ahead(off_t offset, size_t count) const
+{
+    MutexLocker inode_locker(m_inode_lock, Mutex::Mode::Shared);
+    if (const_cast<Ext2FSInode&>(*this).compute_block_list_with_exclusive_locking().is_error())
+        return;
+
+    u64 const block_size = fs().block_size();
+    u64 first_logical_index = offset / block_size;
+    u64 end_logical_index = min(ceil_div(offset + count, block_size), static_cast<u64>(m_block_list.size()));
+    Vector<BlockBasedFileSystem::BlockIndex, 64> blocks_to_read_ahead;
+    for (auto logical_index = first_logical_index; logical_index < end_logical_index; ++logical_index) {
+        auto block_index = m_block_list[logical_index];
+        if (block_index.value() != 0 && blocks_to_read_ahead.try_append(block_index).is_error())
+            break;
+    }
+    fs().read_ahead_blocks(blocks_to_read_ahead);
+}
+
 ErrorOr<void> Ext2FSInode::resize(u64 new_size)
 {
     auto old_size = size();
@@ -1030,8 +1078,11 @@ ErrorOr<void> Ext2FSInode::decrement_link_count()
 
     --m_raw_inode.i_links_count;
     set_metadata_dirty(true);
-    if (m_raw_inode.i_links_count == 0)
+    if (m_raw_inode.i_links_count == 0) {
         did_delete_self();
+        // The page cache holds a reference to us, which would otherwise keep us from being freed.
+        Memory::PageCache::the().forget(*this);
+    }
 
     if (ref_count() == 1 && m_raw_inode.i_links_count == 0)
         fs().uncache_inode(index());
@@ -1067,6 +1118,8 @@ ErrorOr<void> Ext2FSInode::truncate(u64 size)
         return {};
     TRY(resize(size));
     set_metadata_dirty(true);
+    if (auto vmobject = shared_vmobject())
+        vmobject->did_truncate(size);
     return {};
 }
 
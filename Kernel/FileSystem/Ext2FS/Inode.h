@@ -28,6 +28,9 @@ public:
 private:
     // ^Inode
     virtual ErrorOr<size_t> read_bytes_locked(off_t, size_t, UserOrKernelBuffer& buffer, OpenFileDescription*) const override;
+    virtual bool is_page_cacheable() const override { return Kernel::is_regular_file(m_raw_inode.i_mode); }
+    virtual ErrorOr<size_t> read_bytes_for_page_cache(off_t, size_t, UserOrKernelBuffer& buffer) const override;
+    virtual void read_ahead(off_t, size_t) const override;
     virtual InodeMetadata metadata() const override;
     virtual ErrorOr<void> traverse_as_directory(Function<ErrorOr<void>(FileSystem::DirectoryEntryView const&)>) const override;
     virtual ErrorOr<NonnullLockRefPtr<Inode>> lookup(StringView name) override;
@@ -45,6 +48,13 @@ private:
     virtual ErrorOr<void> truncate(u64) override;
     virtual ErrorOr<int> get_block_address(int) override;
 
+    enum class BlockReadMode {
+        Cached,
+        Uncached,
+        PageCache,
+    };
+    ErrorOr<size_t> read_bytes_from_blocks(off_t, size_t, UserOrKernelBuffer& buffer, BlockReadMode) const;
+
     ErrorOr<void> write_directory(Vector<Ext2FSDirectoryEntry>&);
     ErrorOr<void> populate_lookup_cache();
     ErrorOr<void> resize(u64);
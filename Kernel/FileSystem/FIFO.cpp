@@ -18,7 +18,7 @@ static Atomic<int> s_next_fifo_id = 1;
 
 ErrorOr<NonnullLockRefPtr<FIFO>> FIFO::try_create(UserID uid)
 {
-    auto buffer = TRY(DoubleBuffer::try_create("FIFO: Buffer"sv));
+    auto buffer = TRY(PipeBuffer::try_create("FIFO: Buffer"sv));
     return adopt_nonnull_lock_ref_or_enomem(new (nothrow) FIFO(uid, move(buffer)));
 }
 
@@ -59,7 +59,7 @@ ErrorOr<NonnullLockRefPtr<OpenFileDescription>> FIFO::open_direction_blocking(FI
     return description;
 }
 
-FIFO::FIFO(UserID uid, NonnullOwnPtr<DoubleBuffer> buffer)
+FIFO::FIFO(UserID uid, NonnullOwnPtr<PipeBuffer> buffer)
     : m_buffer(move(buffer))
     , m_uid(uid)
 {
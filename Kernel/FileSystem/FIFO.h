@@ -6,9 +6,9 @@
 
 #pragma once
 
-#include <Kernel/DoubleBuffer.h>
 #include <Kernel/FileSystem/File.h>
 #include <Kernel/Locking/Mutex.h>
+#include <Kernel/PipeBuffer.h>
 #include <Kernel/UnixTypes.h>
 #include <Kernel/WaitQueue.h>
 
@@ -49,11 +49,11 @@ private:
     virtual StringView class_name() const override { return "FIFO"sv; }
     virtual bool is_fifo() const override { return true; }
 
-    explicit FIFO(UserID, NonnullOwnPtr<DoubleBuffer> buffer);
+    explicit FIFO(UserID, NonnullOwnPtr<PipeBuffer> buffer);
 
     unsigned m_writers { 0 };
     unsigned m_readers { 0 };
-    NonnullOwnPtr<DoubleBuffer> m_buffer;
+    NonnullOwnPtr<PipeBuffer> m_buffer;
 
     UserID m_uid { 0 };
 
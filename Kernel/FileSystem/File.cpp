@@ -6,12 +6,46 @@
 
 #include <AK/StringView.h>
 #include <AK/Userspace.h>
+#include <Kernel/FileSystem/EPoll.h>
 #include <Kernel/FileSystem/File.h>
+#include <Kernel/FileSystem/IORing.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
 #include <Kernel/Process.h>
 
 namespace Kernel {
 
+void FileBlockerSet::notify_epoll_watches_locked()
+{
+    VERIFY(m_lock.is_locked());
+    for (auto* watch : m_epoll_watches)
+        watch->epoll().watched_description_did_change({}, *watch);
+}
+
+void FileBlockerSet::remove_epoll_watches_for_description(Badge<OpenFileDescription>, OpenFileDescription& description)
+{
+    SpinlockLocker lock(m_lock);
+    m_epoll_watches.remove_all_matching([&](auto* watch) {
+        if (&watch->description() != &description)
+            return false;
+        watch->epoll().watched_description_will_be_destroyed({}, *watch);
+        return true;
+    });
+}
+
+void FileBlockerSet::notify_io_rings_locked()
+{
+    VERIFY(m_lock.is_locked());
+    for (auto* io_ring : m_waiting_io_rings)
+        io_ring->blocker_set_did_change({}, *this);
+    m_waiting_io_rings.clear_with_capacity();
+}
+
+void FileBlockerSet::remove_waiting_io_ring(Badge<IORing>, IORing& io_ring)
+{
+    SpinlockLocker lock(m_lock);
+    m_waiting_io_rings.remove_first_matching([&](auto* entry) { return entry == &io_ring; });
+}
+
 File::File() = default;
 File::~File() = default;
 
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <AK/AtomicRefCounted.h>
+#include <AK/Badge.h>
 #include <AK/Error.h>
 #include <AK/StringView.h>
 #include <AK/Types.h>
@@ -40,7 +41,42 @@ public:
             auto& blocker = static_cast<Thread::FileBlocker&>(b);
             return blocker.unblock_if_conditions_are_met(false, data);
         });
+        if (!m_epoll_watches.is_empty())
+            notify_epoll_watches_locked();
+        if (!m_waiting_io_rings.is_empty())
+            notify_io_rings_locked();
     }
+
+    void remove_epoll_watches_for_description(Badge<OpenFileDescription>, OpenFileDescription&);
+
+    // Registers the ring, and calls did_register() while still holding our lock, so that no change can slip in
+    // between. If that returns false, the ring isn't registered after all.
+    template<typename Callback>
+    ErrorOr<void> add_waiting_io_ring(Badge<IORing>, IORing& io_ring, Callback did_register)
+    {
+        SpinlockLocker lock(m_lock);
+        bool was_registered = m_waiting_io_rings.contains_slow(&io_ring);
+        if (!was_registered)
+            TRY(m_waiting_io_rings.try_append(&io_ring));
+        if (!did_register() && !was_registered)
+            m_waiting_io_rings.take_last();
+        return {};
+    }
+    void remove_waiting_io_ring(Badge<IORing>, IORing&);
+
+private:
+    friend class EPoll;
+
+    void notify_epoll_watches_locked();
+    void notify_io_rings_locked();
+
+    // Unlike blockers, these stay registered across state changes until they
+    // are removed by their EPoll or the watched description goes away.
+    Vector<EPollWatch*> m_epoll_watches;
+
+    // Rings with requests that are waiting for this file. These are only told
+    // about the next change, and register again if they still have to wait.
+    Vector<IORing*> m_waiting_io_rings;
 };
 
 // File is the base class for anything that can be referenced by a OpenFileDescription.
@@ -114,6 +150,8 @@ public:
     virtual bool is_character_device() const { return false; }
     virtual bool is_socket() const { return false; }
     virtual bool is_inode_watcher() const { return false; }
+    virtual bool is_epoll() const { return false; }
+    virtual bool is_io_ring() const { return false; }
 
     virtual bool is_regular_file() const { return false; }
 
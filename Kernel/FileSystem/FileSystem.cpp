@@ -12,6 +12,7 @@
 #include <Kernel/FileSystem/VirtualFileSystem.h>
 #include <Kernel/InterruptDisabler.h>
 #include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Memory/PageCache.h>
 #include <Kernel/Net/LocalSocket.h>
 
 namespace Kernel {
@@ -29,6 +30,8 @@ FileSystem::~FileSystem()
 
 ErrorOr<void> FileSystem::prepare_to_unmount()
 {
+    // Cached file contents keep their inodes alive, which would keep us busy.
+    Memory::PageCache::the().forget_all_in(*this);
     return m_attach_count.with([&](auto& attach_count) -> ErrorOr<void> {
         if (attach_count == 1)
             return prepare_to_clear_last_mount();
@@ -33,6 +33,10 @@ public:
     virtual StringView class_name() const = 0;
     virtual Inode& root_inode() = 0;
     virtual bool supports_watchers() const { return false; }
+    // File systems whose directories only change through Inode::add_child() and friends,
+    // and that report every change through Inode::did_add_child() and did_remove_child(),
+    // can have their path lookups remembered by the CustodyCache.
+    virtual bool supports_lookup_caching() const { return false; }
 
     bool is_readonly() const { return m_readonly; }
 
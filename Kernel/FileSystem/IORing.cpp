@@ -0,0 +1,637 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Checked.h>
+#include <Kernel/FileSystem/IORing.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Net/Socket.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+using BlockFlags = Thread::FileBlocker::BlockFlags;
+
+ErrorOr<NonnullLockRefPtr<IORing>> IORing::try_create(u32 entries)
+{
+    if (entries == 0 || entries > IO_RING_MAX_ENTRIES || !is_power_of_two(entries))
+        return EINVAL;
+
+    auto size = TRY(Memory::page_round_up(io_ring_size(entries)));
+    auto vmobject = TRY(Memory::AnonymousVMObject::try_create_with_size(size, AllocationStrategy::AllocateNow));
+    auto region = TRY(MM.allocate_kernel_region_with_vmobject(*vmobject, size, "IORing"sv, Memory::Region::Access::ReadWrite));
+    auto ring = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) IORing(entries, move(vmobject), move(region))));
+    TRY(ring->start_workers());
+    return ring;
+}
+
+IORing::IORing(u32 entries, NonnullLockRefPtr<Memory::AnonymousVMObject> vmobject, NonnullOwnPtr<Memory::Region> region)
+    : m_entries(entries)
+    , m_vmobject(move(vmobject))
+    , m_region(move(region))
+{
+    auto& header = this->header();
+    header.submission_mask = m_entries - 1;
+    header.submission_offset = io_ring_submission_offset();
+    header.completion_mask = io_ring_completion_entries(m_entries) - 1;
+    header.completion_offset = io_ring_completion_offset(m_entries);
+}
+
+IORing::~IORing()
+{
+    drop_waiting_requests();
+    while (auto* request = m_pending_requests.take_first())
+        delete request;
+    while (auto* request = m_finished_requests.take_first())
+        delete request;
+}
+
+IORing::Request::~Request()
+{
+    // NOTE: Moving this state to Completed is what causes connect() to unblock on the client side, which it
+    //       has to whether or not the accepted socket made it into the process.
+    if (accepted_description)
+        accepted_description->socket()->set_setup_state(Socket::SetupState::Completed);
+}
+
+ErrorOr<void> IORing::start_workers()
+{
+    // NOTE: Each worker holds on to a reference to the ring, which it drops when the ring is closed.
+    auto create_worker = [&](LockRefPtr<Process>& worker_process) -> ErrorOr<void> {
+        auto name = TRY(KString::formatted("IORing Worker #{}", m_workers.size()));
+        LockRefPtr<Thread> thread;
+        ref();
+        if (!worker_process) {
+            worker_process = Process::create_kernel_process(thread, move(name), worker_main, this);
+        } else {
+            thread = worker_process->create_kernel_thread(worker_main, this, THREAD_PRIORITY_NORMAL, move(name), THREAD_AFFINITY_DEFAULT, false);
+        }
+        if (!thread) {
+            unref();
+            return ENOMEM;
+        }
+        SpinlockLocker locker(m_lock);
+        m_workers.unchecked_append(move(thread));
+        return {};
+    };
+
+    LockRefPtr<Process> worker_process;
+    TRY(create_worker(worker_process));
+    // We can make do with fewer workers, as long as there is one.
+    for (size_t i = 1; i < worker_count; ++i) {
+        if (create_worker(worker_process).is_error())
+            break;
+    }
+    return {};
+}
+
+void IORing::worker_main(void* data)
+{
+    LockRefPtr<IORing> ring = adopt_lock_ref(*static_cast<IORing*>(data));
+    for (;;) {
+        Request* request = nullptr;
+        bool closed = false;
+        {
+            SpinlockLocker locker(ring->m_lock);
+            closed = ring->m_closed;
+            if (!closed)
+                request = ring->m_pending_requests.take_first();
+        }
+        if (closed)
+            break;
+        if (!request) {
+            ring->m_work_wait_queue.wait_forever();
+            continue;
+        }
+
+        auto owned_request = adopt_own(*request);
+        owned_request->waiting_for = BlockFlags::None;
+        auto result = ring->execute(*owned_request);
+        if (!result.is_error() && owned_request->waiting_for != BlockFlags::None) {
+            ring->wait_for_file(move(owned_request));
+            continue;
+        }
+        owned_request->result = result.is_error() ? -static_cast<i64>(result.error().code()) : static_cast<i64>(result.value());
+        ring->finish_request(move(owned_request));
+    }
+}
+
+ErrorOr<void> IORing::close()
+{
+    Vector<LockRefPtr<Thread>, worker_count> workers;
+    {
+        SpinlockLocker locker(m_lock);
+        if (m_closed)
+            return {};
+        m_closed = true;
+        workers = move(m_workers);
+    }
+    drop_waiting_requests();
+    m_work_wait_queue.wake_all();
+    // Workers don't wait for files, but may still be blocked inside a read or write, so interrupt those.
+    for (auto& worker : workers)
+        worker->set_should_die();
+    return {};
+}
+
+bool IORing::can_read(OpenFileDescription const&, u64) const
+{
+    SpinlockLocker locker(m_lock);
+    return !m_finished_requests.is_empty();
+}
+
+ErrorOr<NonnullLockRefPtr<Memory::VMObject>> IORing::vmobject_for_mmap(Process&, Memory::VirtualRange const&, u64& offset, bool shared)
+{
+    if (offset != 0 || !shared)
+        return EINVAL;
+    return m_vmobject;
+}
+
+ErrorOr<NonnullOwnPtr<KString>> IORing::pseudo_path(OpenFileDescription const&) const
+{
+    return KString::formatted("IORing:({})", m_entries);
+}
+
+static ErrorOr<size_t> copy_iovecs_from_user(Userspace<iovec const*> user_iovecs, size_t count, Vector<iovec, 1>& iovecs)
+{
+    if (count > IOV_MAX)
+        return EINVAL;
+    TRY(iovecs.try_resize(count));
+    TRY(copy_n_from_user(iovecs.data(), user_iovecs, count));
+
+    // Everything beyond what we're willing to transfer at once is left alone, resulting in a short read or write.
+    size_t total_length = 0;
+    for (size_t i = 0; i < iovecs.size(); ++i) {
+        auto& vec = iovecs[i];
+        if (vec.iov_len > IORing::max_transfer_size - total_length) {
+            vec.iov_len = IORing::max_transfer_size - total_length;
+            iovecs.shrink(i + 1);
+        }
+        total_length += vec.iov_len;
+    }
+    return total_length;
+}
+
+static ErrorOr<void> gather_from_user(ByteBuffer& buffer, Vector<iovec, 1> const& iovecs)
+{
+    size_t offset = 0;
+    for (auto& vec : iovecs) {
+        TRY(copy_from_user(buffer.data() + offset, vec.iov_base, vec.iov_len));
+        offset += vec.iov_len;
+    }
+    return {};
+}
+
+static ErrorOr<void> scatter_to_user(ReadonlyBytes data, Vector<iovec, 1> const& iovecs)
+{
+    for (auto& vec : iovecs) {
+        if (data.is_empty())
+            break;
+        auto chunk_size = min(data.size(), vec.iov_len);
+        TRY(copy_to_user(vec.iov_base, data.data(), chunk_size));
+        data = data.slice(chunk_size);
+    }
+    return {};
+}
+
+ErrorOr<void> IORing::prepare(Process& process, Request& request)
+{
+    auto const& submission = request.submission;
+    request.description = TRY(process.open_file_description(submission.fd));
+    auto& description = *request.description;
+    if (&description.file() == this)
+        return EINVAL;
+
+    switch (submission.opcode) {
+    case IORingOpcode::Read:
+    case IORingOpcode::Readv:
+    case IORingOpcode::Write:
+    case IORingOpcode::Pwritev: {
+        bool is_read = submission.opcode == IORingOpcode::Read || submission.opcode == IORingOpcode::Readv;
+        if (is_read && !description.is_readable())
+            return EBADF;
+        if (is_read && description.is_directory())
+            return EISDIR;
+        if (!is_read && !description.is_writable())
+            return EBADF;
+        // NOTE: A negative offset means "use the current file offset", like pwritev().
+        if (submission.offset >= 0 && !description.file().is_seekable())
+            return EINVAL;
+
+        size_t length = 0;
+        if (submission.opcode == IORingOpcode::Read || submission.opcode == IORingOpcode::Write) {
+            length = min(submission.length, static_cast<u64>(max_transfer_size));
+            TRY(request.iovecs.try_append({ reinterpret_cast<void*>(submission.address), length }));
+        } else {
+            length = TRY(copy_iovecs_from_user(reinterpret_cast<iovec const*>(submission.address), submission.length, request.iovecs));
+        }
+        request.length = length;
+        // NOTE: Reads get their buffer on the worker, once there is something to read.
+        if (!is_read) {
+            request.buffer = TRY(ByteBuffer::create_uninitialized(length));
+            TRY(gather_from_user(request.buffer, request.iovecs));
+        }
+        return {};
+    }
+    case IORingOpcode::Accept4:
+        TRY(process.require_promise(Pledge::accept));
+        if (!description.is_socket())
+            return ENOTSOCK;
+        // Nothing would ever come along to be accepted otherwise.
+        if (description.socket()->role(description) != Socket::Role::Listener)
+            return EINVAL;
+        return {};
+    case IORingOpcode::Recvmsg:
+    case IORingOpcode::Sendmsg: {
+        if (!description.is_socket())
+            return ENOTSOCK;
+        auto& message = request.message;
+        TRY(copy_from_user(&message, reinterpret_cast<msghdr const*>(submission.address)));
+        if (message.msg_iovlen < 0)
+            return EINVAL;
+        // FIXME: Support addresses, for unconnected sockets.
+        if (submission.opcode == IORingOpcode::Sendmsg && message.msg_name)
+            return ENOTSUP;
+        request.length = TRY(copy_iovecs_from_user(message.msg_iov, message.msg_iovlen, request.iovecs));
+        if (submission.opcode == IORingOpcode::Sendmsg) {
+            request.buffer = TRY(ByteBuffer::create_uninitialized(request.length));
+            TRY(gather_from_user(request.buffer, request.iovecs));
+        }
+        return {};
+    }
+    case IORingOpcode::Fsync:
+        return {};
+    }
+    return EINVAL;
+}
+
+ErrorOr<size_t> IORing::execute(Request& request)
+{
+    auto const& submission = request.submission;
+    auto& description = *request.description;
+
+    // Instead of blocking the worker, this puts the request aside until the file changes.
+    auto wait_for = [&](BlockFlags flags) -> ErrorOr<size_t> {
+        request.waiting_for = flags;
+        return 0;
+    };
+
+    switch (submission.opcode) {
+    case IORingOpcode::Read:
+    case IORingOpcode::Readv: {
+        if (request.length == 0)
+            return 0;
+        // NOTE: Non-blocking files report EAGAIN themselves.
+        if (description.is_blocking() && !description.can_read())
+            return wait_for(BlockFlags::Read);
+        request.buffer = TRY(ByteBuffer::create_uninitialized(request.length));
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(request.buffer.data());
+        if (submission.offset >= 0)
+            return description.read(buffer, submission.offset, request.length);
+        return description.read(buffer, request.length);
+    }
+    case IORingOpcode::Write:
+    case IORingOpcode::Pwritev: {
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(request.buffer.data());
+        auto size = request.buffer.size();
+        if (description.should_append() && description.file().is_seekable())
+            TRY(description.seek(0, SEEK_END));
+        while (request.progress < size) {
+            if (!description.can_write()) {
+                if (description.is_blocking())
+                    return wait_for(BlockFlags::Write);
+                if (request.progress > 0)
+                    return request.progress;
+                return EAGAIN;
+            }
+            auto nwritten_or_error = submission.offset >= 0
+                ? description.write(submission.offset + request.progress, buffer.offset(request.progress), size - request.progress)
+                : description.write(buffer.offset(request.progress), size - request.progress);
+            if (nwritten_or_error.is_error()) {
+                if (request.progress > 0)
+                    return request.progress;
+                if (nwritten_or_error.error().code() == EAGAIN)
+                    continue;
+                return nwritten_or_error.release_error();
+            }
+            request.progress += nwritten_or_error.value();
+        }
+        return request.progress;
+    }
+    case IORingOpcode::Accept4: {
+        auto& socket = *description.socket();
+        if (auto accepted_socket = socket.accept()) {
+            auto accepted_description = OpenFileDescription::try_create(*accepted_socket);
+            if (accepted_description.is_error()) {
+                accepted_socket->set_setup_state(Socket::SetupState::Completed);
+                return accepted_description.release_error();
+            }
+            request.accepted_description = accepted_description.release_value();
+            return 0;
+        }
+        if (!description.is_blocking())
+            return EAGAIN;
+        return wait_for(BlockFlags::Accept);
+    }
+    case IORingOpcode::Recvmsg: {
+        auto& socket = *description.socket();
+        if (socket.is_shut_down_for_reading())
+            return 0;
+        bool blocking = (submission.flags & MSG_DONTWAIT) ? false : description.is_blocking();
+        if (blocking && !description.can_read())
+            return wait_for(BlockFlags::Read);
+        request.buffer = TRY(ByteBuffer::create_uninitialized(request.length));
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(request.buffer.data());
+        auto size = request.buffer.size();
+        Time timestamp {};
+        auto nreceived_or_error = socket.recvfrom(description, buffer, size, submission.flags, {}, {}, timestamp, false);
+        if (nreceived_or_error.is_error() && nreceived_or_error.error().code() == EAGAIN && blocking)
+            return wait_for(BlockFlags::Read);
+        auto nreceived = TRY(nreceived_or_error);
+        if (nreceived > size) {
+            request.message_flags |= MSG_TRUNC;
+            nreceived = size;
+        }
+        return nreceived;
+    }
+    case IORingOpcode::Sendmsg: {
+        auto& socket = *description.socket();
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(request.buffer.data());
+        auto size = request.buffer.size();
+        // NOTE: There's nobody to send SIGPIPE to here, so it's as if MSG_NOSIGNAL was always set.
+        if (socket.is_shut_down_for_writing())
+            return EPIPE;
+        if (!description.can_write()) {
+            if (!description.is_blocking())
+                return EAGAIN;
+            return wait_for(BlockFlags::Write);
+        }
+        auto nsent = TRY(socket.sendto(description, buffer, size, submission.flags, {}, 0));
+        if (nsent == 0 && size > 0)
+            return wait_for(BlockFlags::Write);
+        return nsent;
+    }
+    case IORingOpcode::Fsync:
+        TRY(description.sync());
+        return 0;
+    }
+    VERIFY_NOT_REACHED();
+}
+
+void IORing::finish_request(NonnullOwnPtr<Request> request)
+{
+    {
+        SpinlockLocker locker(m_lock);
+        m_finished_requests.append(*request.leak_ptr());
+    }
+    m_completion_wait_queue.wake_all();
+    evaluate_block_conditions();
+}
+
+void IORing::wait_for_file(NonnullOwnPtr<Request> request)
+{
+    // NOTE: The request may be taken by another worker as soon as it's on the list, so hold on to what we need.
+    NonnullLockRefPtr<OpenFileDescription> description = *request->description;
+    auto waiting_for = request->waiting_for;
+    auto& blocker_set = description->blocker_set();
+
+    // NOTE: The request goes on the list in the same step as we register, so that we're never registered
+    //       without a waiting request that close() can find the registration through.
+    bool is_waiting = false;
+    auto result = blocker_set.add_waiting_io_ring({}, *this, [&] {
+        SpinlockLocker locker(m_lock);
+        if (m_closed)
+            return false;
+        m_waiting_requests.append(*request.leak_ptr());
+        is_waiting = true;
+        return true;
+    });
+    if (!is_waiting) {
+        if (result.is_error()) {
+            request->result = -static_cast<i64>(result.error().code());
+            finish_request(move(request));
+        }
+        return;
+    }
+
+    // The file may have become ready before we were registered, in which case nobody is going to tell us.
+    // NOTE: This goes through the blocker set, so that we're unregistered along with being requeued.
+    if (description->should_unblock(waiting_for) != BlockFlags::None)
+        blocker_set.unblock_all_blockers_whose_conditions_are_met();
+}
+
+void IORing::blocker_set_did_change(Badge<FileBlockerSet>, FileBlockerSet& blocker_set)
+{
+    bool requeued_any = false;
+    {
+        SpinlockLocker locker(m_lock);
+        for (auto it = m_waiting_requests.begin(); it != m_waiting_requests.end();) {
+            auto& request = *it;
+            ++it;
+            if (&request.description->blocker_set() != &blocker_set)
+                continue;
+            m_waiting_requests.remove(request);
+            m_pending_requests.append(request);
+            requeued_any = true;
+        }
+    }
+    if (requeued_any)
+        m_work_wait_queue.wake_all();
+}
+
+void IORing::drop_waiting_requests()
+{
+    Request::List requests;
+    {
+        SpinlockLocker locker(m_lock);
+        while (auto* request = m_waiting_requests.take_first())
+            requests.append(*request);
+    }
+    // NOTE: Once we're unregistered, none of the files can tell us about changes anymore, so this can't race with requeueing.
+    while (auto* request = requests.take_first()) {
+        request->description->blocker_set().remove_waiting_io_ring({}, *this);
+        delete request;
+    }
+}
+
+ErrorOr<i64> IORing::finish(Process& process, Request& request)
+{
+    if (request.result < 0)
+        return request.result;
+
+    auto const& submission = request.submission;
+    switch (submission.opcode) {
+    case IORingOpcode::Read:
+    case IORingOpcode::Readv:
+        TRY(scatter_to_user(request.buffer.bytes().trim(request.result), request.iovecs));
+        return request.result;
+    case IORingOpcode::Recvmsg: {
+        TRY(scatter_to_user(request.buffer.bytes().trim(request.result), request.iovecs));
+        auto* user_message = reinterpret_cast<msghdr*>(submission.address);
+        socklen_t zero_length = 0;
+        if (request.message.msg_name)
+            TRY(copy_to_user(&user_message->msg_namelen, &zero_length));
+        TRY(copy_to_user(&user_message->msg_controllen, &zero_length));
+        TRY(copy_to_user(&user_message->msg_flags, &request.message_flags));
+        return request.result;
+    }
+    case IORingOpcode::Accept4: {
+        auto& accepted_socket = *request.accepted_description->socket();
+        // NOTE: The socket was accepted on a worker thread, so make it look like we accepted it ourselves.
+        accepted_socket.set_acceptor(process);
+
+        auto* user_address = reinterpret_cast<sockaddr*>(submission.address);
+        auto* user_address_size = reinterpret_cast<socklen_t*>(submission.address2);
+        if (user_address) {
+            socklen_t address_size = 0;
+            TRY(copy_from_user(&address_size, user_address_size));
+            sockaddr_un address_buffer {};
+            address_size = min(sizeof(sockaddr_un), static_cast<size_t>(address_size));
+            accepted_socket.get_peer_address(reinterpret_cast<sockaddr*>(&address_buffer), &address_size);
+            TRY(copy_to_user(user_address, &address_buffer, address_size));
+            TRY(copy_to_user(user_address_size, &address_size));
+        }
+
+        auto& accepted_socket_description = request.accepted_description;
+        accepted_socket_description->set_readable(true);
+        accepted_socket_description->set_writable(true);
+        if (submission.flags & SOCK_NONBLOCK)
+            accepted_socket_description->set_blocking(false);
+        int fd_flags = 0;
+        if (submission.flags & SOCK_CLOEXEC)
+            fd_flags |= FD_CLOEXEC;
+
+        auto fd = TRY(process.fds().with_exclusive([&](auto& fds) -> ErrorOr<int> {
+            auto fd_allocation = TRY(fds.allocate());
+            fds[fd_allocation.fd].set(*accepted_socket_description, fd_flags);
+            return fd_allocation.fd;
+        }));
+        return fd;
+    }
+    case IORingOpcode::Write:
+    case IORingOpcode::Pwritev:
+    case IORingOpcode::Sendmsg:
+    case IORingOpcode::Fsync:
+        return request.result;
+    }
+    VERIFY_NOT_REACHED();
+}
+
+size_t IORing::post_completions(Process& process)
+{
+    auto& header = this->header();
+    auto const completion_entries = io_ring_completion_entries(m_entries);
+    size_t posted = 0;
+
+    for (;;) {
+        // NOTE: Userspace may have scribbled over the head, in which case we treat the queue as full.
+        auto completion_head = AK::atomic_load(&header.completion_head, AK::memory_order_acquire);
+        if (m_completion_tail - completion_head >= completion_entries)
+            break;
+
+        Request* raw_request = nullptr;
+        {
+            SpinlockLocker locker(m_lock);
+            raw_request = m_finished_requests.take_first();
+        }
+        if (!raw_request)
+            break;
+        auto request = adopt_own(*raw_request);
+
+        auto result = finish(process, *request);
+        auto& completion = completion_at(m_completion_tail);
+        completion.user_data = request->submission.user_data;
+        completion.result = result.is_error() ? -static_cast<i64>(result.error().code()) : result.value();
+        ++m_completion_tail;
+        ++posted;
+
+        SpinlockLocker locker(m_lock);
+        --m_requests_in_flight;
+        m_bytes_in_flight -= request->length;
+    }
+
+    if (posted > 0)
+        AK::atomic_store(&header.completion_tail, m_completion_tail, AK::memory_order_release);
+    return posted;
+}
+
+ErrorOr<size_t> IORing::enter(Process& process, u32 to_submit, u32 min_complete)
+{
+    MutexLocker locker(m_enter_lock);
+    auto& header = this->header();
+    auto const completion_entries = io_ring_completion_entries(m_entries);
+
+    auto submission_tail = AK::atomic_load(&header.submission_tail, AK::memory_order_acquire);
+    if (submission_tail - m_submission_head > m_entries)
+        return EINVAL;
+
+    size_t submitted = 0;
+    while (submitted < to_submit && m_submission_head != submission_tail) {
+        // Never take more requests than we have room for in the completion queue, so that we don't have
+        // to hold on to an unbounded number of finished requests for a process that doesn't collect them.
+        // NOTE: The byte limit can be overshot by the last request taken, which is at most max_transfer_size.
+        bool has_room = false;
+        {
+            SpinlockLocker locker(m_lock);
+            has_room = m_requests_in_flight < completion_entries && m_bytes_in_flight < max_bytes_in_flight;
+        }
+        if (!has_room)
+            break;
+
+        auto request_or_error = adopt_nonnull_own_or_enomem(new (nothrow) Request);
+        if (request_or_error.is_error()) {
+            if (submitted == 0)
+                return request_or_error.release_error();
+            break;
+        }
+        auto request = request_or_error.release_value();
+        // NOTE: Userspace can change the submission at any time, so we only ever look at our own copy of it.
+        request->submission = submission_at(m_submission_head);
+        ++m_submission_head;
+        ++submitted;
+
+        auto result = prepare(process, *request);
+        {
+            SpinlockLocker locker(m_lock);
+            ++m_requests_in_flight;
+            m_bytes_in_flight += request->length;
+        }
+        if (result.is_error()) {
+            request->result = -static_cast<i64>(result.error().code());
+            finish_request(move(request));
+            continue;
+        }
+        {
+            SpinlockLocker locker(m_lock);
+            m_pending_requests.append(*request.leak_ptr());
+        }
+        m_work_wait_queue.wake_one();
+    }
+    AK::atomic_store(&header.submission_head, m_submission_head, AK::memory_order_release);
+
+    size_t completed = post_completions(process);
+    while (completed < min_complete) {
+        // Stop waiting when there is nothing left that could complete, or when there's no room for it.
+        bool can_complete_more = false;
+        {
+            SpinlockLocker locker(m_lock);
+            can_complete_more = m_requests_in_flight > 0;
+        }
+        auto completion_head = AK::atomic_load(&header.completion_head, AK::memory_order_acquire);
+        if (!can_complete_more || m_completion_tail - completion_head >= completion_entries)
+            break;
+
+        if (m_completion_wait_queue.wait_on({}).was_interrupted()) {
+            if (submitted == 0 && completed == 0)
+                return EINTR;
+            break;
+        }
+        completed += post_completions(process);
+    }
+    return submitted;
+}
+
+}
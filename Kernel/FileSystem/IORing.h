@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/IntrusiveList.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Vector.h>
+#include <Kernel/API/IORing.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/Forward.h>
+#include <Kernel/Locking/Mutex.h>
+#include <Kernel/Locking/Spinlock.h>
+#include <Kernel/Memory/AnonymousVMObject.h>
+#include <Kernel/UnixTypes.h>
+#include <Kernel/WaitQueue.h>
+
+namespace Kernel {
+
+// An IORing lets a process hand over batches of I/O requests to the kernel through memory that
+// is shared between the two (see Kernel/API/IORing.h for the layout), instead of making one
+// blocking syscall per request.
+//
+// The requests are carried out by the ring's own kernel worker threads. As those don't run in
+// the address space of the process, io_ring_enter() copies the data that is to be written into
+// kernel buffers when it takes the requests, and copies the data that was read back out when it
+// posts their completions. So completions only show up in the completion queue during
+// io_ring_enter(), but the ring becomes readable as soon as there are some to collect, so it
+// can be waited for with poll() or epoll.
+//
+// Workers never wait for a file to become ready. A request that can't make progress yet is put
+// aside until the file's blocker set tells us that something changed, so a few idle sockets
+// can't hold up the rest of the ring.
+class IORing final : public File {
+public:
+    static constexpr size_t worker_count = 4;
+    // Larger reads and writes are cut short, as they have to go through a kernel buffer.
+    static constexpr size_t max_transfer_size = 1 * MiB;
+    // No more requests are taken once their kernel buffers add up to this much.
+    static constexpr size_t max_bytes_in_flight = 4 * MiB;
+
+    static ErrorOr<NonnullLockRefPtr<IORing>> try_create(u32 entries);
+    virtual ~IORing() override;
+
+    // Takes up to `to_submit` requests from the submission queue, and then waits until `min_complete`
+    // completions have been posted, or until no more can be. Returns the number of requests taken.
+    ErrorOr<size_t> enter(Process&, u32 to_submit, u32 min_complete);
+
+    virtual bool is_io_ring() const override { return true; }
+    virtual ErrorOr<void> close() override;
+    virtual bool can_read(OpenFileDescription const&, u64) const override;
+    virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    virtual bool can_write(OpenFileDescription const&, u64) const override { return false; }
+    virtual ErrorOr<size_t> write(OpenFileDescription&, u64, UserOrKernelBuffer const&, size_t) override { return EINVAL; }
+    virtual ErrorOr<NonnullLockRefPtr<Memory::VMObject>> vmobject_for_mmap(Process&, Memory::VirtualRange const&, u64& offset, bool shared) override;
+
+    virtual ErrorOr<NonnullOwnPtr<KString>> pseudo_path(OpenFileDescription const&) const override;
+    virtual StringView class_name() const override { return "IORing"sv; }
+
+    // Called with the blocker set locked, which also drops our registration with it.
+    void blocker_set_did_change(Badge<FileBlockerSet>, FileBlockerSet&);
+
+private:
+    struct Request {
+        ~Request();
+
+        IORingSubmission submission {};
+        LockRefPtr<OpenFileDescription> description;
+        // How many bytes of kernel buffer this request may use, which counts towards max_bytes_in_flight.
+        size_t length { 0 };
+        // The data to write, or the data that was read. Read buffers are only allocated once the file is ready.
+        ByteBuffer buffer;
+        // How much has been written so far, for writes that had to wait for the file partway through.
+        size_t progress { 0 };
+        // What the file has to become ready for before we try again, if anything.
+        Thread::FileBlocker::BlockFlags waiting_for { Thread::FileBlocker::BlockFlags::None };
+        // Where the data that was read goes, once we're back in the process.
+        Vector<iovec, 1> iovecs;
+        // Our copy of the msghdr for recvmsg and sendmsg.
+        msghdr message {};
+        // The accepted socket gets its description right away, so that it's closed properly if the request
+        // never makes it back to the process.
+        LockRefPtr<OpenFileDescription> accepted_description;
+        i64 result { 0 };
+        int message_flags { 0 };
+        IntrusiveListNode<Request> list_node;
+
+        using List = IntrusiveList<&Request::list_node>;
+    };
+
+    IORing(u32 entries, NonnullLockRefPtr<Memory::AnonymousVMObject>, NonnullOwnPtr<Memory::Region>);
+
+    ErrorOr<void> start_workers();
+    static void worker_main(void*);
+
+    IORingHeader& header() { return *reinterpret_cast<IORingHeader*>(m_region->vaddr().as_ptr()); }
+    IORingSubmission const& submission_at(u32 index) { return reinterpret_cast<IORingSubmission const*>(m_region->vaddr().offset(io_ring_submission_offset()).as_ptr())[index & (m_entries - 1)]; }
+    IORingCompletion& completion_at(u32 index) { return reinterpret_cast<IORingCompletion*>(m_region->vaddr().offset(io_ring_completion_offset(m_entries)).as_ptr())[index & (io_ring_completion_entries(m_entries) - 1)]; }
+
+    // These run in the context of the process that entered the ring.
+    ErrorOr<void> prepare(Process&, Request&);
+    ErrorOr<i64> finish(Process&, Request&);
+    size_t post_completions(Process&);
+
+    // This runs on a worker thread.
+    ErrorOr<size_t> execute(Request&);
+
+    void finish_request(NonnullOwnPtr<Request>);
+    void wait_for_file(NonnullOwnPtr<Request>);
+    void drop_waiting_requests();
+
+    u32 const m_entries { 0 };
+    NonnullLockRefPtr<Memory::AnonymousVMObject> m_vmobject;
+    NonnullOwnPtr<Memory::Region> m_region;
+
+    // Only one thread can enter the ring at a time.
+    Mutex m_enter_lock { "IORing"sv };
+    u32 m_submission_head { 0 };
+    u32 m_completion_tail { 0 };
+
+    mutable Spinlock m_lock { LockRank::None };
+    Request::List m_pending_requests;
+    Request::List m_finished_requests;
+    // Requests that are waiting for their file to become ready. We only stay registered with a file's
+    // blocker set for as long as there is at least one of these for it, which is how close() finds them all.
+    Request::List m_waiting_requests;
+    size_t m_requests_in_flight { 0 };
+    size_t m_bytes_in_flight { 0 };
+    bool m_closed { false };
+    Vector<LockRefPtr<Thread>, worker_count> m_workers;
+
+    WaitQueue m_work_wait_queue;
+    WaitQueue m_completion_wait_queue;
+};
+
+}
@@ -35,6 +35,9 @@ public:
     virtual StringView class_name() const override { return "ISO9660FS"sv; }
     virtual Inode& root_inode() override;
 
+    // NOTE: ISO 9660 file systems are read-only, so their directories never change.
+    virtual bool supports_lookup_caching() const override { return true; }
+
     virtual unsigned total_block_count() const override;
     virtual unsigned total_inode_count() const override;
 
@@ -10,12 +10,15 @@
 #include <AK/StringView.h>
 #include <Kernel/API/InodeWatcherEvent.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/CustodyCache.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/InodeWatcher.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
 #include <Kernel/KBufferBuilder.h>
 #include <Kernel/Library/NonnullLockRefPtrVector.h>
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Memory/PageCache.h>
 #include <Kernel/Memory/SharedInodeVMObject.h>
 #include <Kernel/Net/LocalSocket.h>
 #include <Kernel/Process.h>
@@ -110,13 +113,107 @@ ErrorOr<size_t> Inode::write_bytes(off_t offset, size_t length, UserOrKernelBuff
 {
     MutexLocker locker(m_inode_lock);
     TRY(prepare_to_write_data());
-    return write_bytes_locked(offset, length, target_buffer, open_description);
+    auto vmobject = shared_vmobject();
+    if (!vmobject)
+        return write_bytes_locked(offset, length, target_buffer, open_description);
+
+    // NOTE: The data may change while we're writing it (if it lives in userspace), so both the inode and the page cache
+    //       get theirs from one copy of it. The cache is updated before we let go of the inode lock, so nobody can read
+    //       the old data back into it.
+    u8 chunk_buffer[PAGE_SIZE];
+    size_t nwritten = 0;
+    while (nwritten < length) {
+        auto position = offset + nwritten;
+        size_t chunk_size = min(PAGE_SIZE - position % PAGE_SIZE, length - nwritten);
+        auto chunk_nwritten_or_error = [&]() -> ErrorOr<size_t> {
+            TRY(target_buffer.read(chunk_buffer, nwritten, chunk_size));
+            auto chunk = UserOrKernelBuffer::for_kernel_buffer(chunk_buffer);
+            return write_bytes_locked(position, chunk_size, chunk, open_description);
+        }();
+        if (chunk_nwritten_or_error.is_error()) {
+            if (nwritten > 0)
+                break;
+            return chunk_nwritten_or_error.release_error();
+        }
+        auto chunk_nwritten = chunk_nwritten_or_error.release_value();
+        vmobject->did_write(position, { chunk_buffer, chunk_nwritten });
+        nwritten += chunk_nwritten;
+        if (chunk_nwritten < chunk_size)
+            break;
+    }
+    return nwritten;
 }
 
 ErrorOr<size_t> Inode::read_bytes(off_t offset, size_t length, UserOrKernelBuffer& buffer, OpenFileDescription* open_description) const
+{
+    if (is_page_cacheable() && !(open_description && open_description->is_direct())) {
+        // NOTE: Empty files don't get a VMObject, there is nothing to cache for them anyway.
+        if (auto vmobject_or_error = Memory::PageCache::the().vmobject_for(const_cast<Inode&>(*this)); !vmobject_or_error.is_error()) {
+            auto vmobject = vmobject_or_error.release_value();
+            auto nread = TRY(read_bytes_through_page_cache(*vmobject, offset, length, buffer));
+            note_read(offset, nread, open_description, vmobject.ptr());
+            return nread;
+        }
+    }
+
+    size_t nread = 0;
+    {
+        MutexLocker locker(m_inode_lock, Mutex::Mode::Shared);
+        nread = TRY(read_bytes_locked(offset, length, buffer, open_description));
+    }
+    note_read(offset, nread, open_description, nullptr);
+    return nread;
+}
+
+ErrorOr<size_t> Inode::read_bytes_for_page_cache(off_t offset, size_t length, UserOrKernelBuffer& buffer) const
 {
     MutexLocker locker(m_inode_lock, Mutex::Mode::Shared);
-    return read_bytes_locked(offset, length, buffer, open_description);
+    return read_bytes_locked(offset, length, buffer, nullptr);
+}
+
+ErrorOr<size_t> Inode::read_bytes_through_page_cache(Memory::SharedInodeVMObject& vmobject, off_t offset, size_t length, UserOrKernelBuffer& buffer) const
+{
+    VERIFY(offset >= 0);
+    auto file_size = static_cast<off_t>(size());
+    if (offset >= file_size)
+        return 0;
+    length = min(length, static_cast<size_t>(file_size - offset));
+
+    size_t nread = 0;
+    while (nread < length) {
+        auto position = offset + nread;
+        auto page_index = position / PAGE_SIZE;
+        if (page_index >= vmobject.page_count()) {
+            // The file has grown since its VMObject was created, read the rest directly.
+            auto buffer_offset = buffer.offset(nread);
+            MutexLocker locker(m_inode_lock, Mutex::Mode::Shared);
+            nread += TRY(read_bytes_locked(position, length - nread, buffer_offset, nullptr));
+            break;
+        }
+
+        auto physical_page = TRY(vmobject.ensure_page(page_index));
+        if (!physical_page)
+            break;
+
+        size_t offset_in_page = position % PAGE_SIZE;
+        size_t chunk_size = min(PAGE_SIZE - offset_in_page, length - nread);
+        TRY(Memory::SharedInodeVMObject::copy_from_page(*physical_page, offset_in_page, buffer, nread, chunk_size));
+        nread += chunk_size;
+    }
+    return nread;
+}
+
+void Inode::note_read(off_t offset, size_t nread, OpenFileDescription* open_description, Memory::SharedInodeVMObject* vmobject) const
+{
+    if (!open_description || open_description->is_direct() || nread == 0)
+        return;
+    auto read_ahead_range = open_description->note_read_for_read_ahead(offset, nread);
+    if (!read_ahead_range.has_value())
+        return;
+    // There's no point in reading ahead what's already in the page cache.
+    if (vmobject && vmobject->has_all_pages_in_range(read_ahead_range->offset, read_ahead_range->size))
+        return;
+    read_ahead(read_ahead_range->offset, read_ahead_range->size);
 }
 
 ErrorOr<void> Inode::update_timestamps([[maybe_unused]] Optional<Time> atime, [[maybe_unused]] Optional<Time> ctime, [[maybe_unused]] Optional<Time> mtime)
@@ -217,6 +314,8 @@ void Inode::set_metadata_dirty(bool metadata_dirty)
 
 void Inode::did_add_child(InodeIdentifier, StringView name)
 {
+    CustodyCache::the().invalidate(*this, name);
+
     m_watchers.for_each([&](auto& watcher) {
         watcher->notify_inode_event({}, identifier(), InodeWatcherEvent::Type::ChildCreated, name);
     });
@@ -224,6 +323,8 @@ void Inode::did_add_child(InodeIdentifier, StringView name)
 
 void Inode::did_remove_child(InodeIdentifier, StringView name)
 {
+    CustodyCache::the().invalidate(*this, name);
+
     if (name == "." || name == "..") {
         // These are just aliases and are not interesting to userspace.
         return;
@@ -58,6 +58,11 @@ public:
     ErrorOr<size_t> write_bytes(off_t, size_t, UserOrKernelBuffer const& data, OpenFileDescription*);
     ErrorOr<size_t> read_bytes(off_t, size_t, UserOrKernelBuffer& buffer, OpenFileDescription*) const;
 
+    // Whether regular reads and writes go through the page cache.
+    virtual bool is_page_cacheable() const { return false; }
+    // Used by the page cache to fill its pages, which shouldn't also end up in a lower-level cache.
+    virtual ErrorOr<size_t> read_bytes_for_page_cache(off_t, size_t, UserOrKernelBuffer& buffer) const;
+
     virtual ErrorOr<void> attach(OpenFileDescription&) { return {}; }
     virtual void detach(OpenFileDescription&) { }
     virtual void did_seek(OpenFileDescription&, off_t) { }
@@ -124,8 +129,13 @@ protected:
 
     virtual ErrorOr<size_t> write_bytes_locked(off_t, size_t, UserOrKernelBuffer const& data, OpenFileDescription*) = 0;
     virtual ErrorOr<size_t> read_bytes_locked(off_t, size_t, UserOrKernelBuffer& buffer, OpenFileDescription*) const = 0;
+    // Starts reading the given range in the background, in anticipation of it being read soon.
+    virtual void read_ahead(off_t, size_t) const { }
 
 private:
+    ErrorOr<size_t> read_bytes_through_page_cache(Memory::SharedInodeVMObject&, off_t, size_t, UserOrKernelBuffer& buffer) const;
+    void note_read(off_t, size_t, OpenFileDescription*, Memory::SharedInodeVMObject*) const;
+
     ErrorOr<bool> try_apply_flock(Process const&, OpenFileDescription const&, flock const&);
 
     FileSystem& m_file_system;
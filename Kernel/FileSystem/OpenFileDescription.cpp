@@ -9,7 +9,9 @@
 #include <Kernel/API/POSIX/errno.h>
 #include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/EPoll.h>
 #include <Kernel/FileSystem/FIFO.h>
+#include <Kernel/FileSystem/IORing.h>
 #include <Kernel/FileSystem/InodeFile.h>
 #include <Kernel/FileSystem/InodeWatcher.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
@@ -52,6 +54,7 @@ OpenFileDescription::OpenFileDescription(File& file)
 
 OpenFileDescription::~OpenFileDescription()
 {
+    blocker_set().remove_epoll_watches_for_description({}, *this);
     m_file->detach(*this);
     if (is_fifo())
         static_cast<FIFO*>(m_file.ptr())->detach(fifo_direction());
@@ -328,6 +331,37 @@ InodeWatcher* OpenFileDescription::inode_watcher()
     return static_cast<InodeWatcher*>(m_file.ptr());
 }
 
+bool OpenFileDescription::is_epoll() const
+{
+    return m_file->is_epoll();
+}
+
+EPoll const* OpenFileDescription::epoll() const
+{
+    if (!is_epoll())
+        return nullptr;
+    return static_cast<EPoll const*>(m_file.ptr());
+}
+
+EPoll* OpenFileDescription::epoll()
+{
+    if (!is_epoll())
+        return nullptr;
+    return static_cast<EPoll*>(m_file.ptr());
+}
+
+bool OpenFileDescription::is_io_ring() const
+{
+    return m_file->is_io_ring();
+}
+
+IORing* OpenFileDescription::io_ring()
+{
+    if (!is_io_ring())
+        return nullptr;
+    return static_cast<IORing*>(m_file.ptr());
+}
+
 bool OpenFileDescription::is_master_pty() const
 {
     return m_file->is_master_pty();
@@ -539,6 +573,34 @@ off_t OpenFileDescription::offset() const
     return m_state.with([](auto& state) { return state.current_offset; });
 }
 
+static constexpr size_t minimum_read_ahead_window = 16 * KiB;
+static constexpr size_t maximum_read_ahead_window = 256 * KiB;
+
+Optional<OpenFileDescription::ReadAheadRange> OpenFileDescription::note_read_for_read_ahead(off_t offset, size_t nread)
+{
+    return m_state.with([&](auto& state) -> Optional<ReadAheadRange> {
+        if (offset != state.read_ahead_next_offset) {
+            // Not a sequential read, start over.
+            state.read_ahead_next_offset = offset + nread;
+            state.read_ahead_end = 0;
+            state.read_ahead_window = 0;
+            return {};
+        }
+
+        state.read_ahead_next_offset = offset + nread;
+        state.read_ahead_window = state.read_ahead_window == 0 ? minimum_read_ahead_window : min(state.read_ahead_window * 2, maximum_read_ahead_window);
+
+        // Only issue more once the reader has consumed half of what was already requested.
+        auto requested_ahead = state.read_ahead_end - state.read_ahead_next_offset;
+        if (requested_ahead > 0 && static_cast<size_t>(requested_ahead) >= state.read_ahead_window / 2)
+            return {};
+
+        auto start = max(state.read_ahead_end, state.read_ahead_next_offset);
+        state.read_ahead_end = state.read_ahead_next_offset + state.read_ahead_window;
+        return ReadAheadRange { start, static_cast<size_t>(state.read_ahead_end - start) };
+    });
+}
+
 RefPtr<Custody const> OpenFileDescription::custody() const
 {
     return m_state.with([](auto& state) { return state.custody; });
@@ -82,6 +82,13 @@ public:
     InodeWatcher const* inode_watcher() const;
     InodeWatcher* inode_watcher();
 
+    bool is_epoll() const;
+    EPoll const* epoll() const;
+    EPoll* epoll();
+
+    bool is_io_ring() const;
+    IORing* io_ring();
+
     bool is_master_pty() const;
     MasterPTY const* master_pty() const;
     MasterPTY* master_pty();
@@ -122,6 +129,13 @@ public:
 
     off_t offset() const;
 
+    struct ReadAheadRange {
+        off_t offset { 0 };
+        size_t size { 0 };
+    };
+    // Notes a completed read, and returns what should be read ahead if the reads so far look sequential.
+    Optional<ReadAheadRange> note_read_for_read_ahead(off_t offset, size_t nread);
+
     ErrorOr<void> chown(Credentials const& credentials, UserID, GroupID);
 
     FileBlockerSet& blocker_set();
@@ -147,6 +161,9 @@ private:
         OwnPtr<OpenFileDescriptionData> data;
         RefPtr<Custody> custody;
         off_t current_offset { 0 };
+        off_t read_ahead_next_offset { 0 };
+        off_t read_ahead_end { 0 };
+        size_t read_ahead_window { 0 };
         u32 file_flags { 0 };
         bool readable : 1 { false };
         bool writable : 1 { false };
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonObjectSerializer.h>
+#include <Kernel/FileSystem/CustodyCache.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/CustodyCacheStatistics.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSCustodyCacheStatistics::SysFSCustodyCacheStatistics(SysFSDirectory const& parent_directory)
+    : SysFSGlobalInformation(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullLockRefPtr<SysFSCustodyCacheStatistics> SysFSCustodyCacheStatistics::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_lock_ref_if_nonnull(new (nothrow) SysFSCustodyCacheStatistics(parent_directory)).release_nonnull();
+}
+
+ErrorOr<void> SysFSCustodyCacheStatistics::try_generate(KBufferBuilder& builder)
+{
+    auto stats = CustodyCache::the().statistics();
+
+    auto json = TRY(JsonObjectSerializer<>::try_create(builder));
+    TRY(json.add("entries"sv, stats.entries));
+    TRY(json.add("hits"sv, stats.hits));
+    TRY(json.add("negative_hits"sv, stats.negative_hits));
+    TRY(json.add("misses"sv, stats.misses));
+    TRY(json.add("invalidations"sv, stats.invalidations));
+    TRY(json.finish());
+    return {};
+}
+
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonObjectSerializer.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/KmallocStatistics.h>
+#include <Kernel/Heap/kmalloc.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSKmallocStatistics::SysFSKmallocStatistics(SysFSDirectory const& parent_directory)
+    : SysFSGlobalInformation(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullLockRefPtr<SysFSKmallocStatistics> SysFSKmallocStatistics::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_lock_ref_if_nonnull(new (nothrow) SysFSKmallocStatistics(parent_directory)).release_nonnull();
+}
+
+ErrorOr<void> SysFSKmallocStatistics::try_generate(KBufferBuilder& builder)
+{
+    kmalloc_slabheap_stats stats[kmalloc_slabheap_count];
+    get_kmalloc_slabheap_stats(stats);
+
+    auto array = TRY(JsonArraySerializer<>::try_create(builder));
+    for (auto const& slabheap_stats : stats) {
+        auto obj = TRY(array.add_object());
+        TRY(obj.add("slab_size"sv, slabheap_stats.slab_size));
+        TRY(obj.add("magazine_allocation_hits"sv, slabheap_stats.magazine_allocation_hit_count));
+        TRY(obj.add("magazine_allocation_misses"sv, slabheap_stats.magazine_allocation_miss_count));
+        TRY(obj.add("magazine_free_hits"sv, slabheap_stats.magazine_free_hit_count));
+        TRY(obj.add("magazine_free_misses"sv, slabheap_stats.magazine_free_miss_count));
+        TRY(obj.finish());
+    }
+    TRY(array.finish());
+    return {};
+}
+
+}
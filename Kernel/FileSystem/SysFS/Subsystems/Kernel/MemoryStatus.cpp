@@ -6,6 +6,7 @@
 
 #include <AK/JsonObjectSerializer.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/MemoryStatus.h>
+#include <Kernel/Memory/CompressedPagePool.h>
 #include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Sections.h>
 
@@ -35,6 +36,8 @@ ErrorOr<void> SysFSMemoryStatus::try_generate(KBufferBuilder& builder)
     TRY(json.add("physical_available"sv, system_memory.physical_pages - system_memory.physical_pages_used));
     TRY(json.add("physical_committed"sv, system_memory.physical_pages_committed));
     TRY(json.add("physical_uncommitted"sv, system_memory.physical_pages_uncommitted));
+    TRY(json.add("compressed_pages"sv, Memory::CompressedPagePool::the().page_count()));
+    TRY(json.add("compressed_bytes"sv, Memory::CompressedPagePool::the().compressed_size()));
     TRY(json.add("kmalloc_call_count"sv, stats.kmalloc_call_count));
     TRY(json.add("kfree_call_count"sv, stats.kfree_call_count));
     TRY(json.finish());
@@ -41,6 +41,14 @@ ErrorOr<void> SysFSNetworkTCPStats::try_generate(KBufferBuilder& builder)
         TRY(obj.add("bytes_in"sv, socket.bytes_in()));
         TRY(obj.add("packets_out"sv, socket.packets_out()));
         TRY(obj.add("bytes_out"sv, socket.bytes_out()));
+        TRY(obj.add("mss"sv, socket.mss()));
+        TRY(obj.add("sack_permitted"sv, socket.is_sack_permitted()));
+        TRY(obj.add("congestion_state"sv, TCPSocket::to_string(socket.congestion_state())));
+        TRY(obj.add("congestion_window"sv, socket.congestion_window()));
+        TRY(obj.add("slow_start_threshold"sv, socket.slow_start_threshold()));
+        TRY(obj.add("retransmitted_segments"sv, socket.retransmitted_segments()));
+        TRY(obj.add("fast_retransmits"sv, socket.fast_retransmits()));
+        TRY(obj.add("retransmit_timeouts"sv, socket.retransmit_timeouts()));
         auto current_process_credentials = Process::current().credentials();
         if (current_process_credentials->is_superuser() || current_process_credentials->uid() == socket.origin_uid()) {
             TRY(obj.add("origin_pid"sv, socket.origin_pid().value()));
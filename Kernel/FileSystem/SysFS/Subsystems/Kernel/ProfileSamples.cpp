@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <AK/JsonObjectSerializer.h>
+#include <Kernel/Arch/Processor.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/ProfileSamples.h>
+#include <Kernel/KBufferBuilder.h>
+#include <Kernel/PerformanceSampleRing.h>
+#include <Kernel/Process.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+struct SysFSProfileSamplesData : public OpenFileDescriptionData {
+    // The sequence number of the next sample to read from each processor's ring.
+    Array<u64, MAX_CPU_COUNT> cursors {};
+};
+
+UNMAP_AFTER_INIT SysFSProfileSamples::SysFSProfileSamples(SysFSDirectory const& parent_directory)
+    : SysFSComponent(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullLockRefPtr<SysFSProfileSamples> SysFSProfileSamples::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_lock_ref_if_nonnull(new (nothrow) SysFSProfileSamples(parent_directory)).release_nonnull();
+}
+
+mode_t SysFSProfileSamples::permissions() const
+{
+    return S_IRUSR;
+}
+
+ErrorOr<void> SysFSProfileSamples::refresh_data(OpenFileDescription& description) const
+{
+    TRY(Process::current().jail().with([&](auto& my_jail) -> ErrorOr<void> {
+        if (my_jail)
+            return Error::from_errno(EPERM);
+        return {};
+    }));
+
+    MutexLocker locker(m_lock);
+    // NOTE: This is also called when seeking back to the start, but we're a stream, so keep our position.
+    if (description.data())
+        return {};
+    auto data = TRY(adopt_nonnull_own_or_enomem(new (nothrow) SysFSProfileSamplesData));
+    for (u32 processor_id = 0; processor_id < Processor::count(); ++processor_id) {
+        // Start out with whatever is still in the ring.
+        if (auto* ring = PerformanceSampleRing::for_processor(processor_id)) {
+            auto head = ring->head();
+            data->cursors[processor_id] = head > PerformanceSampleRing::capacity ? head - PerformanceSampleRing::capacity : 0;
+        }
+    }
+    description.data() = move(data);
+    return {};
+}
+
+static ErrorOr<void> append_sample(KBufferBuilder& builder, u32 processor_id, PerformanceSampleRing::Sample const& sample, u64 lost_samples)
+{
+    auto object = TRY(JsonObjectSerializer<>::try_create(builder));
+    TRY(object.add("cpu"sv, processor_id));
+    TRY(object.add("pid"sv, sample.pid));
+    TRY(object.add("tid"sv, sample.tid));
+    TRY(object.add("timestamp"sv, sample.timestamp));
+    TRY(object.add("lost_samples"sv, lost_samples));
+    auto stack_array = TRY(object.add_array("stack"sv));
+    for (size_t i = 0; i < sample.stack_size; ++i)
+        TRY(stack_array.add(sample.stack[i]));
+    TRY(stack_array.finish());
+    TRY(object.finish());
+    TRY(builder.append('\n'));
+    return {};
+}
+
+ErrorOr<size_t> SysFSProfileSamples::read_bytes(off_t, size_t count, UserOrKernelBuffer& buffer, OpenFileDescription* description) const
+{
+    if (!description || !description->data())
+        return Error::from_errno(EIO);
+
+    MutexLocker locker(m_lock);
+    auto& cursors = static_cast<SysFSProfileSamplesData&>(*description->data()).cursors;
+
+    auto builder = TRY(KBufferBuilder::try_create());
+    // The length of the whole lines that fit into the caller's buffer.
+    size_t length = 0;
+    bool buffer_is_full = false;
+    PerformanceSampleRing::Sample sample;
+
+    for (u32 processor_id = 0; processor_id < Processor::count() && !buffer_is_full; ++processor_id) {
+        auto* ring = PerformanceSampleRing::for_processor(processor_id);
+        if (!ring)
+            continue;
+        auto& cursor = cursors[processor_id];
+        u64 lost_samples = 0;
+        for (auto head = ring->head(); cursor < head;) {
+            if (head - cursor > PerformanceSampleRing::capacity) {
+                lost_samples += head - cursor - PerformanceSampleRing::capacity;
+                cursor = head - PerformanceSampleRing::capacity;
+            }
+            if (!ring->try_copy(cursor, sample)) {
+                ++lost_samples;
+                ++cursor;
+                continue;
+            }
+            TRY(append_sample(builder, processor_id, sample, lost_samples));
+            if (builder.length() > count) {
+                buffer_is_full = true;
+                break;
+            }
+            length = builder.length();
+            lost_samples = 0;
+            ++cursor;
+        }
+    }
+
+    // A single sample doesn't fit, so the caller would never make any progress.
+    if (length == 0 && buffer_is_full)
+        return Error::from_errno(EINVAL);
+    if (length == 0)
+        return 0;
+    TRY(buffer.write(builder.bytes().data(), length));
+    return length;
+}
+
+}
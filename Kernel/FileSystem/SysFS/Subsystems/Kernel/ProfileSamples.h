@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+#include <Kernel/FileSystem/SysFS/Component.h>
+#include <Kernel/Library/LockRefPtr.h>
+#include <Kernel/Locking/Mutex.h>
+#include <Kernel/UserOrKernelBuffer.h>
+
+namespace Kernel {
+
+// Unlike the other nodes in this directory, this one is not a snapshot: every read returns
+// (as many whole lines as fit of) the continuous profiling samples that were taken since the
+// previous read through the same file description, and 0 when there are none.
+class SysFSProfileSamples final : public SysFSComponent {
+public:
+    virtual StringView name() const override { return "profile_samples"sv; }
+
+    static NonnullLockRefPtr<SysFSProfileSamples> must_create(SysFSDirectory const& parent_directory);
+
+private:
+    explicit SysFSProfileSamples(SysFSDirectory const& parent_directory);
+
+    virtual mode_t permissions() const override;
+    virtual ErrorOr<size_t> read_bytes(off_t, size_t, UserOrKernelBuffer&, OpenFileDescription*) const override;
+    virtual ErrorOr<void> refresh_data(OpenFileDescription&) const override;
+
+    mutable Mutex m_lock;
+};
+
+}
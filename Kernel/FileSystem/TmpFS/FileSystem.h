@@ -24,6 +24,7 @@ public:
     virtual StringView class_name() const override { return "TmpFS"sv; }
 
     virtual bool supports_watchers() const override { return true; }
+    virtual bool supports_lookup_caching() const override { return true; }
 
     virtual Inode& root_inode() override;
 
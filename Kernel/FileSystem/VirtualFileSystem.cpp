@@ -14,6 +14,7 @@
 #include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/Devices/DeviceManagement.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/CustodyCache.h>
 #include <Kernel/FileSystem/FileBackedFileSystem.h>
 #include <Kernel/FileSystem/FileSystem.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
@@ -63,7 +64,7 @@ bool VirtualFileSystem::mount_point_exists_at_inode(InodeIdentifier inode_identi
 ErrorOr<void> VirtualFileSystem::mount(FileSystem& fs, Custody& mount_point, int flags)
 {
     auto new_mount = TRY(adopt_nonnull_own_or_enomem(new (nothrow) Mount(fs, &mount_point, flags)));
-    return m_mounts.with([&](auto& mounts) -> ErrorOr<void> {
+    TRY(m_mounts.with([&](auto& mounts) -> ErrorOr<void> {
         auto& inode = mount_point.inode();
         dbgln("VirtualFileSystem: FileSystemID {}, Mounting {} at inode {} with flags {}",
             fs.fsid(),
@@ -83,13 +84,17 @@ ErrorOr<void> VirtualFileSystem::mount(FileSystem& fs, Custody& mount_point, int
         // deleted after being added.
         mounts.append(*new_mount.leak_ptr());
         return {};
-    });
+    }));
+
+    // Paths that used to end at the mount point now continue into the mounted file system.
+    CustodyCache::the().invalidate_all();
+    return {};
 }
 
 ErrorOr<void> VirtualFileSystem::bind_mount(Custody& source, Custody& mount_point, int flags)
 {
     auto new_mount = TRY(adopt_nonnull_own_or_enomem(new (nothrow) Mount(source.inode(), mount_point, flags)));
-    return m_mounts.with([&](auto& mounts) -> ErrorOr<void> {
+    TRY(m_mounts.with([&](auto& mounts) -> ErrorOr<void> {
         auto& inode = mount_point.inode();
         dbgln("VirtualFileSystem: Bind-mounting inode {} at inode {}", source.inode().identifier(), inode.identifier());
         if (mount_point_exists_at_inode(inode.identifier())) {
@@ -102,7 +107,10 @@ ErrorOr<void> VirtualFileSystem::bind_mount(Custody& source, Custody& mount_poin
         // deleted after being added.
         mounts.append(*new_mount.leak_ptr());
         return {};
-    });
+    }));
+
+    CustodyCache::the().invalidate_all();
+    return {};
 }
 
 ErrorOr<void> VirtualFileSystem::remount(Custody& mount_point, int new_flags)
@@ -114,6 +122,8 @@ ErrorOr<void> VirtualFileSystem::remount(Custody& mount_point, int new_flags)
         return ENODEV;
 
     mount->set_flags(new_flags);
+    // Cached custodies below the mount point still carry the old flags.
+    CustodyCache::the().invalidate_all();
     return {};
 }
 
@@ -147,7 +157,10 @@ ErrorOr<void> VirtualFileSystem::unmount(Custody& mountpoint_custody)
     auto custody_path = TRY(mountpoint_custody.try_serialize_absolute_path());
     dbgln("VirtualFileSystem: unmount called with inode {} on mountpoint {}", guest_inode.identifier(), custody_path->view());
 
-    return m_mounts.with([&](auto& mounts) -> ErrorOr<void> {
+    // Cached custodies keep their inodes alive, which would keep the file system busy.
+    CustodyCache::the().invalidate_all();
+
+    TRY(m_mounts.with([&](auto& mounts) -> ErrorOr<void> {
         for (auto& mount : mounts) {
             if (&mount.guest() != &guest_inode)
                 continue;
@@ -182,7 +195,10 @@ ErrorOr<void> VirtualFileSystem::unmount(Custody& mountpoint_custody)
         }
         dbgln("VirtualFileSystem: Nothing mounted on inode {}", guest_inode.identifier());
         return ENODEV;
-    });
+    }));
+
+    CustodyCache::the().invalidate_all();
+    return {};
 }
 
 ErrorOr<void> VirtualFileSystem::mount_root(FileSystem& fs)
@@ -1053,30 +1069,45 @@ ErrorOr<NonnullRefPtr<Custody>> VirtualFileSystem::resolve_path_without_veil(Cre
         }
 
         // Okay, let's look up this part.
-        auto child_or_error = parent.inode().lookup(part);
-        if (child_or_error.is_error()) {
-            if (out_parent) {
-                // ENOENT with a non-null parent custody signals to caller that
-                // we found the immediate parent of the file, but the file itself
-                // does not exist yet.
-                *out_parent = have_more_parts ? nullptr : &parent;
+        auto& custody_cache = CustodyCache::the();
+        if (auto cached_child = custody_cache.lookup(parent, part); cached_child.has_value()) {
+            if (!cached_child.value()) {
+                if (out_parent)
+                    *out_parent = have_more_parts ? nullptr : &parent;
+                return ENOENT;
             }
-            return child_or_error.release_error();
-        }
-        auto child_inode = child_or_error.release_value();
+            custody = cached_child.release_value().release_nonnull();
+        } else {
+            auto cache_generation = custody_cache.generation();
+            auto child_or_error = parent.inode().lookup(part);
+            if (child_or_error.is_error()) {
+                if (child_or_error.error().code() == ENOENT)
+                    custody_cache.add(parent, part, nullptr, cache_generation);
+                if (out_parent) {
+                    // ENOENT with a non-null parent custody signals to caller that
+                    // we found the immediate parent of the file, but the file itself
+                    // does not exist yet.
+                    *out_parent = have_more_parts ? nullptr : &parent;
+                }
+                return child_or_error.release_error();
+            }
+            auto child_inode = child_or_error.release_value();
 
-        int mount_flags_for_child = parent.mount_flags();
+            int mount_flags_for_child = parent.mount_flags();
 
-        // See if there's something mounted on the child; in that case
-        // we would need to return the guest inode, not the host inode.
-        if (auto mount = find_mount_for_host(child_inode->identifier())) {
-            child_inode = mount->guest();
-            mount_flags_for_child = mount->flags();
-        }
+            // See if there's something mounted on the child; in that case
+            // we would need to return the guest inode, not the host inode.
+            if (auto mount = find_mount_for_host(child_inode->identifier())) {
+                child_inode = mount->guest();
+                mount_flags_for_child = mount->flags();
+            }
 
-        custody = TRY(Custody::try_create(&parent, part, *child_inode, mount_flags_for_child));
+            custody = TRY(Custody::try_create(&parent, part, *child_inode, mount_flags_for_child));
+            custody_cache.add(parent, part, custody, cache_generation);
+        }
+        auto& child_inode = custody->inode();
 
-        if (child_inode->metadata().is_symlink()) {
+        if (child_inode.metadata().is_symlink()) {
             if (!have_more_parts) {
                 if (options & O_NOFOLLOW)
                     return ELOOP;
@@ -1084,12 +1115,12 @@ ErrorOr<NonnullRefPtr<Custody>> VirtualFileSystem::resolve_path_without_veil(Cre
                     break;
             }
 
-            if (!safe_to_follow_symlink(credentials, *child_inode, parent_metadata))
+            if (!safe_to_follow_symlink(credentials, child_inode, parent_metadata))
                 return EACCES;
 
             TRY(validate_path_against_process_veil(*custody, options));
 
-            auto symlink_target = TRY(child_inode->resolve_as_link(credentials, parent, out_parent, options, symlink_recursion_level + 1));
+            auto symlink_target = TRY(child_inode.resolve_as_link(credentials, parent, out_parent, options, symlink_recursion_level + 1));
             if (!have_more_parts)
                 return symlink_target;
 
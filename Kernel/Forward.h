@@ -19,12 +19,15 @@ class Custody;
 class Device;
 class DiskCache;
 class DoubleBuffer;
+class EPoll;
+class EPollWatch;
 class File;
 class FATInode;
 class OpenFileDescription;
 class DisplayConnector;
 class FileSystem;
 class FutexQueue;
+class IORing;
 class IPv4Socket;
 class Inode;
 class InodeIdentifier;
@@ -37,6 +40,7 @@ class Mutex;
 class MasterPTY;
 class Mount;
 class PerformanceEventBuffer;
+class PipeBuffer;
 class ProcFS;
 class ProcFSDirectoryInode;
 class ProcFSExposedComponent;
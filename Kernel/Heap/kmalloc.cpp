@@ -10,6 +10,7 @@
 #include <Kernel/Debug.h>
 #include <Kernel/Heap/Heap.h>
 #include <Kernel/Heap/kmalloc.h>
+#include <Kernel/InterruptDisabler.h>
 #include <Kernel/KSyms.h>
 #include <Kernel/Locking/Spinlock.h>
 #include <Kernel/Memory/MemoryManager.h>
@@ -396,7 +397,7 @@ struct KmallocGlobalData {
 
     KmallocSubheap::List subheaps;
 
-    KmallocSlabheap slabheaps[6] = { 16, 32, 64, 128, 256, 512 };
+    KmallocSlabheap slabheaps[kmalloc_slabheap_count] = { 16, 32, 64, 128, 256, 512 };
 
     bool expansion_in_progress { false };
 };
@@ -409,9 +410,135 @@ static size_t g_kfree_call_count;
 static size_t g_nested_kfree_calls;
 bool g_dump_kmalloc_stacks;
 
+// Every processor keeps a magazine of free slabs in front of each slabheap, so most small
+// allocations and frees don't have to take the global kmalloc lock. Magazines are refilled
+// from and flushed back to the slabheaps half a magazine at a time.
+struct KmallocMagazine {
+    static constexpr size_t capacity = 32;
+    static constexpr size_t batch_size = capacity / 2;
+
+    void* slabs[capacity];
+    size_t count;
+
+    size_t allocation_hit_count;
+    size_t allocation_miss_count;
+    size_t free_hit_count;
+    size_t free_miss_count;
+};
+
+struct KmallocProcessorData {
+    KmallocMagazine magazines[kmalloc_slabheap_count];
+    size_t kmalloc_call_count;
+    size_t kfree_call_count;
+};
+
+// NOTE: These are used before global constructors run, so they must not need one.
+static KmallocProcessorData s_processor_data[MAX_CPU_COUNT];
+static bool s_magazines_enabled;
+
 void kmalloc_enable_expand()
 {
     g_kmalloc_global->enable_expansion();
+    s_magazines_enabled = true;
+}
+
+static Optional<size_t> slabheap_index_for(size_t size, size_t alignment)
+{
+    for (size_t i = 0; i < kmalloc_slabheap_count; ++i) {
+        auto slab_size = g_kmalloc_global->slabheaps[i].slab_size();
+        if (size <= slab_size && alignment <= slab_size)
+            return i;
+    }
+    return {};
+}
+
+// NOTE: Interrupts have to be disabled, so we stay on the same processor while using its data.
+static KmallocProcessorData* current_processor_data()
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    if (!s_magazines_enabled || !Processor::is_initialized())
+        return nullptr;
+    return &s_processor_data[Processor::current_id()];
+}
+
+static void* try_allocate_from_magazine(size_t size, size_t alignment, CallerWillInitializeMemory caller_will_initialize_memory)
+{
+    auto slabheap_index = slabheap_index_for(size, alignment);
+    if (!slabheap_index.has_value())
+        return nullptr;
+
+    InterruptDisabler disabler;
+    auto* processor_data = current_processor_data();
+    if (!processor_data)
+        return nullptr;
+
+    auto& magazine = processor_data->magazines[*slabheap_index];
+    auto& slabheap = g_kmalloc_global->slabheaps[*slabheap_index];
+    if (magazine.count > 0) {
+        ++magazine.allocation_hit_count;
+    } else {
+        ++magazine.allocation_miss_count;
+        SpinlockLocker lock(s_lock);
+        while (magazine.count < KmallocMagazine::batch_size) {
+            auto* slab = slabheap.allocate(CallerWillInitializeMemory::Yes);
+            if (!slab)
+                break;
+            magazine.slabs[magazine.count++] = slab;
+        }
+        // Let the global allocator figure out how to make room.
+        if (magazine.count == 0)
+            return nullptr;
+    }
+
+    ++processor_data->kmalloc_call_count;
+    auto* ptr = magazine.slabs[--magazine.count];
+    if (caller_will_initialize_memory == CallerWillInitializeMemory::No)
+        memset(ptr, KMALLOC_SCRUB_BYTE, slabheap.slab_size());
+    return ptr;
+}
+
+static bool try_free_to_magazine(void* ptr, size_t size)
+{
+    // NOTE: This has to pick the same slabheap as KmallocGlobalData::deallocate() would.
+    Optional<size_t> slabheap_index;
+    for (size_t i = 0; i < kmalloc_slabheap_count; ++i) {
+        if (size <= g_kmalloc_global->slabheaps[i].slab_size()) {
+            slabheap_index = i;
+            break;
+        }
+    }
+    if (!slabheap_index.has_value())
+        return false;
+
+    InterruptDisabler disabler;
+    auto* processor_data = current_processor_data();
+    if (!processor_data)
+        return false;
+
+    VERIFY(g_kmalloc_global->is_valid_kmalloc_address(VirtualAddress { ptr }));
+    auto& magazine = processor_data->magazines[*slabheap_index];
+    auto& slabheap = g_kmalloc_global->slabheaps[*slabheap_index];
+    if (magazine.count < KmallocMagazine::capacity) {
+        ++magazine.free_hit_count;
+    } else {
+        ++magazine.free_miss_count;
+        SpinlockLocker lock(s_lock);
+        while (magazine.count > KmallocMagazine::capacity - KmallocMagazine::batch_size)
+            slabheap.deallocate(magazine.slabs[--magazine.count]);
+    }
+
+    ++processor_data->kfree_call_count;
+    memset(ptr, KFREE_SCRUB_BYTE, slabheap.slab_size());
+    magazine.slabs[magazine.count++] = ptr;
+    return true;
+}
+
+static Thread* current_thread_for_perf_event()
+{
+    Thread* current_thread = Thread::current();
+    if (!current_thread)
+        current_thread = Processor::idle_thread();
+    return current_thread;
 }
 
 UNMAP_AFTER_INIT void kmalloc_init()
@@ -433,6 +560,16 @@ static void* kmalloc_impl(size_t size, size_t alignment, CallerWillInitializeMem
     // Alignment must be a power of two.
     VERIFY(is_power_of_two(alignment));
 
+    if (!g_dump_kmalloc_stacks) {
+        if (auto* ptr = try_allocate_from_magazine(size, alignment, caller_will_initialize_memory)) {
+            if (auto* current_thread = current_thread_for_perf_event()) {
+                VERIFY(current_thread->is_allocation_enabled());
+                PerformanceManager::add_kmalloc_perf_event(*current_thread, size, (FlatPtr)ptr);
+            }
+            return ptr;
+        }
+    }
+
     SpinlockLocker lock(s_lock);
     ++g_kmalloc_call_count;
 
@@ -443,10 +580,7 @@ static void* kmalloc_impl(size_t size, size_t alignment, CallerWillInitializeMem
 
     void* ptr = g_kmalloc_global->allocate(size, alignment, caller_will_initialize_memory);
 
-    Thread* current_thread = Thread::current();
-    if (!current_thread)
-        current_thread = Processor::idle_thread();
-    if (current_thread) {
+    if (auto* current_thread = current_thread_for_perf_event()) {
         // FIXME: By the time we check this, we have already allocated above.
         //        This means that in the case of an infinite recursion, we can't catch it this way.
         VERIFY(current_thread->is_allocation_enabled());
@@ -484,15 +618,20 @@ void kfree_sized(void* ptr, size_t size)
         Processor::verify_no_spinlocks_held();
     }
 
+    if (try_free_to_magazine(ptr, size)) {
+        if (auto* current_thread = current_thread_for_perf_event()) {
+            VERIFY(current_thread->is_allocation_enabled());
+            PerformanceManager::add_kfree_perf_event(*current_thread, 0, (FlatPtr)ptr);
+        }
+        return;
+    }
+
     SpinlockLocker lock(s_lock);
     ++g_kfree_call_count;
     ++g_nested_kfree_calls;
 
     if (g_nested_kfree_calls == 1) {
-        Thread* current_thread = Thread::current();
-        if (!current_thread)
-            current_thread = Processor::idle_thread();
-        if (current_thread) {
+        if (auto* current_thread = current_thread_for_perf_event()) {
             VERIFY(current_thread->is_allocation_enabled());
             PerformanceManager::add_kfree_perf_event(*current_thread, 0, (FlatPtr)ptr);
         }
@@ -588,4 +727,30 @@ void get_kmalloc_stats(kmalloc_stats& stats)
     stats.bytes_free = g_kmalloc_global->free_bytes();
     stats.kmalloc_call_count = g_kmalloc_call_count;
     stats.kfree_call_count = g_kfree_call_count;
+    // NOTE: These are updated without a lock by their processors, so they are only approximately in sync.
+    for (auto const& processor_data : s_processor_data) {
+        stats.kmalloc_call_count += processor_data.kmalloc_call_count;
+        stats.kfree_call_count += processor_data.kfree_call_count;
+        // Slabs sitting in a magazine are free, even though their slabheap considers them allocated.
+        for (size_t i = 0; i < kmalloc_slabheap_count; ++i) {
+            auto magazine_bytes = processor_data.magazines[i].count * g_kmalloc_global->slabheaps[i].slab_size();
+            stats.bytes_allocated -= magazine_bytes;
+            stats.bytes_free += magazine_bytes;
+        }
+    }
+}
+
+void get_kmalloc_slabheap_stats(kmalloc_slabheap_stats (&stats)[kmalloc_slabheap_count])
+{
+    for (size_t i = 0; i < kmalloc_slabheap_count; ++i) {
+        stats[i] = {};
+        stats[i].slab_size = g_kmalloc_global->slabheaps[i].slab_size();
+        for (auto const& processor_data : s_processor_data) {
+            auto const& magazine = processor_data.magazines[i];
+            stats[i].magazine_allocation_hit_count += magazine.allocation_hit_count;
+            stats[i].magazine_allocation_miss_count += magazine.allocation_miss_count;
+            stats[i].magazine_free_hit_count += magazine.free_hit_count;
+            stats[i].magazine_free_miss_count += magazine.free_miss_count;
+        }
+    }
 }
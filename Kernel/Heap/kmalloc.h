@@ -56,6 +56,17 @@ struct kmalloc_stats {
 };
 void get_kmalloc_stats(kmalloc_stats&);
 
+static constexpr size_t kmalloc_slabheap_count = 6;
+
+struct kmalloc_slabheap_stats {
+    size_t slab_size;
+    size_t magazine_allocation_hit_count;
+    size_t magazine_allocation_miss_count;
+    size_t magazine_free_hit_count;
+    size_t magazine_free_miss_count;
+};
+void get_kmalloc_slabheap_stats(kmalloc_slabheap_stats (&)[kmalloc_slabheap_count]);
+
 extern bool g_dump_kmalloc_stacks;
 
 inline void* operator new(size_t, void* p) { return p; }
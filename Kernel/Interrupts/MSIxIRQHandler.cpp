@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/Debug.h>
+#include <Kernel/Interrupts/MSIxIRQHandler.h>
+#if ARCH(I386) || ARCH(X86_64)
+#    include <Kernel/Arch/x86/common/Interrupts/APIC.h>
+#endif
+
+namespace Kernel {
+
+MSIxIRQHandler::MSIxIRQHandler(PCI::Device& pci_device, u16 msix_table_index, MessageSignalledInterrupt const& interrupt)
+    : GenericInterruptHandler(interrupt.interrupt_number, true)
+    , m_pci_device(pci_device)
+    , m_msix_table_index(msix_table_index)
+    , m_interrupt(interrupt)
+{
+}
+
+MSIxIRQHandler::~MSIxIRQHandler() = default;
+
+ErrorOr<void> MSIxIRQHandler::enable_irq()
+{
+    dbgln_if(IRQ_DEBUG, "Enable MSI-X entry {} as interrupt {}", m_msix_table_index, interrupt_number());
+    if (!is_registered())
+        register_interrupt_handler();
+    return m_pci_device.set_msix_table_entry(m_msix_table_index, m_interrupt.message_address, m_interrupt.message_data, false);
+}
+
+ErrorOr<void> MSIxIRQHandler::disable_irq()
+{
+    dbgln_if(IRQ_DEBUG, "Disable MSI-X entry {} as interrupt {}", m_msix_table_index, interrupt_number());
+    return m_pci_device.set_msix_table_entry_masked(m_msix_table_index, true);
+}
+
+bool MSIxIRQHandler::eoi()
+{
+#if ARCH(I386) || ARCH(X86_64)
+    APIC::the().eoi();
+    return true;
+#else
+    TODO_AARCH64();
+#endif
+}
+
+}
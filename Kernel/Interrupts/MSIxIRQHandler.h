@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Error.h>
+#include <AK/Types.h>
+#include <Kernel/Bus/PCI/Device.h>
+#include <Kernel/Interrupts/GenericInterruptHandler.h>
+
+namespace Kernel {
+
+// Where a device has to write to raise a particular interrupt on a particular processor.
+struct MessageSignalledInterrupt {
+    u8 interrupt_number { 0 };
+    u64 message_address { 0 };
+    u32 message_data { 0 };
+};
+
+// Handles one MSI-X table entry of a PCI device. The message goes straight to the
+// target processor's local interrupt controller, so unlike IRQHandler there is no
+// IRQ controller to program, and no other device to share the interrupt with.
+class MSIxIRQHandler : public GenericInterruptHandler {
+public:
+    virtual ~MSIxIRQHandler() override;
+
+    virtual bool handle_interrupt(RegisterState const& regs) override { return handle_irq(regs); }
+    virtual bool handle_irq(RegisterState const&) = 0;
+
+    ErrorOr<void> enable_irq();
+    ErrorOr<void> disable_irq();
+
+    virtual bool eoi() override;
+
+    virtual HandlerType type() const override { return HandlerType::IRQHandler; }
+    virtual StringView purpose() const override { return "MSI-X Handler"sv; }
+    virtual StringView controller() const override { return "MSI-X"sv; }
+
+    virtual size_t sharing_devices_count() const override { return 0; }
+    virtual bool is_shared_handler() const override { return false; }
+    virtual bool is_sharing_with_others() const override { return false; }
+
+protected:
+    MSIxIRQHandler(PCI::Device&, u16 msix_table_index, MessageSignalledInterrupt const&);
+
+private:
+    PCI::Device& m_pci_device;
+    u16 m_msix_table_index { 0 };
+    MessageSignalledInterrupt m_interrupt;
+};
+
+}
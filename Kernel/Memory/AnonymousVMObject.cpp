@@ -32,14 +32,18 @@ ErrorOr<NonnullLockRefPtr<VMObject>> AnonymousVMObject::try_clone()
     // commit the number of pages that we need to potentially allocate
     // so that the parent is still guaranteed to be able to have all
     // non-volatile memory available.
+    // NOTE: Compressed pages are brought back into a new page on either side, so they are never COW'd.
     size_t new_cow_pages_needed = 0;
     for (auto const& page : m_physical_pages) {
-        if (!page->is_shared_zero_page())
+        if (page && !page->is_shared_zero_page())
             ++new_cow_pages_needed;
     }
 
-    if (new_cow_pages_needed == 0)
-        return TRY(try_create_with_size(size(), AllocationStrategy::None));
+    if (new_cow_pages_needed == 0) {
+        auto clone = TRY(try_create_with_size(size(), AllocationStrategy::None));
+        TRY(clone_compressed_pages_into(*clone));
+        return clone;
+    }
 
     dbgln_if(COMMIT_DEBUG, "Cloning {:p}, need {} committed cow pages", this, new_cow_pages_needed);
 
@@ -54,6 +58,7 @@ ErrorOr<NonnullLockRefPtr<VMObject>> AnonymousVMObject::try_clone()
     auto new_shared_committed_cow_pages = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) SharedCommittedCowPages(move(committed_pages))));
     auto new_physical_pages = TRY(this->try_clone_physical_pages());
     auto clone = TRY(try_create_with_shared_cow(*this, *new_shared_committed_cow_pages, move(new_physical_pages)));
+    TRY(clone_compressed_pages_into(*clone));
 
     // Both original and clone become COW. So create a COW map for ourselves
     // or reset all pages to be copied again if we were previously cloned
@@ -76,6 +81,16 @@ ErrorOr<NonnullLockRefPtr<VMObject>> AnonymousVMObject::try_clone()
     return clone;
 }
 
+ErrorOr<void> AnonymousVMObject::clone_compressed_pages_into(AnonymousVMObject& clone) const
+{
+    VERIFY(m_lock.is_locked_by_current_processor());
+    for (auto& it : m_compressed_pages) {
+        TRY(clone.m_compressed_pages.try_set(it.key, TRY(it.value->try_clone())));
+        clone.m_physical_pages[it.key] = nullptr;
+    }
+    return {};
+}
+
 ErrorOr<NonnullLockRefPtr<AnonymousVMObject>> AnonymousVMObject::try_create_with_size(size_t size, AllocationStrategy strategy)
 {
     Optional<CommittedPhysicalPageSet> committed_pages;
@@ -143,6 +158,7 @@ ErrorOr<NonnullLockRefPtr<AnonymousVMObject>> AnonymousVMObject::try_create_with
 AnonymousVMObject::AnonymousVMObject(FixedArray<RefPtr<PhysicalPage>>&& new_physical_pages, AllocationStrategy strategy, Optional<CommittedPhysicalPageSet> committed_pages)
     : VMObject(move(new_physical_pages))
     , m_unused_committed_pages(move(committed_pages))
+    , m_may_compress_pages(true)
 {
     if (strategy == AllocationStrategy::AllocateNow) {
         // Allocate all pages right now. We know we can get all because we committed the amount needed
@@ -173,6 +189,7 @@ AnonymousVMObject::AnonymousVMObject(LockWeakPtr<AnonymousVMObject> other, Nonnu
     , m_cow_parent(move(other))
     , m_shared_committed_cow_pages(move(shared_committed_cow_pages))
     , m_purgeable(m_cow_parent.strong_ref()->m_purgeable)
+    , m_may_compress_pages(true)
 {
 }
 
@@ -198,12 +215,14 @@ size_t AnonymousVMObject::purge()
     size_t total_pages_purged = 0;
 
     for (auto& page : m_physical_pages) {
-        VERIFY(page);
-        if (page->is_shared_zero_page())
+        if (page && page->is_shared_zero_page())
             continue;
+        // Compressed pages have no physical page to give back, but their contents go all the same.
+        if (page)
+            ++total_pages_purged;
         page = MM.shared_zero_page();
-        ++total_pages_purged;
     }
+    m_compressed_pages.clear();
 
     m_was_purged = true;
 
@@ -248,8 +267,7 @@ ErrorOr<void> AnonymousVMObject::set_volatile(bool is_volatile, bool& was_purged
     // If that fails, we return false to indicate that memory allocation failed.
     size_t committed_pages_needed = 0;
     for (auto& page : m_physical_pages) {
-        VERIFY(page);
-        if (page->is_shared_zero_page())
+        if (page && page->is_shared_zero_page())
             ++committed_pages_needed;
     }
 
@@ -261,7 +279,7 @@ ErrorOr<void> AnonymousVMObject::set_volatile(bool is_volatile, bool& was_purged
     m_unused_committed_pages = TRY(MM.commit_physical_pages(committed_pages_needed));
 
     for (auto& page : m_physical_pages) {
-        if (page->is_shared_zero_page())
+        if (page && page->is_shared_zero_page())
             page = MM.lazy_committed_page();
     }
 
@@ -273,9 +291,35 @@ ErrorOr<void> AnonymousVMObject::set_volatile(bool is_volatile, bool& was_purged
 
 NonnullRefPtr<PhysicalPage> AnonymousVMObject::allocate_committed_page(Badge<Region>)
 {
+    SpinlockLocker lock(m_lock);
     return m_unused_committed_pages->take_one();
 }
 
+bool AnonymousVMObject::try_allocate_committed_large_page(Badge<Region>, size_t first_page_index)
+{
+    SpinlockLocker lock(m_lock);
+    if (!m_unused_committed_pages.has_value() || m_unused_committed_pages->page_count() < pages_per_large_page)
+        return false;
+    if (first_page_index + pages_per_large_page > page_count())
+        return false;
+
+    // Every page we replace has a committed page set aside for it, so taking
+    // a whole large page's worth of them leaves the others untouched.
+    for (size_t i = 0; i < pages_per_large_page; ++i) {
+        auto const& page = physical_pages()[first_page_index + i];
+        if (!page || !page->is_lazy_committed_page())
+            return false;
+    }
+
+    auto physical_pages_or_error = m_unused_committed_pages->try_take_large_page();
+    if (physical_pages_or_error.is_error())
+        return false;
+    auto large_page = physical_pages_or_error.release_value();
+    for (size_t i = 0; i < pages_per_large_page; ++i)
+        physical_pages()[first_page_index + i] = large_page.ptr_at(i);
+    return true;
+}
+
 ErrorOr<void> AnonymousVMObject::ensure_cow_map()
 {
     if (m_cow_map.is_null())
@@ -327,6 +371,10 @@ PageFaultResponse AnonymousVMObject::handle_cow_fault(size_t page_index, Virtual
     }
 
     auto& page_slot = physical_pages()[page_index];
+    if (!page_slot) {
+        // The page was compressed after the fault handler looked at it, so we'll simply fault on it again.
+        return PageFaultResponse::Continue;
+    }
 
     // If we were sharing committed COW pages with another process, and the other process
     // has exhausted the supply, we can stop counting the shared pages.
@@ -381,6 +429,140 @@ PageFaultResponse AnonymousVMObject::handle_cow_fault(size_t page_index, Virtual
     return PageFaultResponse::Continue;
 }
 
+bool AnonymousVMObject::can_compress_pages()
+{
+    // Volatile memory is purged instead. Memory that the kernel maps, or that isn't mapped at all, may be
+    // handed to a device or otherwise used in ways that don't expect its pages to go away, so we leave it alone.
+    if (!m_may_compress_pages || is_volatile())
+        return false;
+    bool has_user_regions = false;
+    bool has_kernel_regions = false;
+    for_each_region([&](Region& region) {
+        if (region.is_user())
+            has_user_regions = true;
+        else
+            has_kernel_regions = true;
+    });
+    return has_user_regions && !has_kernel_regions;
+}
+
+size_t AnonymousVMObject::compress_cold_pages(size_t page_count)
+{
+    SpinlockLocker lock(m_lock);
+    if (!can_compress_pages())
+        return 0;
+
+    size_t compressed_page_count = 0;
+    for (size_t page_index = 0; page_index < this->page_count() && compressed_page_count < page_count; ++page_index) {
+        auto const& page = m_physical_pages[page_index];
+        // If anyone else (like a COW sibling) has a reference to the page, it wouldn't go away anyway.
+        if (!page || page->is_shared_zero_page() || page->is_lazy_committed_page() || page->ref_count() != 1)
+            continue;
+
+        bool was_accessed = false;
+        for_each_region([&](Region& region) {
+            if (region.test_and_clear_accessed(page_index))
+                was_accessed = true;
+        });
+        if (!was_accessed && try_compress_page(page_index))
+            ++compressed_page_count;
+    }
+    return compressed_page_count;
+}
+
+bool AnonymousVMObject::try_compress_page(size_t page_index)
+{
+    VERIFY(m_lock.is_locked_by_current_processor());
+    auto& page_slot = m_physical_pages[page_index];
+    NonnullRefPtr<PhysicalPage> page = *page_slot;
+
+    // We take the page away from all of our regions first, so that it can't change while we compress it.
+    page_slot = nullptr;
+    auto put_page_back = [&] {
+        page_slot = page;
+        (void)remap_page_in_all_regions(page_index, page);
+        return false;
+    };
+    if (!remap_page_in_all_regions(page_index, nullptr))
+        return put_page_back();
+
+    u8 compressed_data[CompressedPage::max_size];
+    size_t compressed_size = 0;
+    {
+        u8* page_data = MM.quickmap_page(*page);
+        compressed_size = CompressedPage::compress({ page_data, PAGE_SIZE }, { compressed_data, sizeof(compressed_data) });
+        MM.unquickmap_page();
+    }
+    if (!compressed_size)
+        return put_page_back();
+
+    auto compressed_page_or_error = CompressedPage::try_create({ compressed_data, compressed_size });
+    if (compressed_page_or_error.is_error() || m_compressed_pages.try_set(page_index, compressed_page_or_error.release_value()).is_error())
+        return put_page_back();
+
+    // We had the only reference to the page, so if it was still to be COW'd, we can stop counting
+    // on a committed page for that, just like handle_cow_fault() does.
+    if (!m_cow_map.is_null() && m_cow_map.get(page_index)) {
+        m_cow_map.set(page_index, false);
+        if (m_shared_committed_cow_pages && !m_shared_committed_cow_pages->is_empty())
+            m_shared_committed_cow_pages->uncommit_one();
+    }
+    return true;
+}
+
+Optional<PageFaultResponse> AnonymousVMObject::try_handle_compressed_page_fault(size_t page_index)
+{
+    SpinlockLocker lock(m_lock);
+    if (!m_compressed_pages.contains(page_index))
+        return {};
+
+    auto page_or_error = MM.allocate_physical_page(MemoryManager::ShouldZeroFill::No);
+    if (page_or_error.is_error()) {
+        dmesgln("MM: try_handle_compressed_page_fault was unable to allocate a physical page");
+        return PageFaultResponse::OutOfMemory;
+    }
+    auto page = page_or_error.release_value();
+
+    // If we're volatile, we may have been purged to make room for the page.
+    auto it = m_compressed_pages.find(page_index);
+    if (it == m_compressed_pages.end())
+        return PageFaultResponse::Continue;
+    {
+        u8* page_data = MM.quickmap_page(*page);
+        it->value->decompress({ page_data, PAGE_SIZE });
+        MM.unquickmap_page();
+    }
+    m_compressed_pages.remove(page_index);
+
+    // The new page is ours alone, even if we were cloned after the page was compressed.
+    m_physical_pages[page_index] = page;
+    if (!m_cow_map.is_null())
+        m_cow_map.set(page_index, false);
+
+    if (!remap_page_in_all_regions(page_index, page))
+        return PageFaultResponse::OutOfMemory;
+    return PageFaultResponse::Continue;
+}
+
+void AnonymousVMObject::discard_compressed_page(size_t page_index)
+{
+    SpinlockLocker lock(m_lock);
+    m_compressed_pages.remove(page_index);
+}
+
+bool AnonymousVMObject::remap_page_in_all_regions(size_t page_index, RefPtr<PhysicalPage> page)
+{
+    bool success = true;
+    for_each_region([&](Region& region) {
+        auto page_index_in_region = page_index;
+        if (!region.is_mapped() || !region.translate_vmobject_page(page_index_in_region))
+            return;
+        if (!region.remap_vmobject_page(page_index, page))
+            success = false;
+    });
+    return success;
+}
+
 AnonymousVMObject::SharedCommittedCowPages::SharedCommittedCowPages(CommittedPhysicalPageSet&& committed_pages)
     : m_committed_pages(move(committed_pages))
 {
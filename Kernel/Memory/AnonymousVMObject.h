@@ -6,7 +6,9 @@
 
 #pragma once
 
+#include <AK/HashMap.h>
 #include <Kernel/Memory/AllocationStrategy.h>
+#include <Kernel/Memory/CompressedPagePool.h>
 #include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Memory/PageFaultResponse.h>
 #include <Kernel/Memory/VMObject.h>
@@ -26,6 +28,7 @@ public:
     virtual ErrorOr<NonnullLockRefPtr<VMObject>> try_clone() override;
 
     [[nodiscard]] NonnullRefPtr<PhysicalPage> allocate_committed_page(Badge<Region>);
+    [[nodiscard]] bool try_allocate_committed_large_page(Badge<Region>, size_t first_page_index);
     PageFaultResponse handle_cow_fault(size_t, VirtualAddress);
     size_t cow_pages() const;
     bool should_cow(size_t page_index, bool) const;
@@ -38,6 +41,13 @@ public:
 
     size_t purge();
 
+    // Compresses up to `page_count` pages that weren't accessed since the last call, and gives their
+    // physical pages back. Returns the number of pages compressed.
+    size_t compress_cold_pages(size_t page_count);
+    // Returns an empty optional if the page isn't compressed.
+    Optional<PageFaultResponse> try_handle_compressed_page_fault(size_t page_index);
+    void discard_compressed_page(size_t page_index);
+
 private:
     class SharedCommittedCowPages;
 
@@ -59,6 +69,11 @@ private:
     ErrorOr<void> ensure_cow_map();
     ErrorOr<void> ensure_or_reset_cow_map();
 
+    ErrorOr<void> clone_compressed_pages_into(AnonymousVMObject&) const;
+    bool can_compress_pages();
+    bool try_compress_page(size_t page_index);
+    bool remap_page_in_all_regions(size_t page_index, RefPtr<PhysicalPage>);
+
     Optional<CommittedPhysicalPageSet> m_unused_committed_pages;
     Bitmap m_cow_map;
 
@@ -85,9 +100,14 @@ private:
     LockWeakPtr<AnonymousVMObject> m_cow_parent;
     LockRefPtr<SharedCommittedCowPages> m_shared_committed_cow_pages;
 
+    // The pages that are compressed have no physical page, and can be found here instead.
+    HashMap<size_t, NonnullOwnPtr<CompressedPage>> m_compressed_pages;
+
     bool m_purgeable { false };
     bool m_volatile { false };
     bool m_was_purged { false };
+    // Only set for memory that we allocated ourselves, and not for physical ranges and the like.
+    bool m_may_compress_pages { false };
 };
 
 }
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <AK/ByteReader.h>
+#include <AK/Singleton.h>
+#include <Kernel/Library/NonnullLockRefPtrVector.h>
+#include <Kernel/Memory/AnonymousVMObject.h>
+#include <Kernel/Memory/CompressedPagePool.h>
+#include <Kernel/Memory/MemoryManager.h>
+
+namespace Kernel::Memory {
+
+static Singleton<CompressedPagePool> s_the;
+
+CompressedPagePool& CompressedPagePool::the()
+{
+    return *s_the;
+}
+
+// The compressed format is a simplified take on LZ4 blocks: a series of sequences, each made up of a
+// token byte (literal length in the upper nibble, match length minus min_match_length in the lower one),
+// any extra literal length bytes, the literals, a little-endian 16-bit match offset, and any extra match
+// length bytes. A nibble of 15 means the length continues in the following bytes, up to the first one that
+// isn't 255. The last sequence has no match.
+static constexpr size_t min_match_length = 4;
+static constexpr size_t hash_table_bits = 10;
+
+static u32 hash_sequence(u32 sequence)
+{
+    return (sequence * 2654435761u) >> (32 - hash_table_bits);
+}
+
+static u32 read_sequence(ReadonlyBytes bytes, size_t offset)
+{
+    return ByteReader::load32(bytes.offset_pointer(offset));
+}
+
+size_t CompressedPage::compress(ReadonlyBytes page, Bytes output)
+{
+    VERIFY(page.size() == PAGE_SIZE);
+    output = output.trim(max_size);
+
+    size_t out = 0;
+    auto emit_extra_length = [&](size_t length) {
+        for (; length >= 255; length -= 255) {
+            if (out == output.size())
+                return false;
+            output[out++] = 255;
+        }
+        if (out == output.size())
+            return false;
+        output[out++] = static_cast<u8>(length);
+        return true;
+    };
+    auto emit_sequence = [&](ReadonlyBytes literals, size_t match_length, size_t match_offset) {
+        if (out == output.size())
+            return false;
+        auto extra_match_length = match_length ? match_length - min_match_length : 0;
+        output[out++] = static_cast<u8>((min<size_t>(literals.size(), 15) << 4) | min<size_t>(extra_match_length, 15));
+        if (literals.size() >= 15 && !emit_extra_length(literals.size() - 15))
+            return false;
+        if (literals.size() > output.size() - out)
+            return false;
+        literals.copy_to(output.slice(out));
+        out += literals.size();
+        if (!match_length)
+            return true;
+        if (output.size() - out < 2)
+            return false;
+        output[out++] = static_cast<u8>(match_offset & 0xff);
+        output[out++] = static_cast<u8>(match_offset >> 8);
+        if (extra_match_length >= 15 && !emit_extra_length(extra_match_length - 15))
+            return false;
+        return true;
+    };
+
+    Array<u16, 1 << hash_table_bits> table {};
+    size_t anchor = 0;
+    size_t in = 0;
+    while (in + min_match_length <= page.size()) {
+        auto sequence = read_sequence(page, in);
+        auto& slot = table[hash_sequence(sequence)];
+        size_t candidate = slot;
+        slot = in;
+        if (candidate >= in || read_sequence(page, candidate) != sequence) {
+            ++in;
+            continue;
+        }
+        size_t match_length = min_match_length;
+        while (in + match_length < page.size() && page[candidate + match_length] == page[in + match_length])
+            ++match_length;
+        if (!emit_sequence(page.slice(anchor, in - anchor), match_length, in - candidate))
+            return 0;
+        in += match_length;
+        anchor = in;
+    }
+    if (!emit_sequence(page.slice(anchor), 0, 0))
+        return 0;
+    return out;
+}
+
+ErrorOr<NonnullOwnPtr<CompressedPage>> CompressedPage::try_create(ReadonlyBytes compressed_data)
+{
+    auto data = TRY(FixedArray<u8>::try_create(compressed_data));
+    return adopt_nonnull_own_or_enomem(new (nothrow) CompressedPage(move(data)));
+}
+
+ErrorOr<NonnullOwnPtr<CompressedPage>> CompressedPage::try_clone() const
+{
+    return try_create(m_data.span());
+}
+
+CompressedPage::CompressedPage(FixedArray<u8>&& data)
+    : m_data(move(data))
+{
+    auto& pool = CompressedPagePool::the();
+    pool.m_page_count.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+    pool.m_compressed_size.fetch_add(m_data.size(), AK::MemoryOrder::memory_order_relaxed);
+}
+
+CompressedPage::~CompressedPage()
+{
+    auto& pool = CompressedPagePool::the();
+    pool.m_page_count.fetch_sub(1, AK::MemoryOrder::memory_order_relaxed);
+    pool.m_compressed_size.fetch_sub(m_data.size(), AK::MemoryOrder::memory_order_relaxed);
+}
+
+void CompressedPage::decompress(Bytes page) const
+{
+    VERIFY(page.size() == PAGE_SIZE);
+    auto input = m_data.span();
+
+    size_t in = 0;
+    auto read_extra_length = [&](size_t& length) {
+        u8 byte;
+        do {
+            VERIFY(in < input.size());
+            byte = input[in++];
+            length += byte;
+        } while (byte == 255);
+    };
+
+    // We wrote this data ourselves, so anything out of place here means kernel memory got corrupted.
+    size_t out = 0;
+    while (in < input.size()) {
+        auto token = input[in++];
+        size_t literal_length = token >> 4;
+        if (literal_length == 15)
+            read_extra_length(literal_length);
+        VERIFY(literal_length <= input.size() - in && literal_length <= page.size() - out);
+        input.slice(in, literal_length).copy_to(page.slice(out));
+        in += literal_length;
+        out += literal_length;
+        if (in == input.size())
+            break;
+
+        VERIFY(input.size() - in >= 2);
+        size_t match_offset = input[in] | (input[in + 1] << 8);
+        in += 2;
+        size_t match_length = (token & 0xf) + min_match_length;
+        if ((token & 0xf) == 15)
+            read_extra_length(match_length);
+        VERIFY(match_offset != 0 && match_offset <= out && match_length <= page.size() - out);
+        // NOTE: The match may overlap what it's copied to, so this has to go byte by byte.
+        for (size_t i = 0; i < match_length; ++i)
+            page[out + i] = page[out - match_offset + i];
+        out += match_length;
+    }
+    VERIFY(out == page.size());
+}
+
+bool CompressedPagePool::is_full() const
+{
+    auto physical_memory_size = MM.get_system_memory_info().physical_pages * PAGE_SIZE;
+    return compressed_size() >= physical_memory_size / max_physical_memory_share_divisor;
+}
+
+size_t CompressedPagePool::compress_cold_pages(size_t page_count)
+{
+    NonnullLockRefPtrVector<AnonymousVMObject> vmobjects;
+    MemoryManager::for_each_vmobject([&](auto& vmobject) {
+        if (!vmobject.is_anonymous())
+            return IterationDecision::Continue;
+        // If we can't hold on to all of them, we'll make do with the ones we have.
+        if (vmobjects.try_append(static_cast<AnonymousVMObject&>(vmobject)).is_error())
+            return IterationDecision::Break;
+        return IterationDecision::Continue;
+    });
+
+    size_t compressed_page_count = 0;
+    for (auto& vmobject : vmobjects) {
+        if (compressed_page_count >= page_count || is_full())
+            break;
+        compressed_page_count += vmobject.compress_cold_pages(page_count - compressed_page_count);
+    }
+    return compressed_page_count;
+}
+
+}
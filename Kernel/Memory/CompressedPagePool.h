@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/FixedArray.h>
+#include <AK/Noncopyable.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Span.h>
+#include <Kernel/Forward.h>
+
+namespace Kernel::Memory {
+
+// The contents of an anonymous page that was compressed to give its physical page back.
+class CompressedPage {
+    AK_MAKE_NONCOPYABLE(CompressedPage);
+    AK_MAKE_NONMOVABLE(CompressedPage);
+
+public:
+    // Pages that don't shrink to at least this size are not worth keeping compressed.
+    static constexpr size_t max_size = PAGE_SIZE * 3 / 4;
+
+    // Returns the compressed size, or 0 if the page doesn't compress down to `max_size`.
+    static size_t compress(ReadonlyBytes page, Bytes output);
+
+    static ErrorOr<NonnullOwnPtr<CompressedPage>> try_create(ReadonlyBytes compressed_data);
+    ErrorOr<NonnullOwnPtr<CompressedPage>> try_clone() const;
+    ~CompressedPage();
+
+    void decompress(Bytes page) const;
+
+private:
+    explicit CompressedPage(FixedArray<u8>&&);
+
+    FixedArray<u8> m_data;
+};
+
+// Serenity has no swap, so when memory runs low, we compress the anonymous pages that haven't been
+// used in a while and keep them in kernel memory instead, and bring them back when they are faulted on.
+// A page counts as unused if none of its mappings had their accessed bit set since the last time we looked.
+class CompressedPagePool {
+public:
+    static CompressedPagePool& the();
+
+    // Compresses up to `page_count` pages. Returns the number of physical pages given back.
+    size_t compress_cold_pages(size_t page_count);
+
+    // We stop compressing pages once the compressed data takes up this share of physical memory.
+    static constexpr size_t max_physical_memory_share_divisor = 4;
+    bool is_full() const;
+
+    size_t page_count() const { return m_page_count.load(AK::MemoryOrder::memory_order_relaxed); }
+    size_t compressed_size() const { return m_compressed_size.load(AK::MemoryOrder::memory_order_relaxed); }
+
+private:
+    friend class CompressedPage;
+
+    Atomic<size_t> m_page_count { 0 };
+    Atomic<size_t> m_compressed_size { 0 };
+};
+
+}
@@ -19,6 +19,7 @@
 #include <Kernel/KSyms.h>
 #include <Kernel/Memory/AnonymousVMObject.h>
 #include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Memory/PageCache.h>
 #include <Kernel/Memory/PageDirectory.h>
 #include <Kernel/Memory/PhysicalRegion.h>
 #include <Kernel/Memory/SharedInodeVMObject.h>
@@ -46,6 +47,16 @@ extern size_t multiboot_copy_boot_modules_count;
 
 namespace Kernel::Memory {
 
+static ALWAYS_INLINE bool is_large_page(PageDirectoryEntry const& pde)
+{
+#if ARCH(I386) || ARCH(X86_64)
+    return pde.is_huge();
+#else
+    (void)pde;
+    return false;
+#endif
+}
+
 ErrorOr<FlatPtr> page_round_up(FlatPtr x)
 {
     if (x > (explode_byte(0xFF) & ~0xFFF)) {
@@ -60,6 +71,9 @@ ErrorOr<FlatPtr> page_round_up(FlatPtr x)
 // the memory manager to be initialized twice!
 static MemoryManager* s_the;
 
+// Releasing page cache pages one by one would have us come back for more on every allocation.
+static constexpr size_t page_cache_release_batch_size = 32;
+
 MemoryManager& MemoryManager::the()
 {
     return *s_the;
@@ -572,12 +586,42 @@ PageTableEntry* MemoryManager::pte(PageDirectory& page_directory, VirtualAddress
 
     auto* pd = quickmap_pd(const_cast<PageDirectory&>(page_directory), page_directory_table_index);
     PageDirectoryEntry const& pde = pd[page_directory_index];
-    if (!pde.is_present())
+    // NOTE: Large pages have no page table to point into.
+    if (!pde.is_present() || is_large_page(pde))
         return nullptr;
 
     return &quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()))[page_table_index];
 }
 
+bool MemoryManager::test_and_clear_accessed(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    VERIFY(page_directory.get_lock().is_locked_by_current_processor());
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x1ff;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+    u32 page_table_index = (vaddr.get() >> 12) & 0x1ff;
+
+    // NOTE: We don't flush the TLB after clearing the accessed bit. An entry that's still cached will keep
+    //       the bit from being set again, so the page may look unused when it isn't, but that only costs a fault.
+    auto* pd = quickmap_pd(page_directory, page_directory_table_index);
+    auto& pde = pd[page_directory_index];
+    if (!pde.is_present())
+        return false;
+    if (is_large_page(pde)) {
+        // All pages of a large page share its accessed bit, so we only clear it when asked
+        // about the last of them, assuming that the pages are asked about in order.
+        bool was_accessed = pde.is_accessed();
+        if (page_table_index == pages_per_large_page - 1)
+            pde.set_accessed(false);
+        return was_accessed;
+    }
+
+    auto& pte = quickmap_pt(PhysicalAddress(pde.page_table_base()))[page_table_index];
+    bool was_accessed = pte.is_accessed();
+    pte.set_accessed(false);
+    return was_accessed;
+}
+
 PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, VirtualAddress vaddr)
 {
     VERIFY_INTERRUPTS_DISABLED();
@@ -588,11 +632,13 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     auto& pde = pd[page_directory_index];
-    if (pde.is_present())
+    auto original_pde = pde;
+    bool is_splitting_large_page = original_pde.is_present() && is_large_page(original_pde);
+    if (original_pde.is_present() && !is_splitting_large_page)
         return &quickmap_pt(PhysicalAddress(pde.page_table_base()))[page_table_index];
 
     bool did_purge = false;
-    auto page_table_or_error = allocate_physical_page(ShouldZeroFill::Yes, &did_purge);
+    auto page_table_or_error = allocate_physical_page(is_splitting_large_page ? ShouldZeroFill::No : ShouldZeroFill::Yes, &did_purge);
     if (page_table_or_error.is_error()) {
         dbgln("MM: Unable to allocate page table to map {}", vaddr);
         return nullptr;
@@ -605,8 +651,28 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
         pd = quickmap_pd(page_directory, page_directory_table_index);
         VERIFY(&pde == &pd[page_directory_index]); // Sanity check
 
-        VERIFY(!pde.is_present()); // Should have not changed
+        VERIFY(pde.raw() == original_pde.raw()); // Should have not changed
     }
+
+    if (is_splitting_large_page) {
+        // Someone wants to map an individual page inside a large page, so break it up
+        // into a page table that maps the same physical memory with the same permissions.
+        auto* ptes = quickmap_pt(page_table->paddr());
+        for (size_t i = 0; i < pages_per_large_page; ++i) {
+            auto& pte = ptes[i];
+            pte.clear();
+            pte.set_physical_page_base(original_pde.page_table_base() + i * PAGE_SIZE);
+            pte.set_user_allowed(original_pde.is_user_allowed());
+            pte.set_writable(original_pde.is_writable());
+            pte.set_write_through(original_pde.is_write_through());
+            pte.set_cache_disabled(original_pde.is_cache_disabled());
+            pte.set_global(original_pde.is_global());
+            pte.set_execute_disabled(original_pde.is_execute_disabled());
+            pte.set_present(true);
+        }
+        pde.clear();
+    }
+
     pde.set_page_table_base(page_table->paddr().get());
     pde.set_user_allowed(true);
     pde.set_present(true);
@@ -629,6 +695,12 @@ void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress va
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     PageDirectoryEntry& pde = pd[page_directory_index];
+    if (pde.is_present() && is_large_page(pde)) {
+        // NOTE: Large pages are only used when a single region covers all of it,
+        //       and regions are always unmapped as a whole.
+        pde.clear();
+        return;
+    }
     if (pde.is_present()) {
         auto* page_table = quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()));
         auto& pte = page_table[page_table_index];
@@ -652,6 +724,31 @@ void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress va
     }
 }
 
+PageDirectoryEntry* MemoryManager::ensure_large_page_pde(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    VERIFY(page_directory.get_lock().is_locked_by_current_processor());
+    VERIFY(!(vaddr.get() % large_page_size));
+#if ARCH(I386) || ARCH(X86_64)
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x1ff;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+
+    auto* pd = quickmap_pd(page_directory, page_directory_table_index);
+    auto& pde = pd[page_directory_index];
+    if (pde.is_present() && !pde.is_huge()) {
+        // The caller is about to map the whole range covered by this entry,
+        // so the page table that was used for it so far can go away.
+        get_physical_page_entry(PhysicalAddress { pde.page_table_base() }).allocated.physical_page.unref();
+    }
+    pde.clear();
+    return &pde;
+#else
+    (void)page_directory;
+    (void)vaddr;
+    return nullptr;
+#endif
+}
+
 UNMAP_AFTER_INIT void MemoryManager::initialize(u32 cpu)
 {
     ProcessorSpecific<MemoryManagerData>::initialize();
@@ -848,6 +945,9 @@ ErrorOr<CommittedPhysicalPageSet> MemoryManager::commit_physical_pages(size_t pa
 {
     VERIFY(page_count > 0);
     auto result = m_global_data.with([&](auto& global_data) -> ErrorOr<CommittedPhysicalPageSet> {
+        // Memory taken up by the page cache is still available to be committed.
+        if (global_data.system_memory_info.physical_pages_uncommitted < page_count)
+            PageCache::the().try_release_pages(page_count - global_data.system_memory_info.physical_pages_uncommitted);
         if (global_data.system_memory_info.physical_pages_uncommitted < page_count) {
             dbgln("MM: Unable to commit {} pages, have only {}", page_count, global_data.system_memory_info.physical_pages_uncommitted);
             return ENOMEM;
@@ -954,6 +1054,34 @@ NonnullRefPtr<PhysicalPage> MemoryManager::allocate_committed_physical_page(Badg
     return page.release_nonnull();
 }
 
+ErrorOr<NonnullRefPtrVector<PhysicalPage>> MemoryManager::allocate_committed_large_page(Badge<CommittedPhysicalPageSet>)
+{
+    auto physical_pages = TRY(m_global_data.with([&](auto& global_data) -> ErrorOr<NonnullRefPtrVector<PhysicalPage>> {
+        VERIFY(global_data.system_memory_info.physical_pages_committed >= pages_per_large_page);
+
+        for (auto& physical_region : global_data.physical_regions) {
+            auto physical_pages = physical_region.take_contiguous_free_pages(pages_per_large_page);
+            if (!physical_pages.is_empty()) {
+                global_data.system_memory_info.physical_pages_committed -= pages_per_large_page;
+                global_data.system_memory_info.physical_pages_used += pages_per_large_page;
+                return physical_pages;
+            }
+        }
+        return ENOMEM;
+    }));
+
+    // NOTE: Large zones start on a large page boundary, so blocks of this size are naturally aligned.
+    VERIFY(!(physical_pages[0].paddr().get() % large_page_size));
+
+    InterruptDisabler disabler;
+    for (auto& physical_page : physical_pages) {
+        auto* ptr = quickmap_page(physical_page);
+        memset(ptr, 0, PAGE_SIZE);
+        unquickmap_page();
+    }
+    return physical_pages;
+}
+
 ErrorOr<NonnullRefPtr<PhysicalPage>> MemoryManager::allocate_physical_page(ShouldZeroFill should_zero_fill, bool* did_purge)
 {
     return m_global_data.with([&](auto&) -> ErrorOr<NonnullRefPtr<PhysicalPage>> {
@@ -980,7 +1108,15 @@ ErrorOr<NonnullRefPtr<PhysicalPage>> MemoryManager::allocate_physical_page(Shoul
             });
         }
         if (!page) {
-            // Second, we look for a file-backed VMObject with clean pages.
+            // Second, we give back pages from the least recently used files in the page cache.
+            if (auto released_page_count = PageCache::the().try_release_pages(page_cache_release_batch_size)) {
+                dbgln_if(PAGE_FAULT_DEBUG, "MM: Released {} pages from the page cache", released_page_count);
+                // NOTE: A page may still be in use by someone copying out of it, so this can fail.
+                page = find_free_physical_page(false);
+            }
+        }
+        if (!page) {
+            // Third, we look for a file-backed VMObject with clean pages.
             for_each_vmobject([&](auto& vmobject) {
                 if (!vmobject.is_inode())
                     return IterationDecision::Continue;
@@ -1200,6 +1336,14 @@ NonnullRefPtr<PhysicalPage> CommittedPhysicalPageSet::take_one()
     return MM.allocate_committed_physical_page({}, MemoryManager::ShouldZeroFill::Yes);
 }
 
+ErrorOr<NonnullRefPtrVector<PhysicalPage>> CommittedPhysicalPageSet::try_take_large_page()
+{
+    VERIFY(m_page_count >= pages_per_large_page);
+    auto physical_pages = TRY(MM.allocate_committed_large_page({}));
+    m_page_count -= pages_per_large_page;
+    return physical_pages;
+}
+
 void CommittedPhysicalPageSet::uncommit_one()
 {
     VERIFY(m_page_count > 0);
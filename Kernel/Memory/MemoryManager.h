@@ -30,6 +30,10 @@ struct KmallocGlobalData;
 
 namespace Kernel::Memory {
 
+// A large page is mapped by a single page directory entry instead of a page table full of 4 KiB pages.
+constexpr size_t large_page_size = 2 * MiB;
+constexpr size_t pages_per_large_page = large_page_size / PAGE_SIZE;
+
 ErrorOr<FlatPtr> page_round_up(FlatPtr x);
 
 constexpr FlatPtr page_round_down(FlatPtr x)
@@ -117,6 +121,7 @@ public:
     size_t page_count() const { return m_page_count; }
 
     [[nodiscard]] NonnullRefPtr<PhysicalPage> take_one();
+    ErrorOr<NonnullRefPtrVector<PhysicalPage>> try_take_large_page();
     void uncommit_one();
 
     void operator=(CommittedPhysicalPageSet&&) = delete;
@@ -130,6 +135,7 @@ class MemoryManager {
     friend class AnonymousVMObject;
     friend class Region;
     friend class RegionTree;
+    friend class SharedInodeVMObject;
     friend class VMObject;
     friend struct ::KmallocGlobalData;
 
@@ -167,6 +173,7 @@ public:
     void uncommit_physical_pages(Badge<CommittedPhysicalPageSet>, size_t page_count);
 
     NonnullRefPtr<PhysicalPage> allocate_committed_physical_page(Badge<CommittedPhysicalPageSet>, ShouldZeroFill = ShouldZeroFill::Yes);
+    ErrorOr<NonnullRefPtrVector<PhysicalPage>> allocate_committed_large_page(Badge<CommittedPhysicalPageSet>);
     ErrorOr<NonnullRefPtr<PhysicalPage>> allocate_physical_page(ShouldZeroFill = ShouldZeroFill::Yes, bool* did_purge = nullptr);
     ErrorOr<NonnullRefPtrVector<PhysicalPage>> allocate_contiguous_physical_pages(size_t size);
     void deallocate_physical_page(PhysicalAddress);
@@ -271,11 +278,14 @@ private:
 
     PageTableEntry* pte(PageDirectory&, VirtualAddress);
     PageTableEntry* ensure_pte(PageDirectory&, VirtualAddress);
+    PageDirectoryEntry* ensure_large_page_pde(PageDirectory&, VirtualAddress);
     enum class IsLastPTERelease {
         Yes,
         No
     };
     void release_pte(PageDirectory&, VirtualAddress, IsLastPTERelease);
+    // Returns whether the page was accessed since the last call, and starts over.
+    bool test_and_clear_accessed(PageDirectory&, VirtualAddress);
 
     // NOTE: These are outside of GlobalData as they are only assigned on startup,
     //       and then never change. Atomic ref-counting covers that case without
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Singleton.h>
+#include <Kernel/FileSystem/FileSystem.h>
+#include <Kernel/FileSystem/Inode.h>
+#include <Kernel/Memory/PageCache.h>
+
+namespace Kernel::Memory {
+
+static Singleton<PageCache> s_the;
+
+PageCache& PageCache::the()
+{
+    return *s_the;
+}
+
+ErrorOr<NonnullLockRefPtr<SharedInodeVMObject>> PageCache::vmobject_for(Inode& inode)
+{
+    auto vmobject = TRY(SharedInodeVMObject::try_create_with_inode(inode));
+
+    // NOTE: Dropping the last reference to a VMObject frees its pages, which we must not do
+    //       while holding our lock, as the memory manager may call into us with its lock held.
+    LockRefPtr<SharedInodeVMObject> evicted_vmobject;
+    m_cached_inodes.with([&](auto& cached_inodes) {
+        if (!vmobject->m_page_cache_list_node.is_in_list())
+            ++cached_inodes.count;
+        cached_inodes.lru_list.append(*vmobject);
+        if (cached_inodes.count > max_cached_inodes) {
+            evicted_vmobject = cached_inodes.lru_list.take_first();
+            --cached_inodes.count;
+        }
+    });
+    return vmobject;
+}
+
+size_t PageCache::try_release_pages(size_t page_count)
+{
+    size_t released_page_count = 0;
+    m_cached_inodes.with([&](auto& cached_inodes) {
+        for (auto& vmobject : cached_inodes.lru_list) {
+            if (released_page_count >= page_count)
+                break;
+            // We don't track which pages were written to through a shared mapping,
+            // so the pages of writably mapped files have to stay where they are.
+            if (vmobject.writable_mappings())
+                continue;
+            released_page_count += vmobject.try_release_clean_pages(static_cast<int>(page_count - released_page_count));
+        }
+    });
+    return released_page_count;
+}
+
+void PageCache::forget(Inode& inode)
+{
+    auto vmobject = inode.shared_vmobject();
+    if (!vmobject)
+        return;
+    m_cached_inodes.with([&](auto& cached_inodes) {
+        if (!vmobject->m_page_cache_list_node.is_in_list())
+            return;
+        cached_inodes.lru_list.remove(*vmobject);
+        --cached_inodes.count;
+    });
+}
+
+void PageCache::forget_all_in(FileSystem const& fs)
+{
+    SharedInodeVMObject::PageCacheList forgotten_vmobjects;
+    m_cached_inodes.with([&](auto& cached_inodes) {
+        for (auto it = cached_inodes.lru_list.begin(); it != cached_inodes.lru_list.end();) {
+            auto& vmobject = *it;
+            ++it;
+            if (&vmobject.inode().fs() != &fs)
+                continue;
+            // Moving between lists briefly drops the list's reference.
+            LockRefPtr<SharedInodeVMObject> protector = &vmobject;
+            forgotten_vmobjects.append(vmobject);
+            --cached_inodes.count;
+        }
+    });
+    forgotten_vmobjects.clear();
+}
+
+}
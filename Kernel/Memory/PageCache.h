@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <Kernel/Forward.h>
+#include <Kernel/Library/NonnullLockRefPtr.h>
+#include <Kernel/Locking/SpinlockProtected.h>
+#include <Kernel/Memory/SharedInodeVMObject.h>
+
+namespace Kernel::Memory {
+
+// The page cache keeps file contents in memory, in the same SharedInodeVMObject that
+// mmap() uses for shared file mappings, so read(), write() and mapped accesses all see
+// (and share) the same physical pages. Cached inodes are kept in least-recently-used
+// order, and their pages are given back to the memory manager when it runs out.
+class PageCache {
+public:
+    static PageCache& the();
+
+    ErrorOr<NonnullLockRefPtr<SharedInodeVMObject>> vmobject_for(Inode&);
+
+    // Called with the memory manager lock held when physical memory runs out.
+    size_t try_release_pages(size_t page_count);
+
+    void forget(Inode&);
+    void forget_all_in(FileSystem const&);
+
+private:
+    // The number of inodes we keep a reference to, whether or not they have resident pages.
+    static constexpr size_t max_cached_inodes = 1024;
+
+    struct CachedInodes {
+        // Least recently used first.
+        SharedInodeVMObject::PageCacheList lru_list;
+        size_t count { 0 };
+    };
+    SpinlockProtected<CachedInodes> m_cached_inodes { LockRank::None };
+};
+
+}
@@ -56,7 +56,24 @@ void PhysicalRegion::initialize_zones()
         return zone_count;
     };
 
-    // First make 16 MiB zones (with 4096 pages each)
+    // Large zones should start on a large page boundary, so that their naturally aligned
+    // blocks of pages_per_large_page pages can be mapped as large pages.
+    // Put the pages in front of that boundary into zones of their own.
+    size_t pages_before_large_page_boundary = ((large_page_size - base_address.get() % large_page_size) % large_page_size) / PAGE_SIZE;
+    if (remaining_pages >= pages_before_large_page_boundary + large_zone_size / PAGE_SIZE) {
+        while (pages_before_large_page_boundary > 0) {
+            size_t pages_in_zone = 1u << count_trailing_zeroes(pages_before_large_page_boundary);
+            m_zones.append(adopt_nonnull_own_or_enomem(new (nothrow) PhysicalZone(base_address, pages_in_zone)).release_value_but_fixme_should_propagate_errors());
+            m_usable_zones.append(m_zones.last());
+            base_address = base_address.offset(pages_in_zone * PAGE_SIZE);
+            remaining_pages -= pages_in_zone;
+            pages_before_large_page_boundary -= pages_in_zone;
+            ++m_alignment_zones;
+        }
+    }
+    m_large_zone_base = base_address;
+
+    // Then make 16 MiB zones (with 4096 pages each)
     m_large_zones = make_zones(large_zone_size);
 
     // Then divide any remaining space into 1 MiB zones (with 256 pages each)
@@ -122,14 +139,21 @@ RefPtr<PhysicalPage> PhysicalRegion::take_free_page()
 
 void PhysicalRegion::return_page(PhysicalAddress paddr)
 {
-    auto large_zone_base = lower().get();
-    auto small_zone_base = lower().get() + (m_large_zones * large_zone_size);
+    auto large_zone_base = m_large_zone_base.get();
+    auto small_zone_base = large_zone_base + (m_large_zones * large_zone_size);
 
     size_t zone_index;
-    if (paddr.get() < small_zone_base)
-        zone_index = (paddr.get() - large_zone_base) / large_zone_size;
-    else
-        zone_index = m_large_zones + (paddr.get() - small_zone_base) / small_zone_size;
+    if (paddr.get() < large_zone_base) {
+        // There are only a handful of zones in front of the large ones, and they differ in size.
+        zone_index = 0;
+        while (!m_zones[zone_index].contains(paddr))
+            ++zone_index;
+        VERIFY(zone_index < m_alignment_zones);
+    } else if (paddr.get() < small_zone_base) {
+        zone_index = m_alignment_zones + (paddr.get() - large_zone_base) / large_zone_size;
+    } else {
+        zone_index = m_alignment_zones + m_large_zones + (paddr.get() - small_zone_base) / small_zone_size;
+    }
 
     auto& zone = m_zones[zone_index];
     VERIFY(zone.contains(paddr));
@@ -45,7 +45,9 @@ private:
 
     NonnullOwnPtrVector<PhysicalZone> m_zones;
 
+    size_t m_alignment_zones { 0 };
     size_t m_large_zones { 0 };
+    PhysicalAddress m_large_zone_base;
 
     PhysicalZone::List m_usable_zones;
     PhysicalZone::List m_full_zones;
@@ -238,6 +238,50 @@ bool Region::map_individual_page_impl(size_t page_index, RefPtr<PhysicalPage> pa
     return true;
 }
 
+bool Region::map_large_page_impl(size_t page_index)
+{
+    VERIFY(m_page_directory->get_lock().is_locked_by_current_processor());
+
+    auto page_vaddr = vaddr_from_page_index(page_index);
+    if (page_vaddr.get() % large_page_size || page_index + pages_per_large_page > page_count())
+        return false;
+
+    // NOTE: Kernel regions share their page tables with every address space, so we leave those alone.
+    //       Write-combining would need the PAT bit, which lives elsewhere in a large page entry.
+    if (!is_user() || !vmobject().is_anonymous() || !m_cacheable || is_write_combine() || (!is_readable() && !is_writable()))
+        return false;
+
+    PhysicalAddress large_page_paddr;
+    {
+        SpinlockLocker vmobject_locker(vmobject().m_lock);
+        for (size_t i = 0; i < pages_per_large_page; ++i) {
+            auto page = physical_page(page_index + i);
+            if (!page || page->is_shared_zero_page() || page->is_lazy_committed_page() || should_cow(page_index + i))
+                return false;
+            if (i == 0)
+                large_page_paddr = page->paddr();
+            if (page->paddr() != large_page_paddr.offset(i * PAGE_SIZE))
+                return false;
+        }
+    }
+    if (large_page_paddr.get() % large_page_size)
+        return false;
+
+    auto* pde = MM.ensure_large_page_pde(*m_page_directory, page_vaddr);
+    if (!pde)
+        return false;
+
+    pde->set_page_table_base(large_page_paddr.get());
+    pde->set_huge(true);
+    pde->set_present(true);
+    pde->set_writable(is_writable());
+    if (Processor::current().has_nx())
+        pde->set_execute_disabled(!is_executable());
+    pde->set_user_allowed(true);
+
+    return true;
+}
+
 bool Region::map_individual_page_impl(size_t page_index)
 {
     RefPtr<PhysicalPage> page;
@@ -249,7 +293,7 @@ bool Region::map_individual_page_impl(size_t page_index)
     return map_individual_page_impl(page_index, page);
 }
 
-bool Region::remap_vmobject_page(size_t page_index, NonnullRefPtr<PhysicalPage> physical_page)
+bool Region::remap_vmobject_page(size_t page_index, RefPtr<PhysicalPage> physical_page)
 {
     SpinlockLocker page_lock(m_page_directory->get_lock());
 
@@ -262,6 +306,19 @@ bool Region::remap_vmobject_page(size_t page_index, NonnullRefPtr<PhysicalPage>
     return success;
 }
 
+bool Region::test_and_clear_accessed(size_t page_index)
+{
+    if (!m_page_directory)
+        return false;
+    SpinlockLocker page_lock(m_page_directory->get_lock());
+
+    // NOTE: `page_index` is a VMObject page index, so first we convert it to a Region page index.
+    if (!translate_vmobject_page(page_index))
+        return false;
+
+    return MM.test_and_clear_accessed(*m_page_directory, vaddr_from_page_index(page_index));
+}
+
 void Region::unmap(ShouldFlushTLB should_flush_tlb)
 {
     if (!m_page_directory)
@@ -302,6 +359,10 @@ ErrorOr<void> Region::map(PageDirectory& page_directory, ShouldFlushTLB should_f
     set_page_directory(page_directory);
     size_t page_index = 0;
     while (page_index < page_count()) {
+        if (map_large_page_impl(page_index)) {
+            page_index += pages_per_large_page;
+            continue;
+        }
         if (!map_individual_page_impl(page_index))
             break;
         ++page_index;
@@ -309,12 +370,21 @@ ErrorOr<void> Region::map(PageDirectory& page_directory, ShouldFlushTLB should_f
     if (page_index > 0) {
         if (should_flush_tlb == ShouldFlushTLB::Yes)
             MemoryManager::flush_tlb(m_page_directory, vaddr(), page_index);
-        if (page_index == page_count())
+        if (page_index == page_count()) {
+            m_map_on_first_fault = false;
             return {};
+        }
     }
     return ENOMEM;
 }
 
+void Region::map_on_first_fault(PageDirectory& page_directory)
+{
+    SpinlockLocker page_lock(page_directory.get_lock());
+    set_page_directory(page_directory);
+    m_map_on_first_fault = true;
+}
+
 void Region::remap()
 {
     VERIFY(m_page_directory);
@@ -341,8 +411,9 @@ void Region::clear_to_zero()
     SpinlockLocker locker(vmobject().m_lock);
     for (auto i = 0u; i < page_count(); ++i) {
         auto& page = physical_page_slot(i);
-        VERIFY(page);
-        if (page->is_shared_zero_page())
+        if (!page)
+            static_cast<AnonymousVMObject&>(vmobject()).discard_compressed_page(translate_to_vmobject_page(i));
+        else if (page->is_shared_zero_page())
             continue;
         page = MM.shared_zero_page();
     }
@@ -350,7 +421,23 @@ void Region::clear_to_zero()
 
 PageFaultResponse Region::handle_fault(PageFault const& fault)
 {
+    if (m_map_on_first_fault) {
+        VERIFY(m_page_directory);
+        SpinlockLocker page_lock(m_page_directory->get_lock());
+        // Another thread may have beaten us to it, in which case there's nothing left to do but retry.
+        if (m_map_on_first_fault && map(*m_page_directory, ShouldFlushTLB::No).is_error())
+            return PageFaultResponse::OutOfMemory;
+        // If the access wasn't allowed after all, it will simply fault again.
+        return PageFaultResponse::Continue;
+    }
+
     auto page_index_in_region = page_index_from_address(fault.vaddr());
+    if (vmobject().is_anonymous()) {
+        // Whatever the access ran into, the page may have been compressed before we got here.
+        auto response = static_cast<AnonymousVMObject&>(vmobject()).try_handle_compressed_page_fault(translate_to_vmobject_page(page_index_in_region));
+        if (response.has_value())
+            return response.value();
+    }
     if (fault.type() == PageFault::Type::PageNotPresent) {
         if (fault.is_read() && !is_readable()) {
             dbgln("NP(non-readable) fault in Region({})[{}]", this, page_index_in_region);
@@ -367,6 +454,10 @@ PageFaultResponse Region::handle_fault(PageFault const& fault)
 
         SpinlockLocker vmobject_locker(vmobject().m_lock);
         auto& page_slot = physical_page_slot(page_index_in_region);
+        if (!page_slot) {
+            // The page was compressed after we checked above, so we'll simply fault on it again.
+            return PageFaultResponse::Continue;
+        }
         if (page_slot->is_lazy_committed_page()) {
             auto page_index_in_vmobject = translate_to_vmobject_page(page_index_in_region);
             VERIFY(m_vmobject->is_anonymous());
@@ -375,6 +466,13 @@ PageFaultResponse Region::handle_fault(PageFault const& fault)
                 return PageFaultResponse::OutOfMemory;
             return PageFaultResponse::Continue;
         }
+        if (!page_slot->is_shared_zero_page()) {
+            // Someone else brought the page back from the compressed page pool while we were on our way here.
+            dbgln_if(PAGE_FAULT_DEBUG, "NP fault in Region({})[{}] for a page that was decompressed, remapping.", this, page_index_in_region);
+            if (!remap_vmobject_page(translate_to_vmobject_page(page_index_in_region), *page_slot))
+                return PageFaultResponse::OutOfMemory;
+            return PageFaultResponse::Continue;
+        }
         dbgln("BUG! Unexpected NP fault at {}", fault.vaddr());
         dbgln("     - Physical page slot pointer: {:p}", page_slot.ptr());
         if (page_slot) {
@@ -385,9 +483,13 @@ PageFaultResponse Region::handle_fault(PageFault const& fault)
         return PageFaultResponse::ShouldCrash;
     }
     VERIFY(fault.type() == PageFault::Type::ProtectionViolation);
+    // As above, the page may have been compressed after we checked. We only look at the slot once,
+    // as it may be emptied again as soon as the VMObject is unlocked.
+    auto phys_page = physical_page(page_index_in_region);
+    if (vmobject().is_anonymous() && !phys_page)
+        return PageFaultResponse::Continue;
     if (fault.access() == PageFault::Access::Write && is_writable() && should_cow(page_index_in_region)) {
         dbgln_if(PAGE_FAULT_DEBUG, "PV(cow) fault in Region({})[{}] at {}", this, page_index_in_region, fault.vaddr());
-        auto phys_page = physical_page(page_index_in_region);
         if (phys_page->is_shared_zero_page() || phys_page->is_lazy_committed_page()) {
             dbgln_if(PAGE_FAULT_DEBUG, "NP(zero) fault in Region({})[{}] at {}", this, page_index_in_region, fault.vaddr());
             return handle_zero_fault(page_index_in_region, *phys_page);
@@ -412,6 +514,8 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region, Physica
 
     if (page_in_slot_at_time_of_fault.is_lazy_committed_page()) {
         VERIFY(m_vmobject->is_anonymous());
+        if (auto response = try_handle_zero_fault_with_large_page(page_index_in_region); response.has_value())
+            return response.value();
         new_physical_page = static_cast<AnonymousVMObject&>(*m_vmobject).allocate_committed_page({});
         dbgln_if(PAGE_FAULT_DEBUG, "      >> ALLOCATED COMMITTED {}", new_physical_page->paddr());
     } else {
@@ -446,6 +550,35 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region, Physica
     return PageFaultResponse::Continue;
 }
 
+Optional<PageFaultResponse> Region::try_handle_zero_fault_with_large_page(size_t page_index_in_region)
+{
+    // If the large page around the faulting address lies entirely within this region and none of it
+    // has been touched yet, populate all of it at once and map it with a single page directory entry.
+    auto large_page_vaddr = VirtualAddress { vaddr_from_page_index(page_index_in_region).get() & ~(large_page_size - 1) };
+    if (large_page_vaddr < vaddr() || large_page_vaddr.offset(large_page_size) > vaddr().offset(size()))
+        return {};
+    if (!is_user() || !m_cacheable || is_write_combine())
+        return {};
+
+    auto first_page_index_in_region = (large_page_vaddr - vaddr()).get() / PAGE_SIZE;
+    auto first_page_index_in_vmobject = translate_to_vmobject_page(first_page_index_in_region);
+    if (!static_cast<AnonymousVMObject&>(*m_vmobject).try_allocate_committed_large_page({}, first_page_index_in_vmobject))
+        return {};
+    dbgln_if(PAGE_FAULT_DEBUG, "      >> ALLOCATED COMMITTED LARGE PAGE @ {}", large_page_vaddr);
+
+    SpinlockLocker page_lock(m_page_directory->get_lock());
+    if (!map_large_page_impl(first_page_index_in_region)) {
+        for (size_t i = 0; i < pages_per_large_page; ++i) {
+            if (!map_individual_page_impl(first_page_index_in_region + i)) {
+                dmesgln("MM: handle_zero_fault was unable to allocate a page table to map {}", large_page_vaddr);
+                return PageFaultResponse::OutOfMemory;
+            }
+        }
+    }
+    MemoryManager::flush_tlb(m_page_directory, large_page_vaddr, pages_per_large_page);
+    return PageFaultResponse::Continue;
+}
+
 PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
 {
     auto current_thread = Thread::current();
@@ -457,7 +590,11 @@ PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
 
     auto page_index_in_vmobject = translate_to_vmobject_page(page_index_in_region);
     auto response = reinterpret_cast<AnonymousVMObject&>(vmobject()).handle_cow_fault(page_index_in_vmobject, vaddr().offset(page_index_in_region * PAGE_SIZE));
-    if (!remap_vmobject_page(page_index_in_vmobject, *vmobject().physical_pages()[page_index_in_vmobject]))
+    auto page = physical_page(page_index_in_region);
+    // The page was compressed in the meantime, which also unmapped it, so we'll simply fault on it again.
+    if (!page)
+        return response;
+    if (!remap_vmobject_page(page_index_in_vmobject, *page))
         return PageFaultResponse::OutOfMemory;
     return response;
 }
@@ -489,6 +626,33 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
     if (current_thread)
         current_thread->did_inode_fault();
 
+    if (inode_vmobject.is_shared_inode()) {
+        // Shared mappings use the same pages as the page cache, so we let it bring the page in.
+        auto& shared_inode_vmobject = static_cast<SharedInodeVMObject&>(inode_vmobject);
+        for (;;) {
+            auto physical_page_or_error = shared_inode_vmobject.ensure_page(page_index_in_vmobject);
+            if (physical_page_or_error.is_error()) {
+                dmesgln("handle_inode_fault: Error ({}) while reading from inode", physical_page_or_error.error());
+                if (physical_page_or_error.error().code() == ENOMEM)
+                    return PageFaultResponse::OutOfMemory;
+                return PageFaultResponse::ShouldCrash;
+            }
+            auto physical_page = physical_page_or_error.release_value();
+            // Note: If there is no page, we are at the end of file or after it,
+            // which means we should return bus error.
+            if (!physical_page)
+                return PageFaultResponse::BusError;
+
+            SpinlockLocker locker(inode_vmobject.m_lock);
+            // The page may have been released again while we weren't holding the lock.
+            if (vmobject_physical_page_slot != physical_page)
+                continue;
+            if (!remap_vmobject_page(page_index_in_vmobject, *physical_page))
+                return PageFaultResponse::OutOfMemory;
+            return PageFaultResponse::Continue;
+        }
+    }
+
     u8 page_buffer[PAGE_SIZE];
     auto& inode = inode_vmobject.inode();
 
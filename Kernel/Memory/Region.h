@@ -32,6 +32,7 @@ enum class ShouldFlushTLB {
 class Region final
     : public LockWeakable<Region> {
     friend class AddressSpace;
+    friend class AnonymousVMObject;
     friend class MemoryManager;
     friend class RegionTree;
 
@@ -191,6 +192,10 @@ public:
 
     void set_page_directory(PageDirectory&);
     ErrorOr<void> map(PageDirectory&, ShouldFlushTLB = ShouldFlushTLB::Yes);
+    // Attaches the region to the page directory without filling in any page table entries.
+    // That happens all at once when the region first faults, so regions that are never touched
+    // (like most of them in a process that was forked only to exec) never have their tables built.
+    void map_on_first_fault(PageDirectory&);
     void unmap(ShouldFlushTLB = ShouldFlushTLB::Yes);
     void unmap_with_locks_held(ShouldFlushTLB, SpinlockLocker<RecursiveSpinlock>& pd_locker);
 
@@ -211,7 +216,9 @@ private:
     Region(NonnullLockRefPtr<VMObject>, size_t offset_in_vmobject, OwnPtr<KString>, Region::Access access, Cacheable, bool shared);
     Region(VirtualRange const&, NonnullLockRefPtr<VMObject>, size_t offset_in_vmobject, OwnPtr<KString>, Region::Access access, Cacheable, bool shared);
 
-    [[nodiscard]] bool remap_vmobject_page(size_t page_index, NonnullRefPtr<PhysicalPage>);
+    // Unmaps the page if there's no physical page.
+    [[nodiscard]] bool remap_vmobject_page(size_t page_index, RefPtr<PhysicalPage>);
+    [[nodiscard]] bool test_and_clear_accessed(size_t page_index_in_vmobject);
 
     void set_access_bit(Access access, bool b)
     {
@@ -224,9 +231,11 @@ private:
     [[nodiscard]] PageFaultResponse handle_cow_fault(size_t page_index);
     [[nodiscard]] PageFaultResponse handle_inode_fault(size_t page_index);
     [[nodiscard]] PageFaultResponse handle_zero_fault(size_t page_index, PhysicalPage& page_in_slot_at_time_of_fault);
+    [[nodiscard]] Optional<PageFaultResponse> try_handle_zero_fault_with_large_page(size_t page_index);
 
     [[nodiscard]] bool map_individual_page_impl(size_t page_index);
     [[nodiscard]] bool map_individual_page_impl(size_t page_index, RefPtr<PhysicalPage>);
+    [[nodiscard]] bool map_large_page_impl(size_t page_index);
 
     LockRefPtr<PageDirectory> m_page_directory;
     VirtualRange m_range;
@@ -243,6 +252,8 @@ private:
     bool m_write_combine : 1 { false };
     bool m_mmapped_from_readable : 1 { false };
     bool m_mmapped_from_writable : 1 { false };
+    // Protected by the page directory lock. Not a bitfield, so that it can be checked without it.
+    bool m_map_on_first_fault { false };
 
     IntrusiveRedBlackTreeNode<FlatPtr, Region, RawPtr<Region>> m_tree_node;
     IntrusiveListNode<Region> m_vmobject_list_node;
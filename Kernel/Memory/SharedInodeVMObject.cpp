@@ -5,7 +5,9 @@
  */
 
 #include <Kernel/FileSystem/Inode.h>
+#include <Kernel/InterruptDisabler.h>
 #include <Kernel/Locking/Spinlock.h>
+#include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Memory/SharedInodeVMObject.h>
 
 namespace Kernel::Memory {
@@ -69,4 +71,145 @@ ErrorOr<void> SharedInodeVMObject::sync(off_t offset_in_pages, size_t pages)
     return {};
 }
 
+ErrorOr<RefPtr<PhysicalPage>> SharedInodeVMObject::ensure_page(size_t page_index)
+{
+    if (page_index >= page_count())
+        return RefPtr<PhysicalPage> {};
+
+    for (;;) {
+        auto write_generation = m_write_generation.load();
+        {
+            SpinlockLocker locker(m_lock);
+            if (auto physical_page = m_physical_pages[page_index])
+                return physical_page;
+        }
+
+        u8 page_buffer[PAGE_SIZE];
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(page_buffer);
+        auto nread = TRY(m_inode->read_bytes_for_page_cache(page_index * PAGE_SIZE, PAGE_SIZE, buffer));
+        if (nread == 0)
+            return RefPtr<PhysicalPage> {};
+        if (nread < PAGE_SIZE) {
+            // If we read less than a page, zero out the rest to avoid leaking uninitialized data.
+            memset(page_buffer + nread, 0, PAGE_SIZE - nread);
+        }
+
+        auto new_physical_page = TRY(MM.allocate_physical_page(MemoryManager::ShouldZeroFill::No));
+        {
+            InterruptDisabler disabler;
+            u8* dest_ptr = MM.quickmap_page(*new_physical_page);
+            memcpy(dest_ptr, page_buffer, PAGE_SIZE);
+            MM.unquickmap_page();
+        }
+
+        SpinlockLocker locker(m_lock);
+        auto& physical_page_slot = m_physical_pages[page_index];
+        if (physical_page_slot)
+            return physical_page_slot;
+        // The inode was written to while we were reading it, so what we read may be stale.
+        if (write_generation != m_write_generation.load())
+            continue;
+        physical_page_slot = move(new_physical_page);
+        return physical_page_slot;
+    }
+}
+
+bool SharedInodeVMObject::has_all_pages_in_range(u64 offset, size_t size) const
+{
+    SpinlockLocker locker(m_lock);
+    auto first_page_index = offset / PAGE_SIZE;
+    auto end_page_index = ceil_div(offset + size, static_cast<u64>(PAGE_SIZE));
+    if (end_page_index > page_count())
+        return false;
+    for (auto page_index = first_page_index; page_index < end_page_index; ++page_index) {
+        if (!m_physical_pages[page_index])
+            return false;
+    }
+    return true;
+}
+
+ErrorOr<void> SharedInodeVMObject::copy_from_page(PhysicalPage& physical_page, size_t offset_in_page, UserOrKernelBuffer& buffer, size_t buffer_offset, size_t size)
+{
+    VERIFY(offset_in_page + size <= PAGE_SIZE);
+    if (buffer.is_kernel_buffer()) {
+        // Kernel buffers can't fault, so they can be copied into straight from the quickmapped page.
+        auto* page_ptr = MM.quickmap_page(physical_page);
+        auto result = buffer.write(page_ptr + offset_in_page, buffer_offset, size);
+        MM.unquickmap_page();
+        return result;
+    }
+
+    // NOTE: Copying to userspace may fault, which we can't handle while the page is quickmapped.
+    u8 chunk_buffer[PAGE_SIZE];
+    auto* page_ptr = MM.quickmap_page(physical_page);
+    memcpy(chunk_buffer, page_ptr + offset_in_page, size);
+    MM.unquickmap_page();
+    return buffer.write(chunk_buffer, buffer_offset, size);
+}
+
+void SharedInodeVMObject::did_write(u64 offset, ReadonlyBytes data)
+{
+    ++m_write_generation;
+
+    size_t nprocessed = 0;
+    while (nprocessed < data.size()) {
+        auto position = offset + nprocessed;
+        auto page_index = position / PAGE_SIZE;
+        if (page_index >= page_count())
+            break;
+        size_t offset_in_page = position % PAGE_SIZE;
+        size_t chunk_size = min(PAGE_SIZE - offset_in_page, data.size() - nprocessed);
+
+        SpinlockLocker locker(m_lock);
+        if (auto& physical_page = m_physical_pages[page_index]) {
+            InterruptDisabler disabler;
+            u8* page_ptr = MM.quickmap_page(*physical_page);
+            memcpy(page_ptr + offset_in_page, data.offset_pointer(nprocessed), chunk_size);
+            MM.unquickmap_page();
+        }
+        nprocessed += chunk_size;
+    }
+}
+
+void SharedInodeVMObject::did_truncate(u64 new_size)
+{
+    ++m_write_generation;
+
+    SpinlockLocker locker(m_lock);
+    bool dropped_any_page = false;
+    for (auto page_index = ceil_div(new_size, static_cast<u64>(PAGE_SIZE)); page_index < page_count(); ++page_index) {
+        if (m_physical_pages[page_index]) {
+            m_physical_pages[page_index] = nullptr;
+            dropped_any_page = true;
+        }
+    }
+
+    // Whatever lies beyond the new end of the file in its last page has to read back as zeroes.
+    auto last_page_index = new_size / PAGE_SIZE;
+    size_t offset_in_last_page = new_size % PAGE_SIZE;
+    if (offset_in_last_page && last_page_index < page_count() && m_physical_pages[last_page_index]) {
+        InterruptDisabler disabler;
+        u8* page_ptr = MM.quickmap_page(*m_physical_pages[last_page_index]);
+        memset(page_ptr + offset_in_last_page, 0, PAGE_SIZE - offset_in_last_page);
+        MM.unquickmap_page();
+    }
+
+    if (dropped_any_page) {
+        for_each_region([](auto& region) {
+            region.remap();
+        });
+    }
+}
+
+void SharedInodeVMObject::drop_page(size_t page_index)
+{
+    SpinlockLocker locker(m_lock);
+    if (!m_physical_pages[page_index])
+        return;
+    m_physical_pages[page_index] = nullptr;
+    for_each_region([](auto& region) {
+        region.remap();
+    });
+}
+
 }
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/IntrusiveList.h>
 #include <Kernel/Memory/InodeVMObject.h>
 #include <Kernel/UnixTypes.h>
 
@@ -21,7 +22,20 @@ public:
 
     ErrorOr<void> sync(off_t offset_in_pages = 0, size_t pages = -1);
 
+    // Returns the page at the given index, reading it from the inode if it isn't resident.
+    // Returns null if the page lies entirely beyond the end of the file.
+    ErrorOr<RefPtr<PhysicalPage>> ensure_page(size_t page_index);
+    bool has_all_pages_in_range(u64 offset, size_t size) const;
+    static ErrorOr<void> copy_from_page(PhysicalPage&, size_t offset_in_page, UserOrKernelBuffer&, size_t buffer_offset, size_t size);
+
+    // Keeps resident pages in sync with data written to the inode, or with the inode shrinking.
+    // NOTE: The written data must be the very copy that went to the inode, not something that may have changed since.
+    void did_write(u64 offset, ReadonlyBytes);
+    void did_truncate(u64 new_size);
+
 private:
+    friend class PageCache;
+
     virtual bool is_shared_inode() const override { return true; }
 
     explicit SharedInodeVMObject(Inode&, FixedArray<RefPtr<PhysicalPage>>&&, Bitmap dirty_pages);
@@ -30,6 +44,15 @@ private:
     virtual StringView class_name() const override { return "SharedInodeVMObject"sv; }
 
     SharedInodeVMObject& operator=(SharedInodeVMObject const&) = delete;
+
+    void drop_page(size_t page_index);
+
+    // Bumped by every write, so that a page read from the inode before the write isn't installed after it.
+    Atomic<u64> m_write_generation { 0 };
+    IntrusiveListNode<SharedInodeVMObject, LockRefPtr<SharedInodeVMObject>> m_page_cache_list_node;
+
+public:
+    using PageCacheList = IntrusiveList<&SharedInodeVMObject::m_page_cache_list_node>;
 };
 
 }
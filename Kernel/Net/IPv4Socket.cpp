@@ -246,6 +246,21 @@ ErrorOr<size_t> IPv4Socket::sendto(OpenFileDescription&, UserOrKernelBuffer cons
     return nsent_or_error;
 }
 
+ErrorOr<size_t> IPv4Socket::send_from_inode(OpenFileDescription&, Inode const& inode, off_t offset, size_t length)
+{
+    MutexLocker locker(mutex());
+
+    if (type() != SOCK_STREAM)
+        return ENOTSUP;
+    if (is_shut_down_for_writing() || !is_connected())
+        return set_so_error(EPIPE);
+
+    auto nsent_or_error = protocol_send_from_inode(inode, offset, length);
+    if (!nsent_or_error.is_error())
+        Thread::current()->did_ipv4_socket_write(nsent_or_error.value());
+    return nsent_or_error;
+}
+
 ErrorOr<size_t> IPv4Socket::receive_byte_buffered(OpenFileDescription& description, UserOrKernelBuffer& buffer, size_t buffer_length, int flags, Userspace<sockaddr*>, Userspace<socklen_t*>, bool blocking)
 {
     MutexLocker locker(mutex());
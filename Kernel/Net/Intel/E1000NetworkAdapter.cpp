@@ -245,8 +245,8 @@ bool E1000NetworkAdapter::handle_irq(RegisterState const&)
     if (status & INTERRUPT_RXO) {
         dbgln_if(E1000_DEBUG, "E1000: RX buffer overrun");
     }
-    if (status & INTERRUPT_RXT0) {
-        receive();
+    if (status & (INTERRUPT_RXT0 | INTERRUPT_RXO)) {
+        schedule_receive_poll();
     }
 
     m_wait_queue.wake_all();
@@ -416,13 +416,28 @@ void E1000NetworkAdapter::send_raw(ReadonlyBytes payload)
     dbgln_if(E1000_DEBUG, "E1000: Sent packet, status is now {:#02x}!", (u8)descriptor.status);
 }
 
-void E1000NetworkAdapter::receive()
+u32 E1000NetworkAdapter::next_rx_descriptor_index()
+{
+    return (in32(REG_RXDESCTAIL) + 1) % number_of_rx_descriptors;
+}
+
+bool E1000NetworkAdapter::has_received_frames()
 {
     auto* rx_descriptors = (e1000_tx_desc*)m_rx_descriptors_region->vaddr().as_ptr();
-    u32 rx_current;
-    for (;;) {
-        rx_current = in32(REG_RXDESCTAIL) % number_of_rx_descriptors;
-        rx_current = (rx_current + 1) % number_of_rx_descriptors;
+    return rx_descriptors[next_rx_descriptor_index()].status & 1;
+}
+
+void E1000NetworkAdapter::set_receive_interrupts_enabled(bool enabled)
+{
+    out32(enabled ? REG_INTERRUPT_MASK_SET : REG_INTERRUPT_MASK_CLEAR, INTERRUPT_RXT0 | INTERRUPT_RXO);
+}
+
+size_t E1000NetworkAdapter::receive_batch(size_t budget)
+{
+    auto* rx_descriptors = (e1000_tx_desc*)m_rx_descriptors_region->vaddr().as_ptr();
+    size_t received = 0;
+    while (received < budget) {
+        u32 rx_current = next_rx_descriptor_index();
         if (!(rx_descriptors[rx_current].status & 1))
             break;
         auto* buffer = m_rx_buffers[rx_current];
@@ -432,7 +447,9 @@ void E1000NetworkAdapter::receive()
         did_receive({ buffer, length });
         rx_descriptors[rx_current].status = 0;
         out32(REG_RXDESCTAIL, rx_current);
+        ++received;
     }
+    return received;
 }
 
 i32 E1000NetworkAdapter::link_speed()
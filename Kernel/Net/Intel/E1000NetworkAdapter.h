@@ -41,6 +41,10 @@ protected:
     virtual bool handle_irq(RegisterState const&) override;
     virtual StringView class_name() const override { return "E1000NetworkAdapter"sv; }
 
+    virtual size_t receive_batch(size_t budget) override;
+    virtual bool has_received_frames() override;
+    virtual void set_receive_interrupts_enabled(bool) override;
+
     struct [[gnu::packed]] e1000_rx_desc {
         volatile uint64_t addr { 0 };
         volatile uint16_t length { 0 };
@@ -77,7 +81,7 @@ protected:
     u16 in16(u16 address);
     u32 in32(u16 address);
 
-    void receive();
+    u32 next_rx_descriptor_index();
 
     static constexpr size_t number_of_rx_descriptors = 256;
     static constexpr size_t number_of_tx_descriptors = 256;
@@ -95,6 +95,30 @@ void NetworkAdapter::did_receive(ReadonlyBytes payload)
         on_receive();
 }
 
+void NetworkAdapter::schedule_receive_poll()
+{
+    set_receive_interrupts_enabled(false);
+    m_receive_poll_scheduled = true;
+    if (on_receive)
+        on_receive();
+}
+
+size_t NetworkAdapter::poll_receive(size_t budget)
+{
+    auto received = receive_batch(budget);
+    if (received == budget)
+        return received;
+
+    m_receive_poll_scheduled = false;
+    set_receive_interrupts_enabled(true);
+    // A frame that arrived after we stopped looking may not have raised an interrupt.
+    if (has_received_frames()) {
+        set_receive_interrupts_enabled(false);
+        m_receive_poll_scheduled = true;
+    }
+    return received;
+}
+
 size_t NetworkAdapter::dequeue_packet(u8* buffer, size_t buffer_size, Time& packet_timestamp)
 {
     InterruptDisabler disabler;
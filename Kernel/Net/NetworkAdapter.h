@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
 #include <AK/AtomicRefCounted.h>
 #include <AK/ByteBuffer.h>
 #include <AK/Function.h>
@@ -93,12 +94,25 @@ public:
 
     void send_packet(ReadonlyBytes);
 
+    // Adapters that support polling turn off their receive interrupt when a frame arrives,
+    // and leave it to the network task to fetch frames in batches until they run dry.
+    // This keeps a busy adapter from raising an interrupt for every single frame.
+    bool is_receive_poll_scheduled() const { return m_receive_poll_scheduled; }
+    size_t poll_receive(size_t budget);
+
 protected:
     NetworkAdapter(NonnullOwnPtr<KString>);
     void set_mac_address(MACAddress const& mac_address) { m_mac_address = mac_address; }
     void did_receive(ReadonlyBytes);
     virtual void send_raw(ReadonlyBytes) = 0;
 
+    // Called by the interrupt handler instead of receiving frames right away.
+    void schedule_receive_poll();
+    // Receives at most `budget` frames, and returns how many there were.
+    virtual size_t receive_batch(size_t) { return 0; }
+    virtual bool has_received_frames() { return false; }
+    virtual void set_receive_interrupts_enabled(bool) { }
+
 private:
     MACAddress m_mac_address;
     IPv4Address m_ipv4_address;
@@ -118,6 +132,7 @@ private:
     u32 m_packets_out { 0 };
     u32 m_bytes_out { 0 };
     u32 m_mtu { 1500 };
+    Atomic<bool> m_receive_poll_scheduled { false };
 };
 
 }
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/ScopeGuard.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Locking/Mutex.h>
 #include <Kernel/Locking/MutexProtected.h>
@@ -25,6 +26,7 @@
 
 namespace Kernel {
 
+static void handle_frame(u8 const* buffer, size_t frame_size, Time const& packet_timestamp);
 static void handle_arp(EthernetFrameHeader const&, size_t frame_size);
 static void handle_ipv4(EthernetFrameHeader const&, size_t frame_size, Time const& packet_timestamp);
 static void handle_icmp(EthernetFrameHeader const&, IPv4Packet const&, Time const& packet_timestamp);
@@ -38,6 +40,25 @@ static void retransmit_tcp_packets();
 static Thread* network_task = nullptr;
 static HashTable<LockRefPtr<TCPSocket>>* delayed_ack_sockets;
 
+static constexpr size_t receive_batch_size = 64;
+static constexpr size_t receive_budget_per_adapter = 64;
+
+// Consecutive segments for the same connection within a batch are handled with
+// a single lookup and acquisition of the socket's mutex.
+struct TCPReceiveBatch {
+    LockRefPtr<TCPSocket> socket;
+    MutexLocker locker;
+
+    void finish()
+    {
+        if (!socket)
+            return;
+        locker.unlock();
+        socket = nullptr;
+    }
+};
+static TCPReceiveBatch* tcp_receive_batch;
+
 [[noreturn]] static void NetworkTask_main(void*);
 
 void NetworkTask::spawn()
@@ -58,9 +79,9 @@ bool NetworkTask::is_current()
 void NetworkTask_main(void*)
 {
     delayed_ack_sockets = new HashTable<LockRefPtr<TCPSocket>>;
+    tcp_receive_batch = new TCPReceiveBatch;
 
     WaitQueue packet_wait_queue;
-    int pending_packets = 0;
     NetworkingManagement::the().for_each([&](auto& adapter) {
         dmesgln("NetworkTask: {} network adapter found: hw={}", adapter.class_name(), adapter.mac_address().to_string());
 
@@ -70,63 +91,95 @@ void NetworkTask_main(void*)
         }
 
         adapter.on_receive = [&]() {
-            pending_packets++;
             packet_wait_queue.wake_all();
         };
     });
 
-    auto dequeue_packet = [&pending_packets](u8* buffer, size_t buffer_size, Time& packet_timestamp) -> size_t {
-        if (pending_packets == 0)
-            return 0;
-        size_t packet_size = 0;
-        NetworkingManagement::the().for_each([&](auto& adapter) {
-            if (packet_size || !adapter.has_queued_packets())
-                return;
-            packet_size = adapter.dequeue_packet(buffer, buffer_size, packet_timestamp);
-            pending_packets--;
-            dbgln_if(NETWORK_TASK_DEBUG, "NetworkTask: Dequeued packet from {} ({} bytes)", adapter.name(), packet_size);
-        });
-        return packet_size;
+    // Frames are handled in batches: First we let every adapter that wants to be polled
+    // receive up to a budget of frames, then we copy out as many queued frames as fit into
+    // our buffer, and only then do we process them, all without waiting in between.
+    struct Frame {
+        size_t offset { 0 };
+        size_t size { 0 };
+        Time timestamp;
     };
+    Vector<Frame, receive_batch_size> frames;
 
-    size_t buffer_size = 64 * KiB;
+    // NOTE: A single frame is never bigger than this.
+    constexpr size_t maximum_frame_size = 64 * KiB;
+    size_t buffer_size = 4 * maximum_frame_size;
     auto region_or_error = MM.allocate_kernel_region(buffer_size, "Kernel Packet Buffer"sv, Memory::Region::Access::ReadWrite);
     if (region_or_error.is_error())
         TODO();
     auto buffer_region = region_or_error.release_value();
     auto buffer = (u8*)buffer_region->vaddr().get();
-    Time packet_timestamp;
+
+    auto dequeue_frames = [&]() {
+        frames.clear_with_capacity();
+        size_t offset = 0;
+        NetworkingManagement::the().for_each([&](auto& adapter) {
+            while (frames.size() < receive_batch_size && buffer_size - offset >= maximum_frame_size && adapter.has_queued_packets()) {
+                Time packet_timestamp;
+                auto packet_size = adapter.dequeue_packet(buffer + offset, buffer_size - offset, packet_timestamp);
+                if (!packet_size)
+                    break;
+                dbgln_if(NETWORK_TASK_DEBUG, "NetworkTask: Dequeued packet from {} ({} bytes)", adapter.name(), packet_size);
+                frames.unchecked_append({ offset, packet_size, packet_timestamp });
+                offset += packet_size;
+            }
+        });
+    };
 
     for (;;) {
         flush_delayed_tcp_acks();
         retransmit_tcp_packets();
-        size_t packet_size = dequeue_packet(buffer, buffer_size, packet_timestamp);
-        if (!packet_size) {
+
+        bool has_more_to_poll = false;
+        NetworkingManagement::the().for_each([&](auto& adapter) {
+            if (!adapter.is_receive_poll_scheduled())
+                return;
+            adapter.poll_receive(receive_budget_per_adapter);
+            has_more_to_poll |= adapter.is_receive_poll_scheduled();
+        });
+
+        dequeue_frames();
+        if (frames.is_empty()) {
+            if (has_more_to_poll)
+                continue;
             auto timeout_time = Time::from_milliseconds(500);
             auto timeout = Thread::BlockTimeout { false, &timeout_time };
             [[maybe_unused]] auto result = packet_wait_queue.wait_on(timeout, "NetworkTask"sv);
             continue;
         }
-        if (packet_size < sizeof(EthernetFrameHeader)) {
-            dbgln("NetworkTask: Packet is too small to be an Ethernet packet! ({})", packet_size);
-            continue;
-        }
-        auto& eth = *(EthernetFrameHeader const*)buffer;
-        dbgln_if(ETHERNET_DEBUG, "NetworkTask: From {} to {}, ether_type={:#04x}, packet_size={}", eth.source().to_string(), eth.destination().to_string(), eth.ether_type(), packet_size);
-
-        switch (eth.ether_type()) {
-        case EtherType::ARP:
-            handle_arp(eth, packet_size);
-            break;
-        case EtherType::IPv4:
-            handle_ipv4(eth, packet_size, packet_timestamp);
-            break;
-        case EtherType::IPv6:
-            // ignore
-            break;
-        default:
-            dbgln_if(ETHERNET_DEBUG, "NetworkTask: Unknown ethernet type {:#04x}", eth.ether_type());
-        }
+
+        for (auto& frame : frames)
+            handle_frame(buffer + frame.offset, frame.size, frame.timestamp);
+        tcp_receive_batch->finish();
+    }
+}
+
+void handle_frame(u8 const* buffer, size_t packet_size, Time const& packet_timestamp)
+{
+    if (packet_size < sizeof(EthernetFrameHeader)) {
+        dbgln("NetworkTask: Packet is too small to be an Ethernet packet! ({})", packet_size);
+        return;
+    }
+    auto& eth = *(EthernetFrameHeader const*)buffer;
+    dbgln_if(ETHERNET_DEBUG, "NetworkTask: From {} to {}, ether_type={:#04x}, packet_size={}", eth.source().to_string(), eth.destination().to_string(), eth.ether_type(), packet_size);
+
+    switch (eth.ether_type()) {
+    case EtherType::ARP:
+        tcp_receive_batch->finish();
+        handle_arp(eth, packet_size);
+        break;
+    case EtherType::IPv4:
+        handle_ipv4(eth, packet_size, packet_timestamp);
+        break;
+    case EtherType::IPv6:
+        // ignore
+        break;
+    default:
+        dbgln_if(ETHERNET_DEBUG, "NetworkTask: Unknown ethernet type {:#04x}", eth.ether_type());
     }
 }
 
@@ -212,8 +265,10 @@ void handle_ipv4(EthernetFrameHeader const& eth, size_t frame_size, Time const&
 
     switch ((IPv4Protocol)packet.protocol()) {
     case IPv4Protocol::ICMP:
+        tcp_receive_batch->finish();
         return handle_icmp(eth, packet, packet_timestamp);
     case IPv4Protocol::UDP:
+        tcp_receive_batch->finish();
         return handle_udp(packet, packet_timestamp);
     case IPv4Protocol::TCP:
         return handle_tcp(packet, packet_timestamp);
@@ -381,6 +436,7 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
     size_t maximum_tcp_header_size = 15 * sizeof(u32);
     if (tcp_packet.header_size() < minimum_tcp_header_size || tcp_packet.header_size() > maximum_tcp_header_size) {
         dbgln("handle_tcp: TCP packet header has invalid size {}", tcp_packet.header_size());
+        return;
     }
 
     if (ipv4_packet.payload_size() < tcp_packet.header_size()) {
@@ -415,16 +471,34 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
 
     dbgln_if(TCP_DEBUG, "handle_tcp: looking for socket; tuple={}", tuple.to_string());
 
-    auto socket = TCPSocket::from_tuple(tuple);
-    if (!socket) {
-        if (!tcp_packet.has_rst()) {
-            dbgln("handle_tcp: No TCP socket for tuple {}. Sending RST.", tuple.to_string());
-            send_tcp_rst(ipv4_packet, tcp_packet, adapter);
+    LockRefPtr<TCPSocket> socket;
+    MutexLocker locker;
+    if (tcp_receive_batch->socket && tcp_receive_batch->socket->tuple() == tuple) {
+        socket = tcp_receive_batch->socket;
+    } else {
+        tcp_receive_batch->finish();
+        socket = TCPSocket::from_tuple(tuple);
+        if (!socket) {
+            if (!tcp_packet.has_rst()) {
+                dbgln("handle_tcp: No TCP socket for tuple {}. Sending RST.", tuple.to_string());
+                send_tcp_rst(ipv4_packet, tcp_packet, adapter);
+            }
+            return;
+        }
+        if (socket->tuple() == tuple) {
+            tcp_receive_batch->socket = socket;
+            tcp_receive_batch->locker.attach_and_lock(socket->mutex());
+        } else {
+            // Listening sockets hand off their connections to new sockets, so don't hold on to them.
+            locker.attach_and_lock(socket->mutex());
         }
-        return;
     }
 
-    MutexLocker locker(socket->mutex());
+    // A closed socket is no longer in the socket table, so any further segments must not reach it.
+    ScopeGuard finish_batch_if_closed([&] {
+        if (socket->state() == TCPSocket::State::Closed)
+            tcp_receive_batch->finish();
+    });
 
     VERIFY(socket->type() == SOCK_STREAM);
     VERIFY(socket->local_port() == tcp_packet.destination_port());
@@ -457,6 +531,7 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
             auto client = client_or_error.release_value();
             MutexLocker locker(client->mutex());
             dbgln_if(TCP_DEBUG, "handle_tcp: created new client socket with tuple {}", client->tuple().to_string());
+            client->process_syn_options(tcp_packet);
             client->set_sequence_number(1000);
             client->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
             [[maybe_unused]] auto rc2 = client->send_tcp_packet(TCPFlags::SYN | TCPFlags::ACK);
@@ -395,6 +395,8 @@ void RTL8168NetworkAdapter::startup()
         enabled_interrupts |= INT_RX_FIFO_OVERFLOW;
         enabled_interrupts &= ~INT_RX_OVERFLOW;
     }
+    m_enabled_interrupts = enabled_interrupts;
+    m_receive_interrupts = enabled_interrupts & (INT_RXOK | INT_RX_OVERFLOW | INT_RX_FIFO_OVERFLOW);
     out16(REG_IMR, enabled_interrupts);
 
     // update link status
@@ -1142,7 +1144,7 @@ bool RTL8168NetworkAdapter::handle_irq(RegisterState const&)
         was_handled = true;
         if (status & INT_RXOK) {
             dbgln_if(RTL8168_DEBUG, "RTL8168: RX ready");
-            receive();
+            schedule_receive_poll();
         }
         if (status & INT_RXERR) {
             dbgln_if(RTL8168_DEBUG, "RTL8168: RX error - invalid packet");
@@ -1156,7 +1158,7 @@ bool RTL8168NetworkAdapter::handle_irq(RegisterState const&)
         }
         if (status & INT_RX_OVERFLOW) {
             dmesgln("RTL8168: RX descriptor unavailable (packet lost)");
-            receive();
+            schedule_receive_poll();
         }
         if (status & INT_LINK_CHANGE) {
             m_link_up = (in8(REG_PHYSTATUS) & PHY_LINK_STATUS) != 0;
@@ -1164,7 +1166,7 @@ bool RTL8168NetworkAdapter::handle_irq(RegisterState const&)
         }
         if (status & INT_RX_FIFO_OVERFLOW) {
             dmesgln("RTL8168: RX FIFO overflow");
-            receive();
+            schedule_receive_poll();
         }
         if (status & INT_SYS_ERR) {
             dmesgln("RTL8168: Fatal system error");
@@ -1219,17 +1221,31 @@ void RTL8168NetworkAdapter::send_raw(ReadonlyBytes payload)
     out8(REG_TXSTART, TXSTART_START); // FIXME: this shouldn't be done so often, we should look into doing this using the watchdog timer
 }
 
-void RTL8168NetworkAdapter::receive()
+bool RTL8168NetworkAdapter::has_received_frames()
 {
     auto* rx_descriptors = (RXDescriptor*)m_rx_descriptors_region->vaddr().as_ptr();
-    for (u16 i = 0; i < number_of_rx_descriptors; ++i) {
-        auto descriptor_index = (m_rx_free_index + i) % number_of_rx_descriptors;
+    return (rx_descriptors[m_rx_free_index].flags & RXDescriptor::Ownership) == 0;
+}
+
+void RTL8168NetworkAdapter::set_receive_interrupts_enabled(bool enabled)
+{
+    if (enabled)
+        m_enabled_interrupts |= m_receive_interrupts;
+    else
+        m_enabled_interrupts &= ~m_receive_interrupts;
+    out16(REG_IMR, m_enabled_interrupts);
+}
+
+size_t RTL8168NetworkAdapter::receive_batch(size_t budget)
+{
+    auto* rx_descriptors = (RXDescriptor*)m_rx_descriptors_region->vaddr().as_ptr();
+    size_t received = 0;
+    while (received < budget) {
+        auto descriptor_index = m_rx_free_index;
         auto& descriptor = rx_descriptors[descriptor_index];
 
-        if ((descriptor.flags & RXDescriptor::Ownership) != 0) {
-            m_rx_free_index = descriptor_index;
+        if ((descriptor.flags & RXDescriptor::Ownership) != 0)
             break;
-        }
 
         u16 flags = descriptor.flags;
         u16 length = descriptor.buffer_size & 0x3FFF;
@@ -1251,7 +1267,11 @@ void RTL8168NetworkAdapter::receive()
         if (descriptor_index == number_of_rx_descriptors - 1)
             flags |= RXDescriptor::EndOfRing;
         descriptor.flags = flags; // let the NIC know it can use this descriptor again
+
+        m_rx_free_index = (descriptor_index + 1) % number_of_rx_descriptors;
+        ++received;
     }
+    return received;
 }
 
 void RTL8168NetworkAdapter::out8(u16 address, u8 data)
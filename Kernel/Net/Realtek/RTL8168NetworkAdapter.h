@@ -43,6 +43,10 @@ private:
     virtual bool handle_irq(RegisterState const&) override;
     virtual StringView class_name() const override { return "RTL8168NetworkAdapter"sv; }
 
+    virtual size_t receive_batch(size_t budget) override;
+    virtual bool has_received_frames() override;
+    virtual void set_receive_interrupts_enabled(bool) override;
+
     bool determine_supported_version() const;
 
     struct [[gnu::packed]] TXDescriptor {
@@ -149,8 +153,6 @@ private:
     void initialize_rx_descriptors();
     void initialize_tx_descriptors();
 
-    void receive();
-
     void out8(u16 address, u8 data);
     void out16(u16 address, u16 data);
     void out32(u16 address, u32 data);
@@ -204,6 +206,8 @@ private:
     OwnPtr<Memory::Region> m_rx_descriptors_region;
     NonnullOwnPtrVector<Memory::Region> m_rx_buffers_regions;
     u16 m_rx_free_index { 0 };
+    u16 m_enabled_interrupts { 0 };
+    u16 m_receive_interrupts { 0 };
     OwnPtr<Memory::Region> m_tx_descriptors_region;
     NonnullOwnPtrVector<Memory::Region> m_tx_buffers_regions;
     u16 m_tx_free_index { 0 };
@@ -69,6 +69,7 @@ public:
 
     bool can_accept() const { return !m_pending.is_empty(); }
     LockRefPtr<Socket> accept();
+    void set_acceptor(Process const&);
 
     ErrorOr<void> shutdown(int how);
 
@@ -82,6 +83,10 @@ public:
     virtual ErrorOr<size_t> sendto(OpenFileDescription&, UserOrKernelBuffer const&, size_t, int flags, Userspace<sockaddr const*>, socklen_t) = 0;
     virtual ErrorOr<size_t> recvfrom(OpenFileDescription&, UserOrKernelBuffer&, size_t, int flags, Userspace<sockaddr*>, Userspace<socklen_t*>, Time&, bool blocking) = 0;
 
+    // Sends file contents straight from the inode, without staging them in an intermediate buffer.
+    // Sockets that can't do this return ENOTSUP, and callers have to fall back to write().
+    virtual ErrorOr<size_t> send_from_inode(OpenFileDescription&, Inode const&, off_t, size_t) { return ENOTSUP; }
+
     virtual ErrorOr<void> setsockopt(int level, int option, Userspace<void const*>, socklen_t);
     virtual ErrorOr<void> getsockopt(OpenFileDescription&, int level, int option, Userspace<void*>, Userspace<socklen_t*>);
 
@@ -150,7 +155,6 @@ protected:
     }
 
     void set_origin(Process const&);
-    void set_acceptor(Process const&);
 
     void set_role(Role role) { m_role = role; }
 
@@ -22,6 +22,15 @@ struct TCPFlags {
     };
 };
 
+enum class TCPOptionKind : u8 {
+    End = 0,
+    NOP = 1,
+    MSS = 2,
+    WindowScale = 3,
+    SACKPermitted = 4,
+    SACK = 5,
+};
+
 class [[gnu::packed]] TCPOptionMSS {
 public:
     TCPOptionMSS(u16 value)
@@ -39,6 +48,23 @@ private:
 
 static_assert(AssertSize<TCPOptionMSS, 4>());
 
+// Padded with two NOPs to keep the following options 32-bit aligned.
+class [[gnu::packed]] TCPOptionSACKPermitted {
+private:
+    u8 m_padding[2] { to_underlying(TCPOptionKind::NOP), to_underlying(TCPOptionKind::NOP) };
+    u8 m_option_kind { to_underlying(TCPOptionKind::SACKPermitted) };
+    u8 m_option_length { 2 };
+};
+
+static_assert(AssertSize<TCPOptionSACKPermitted, 4>());
+
+struct [[gnu::packed]] TCPSACKBlock {
+    NetworkOrdered<u32> left_edge;
+    NetworkOrdered<u32> right_edge;
+};
+
+static_assert(AssertSize<TCPSACKBlock, 8>());
+
 class [[gnu::packed]] TCPPacket {
 public:
     TCPPacket() = default;
@@ -78,6 +104,8 @@ public:
     u16 urgent() const { return m_urgent; }
     void set_urgent(u16 urgent) { m_urgent = urgent; }
 
+    ReadonlyBytes options() const { return { ((u8 const*)this) + sizeof(TCPPacket), header_size() - sizeof(TCPPacket) }; }
+
     void const* payload() const { return ((u8 const*)this) + header_size(); }
     void* payload() { return ((u8*)this) + header_size(); }
 
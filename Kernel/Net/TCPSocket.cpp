@@ -8,6 +8,7 @@
 #include <AK/Time.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Devices/RandomDevice.h>
+#include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
 #include <Kernel/Locking/MutexProtected.h>
 #include <Kernel/Net/EthernetFrameHeader.h>
@@ -22,6 +23,36 @@
 
 namespace Kernel {
 
+// Sequence numbers wrap around, so they can only be compared relative to each other.
+static bool sequence_number_less_than(u32 a, u32 b)
+{
+    return static_cast<i32>(a - b) < 0;
+}
+
+static bool sequence_number_less_than_or_equal(u32 a, u32 b)
+{
+    return static_cast<i32>(a - b) <= 0;
+}
+
+template<typename Callback>
+static void for_each_tcp_option(TCPPacket const& packet, Callback callback)
+{
+    auto options = packet.options();
+    while (!options.is_empty()) {
+        auto kind = static_cast<TCPOptionKind>(options[0]);
+        if (kind == TCPOptionKind::End)
+            return;
+        if (kind == TCPOptionKind::NOP) {
+            options = options.slice(1);
+            continue;
+        }
+        if (options.size() < 2 || options[1] < 2 || options[1] > options.size())
+            return;
+        callback(kind, options.slice(2, options[1] - 2));
+        options = options.slice(options[1]);
+    }
+}
+
 void TCPSocket::for_each(Function<void(TCPSocket const&)> callback)
 {
     sockets_by_tuple().for_each_shared([&](auto const& it) {
@@ -63,6 +94,12 @@ void TCPSocket::set_state(State new_state)
 
     m_state = new_state;
 
+    if (new_state == State::Established) {
+        m_congestion_window = initial_congestion_window();
+        // RFC 6582: recover starts out as the initial send sequence number.
+        m_recover = m_sequence_number - 1;
+    }
+
     if (new_state == State::Established && m_direction == Direction::Outgoing) {
         set_role(Role::Connected);
         clear_so_error();
@@ -166,6 +203,7 @@ TCPSocket::TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, N
     : IPv4Socket(SOCK_STREAM, protocol, move(receive_buffer), move(scratch_buffer))
 {
     m_last_retransmit_time = kgettimeofday();
+    m_congestion_window = initial_congestion_window();
 }
 
 TCPSocket::~TCPSocket()
@@ -206,11 +244,36 @@ ErrorOr<size_t> TCPSocket::protocol_send(UserOrKernelBuffer const& data, size_t
     if (routing_decision.is_zero())
         return set_so_error(EHOSTUNREACH);
     size_t mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
+    if (m_peer_mss)
+        mss = min<size_t>(mss, m_peer_mss);
     data_length = min(data_length, mss);
     TRY(send_tcp_packet(TCPFlags::PSH | TCPFlags::ACK, &data, data_length, &routing_decision));
     return data_length;
 }
 
+ErrorOr<size_t> TCPSocket::protocol_send_from_inode(Inode const& inode, off_t offset, size_t length)
+{
+    RoutingDecision routing_decision = route_to(peer_address(), local_address(), bound_interface());
+    if (routing_decision.is_zero())
+        return set_so_error(EHOSTUNREACH);
+    size_t mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
+    if (m_peer_mss)
+        mss = min<size_t>(mss, m_peer_mss);
+    length = min(length, mss);
+
+    // The file contents are read straight into the packet buffer, which is also
+    // what we hold on to for retransmission, so there is no intermediate copy.
+    TRY(send_tcp_packet_with_payload(TCPFlags::PSH | TCPFlags::ACK, length, &routing_decision, [&](Bytes payload) -> ErrorOr<void> {
+        auto buffer = UserOrKernelBuffer::for_kernel_buffer(payload.data());
+        auto nread = TRY(inode.read_bytes(offset, payload.size(), buffer, nullptr));
+        // The file was truncated under us, and we have already committed to the payload size.
+        if (nread != payload.size())
+            return EIO;
+        return {};
+    }));
+    return length;
+}
+
 ErrorOr<void> TCPSocket::send_ack(bool allow_duplicate)
 {
     if (!allow_duplicate && m_last_ack_number_sent == m_ack_number)
@@ -219,6 +282,15 @@ ErrorOr<void> TCPSocket::send_ack(bool allow_duplicate)
 }
 
 ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* payload, size_t payload_size, RoutingDecision* user_routing_decision)
+{
+    if (!payload)
+        return send_tcp_packet_with_payload(flags, 0, user_routing_decision, nullptr);
+    return send_tcp_packet_with_payload(flags, payload_size, user_routing_decision, [&](Bytes bytes) {
+        return payload->read(bytes.data(), bytes.size());
+    });
+}
+
+ErrorOr<void> TCPSocket::send_tcp_packet_with_payload(u16 flags, size_t payload_size, RoutingDecision* user_routing_decision, Function<ErrorOr<void>(Bytes)> const& fill_payload)
 {
     RoutingDecision routing_decision = user_routing_decision ? *user_routing_decision : route_to(peer_address(), local_address(), bound_interface());
     if (routing_decision.is_zero())
@@ -226,8 +298,10 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
 
     auto ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
 
-    bool const has_mss_option = flags == TCPFlags::SYN;
-    const size_t options_size = has_mss_option ? sizeof(TCPOptionMSS) : 0;
+    bool const has_mss_option = flags & TCPFlags::SYN;
+    // We only offer SACK on SYN|ACK if the peer offered it first.
+    bool const has_sack_permitted_option = flags == TCPFlags::SYN || (has_mss_option && m_sack_permitted);
+    const size_t options_size = (has_mss_option ? sizeof(TCPOptionMSS) : 0) + (has_sack_permitted_option ? sizeof(TCPOptionSACKPermitted) : 0);
     const size_t tcp_header_size = sizeof(TCPPacket) + options_size;
     const size_t buffer_size = ipv4_payload_offset + tcp_header_size + payload_size;
     auto packet = routing_decision.adapter->acquire_packet_buffer(buffer_size);
@@ -246,8 +320,8 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
     tcp_packet.set_data_offset(tcp_header_size / sizeof(u32));
     tcp_packet.set_flags(flags);
 
-    if (payload) {
-        if (auto result = payload->read(tcp_packet.payload(), payload_size); result.is_error()) {
+    if (fill_payload) {
+        if (auto result = fill_payload({ tcp_packet.payload(), payload_size }); result.is_error()) {
             routing_decision.adapter->release_packet_buffer(*packet);
             return set_so_error(result.release_error());
         }
@@ -259,6 +333,7 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
         tcp_packet.set_ack_number(m_ack_number);
     }
 
+    u32 packet_sequence_number = m_sequence_number;
     if (flags & TCPFlags::SYN) {
         ++m_sequence_number;
     } else {
@@ -267,18 +342,29 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
 
     if (has_mss_option) {
         u16 mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
+        m_mss = m_peer_mss ? min(mss, m_peer_mss) : mss;
         TCPOptionMSS mss_option { mss };
         VERIFY(packet->buffer->size() >= ipv4_payload_offset + sizeof(TCPPacket) + sizeof(mss_option));
         memcpy(packet->buffer->data() + ipv4_payload_offset + sizeof(TCPPacket), &mss_option, sizeof(mss_option));
     }
 
+    if (has_sack_permitted_option) {
+        TCPOptionSACKPermitted sack_permitted_option;
+        auto offset = ipv4_payload_offset + sizeof(TCPPacket) + sizeof(TCPOptionMSS);
+        VERIFY(packet->buffer->size() >= offset + sizeof(sack_permitted_option));
+        memcpy(packet->buffer->data() + offset, &sack_permitted_option, sizeof(sack_permitted_option));
+    }
+
     tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
 
     bool expect_ack { tcp_packet.has_syn() || payload_size > 0 };
     if (expect_ack) {
         bool append_failed { false };
         m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
-            auto result = unacked_packets.packets.try_append({ m_sequence_number, packet, ipv4_payload_offset, *routing_decision.adapter });
+            // RFC 6298 (5.1): Start the retransmission timer if it isn't running.
+            if (unacked_packets.packets.is_empty())
+                m_last_retransmit_time = kgettimeofday();
+            auto result = unacked_packets.packets.try_append({ m_sequence_number, packet, ipv4_payload_offset, *routing_decision.adapter, 0, packet_sequence_number, payload_size });
             if (result.is_error()) {
                 dbgln("TCPSocket: Dropped outbound packet because try_append() failed");
                 append_failed = true;
@@ -302,6 +388,9 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
 
 void TCPSocket::receive_tcp_packet(TCPPacket const& packet, u16 size)
 {
+    if (packet.has_syn())
+        process_syn_options(packet);
+
     if (packet.has_ack()) {
         u32 ack_number = packet.ack_number();
 
@@ -309,18 +398,21 @@ void TCPSocket::receive_tcp_packet(TCPPacket const& packet, u16 size)
 
         int removed = 0;
         m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
+            if (m_sack_permitted)
+                process_sack_option(packet, unacked_packets);
+
+            size_t acked_bytes = 0;
             while (!unacked_packets.packets.is_empty()) {
                 auto& packet = unacked_packets.packets.first();
 
                 dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: iterate: {}", packet.ack_number);
 
-                if (packet.ack_number <= ack_number) {
+                if (sequence_number_less_than_or_equal(packet.ack_number, ack_number)) {
                     auto old_adapter = packet.adapter.strong_ref();
                     if (old_adapter)
                         old_adapter->release_packet_buffer(*packet.buffer);
-                    TCPPacket& tcp_packet = *(TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
-                    auto payload_size = packet.buffer->buffer->data() + packet.buffer->buffer->size() - (u8*)tcp_packet.payload();
-                    unacked_packets.size -= payload_size;
+                    unacked_packets.size -= packet.payload_size;
+                    acked_bytes += packet.payload_size;
                     evaluate_block_conditions();
                     unacked_packets.packets.take_first();
                     removed++;
@@ -329,6 +421,15 @@ void TCPSocket::receive_tcp_packet(TCPPacket const& packet, u16 size)
                 }
             }
 
+            if (removed > 0) {
+                did_receive_new_ack(unacked_packets, ack_number, acked_bytes);
+            } else if (!unacked_packets.packets.is_empty() && size == packet.header_size() && !packet.has_syn() && !packet.has_fin()
+                && ack_number == unacked_packets.packets.first().sequence_number) {
+                // RFC 5681: An ACK that carries no data and doesn't move the window forward
+                // means the peer received a segment out of order.
+                did_receive_duplicate_ack(unacked_packets, ack_number);
+            }
+
             if (unacked_packets.packets.is_empty()) {
                 m_retransmit_attempts = 0;
                 dequeue_for_retransmit();
@@ -342,6 +443,146 @@ void TCPSocket::receive_tcp_packet(TCPPacket const& packet, u16 size)
     m_bytes_in += packet.header_size() + size;
 }
 
+void TCPSocket::process_syn_options(TCPPacket const& packet)
+{
+    for_each_tcp_option(packet, [&](TCPOptionKind kind, ReadonlyBytes data) {
+        switch (kind) {
+        case TCPOptionKind::MSS:
+            if (data.size() == sizeof(u16))
+                m_peer_mss = max<u16>((data[0] << 8) | data[1], 64);
+            break;
+        case TCPOptionKind::SACKPermitted:
+            m_sack_permitted = true;
+            break;
+        default:
+            break;
+        }
+    });
+    if (m_peer_mss)
+        m_mss = min(m_mss, m_peer_mss);
+}
+
+u32 TCPSocket::initial_congestion_window() const
+{
+    // RFC 3390
+    return min(4u * m_mss, max(2u * m_mss, 4380u));
+}
+
+void TCPSocket::process_sack_option(TCPPacket const& packet, UnackedPackets& unacked_packets)
+{
+    for_each_tcp_option(packet, [&](TCPOptionKind kind, ReadonlyBytes data) {
+        if (kind != TCPOptionKind::SACK || data.size() % sizeof(TCPSACKBlock) != 0)
+            return;
+        for (size_t i = 0; i < data.size(); i += sizeof(TCPSACKBlock)) {
+            TCPSACKBlock block;
+            memcpy(&block, data.offset_pointer(i), sizeof(block));
+            u32 left_edge = block.left_edge;
+            u32 right_edge = block.right_edge;
+            for (auto& outgoing_packet : unacked_packets.packets) {
+                if (sequence_number_less_than_or_equal(left_edge, outgoing_packet.sequence_number) && sequence_number_less_than_or_equal(outgoing_packet.ack_number, right_edge))
+                    outgoing_packet.sacked = true;
+            }
+        }
+    });
+}
+
+void TCPSocket::did_receive_new_ack(UnackedPackets& unacked_packets, u32 ack_number, size_t acked_bytes)
+{
+    // RFC 6298 (5.3): Restart the retransmission timer when new data is acknowledged.
+    m_last_retransmit_time = kgettimeofday();
+    m_retransmit_attempts = 0;
+    m_duplicate_acks_received = 0;
+
+    if (m_congestion_state != CongestionState::Open && sequence_number_less_than_or_equal(m_recover, ack_number)) {
+        // Everything that was outstanding when the loss was detected has arrived.
+        if (m_congestion_state == CongestionState::FastRecovery)
+            m_congestion_window = max(min<u32>(m_slow_start_threshold, unacked_packets.size + m_mss), m_mss);
+        m_congestion_state = CongestionState::Open;
+        return;
+    }
+
+    switch (m_congestion_state) {
+    case CongestionState::FastRecovery:
+        // RFC 6582: A partial acknowledgement means the next segment was lost as well.
+        retransmit_holes(unacked_packets, 1, m_recover);
+        m_congestion_window -= min<u32>(m_congestion_window, acked_bytes);
+        if (acked_bytes >= m_mss)
+            m_congestion_window += m_mss;
+        m_congestion_window = max<u32>(m_congestion_window, m_mss);
+        return;
+    case CongestionState::Loss:
+        // After a timeout, the peer may have lost everything that was in flight, so keep
+        // resending what it hasn't received yet at the pace of slow start.
+        m_congestion_window = min(m_congestion_window + min<u32>(acked_bytes, m_mss), maximum_congestion_window);
+        retransmit_holes(unacked_packets, 2, m_recover);
+        return;
+    case CongestionState::Open:
+        break;
+    }
+
+    if (m_congestion_window < m_slow_start_threshold)
+        m_congestion_window += min<u32>(acked_bytes, m_mss);
+    else
+        m_congestion_window += max<u32>(1, m_mss * m_mss / m_congestion_window);
+    m_congestion_window = min(m_congestion_window, maximum_congestion_window);
+}
+
+void TCPSocket::did_receive_duplicate_ack(UnackedPackets& unacked_packets, u32 ack_number)
+{
+    ++m_duplicate_acks_received;
+
+    if (m_congestion_state == CongestionState::FastRecovery) {
+        // Every duplicate ACK means another segment has left the network.
+        m_congestion_window = min(m_congestion_window + m_mss, maximum_congestion_window);
+        if (m_sack_permitted) {
+            u32 highest_sacked = ack_number;
+            for (auto& packet : unacked_packets.packets) {
+                if (packet.sacked)
+                    highest_sacked = packet.ack_number;
+            }
+            retransmit_holes(unacked_packets, 1, highest_sacked);
+        }
+        return;
+    }
+
+    if (m_congestion_state != CongestionState::Open || m_duplicate_acks_received != fast_retransmit_threshold)
+        return;
+
+    // RFC 6582: Don't reduce the window twice for losses from the same window of data.
+    if (sequence_number_less_than_or_equal(ack_number, m_recover))
+        return;
+
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) fast retransmit at {}", this, ack_number);
+
+    m_slow_start_threshold = max<u32>(unacked_packets.size / 2, 2 * m_mss);
+    m_recover = m_sequence_number;
+    for (auto& packet : unacked_packets.packets)
+        packet.retransmitted = false;
+    if (retransmit_holes(unacked_packets, 1, m_recover) > 0)
+        ++m_fast_retransmits;
+    m_congestion_window = m_slow_start_threshold + fast_retransmit_threshold * m_mss;
+    m_congestion_state = CongestionState::FastRecovery;
+}
+
+size_t TCPSocket::retransmit_holes(UnackedPackets& unacked_packets, size_t max_count, u32 end_sequence_number)
+{
+    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
+    if (routing_decision.is_zero())
+        return 0;
+
+    size_t count = 0;
+    for (auto& packet : unacked_packets.packets) {
+        if (count == max_count || !sequence_number_less_than(packet.sequence_number, end_sequence_number))
+            break;
+        if (packet.sacked || packet.retransmitted)
+            continue;
+        packet.retransmitted = true;
+        retransmit_packet(packet, routing_decision);
+        ++count;
+    }
+    return count;
+}
+
 bool TCPSocket::should_delay_next_ack() const
 {
     // FIXME: We don't know the MSS here so make a reasonable guess.
@@ -598,46 +839,65 @@ void TCPSocket::retransmit_packets()
         return;
     }
 
-    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
-    if (routing_decision.is_zero())
-        return;
-
     m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
+        if (unacked_packets.packets.is_empty())
+            return;
+
+        ++m_retransmit_timeouts;
+        if (m_state == State::Established) {
+            // RFC 5681 (3.1): After a timeout, fall back to slow start from a single segment.
+            if (m_congestion_state == CongestionState::Open || m_retransmit_attempts == 1)
+                m_slow_start_threshold = max<u32>(unacked_packets.size / 2, 2 * m_mss);
+            m_congestion_window = m_mss;
+            m_congestion_state = CongestionState::Loss;
+            m_recover = m_sequence_number;
+            m_duplicate_acks_received = 0;
+        }
+
+        // RFC 2018: The peer may have dropped what it has selectively acknowledged, so forget about it.
         for (auto& packet : unacked_packets.packets) {
-            packet.tx_counter++;
-
-            if constexpr (TCP_SOCKET_DEBUG) {
-                auto& tcp_packet = *(const TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
-                dbgln("Sending TCP packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, tx_counter={}",
-                    local_address(), local_port(),
-                    peer_address(), peer_port(),
-                    (tcp_packet.has_syn() ? "SYN " : ""),
-                    (tcp_packet.has_ack() ? "ACK " : ""),
-                    (tcp_packet.has_fin() ? "FIN " : ""),
-                    (tcp_packet.has_rst() ? "RST " : ""),
-                    tcp_packet.sequence_number(),
-                    tcp_packet.ack_number(),
-                    packet.tx_counter);
-            }
+            packet.sacked = false;
+            packet.retransmitted = false;
+        }
+        retransmit_holes(unacked_packets, 1, m_sequence_number);
+    });
+}
 
-            size_t ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
-            if (ipv4_payload_offset != packet.ipv4_payload_offset) {
-                // FIXME: Add support for this. This can happen if after a route change
-                // we ended up on another adapter which doesn't have the same layer 2 type
-                // like the previous adapter.
-                VERIFY_NOT_REACHED();
-            }
+void TCPSocket::retransmit_packet(OutgoingPacket& packet, RoutingDecision& routing_decision)
+{
+    packet.tx_counter++;
 
-            auto packet_buffer = packet.buffer->bytes();
+    if constexpr (TCP_SOCKET_DEBUG) {
+        auto& tcp_packet = *(const TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
+        dbgln("Sending TCP packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, tx_counter={}",
+            local_address(), local_port(),
+            peer_address(), peer_port(),
+            (tcp_packet.has_syn() ? "SYN " : ""),
+            (tcp_packet.has_ack() ? "ACK " : ""),
+            (tcp_packet.has_fin() ? "FIN " : ""),
+            (tcp_packet.has_rst() ? "RST " : ""),
+            tcp_packet.sequence_number(),
+            tcp_packet.ack_number(),
+            packet.tx_counter);
+    }
 
-            routing_decision.adapter->fill_in_ipv4_header(*packet.buffer,
-                local_address(), routing_decision.next_hop, peer_address(),
-                IPv4Protocol::TCP, packet_buffer.size() - ipv4_payload_offset, type_of_service(), ttl());
-            routing_decision.adapter->send_packet(packet_buffer);
-            m_packets_out++;
-            m_bytes_out += packet_buffer.size();
-        }
-    });
+    size_t ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
+    if (ipv4_payload_offset != packet.ipv4_payload_offset) {
+        // FIXME: Add support for this. This can happen if after a route change
+        // we ended up on another adapter which doesn't have the same layer 2 type
+        // like the previous adapter.
+        VERIFY_NOT_REACHED();
+    }
+
+    auto packet_buffer = packet.buffer->bytes();
+
+    routing_decision.adapter->fill_in_ipv4_header(*packet.buffer,
+        local_address(), routing_decision.next_hop, peer_address(),
+        IPv4Protocol::TCP, packet_buffer.size() - ipv4_payload_offset, type_of_service(), ttl());
+    routing_decision.adapter->send_packet(packet_buffer);
+    m_packets_out++;
+    m_bytes_out += packet_buffer.size();
+    m_retransmitted_segments++;
 }
 
 bool TCPSocket::can_write(OpenFileDescription const& file_description, u64 size) const
@@ -648,11 +908,8 @@ bool TCPSocket::can_write(OpenFileDescription const& file_description, u64 size)
     if (m_state == State::SynSent || m_state == State::SynReceived)
         return false;
 
-    if (!file_description.is_blocking())
-        return true;
-
     return m_unacked_packets.with_shared([&](auto& unacked_packets) {
-        return unacked_packets.size + size <= m_send_window_size;
+        return unacked_packets.size + size <= send_window();
     });
 }
 }
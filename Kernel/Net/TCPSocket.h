@@ -139,6 +139,37 @@ public:
     void set_duplicate_acks(u32 acks) { m_duplicate_acks = acks; }
     u32 duplicate_acks() const { return m_duplicate_acks; }
 
+    enum class CongestionState {
+        Open,
+        FastRecovery,
+        Loss,
+    };
+
+    static StringView to_string(CongestionState state)
+    {
+        switch (state) {
+        case CongestionState::Open:
+            return "Open"sv;
+        case CongestionState::FastRecovery:
+            return "FastRecovery"sv;
+        case CongestionState::Loss:
+            return "Loss"sv;
+        default:
+            return "None"sv;
+        }
+    }
+
+    CongestionState congestion_state() const { return m_congestion_state; }
+    u32 congestion_window() const { return m_congestion_window; }
+    u32 slow_start_threshold() const { return m_slow_start_threshold; }
+    u16 mss() const { return m_mss; }
+    bool is_sack_permitted() const { return m_sack_permitted; }
+    u32 retransmitted_segments() const { return m_retransmitted_segments; }
+    u32 fast_retransmits() const { return m_fast_retransmits; }
+    u32 retransmit_timeouts() const { return m_retransmit_timeouts; }
+
+    void process_syn_options(TCPPacket const&);
+
     ErrorOr<void> send_ack(bool allow_duplicate = false);
     ErrorOr<void> send_tcp_packet(u16 flags, UserOrKernelBuffer const* = nullptr, size_t = 0, RoutingDecision* = nullptr);
     void receive_tcp_packet(TCPPacket const&, u16 size);
@@ -175,6 +206,7 @@ private:
 
     virtual ErrorOr<size_t> protocol_receive(ReadonlyBytes raw_ipv4_packet, UserOrKernelBuffer& buffer, size_t buffer_size, int flags) override;
     virtual ErrorOr<size_t> protocol_send(UserOrKernelBuffer const&, size_t) override;
+    virtual ErrorOr<size_t> protocol_send_from_inode(Inode const&, off_t, size_t) override;
     virtual ErrorOr<void> protocol_connect(OpenFileDescription&) override;
     virtual ErrorOr<u16> protocol_allocate_local_port() override;
     virtual ErrorOr<size_t> protocol_size(ReadonlyBytes raw_ipv4_packet) override;
@@ -182,9 +214,20 @@ private:
     virtual ErrorOr<void> protocol_bind() override;
     virtual ErrorOr<void> protocol_listen(bool did_allocate_port) override;
 
+    // Like send_tcp_packet(), but lets the caller fill in the payload directly in the packet buffer.
+    ErrorOr<void> send_tcp_packet_with_payload(u16 flags, size_t payload_size, RoutingDecision*, Function<ErrorOr<void>(Bytes)> const& fill_payload);
+
     void enqueue_for_retransmit();
     void dequeue_for_retransmit();
 
+    struct UnackedPackets;
+    u32 send_window() const { return min(m_send_window_size, m_congestion_window); }
+    u32 initial_congestion_window() const;
+    void process_sack_option(TCPPacket const&, UnackedPackets&);
+    void did_receive_new_ack(UnackedPackets&, u32 ack_number, size_t acked_bytes);
+    void did_receive_duplicate_ack(UnackedPackets&, u32 ack_number);
+    size_t retransmit_holes(UnackedPackets&, size_t max_count, u32 end_sequence_number);
+
     LockWeakPtr<TCPSocket> m_originator;
     HashMap<IPv4SocketTuple, NonnullLockRefPtr<TCPSocket>> m_pending_release_for_accept;
     Direction m_direction { Direction::Unspecified };
@@ -204,6 +247,12 @@ private:
         size_t ipv4_payload_offset;
         LockWeakPtr<NetworkAdapter> adapter;
         int tx_counter { 0 };
+        u32 sequence_number { 0 };
+        size_t payload_size { 0 };
+        // The peer told us it has this segment, but it can't acknowledge it yet.
+        bool sacked { false };
+        // Whether this segment was retransmitted during the current recovery.
+        bool retransmitted { false };
     };
 
     struct UnackedPackets {
@@ -213,6 +262,8 @@ private:
 
     MutexProtected<UnackedPackets> m_unacked_packets;
 
+    void retransmit_packet(OutgoingPacket&, RoutingDecision&);
+
     u32 m_duplicate_acks { 0 };
 
     u32 m_last_ack_number_sent { 0 };
@@ -226,6 +277,24 @@ private:
     // FIXME: Parse window size TCP option from the peer
     u32 m_send_window_size { 64 * KiB };
 
+    // Congestion control as per RFC 5681, with NewReno fast recovery (RFC 6582)
+    // and retransmission of the holes the peer reports with SACK (RFC 2018).
+    static constexpr u16 default_mss = 536;
+    static constexpr u32 fast_retransmit_threshold = 3;
+    static constexpr u32 maximum_congestion_window = 1 * MiB;
+    CongestionState m_congestion_state { CongestionState::Open };
+    u16 m_mss { default_mss };
+    u16 m_peer_mss { 0 };
+    bool m_sack_permitted { false };
+    u32 m_congestion_window { 0 };
+    u32 m_slow_start_threshold { NumericLimits<u32>::max() };
+    // The highest sequence number sent when the current recovery started.
+    u32 m_recover { 0 };
+    u32 m_duplicate_acks_received { 0 };
+    u32 m_retransmitted_segments { 0 };
+    u32 m_fast_retransmits { 0 };
+    u32 m_retransmit_timeouts { 0 };
+
     IntrusiveListNode<TCPSocket> m_retransmit_list_node;
 
 public:
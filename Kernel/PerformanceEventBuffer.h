@@ -7,6 +7,7 @@
 #pragma once
 
 #include <AK/Error.h>
+#include <AK/Vector.h>
 #include <Kernel/KBuffer.h>
 
 namespace Kernel {
@@ -148,6 +149,9 @@ private:
     HashMap<NonnullOwnPtr<KString>, size_t> m_strings;
 };
 
+// Walks the stack starting at the given frame pointer, kernel frames first, then userspace ones.
+Vector<FlatPtr, PerformanceEvent::max_stack_frame_count> raw_backtrace(FlatPtr bp, FlatPtr ip);
+
 extern bool g_profiling_all_threads;
 extern PerformanceEventBuffer* g_global_perf_events;
 extern u64 g_profiling_event_mask;
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <Kernel/Arch/Processor.h>
+#include <Kernel/Arch/RegisterState.h>
+#include <Kernel/Locking/Mutex.h>
+#include <Kernel/PerformanceEventBuffer.h>
+#include <Kernel/PerformanceSampleRing.h>
+#include <Kernel/Thread.h>
+#include <Kernel/Time/TimeManagement.h>
+
+namespace Kernel {
+
+static_assert(is_power_of_two(PerformanceSampleRing::capacity));
+
+// NOTE: Once allocated, the rings stay around, so readers never have to worry about them going away.
+static Array<PerformanceSampleRing*, MAX_CPU_COUNT> s_rings;
+static Atomic<bool> s_enabled { false };
+static Mutex s_enable_lock { "PerformanceSampleRing"sv };
+
+bool PerformanceSampleRing::is_enabled()
+{
+    return s_enabled.load(AK::MemoryOrder::memory_order_relaxed);
+}
+
+ErrorOr<void> PerformanceSampleRing::set_enabled(bool enabled)
+{
+    MutexLocker locker(s_enable_lock);
+    if (enabled && !s_rings[0]) {
+        for (u32 processor_id = 0; processor_id < Processor::count(); ++processor_id) {
+            auto buffer = TRY(KBuffer::try_create_with_size("Performance samples"sv, capacity * sizeof(Sample), Memory::Region::Access::ReadWrite, AllocationStrategy::AllocateNow));
+            auto ring = TRY(adopt_nonnull_own_or_enomem(new (nothrow) PerformanceSampleRing(move(buffer))));
+            s_rings[processor_id] = ring.leak_ptr();
+        }
+    }
+    s_enabled.store(enabled, AK::MemoryOrder::memory_order_release);
+    return {};
+}
+
+PerformanceSampleRing* PerformanceSampleRing::for_processor(u32 processor_id)
+{
+    if (processor_id >= s_rings.size())
+        return nullptr;
+    return s_rings[processor_id];
+}
+
+PerformanceSampleRing::PerformanceSampleRing(NonnullOwnPtr<KBuffer> buffer)
+    : m_buffer(move(buffer))
+{
+}
+
+void PerformanceSampleRing::append(Thread& thread, RegisterState const& regs)
+{
+    auto backtrace = raw_backtrace(regs.bp(), regs.ip());
+
+    auto head = m_head.load(AK::MemoryOrder::memory_order_relaxed);
+    auto& sample = samples()[head & (capacity - 1)];
+    sample.pid = thread.pid().value();
+    sample.tid = thread.tid().value();
+    sample.timestamp = TimeManagement::the().uptime_ms();
+    sample.stack_size = min(backtrace.size(), Sample::max_stack_frame_count);
+    memcpy(sample.stack, backtrace.data(), sample.stack_size * sizeof(FlatPtr));
+    m_head.store(head + 1, AK::MemoryOrder::memory_order_release);
+}
+
+bool PerformanceSampleRing::try_copy(u64 sequence, Sample& sample) const
+{
+    if (sequence >= head() || head() - sequence > capacity)
+        return false;
+    auto const& slot = samples()[sequence & (capacity - 1)];
+    sample.pid = slot.pid;
+    sample.tid = slot.tid;
+    sample.timestamp = slot.timestamp;
+    sample.stack_size = min(slot.stack_size, static_cast<u32>(Sample::max_stack_frame_count));
+    memcpy(sample.stack, slot.stack, sample.stack_size * sizeof(FlatPtr));
+
+    // The processor starts overwriting this slot once the head has caught up with the next lap,
+    // so if that happened while we were copying, the copy may be torn.
+    AK::atomic_thread_fence(AK::MemoryOrder::memory_order_acquire);
+    return head() - sequence < capacity;
+}
+
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Error.h>
+#include <AK/NonnullOwnPtr.h>
+#include <Kernel/Forward.h>
+#include <Kernel/KBuffer.h>
+
+namespace Kernel {
+
+struct RegisterState;
+
+// Continuous profiling samples the current thread of every processor on each scheduler tick.
+// Each processor writes its samples into its own ring, overwriting the oldest ones when it is
+// full, so there's no lock to take and profiling can be left on indefinitely. Readers keep
+// their own position in each ring, and find out when samples were overwritten before they
+// got to them.
+class PerformanceSampleRing {
+public:
+    struct Sample {
+        static constexpr size_t max_stack_frame_count = 32;
+
+        u32 pid { 0 };
+        u32 tid { 0 };
+        u64 timestamp { 0 };
+        u32 stack_size { 0 };
+        FlatPtr stack[max_stack_frame_count];
+    };
+
+    static constexpr size_t capacity = 2048;
+
+    static bool is_enabled();
+    static ErrorOr<void> set_enabled(bool);
+    static PerformanceSampleRing* for_processor(u32 processor_id);
+
+    // Called from the scheduler tick of the processor that owns this ring.
+    void append(Thread&, RegisterState const&);
+
+    // The sequence number that the next sample will get.
+    u64 head() const { return m_head.load(AK::MemoryOrder::memory_order_acquire); }
+
+    // Returns false if the sample has been (or is being) overwritten.
+    bool try_copy(u64 sequence, Sample&) const;
+
+private:
+    explicit PerformanceSampleRing(NonnullOwnPtr<KBuffer>);
+
+    Sample* samples() { return reinterpret_cast<Sample*>(m_buffer->data()); }
+    Sample const* samples() const { return reinterpret_cast<Sample const*>(m_buffer->data()); }
+
+    NonnullOwnPtr<KBuffer> m_buffer;
+    Atomic<u64> m_head { 0 };
+};
+
+}
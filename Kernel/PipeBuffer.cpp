@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/StringView.h>
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/PipeBuffer.h>
+
+namespace Kernel {
+
+ErrorOr<NonnullOwnPtr<PipeBuffer>> PipeBuffer::try_create(StringView name, size_t maximum_capacity)
+{
+    VERIFY(is_power_of_two(maximum_capacity));
+    VERIFY(maximum_capacity >= PAGE_SIZE);
+    auto storage = TRY(KBuffer::try_create_with_size(name, PAGE_SIZE, Memory::Region::Access::ReadWrite));
+    return adopt_nonnull_own_or_enomem(new (nothrow) PipeBuffer(name, maximum_capacity, move(storage)));
+}
+
+PipeBuffer::PipeBuffer(StringView name, size_t maximum_capacity, NonnullOwnPtr<KBuffer> storage)
+    : m_name(name)
+    , m_storage(move(storage))
+    , m_maximum_capacity(maximum_capacity)
+    , m_capacity(PAGE_SIZE)
+    , m_capacity_can_grow(maximum_capacity > PAGE_SIZE)
+{
+}
+
+void PipeBuffer::try_grow(size_t needed_capacity)
+{
+    VERIFY(m_write_lock.is_exclusively_locked_by_current_thread());
+
+    auto capacity = m_capacity.load();
+    auto new_capacity = capacity;
+    while (new_capacity < needed_capacity && new_capacity < m_maximum_capacity)
+        new_capacity *= 2;
+    if (new_capacity == capacity)
+        return;
+
+    auto new_storage_or_error = KBuffer::try_create_with_size(m_name, new_capacity, Memory::Region::Access::ReadWrite);
+    if (new_storage_or_error.is_error()) {
+        // Make do with what we have, rather than have writers keep coming back for more.
+        m_capacity_can_grow = false;
+        return;
+    }
+    auto new_storage = new_storage_or_error.release_value();
+
+    // The reader must not look at the storage while we're replacing it.
+    MutexLocker read_locker(m_read_lock);
+    auto read_index = m_read_index.load();
+    auto write_index = m_write_index.load();
+    for (auto index = read_index; index != write_index;) {
+        auto old_offset = index & (capacity - 1);
+        auto new_offset = index & (new_capacity - 1);
+        auto chunk_size = min(write_index - index, min(capacity - old_offset, new_capacity - new_offset));
+        memcpy(new_storage->data() + new_offset, m_storage->data() + old_offset, chunk_size);
+        index += chunk_size;
+    }
+    m_storage = move(new_storage);
+    m_capacity = new_capacity;
+    m_capacity_can_grow = new_capacity < m_maximum_capacity;
+}
+
+ErrorOr<size_t> PipeBuffer::write(UserOrKernelBuffer const& data, size_t size)
+{
+    if (!size)
+        return 0;
+    MutexLocker locker(m_write_lock);
+
+    auto write_index = m_write_index.load();
+    if (auto needed_capacity = write_index - m_read_index.load() + size; needed_capacity > m_capacity.load() && m_capacity_can_grow.load())
+        try_grow(needed_capacity);
+
+    // NOTE: The storage only changes while we're holding the write lock, so it's ours to use from here on.
+    auto capacity = m_capacity.load();
+    auto readable = write_index - m_read_index.load();
+    size_t bytes_to_write = min(size, capacity - readable);
+    if (bytes_to_write == 0)
+        return EAGAIN;
+
+    auto offset = write_index & (capacity - 1);
+    auto bytes_until_wrap = min(bytes_to_write, capacity - offset);
+    TRY(data.read(m_storage->data() + offset, 0, bytes_until_wrap));
+    if (bytes_until_wrap < bytes_to_write)
+        TRY(data.read(m_storage->data(), bytes_until_wrap, bytes_to_write - bytes_until_wrap));
+    m_write_index.store(write_index + bytes_to_write);
+
+    // If the reader had caught up with us before we published our data, it may be waiting for it.
+    if (m_unblock_callback && m_read_index.load() == write_index)
+        m_unblock_callback();
+
+    // Make room for the next writer now, rather than have it find the buffer full.
+    if (readable + bytes_to_write == capacity && m_capacity_can_grow.load())
+        try_grow(capacity * 2);
+    return bytes_to_write;
+}
+
+ErrorOr<size_t> PipeBuffer::read(UserOrKernelBuffer& data, size_t size)
+{
+    if (!size)
+        return 0;
+    MutexLocker locker(m_read_lock);
+
+    auto capacity = m_capacity.load();
+    auto read_index = m_read_index.load();
+    size_t bytes_to_read = min(size, m_write_index.load() - read_index);
+    if (bytes_to_read == 0)
+        return 0;
+
+    auto offset = read_index & (capacity - 1);
+    auto bytes_until_wrap = min(bytes_to_read, capacity - offset);
+    TRY(data.write(m_storage->data() + offset, 0, bytes_until_wrap));
+    if (bytes_until_wrap < bytes_to_read)
+        TRY(data.write(m_storage->data(), bytes_until_wrap, bytes_to_read - bytes_until_wrap));
+    m_read_index.store(read_index + bytes_to_read);
+
+    // If the buffer was full before we made room in it, the writer may be waiting for that.
+    if (m_unblock_callback && m_write_index.load() - read_index >= capacity)
+        m_unblock_callback();
+    return bytes_to_read;
+}
+
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Types.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/Locking/Mutex.h>
+#include <Kernel/UserOrKernelBuffer.h>
+
+namespace Kernel {
+
+// A ring buffer for pipes. The reading and the writing side each have their own lock,
+// and only ever move their own index, so a reader and a writer never wait for each other.
+// The buffer starts out at a single page, and grows (by doubling) when a writer runs out
+// of space, up to the given maximum capacity. The growing is done by the writer that fills
+// the buffer up, so that the space we report is always there to be written to.
+class PipeBuffer {
+public:
+    static ErrorOr<NonnullOwnPtr<PipeBuffer>> try_create(StringView name, size_t maximum_capacity = 64 * KiB);
+
+    ErrorOr<size_t> write(UserOrKernelBuffer const&, size_t);
+    ErrorOr<size_t> read(UserOrKernelBuffer&, size_t);
+
+    bool is_empty() const { return immediately_readable() == 0; }
+
+    size_t immediately_readable() const
+    {
+        // NOTE: The read index must be loaded first, as it never passes the write index.
+        auto read_index = m_read_index.load();
+        return m_write_index.load() - read_index;
+    }
+
+    size_t space_for_writing() const
+    {
+        // NOTE: The capacity must be loaded last, as it only ever grows.
+        auto readable = immediately_readable();
+        return m_capacity.load() - readable;
+    }
+
+    // The callback is only called when the buffer stops being empty or full,
+    // which is when there may be someone waiting for it.
+    void set_unblock_callback(Function<void()> callback)
+    {
+        VERIFY(!m_unblock_callback);
+        m_unblock_callback = move(callback);
+    }
+
+private:
+    PipeBuffer(StringView name, size_t maximum_capacity, NonnullOwnPtr<KBuffer> storage);
+
+    void try_grow(size_t needed_capacity);
+
+    StringView m_name;
+    NonnullOwnPtr<KBuffer> m_storage;
+    Function<void()> m_unblock_callback;
+    size_t const m_maximum_capacity { 0 };
+
+    // The indices only ever increase, and are masked with (capacity - 1) to get an offset into the storage.
+    Atomic<size_t> m_read_index { 0 };
+    Atomic<size_t> m_write_index { 0 };
+    Atomic<size_t> m_capacity { 0 };
+    Atomic<bool> m_capacity_can_grow { true };
+
+    // NOTE: When both locks are needed (to grow the buffer), the write lock is taken first.
+    Mutex m_write_lock { "PipeBuffer write"sv };
+    Mutex m_read_lock { "PipeBuffer read"sv };
+};
+
+}
@@ -6,13 +6,13 @@
 
 #include <AK/BuiltinWrappers.h>
 #include <AK/ScopeGuard.h>
-#include <AK/Singleton.h>
 #include <AK/Time.h>
 #include <Kernel/Arch/TrapFrame.h>
 #include <Kernel/Debug.h>
 #include <Kernel/InterruptDisabler.h>
 #include <Kernel/Panic.h>
 #include <Kernel/PerformanceManager.h>
+#include <Kernel/PerformanceSampleRing.h>
 #include <Kernel/Process.h>
 #include <Kernel/Scheduler.h>
 #include <Kernel/Sections.h>
@@ -46,7 +46,60 @@ struct ThreadReadyQueues {
     Array<ThreadReadyQueue, count> queues;
 };
 
-static Singleton<SpinlockProtected<ThreadReadyQueues>> g_ready_queues;
+// Every processor has its own set of ready queues, so that picking the next
+// thread only needs to look at (and lock) the local queues. Processors that
+// run out of work steal from the busiest other processor.
+struct ProcessorReadyQueues {
+    Thread* take(u32 affinity_mask)
+    {
+        return ready_queues.with([&](auto& queues) {
+            return find(queues, affinity_mask, [&](Thread& thread, ThreadReadyQueue& ready_queue, u32 priority) {
+                thread.m_runnable_priority = -1;
+                ready_queue.thread_list.remove(thread);
+                if (ready_queue.thread_list.is_empty())
+                    queues.mask &= ~(1u << priority);
+                runnable_count--;
+            });
+        });
+    }
+
+    Thread* peek(u32 affinity_mask)
+    {
+        return ready_queues.with([&](auto& queues) {
+            return find(queues, affinity_mask, [](auto&, auto&, auto) {});
+        });
+    }
+
+    SpinlockProtected<ThreadReadyQueues> ready_queues { LockRank::None };
+    // Only used as a hint for choosing a victim to steal from, so it is
+    // read without holding the lock.
+    Atomic<u32, AK::MemoryOrder::memory_order_relaxed> runnable_count { 0 };
+
+private:
+    template<typename Callback>
+    static Thread* find(ThreadReadyQueues& ready_queues, u32 affinity_mask, Callback callback)
+    {
+        auto priority_mask = ready_queues.mask;
+        while (priority_mask != 0) {
+            auto priority = bit_scan_forward(priority_mask);
+            VERIFY(priority > 0);
+            auto& ready_queue = ready_queues.queues[--priority];
+            for (auto& thread : ready_queue.thread_list) {
+                VERIFY(thread.m_runnable_priority == (int)priority);
+                if (thread.is_active())
+                    continue;
+                if (!(thread.affinity() & affinity_mask))
+                    continue;
+                callback(thread, ready_queue, priority);
+                return &thread;
+            }
+            priority_mask &= ~(1u << priority);
+        }
+        return nullptr;
+    }
+};
+
+static Array<ProcessorReadyQueues, MAX_CPU_COUNT> s_processor_ready_queues;
 
 static SpinlockProtected<TotalTimeScheduled> g_total_time_scheduled { LockRank::None };
 
@@ -55,7 +108,7 @@ static void dump_thread_list(bool = false);
 static inline u32 thread_priority_to_priority_index(u32 thread_priority)
 {
     // Converts the priority in the range of THREAD_PRIORITY_MIN...THREAD_PRIORITY_MAX
-    // to a index into g_ready_queues where 0 is the highest priority bucket
+    // to a index into ThreadReadyQueues::queues where 0 is the highest priority bucket
     VERIFY(thread_priority >= THREAD_PRIORITY_MIN && thread_priority <= THREAD_PRIORITY_MAX);
     constexpr u32 thread_priority_count = THREAD_PRIORITY_MAX - THREAD_PRIORITY_MIN + 1;
     static_assert(thread_priority_count > 0);
@@ -64,70 +117,98 @@ static inline u32 thread_priority_to_priority_index(u32 thread_priority)
     return priority_bucket;
 }
 
-Thread& Scheduler::pull_next_runnable_thread()
+static u32 processor_for_runnable_thread(Thread const& thread)
 {
-    auto affinity_mask = 1u << Processor::current_id();
+    auto processor_count = Processor::count();
+    auto processor_mask = processor_count >= 32 ? ~0u : (1u << processor_count) - 1;
+    auto usable_mask = thread.affinity() & processor_mask;
+
+    // Prefer the processor the thread last ran on, its caches are most likely still warm.
+    auto last_cpu = thread.cpu();
+    if (last_cpu < 32 && (usable_mask & (1u << last_cpu)))
+        return last_cpu;
+
+    if (usable_mask == 0) {
+        // None of the processors in the affinity mask are online, there's
+        // nowhere this thread could run. Park it on the current processor.
+        return Processor::current_id();
+    }
 
-    return g_ready_queues->with([&](auto& ready_queues) -> Thread& {
-        auto priority_mask = ready_queues.mask;
-        while (priority_mask != 0) {
-            auto priority = bit_scan_forward(priority_mask);
-            VERIFY(priority > 0);
-            auto& ready_queue = ready_queues.queues[--priority];
-            for (auto& thread : ready_queue.thread_list) {
-                VERIFY(thread.m_runnable_priority == (int)priority);
-                if (thread.is_active())
-                    continue;
-                if (!(thread.affinity() & affinity_mask))
-                    continue;
-                thread.m_runnable_priority = -1;
-                ready_queue.thread_list.remove(thread);
-                if (ready_queue.thread_list.is_empty())
-                    ready_queues.mask &= ~(1u << priority);
-                // Mark it as active because we are using this thread. This is similar
-                // to comparing it with Processor::current_thread, but when there are
-                // multiple processors there's no easy way to check whether the thread
-                // is actually still needed. This prevents accidental finalization when
-                // a thread is no longer in Running state, but running on another core.
-
-                // We need to mark it active here so that this thread won't be
-                // scheduled on another core if it were to be queued before actually
-                // switching to it.
-                // FIXME: Figure out a better way maybe?
-                thread.set_active(true);
-                return thread;
+    return bit_scan_forward(usable_mask) - 1;
+}
+
+template<typename Callback>
+static Thread* steal_from_busiest_processor(Callback callback)
+{
+    // Try the processors with the most runnable threads first, to spread
+    // the load as evenly as possible.
+    auto current_id = Processor::current_id();
+    auto processor_count = Processor::count();
+    u64 tried_mask = 1ull << current_id;
+
+    for (;;) {
+        u32 victim = current_id;
+        u32 victim_count = 0;
+        for (u32 offset = 1; offset < processor_count; offset++) {
+            auto cpu = (current_id + offset) % processor_count;
+            if (tried_mask & (1ull << cpu))
+                continue;
+            auto count = s_processor_ready_queues[cpu].runnable_count.load();
+            if (count > victim_count) {
+                victim = cpu;
+                victim_count = count;
             }
-            priority_mask &= ~(1u << priority);
         }
+        if (victim == current_id)
+            return nullptr;
+        if (auto* thread = callback(victim))
+            return thread;
+        tried_mask |= 1ull << victim;
+    }
+}
+
+Thread& Scheduler::pull_next_runnable_thread()
+{
+    auto affinity_mask = 1u << Processor::current_id();
+
+    auto* thread = s_processor_ready_queues[Processor::current_id()].take(affinity_mask);
+    if (!thread) {
+        thread = steal_from_busiest_processor([&](u32 victim) {
+            return s_processor_ready_queues[victim].take(affinity_mask);
+        });
+        if (thread)
+            dbgln_if(SCHEDULER_DEBUG, "Scheduler[{}]: Stole {}", Processor::current_id(), *thread);
+    }
+
+    if (!thread)
         return *Processor::idle_thread();
-    });
+
+    // Mark it as active because we are using this thread. This is similar
+    // to comparing it with Processor::current_thread, but when there are
+    // multiple processors there's no easy way to check whether the thread
+    // is actually still needed. This prevents accidental finalization when
+    // a thread is no longer in Running state, but running on another core.
+
+    // We need to mark it active here so that this thread won't be
+    // scheduled on another core if it were to be queued before actually
+    // switching to it.
+    // FIXME: Figure out a better way maybe?
+    thread->set_active(true);
+    return *thread;
 }
 
 Thread* Scheduler::peek_next_runnable_thread()
 {
     auto affinity_mask = 1u << Processor::current_id();
 
-    return g_ready_queues->with([&](auto& ready_queues) -> Thread* {
-        auto priority_mask = ready_queues.mask;
-        while (priority_mask != 0) {
-            auto priority = bit_scan_forward(priority_mask);
-            VERIFY(priority > 0);
-            auto& ready_queue = ready_queues.queues[--priority];
-            for (auto& thread : ready_queue.thread_list) {
-                VERIFY(thread.m_runnable_priority == (int)priority);
-                if (thread.is_active())
-                    continue;
-                if (!(thread.affinity() & affinity_mask))
-                    continue;
-                return &thread;
-            }
-            priority_mask &= ~(1u << priority);
-        }
+    // Unlike in pull_next_runnable_thread() we don't want to fall back to
+    // the idle thread. We just want to see if we have any other thread ready
+    // to be scheduled, either locally or on a processor we could steal from.
+    if (auto* thread = s_processor_ready_queues[Processor::current_id()].peek(affinity_mask))
+        return thread;
 
-        // Unlike in pull_next_runnable_thread() we don't want to fall back to
-        // the idle thread. We just want to see if we have any other thread ready
-        // to be scheduled.
-        return nullptr;
+    return steal_from_busiest_processor([&](u32 victim) {
+        return s_processor_ready_queues[victim].peek(affinity_mask);
     });
 }
 
@@ -136,7 +217,13 @@ bool Scheduler::dequeue_runnable_thread(Thread& thread, bool check_affinity)
     if (thread.is_idle_thread())
         return true;
 
-    return g_ready_queues->with([&](auto& ready_queues) {
+    if (thread.m_runnable_priority < 0) {
+        VERIFY(!thread.m_ready_queue_node.is_in_list());
+        return false;
+    }
+
+    auto& processor_queues = s_processor_ready_queues[thread.m_runnable_cpu];
+    return processor_queues.ready_queues.with([&](auto& ready_queues) {
         auto priority = thread.m_runnable_priority;
         if (priority < 0) {
             VERIFY(!thread.m_ready_queue_node.is_in_list());
@@ -152,6 +239,7 @@ bool Scheduler::dequeue_runnable_thread(Thread& thread, bool check_affinity)
         ready_queue.thread_list.remove(thread);
         if (ready_queue.thread_list.is_empty())
             ready_queues.mask &= ~(1u << priority);
+        processor_queues.runnable_count--;
         return true;
     });
 }
@@ -162,16 +250,20 @@ void Scheduler::enqueue_runnable_thread(Thread& thread)
     if (thread.is_idle_thread())
         return;
     auto priority = thread_priority_to_priority_index(thread.priority());
+    auto cpu = processor_for_runnable_thread(thread);
 
-    g_ready_queues->with([&](auto& ready_queues) {
+    auto& processor_queues = s_processor_ready_queues[cpu];
+    processor_queues.ready_queues.with([&](auto& ready_queues) {
         VERIFY(thread.m_runnable_priority < 0);
         thread.m_runnable_priority = (int)priority;
+        thread.m_runnable_cpu = cpu;
         VERIFY(!thread.m_ready_queue_node.is_in_list());
         auto& ready_queue = ready_queues.queues[priority];
         bool was_empty = ready_queue.thread_list.is_empty();
         ready_queue.thread_list.append(thread);
         if (was_empty)
             ready_queues.mask |= (1u << priority);
+        processor_queues.runnable_count++;
     });
 }
 
@@ -420,6 +512,11 @@ void Scheduler::timer_tick(RegisterState const& regs)
     VERIFY(current_thread->current_trap());
     VERIFY(current_thread->current_trap()->regs == &regs);
 
+    if (PerformanceSampleRing::is_enabled() && !current_thread->is_idle_thread() && !current_thread->is_profiling_suppressed()) {
+        if (auto* sample_ring = PerformanceSampleRing::for_processor(Processor::current_id()))
+            sample_ring->append(*current_thread, regs);
+    }
+
     if (current_thread->process().is_kernel_process()) {
         // Because the previous mode when entering/exiting kernel threads never changes
         // we never update the time scheduled. So we need to update it manually on the
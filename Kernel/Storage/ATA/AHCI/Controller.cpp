@@ -98,6 +98,11 @@ void AHCIController::complete_current_request(AsyncDeviceRequest::RequestResult)
     VERIFY_NOT_REACHED();
 }
 
+size_t AHCIController::max_transfer_size() const
+{
+    return AHCIPort::max_transfer_size;
+}
+
 volatile AHCI::PortRegisters& AHCIController::port(size_t port_number) const
 {
     VERIFY(port_number < (size_t)AHCI::Limits::MaxPorts);
@@ -38,6 +38,10 @@ class AHCIPort
     friend class AHCIController;
 
 public:
+    // Each port has this many pages to DMA to and from, and a request can be scattered across all of them.
+    static constexpr size_t dma_buffer_pages_count = 32;
+    static constexpr size_t max_transfer_size = dma_buffer_pages_count * PAGE_SIZE;
+
     static ErrorOr<NonnullLockRefPtr<AHCIPort>> create(AHCIController const&, AHCI::HBADefinedCapabilities, volatile AHCI::PortRegisters&, u32 port_index);
 
     u32 port_index() const { return m_port_index; }
@@ -75,7 +79,7 @@ private:
 
     void start_request(AsyncBlockDeviceRequest&);
     void complete_current_request(AsyncDeviceRequest::RequestResult);
-    bool access_device(AsyncBlockDeviceRequest::RequestType, u64 lba, u8 block_count);
+    bool access_device(AsyncBlockDeviceRequest::RequestType, u64 lba, u16 block_count);
     size_t calculate_descriptors_count(size_t block_count) const;
     [[nodiscard]] Optional<AsyncDeviceRequest::RequestResult> prepare_and_set_scatter_list(AsyncBlockDeviceRequest& request);
 
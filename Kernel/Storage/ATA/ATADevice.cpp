@@ -21,6 +21,7 @@ ATADevice::ATADevice(ATAController const& controller, ATADevice::Address ata_add
     , m_controller(controller)
     , m_ata_address(ata_address)
     , m_capabilities(capabilities)
+    , m_max_blocks_per_request(controller.max_transfer_size() / logical_sector_size)
 {
 }
 
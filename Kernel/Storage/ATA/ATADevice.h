@@ -32,6 +32,9 @@ public:
     // ^BlockDevice
     virtual void start_request(AsyncBlockDeviceRequest&) override;
 
+    // ^StorageDevice
+    virtual size_t max_blocks_per_request() const override { return m_max_blocks_per_request; }
+
     u16 ata_capabilites() const { return m_capabilities; }
     Address const& ata_address() const { return m_ata_address; }
 
@@ -41,6 +44,7 @@ protected:
     LockWeakPtr<ATAController> m_controller;
     const Address m_ata_address;
     const u16 m_capabilities;
+    size_t const m_max_blocks_per_request { 0 };
 };
 
 }
@@ -6,8 +6,10 @@
  */
 
 #include <AK/Format.h>
+#include <AK/ScopeGuard.h>
 #include <AK/Types.h>
 #include <Kernel/Arch/Delay.h>
+#include <Kernel/Arch/InterruptManagement.h>
 #include <Kernel/Arch/SafeMem.h>
 #include <Kernel/Bus/PCI/API.h>
 #include <Kernel/CommandLine.h>
@@ -52,17 +54,46 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::initialize(bool is_queue_polled)
     auto caps = m_controller_regs->cap;
     m_ready_timeout = Time::from_milliseconds((CAP_TO(caps) + 1) * 500); // CAP.TO is in 500ms units
 
+    // With MSI-X, every queue gets its own interrupt, delivered to the processor that submits to it.
+    // Table entry 0 is for the admin queue, and entry N for the IO queue with qid N.
+    // The admin queue's vector is allocated before MSI-X is enabled, so we can still use the pin-based interrupt without it.
+    Optional<NVMeMSIxVector> admin_msix_vector;
+    if (!is_queue_polled && is_msix_capable() && InterruptManagement::the().supports_message_signalled_interrupts() && msix_table_size() > 1) {
+        if (auto interrupt_or_error = InterruptManagement::the().allocate_message_signalled_interrupt(0); interrupt_or_error.is_error()) {
+            dmesgln("NVMe: Failed to allocate an MSI-X vector ({}), using pin-based interrupts", interrupt_or_error.error());
+        } else {
+            m_using_msix = true;
+            admin_msix_vector = NVMeMSIxVector { 0, interrupt_or_error.release_value() };
+            nr_of_queues = min<size_t>(nr_of_queues, msix_table_size() - 1);
+            enable_extended_message_signalled_interrupts();
+        }
+    }
+
     calculate_doorbell_stride();
-    TRY(create_admin_queue(irq));
+    TRY(create_admin_queue(irq, admin_msix_vector));
     VERIFY(m_admin_queue_ready == true);
 
     VERIFY(IO_QUEUE_SIZE < MQES(caps));
     dbgln_if(NVME_DEBUG, "NVMe: IO queue depth is: {}", IO_QUEUE_SIZE);
 
+    TRY(identify_controller());
+    dbgln_if(NVME_DEBUG, "NVMe: Maximum transfer size is {} bytes", m_max_transfer_size);
+
+    if (auto result = request_io_queues(nr_of_queues); result.is_error()) {
+        dmesgln("NVMe: Failed to request {} IO queues, trying with one", nr_of_queues);
+        nr_of_queues = 1;
+    }
+
     // Create an IO queue per core
     for (u32 cpuid = 0; cpuid < nr_of_queues; ++cpuid) {
         // qid is zero is used for admin queue
-        TRY(create_io_queue(cpuid + 1, irq));
+        if (auto result = create_io_queue(cpuid + 1, irq); result.is_error()) {
+            // The controller may support fewer queues than we have processors, so make do with what we got.
+            if (m_queues.is_empty())
+                return result.release_error();
+            dmesgln("NVMe: Failed to create IO queue {}, sharing {} queues between all processors", cpuid + 1, m_queues.size());
+            break;
+        }
     }
     TRY(identify_and_init_namespaces());
     return {};
@@ -147,6 +178,56 @@ UNMAP_AFTER_INIT u32 NVMeController::get_admin_q_dept()
     return q_depth;
 }
 
+UNMAP_AFTER_INIT ErrorOr<void> NVMeController::identify_controller()
+{
+    RefPtr<Memory::PhysicalPage> prp_dma_buffer;
+    auto prp_dma_region = TRY(MM.allocate_dma_buffer_page("Identify PRP"sv, Memory::Region::Access::ReadWrite, prp_dma_buffer));
+
+    NVMeSubmission sub {};
+    sub.op = OP_ADMIN_IDENTIFY;
+    sub.identify.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(prp_dma_buffer->paddr().as_ptr()));
+    sub.identify.cns = NVMe_CNS_ID_CTRL & 0xff;
+    if (submit_admin_command(sub, true)) {
+        dmesgln("Failed to identify controller command");
+        return EFAULT;
+    }
+
+    // MDTS is a power of two in units of the minimum memory page size, with 0 meaning no limit.
+    u8 mdts = prp_dma_region->vaddr().offset(NVMe_ID_CTRL_MDTS_INDEX).as_ptr()[0];
+    size_t max_transfer_size = NVMe_MAX_TRANSFER_SIZE;
+    auto min_page_size_shift = 12 + CAP_MPSMIN(m_controller_regs->cap);
+    if (mdts != 0 && mdts + min_page_size_shift < 32)
+        max_transfer_size = min<size_t>(max_transfer_size, 1ul << (mdts + min_page_size_shift));
+    m_max_transfer_size = max(max_transfer_size, PAGE_SIZE);
+    return {};
+}
+
+UNMAP_AFTER_INIT ErrorOr<void> NVMeController::request_io_queues(u16 count)
+{
+    NVMeSubmission sub {};
+    sub.op = OP_ADMIN_SET_FEATURES;
+    sub.generic.cdw10 = FEATURE_NUMBER_OF_QUEUES;
+    // Both counts are 0 based
+    sub.generic.cdw11 = ((count - 1) << 16) | (count - 1);
+    if (submit_admin_command(sub, true))
+        return EIO;
+    return {};
+}
+
+UNMAP_AFTER_INIT ErrorOr<Optional<NVMeMSIxVector>> NVMeController::allocate_msix_vector(u16 table_index, u32 target_cpu)
+{
+    if (!m_using_msix)
+        return Optional<NVMeMSIxVector> {};
+    auto interrupt = TRY(InterruptManagement::the().allocate_message_signalled_interrupt(target_cpu));
+    return NVMeMSIxVector { table_index, interrupt };
+}
+
+UNMAP_AFTER_INIT void NVMeController::free_msix_vector(Optional<NVMeMSIxVector> const& msix_vector)
+{
+    if (msix_vector.has_value())
+        InterruptManagement::the().free_message_signalled_interrupt(msix_vector->interrupt);
+}
+
 UNMAP_AFTER_INIT ErrorOr<void> NVMeController::identify_and_init_namespaces()
 {
 
@@ -205,7 +286,7 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::identify_and_init_namespaces()
 
             dbgln_if(NVME_DEBUG, "NVMe: Block count is {} and Block size is {}", block_counts, block_size);
 
-            m_namespaces.append(TRY(NVMeNameSpace::try_create(*this, m_queues, nsid, block_counts, block_size)));
+            m_namespaces.append(TRY(NVMeNameSpace::try_create(*this, m_queues, nsid, block_counts, block_size, m_max_transfer_size)));
             m_device_count++;
             dbgln_if(NVME_DEBUG, "NVMe: Initialized namespace with NSID: {}", nsid);
         }
@@ -253,8 +334,11 @@ void NVMeController::complete_current_request([[maybe_unused]] AsyncDeviceReques
     VERIFY_NOT_REACHED();
 }
 
-UNMAP_AFTER_INIT ErrorOr<void> NVMeController::create_admin_queue(Optional<u8> irq)
+UNMAP_AFTER_INIT ErrorOr<void> NVMeController::create_admin_queue(Optional<u8> irq, Optional<NVMeMSIxVector> msix_vector)
 {
+    ArmedScopeGuard free_msix_vector_on_failure = [&] {
+        free_msix_vector(msix_vector);
+    };
     auto qdepth = get_admin_q_dept();
     OwnPtr<Memory::Region> cq_dma_region;
     NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_pages;
@@ -289,7 +373,9 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::create_admin_queue(Optional<u8> i
         return EFAULT;
     }
     set_admin_queue_ready_flag();
-    m_admin_queue = TRY(NVMeQueue::try_create(0, irq, qdepth, move(cq_dma_region), cq_dma_pages, move(sq_dma_region), sq_dma_pages, move(doorbell_regs)));
+    // NOTE: Admin commands never transfer more than a page through the queue's own buffer.
+    m_admin_queue = TRY(NVMeQueue::try_create(*this, 0, irq, msix_vector, qdepth, PAGE_SIZE, move(cq_dma_region), cq_dma_pages, move(sq_dma_region), sq_dma_pages, move(doorbell_regs)));
+    free_msix_vector_on_failure.disarm();
 
     dbgln_if(NVME_DEBUG, "NVMe: Admin queue created");
     return {};
@@ -303,6 +389,11 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::create_io_queue(u8 qid, Optional<
     NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_pages;
     auto cq_size = round_up_to_power_of_two(CQ_SIZE(IO_QUEUE_SIZE), 4096);
     auto sq_size = round_up_to_power_of_two(SQ_SIZE(IO_QUEUE_SIZE), 4096);
+    // Queue N is used by processor N - 1
+    auto msix_vector = TRY(allocate_msix_vector(qid, qid - 1));
+    ArmedScopeGuard free_msix_vector_on_failure = [&] {
+        free_msix_vector(msix_vector);
+    };
 
     {
         auto buffer = TRY(MM.allocate_dma_buffer_pages(cq_size, "IO CQ queue"sv, Memory::Region::Access::ReadWrite, cq_dma_pages));
@@ -325,13 +416,16 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::create_io_queue(u8 qid, Optional<
         sub.create_cq.cqid = qid;
         // The queue size is 0 based
         sub.create_cq.qsize = AK::convert_between_host_and_little_endian(IO_QUEUE_SIZE - 1);
-        auto flags = irq.has_value() ? QUEUE_IRQ_ENABLED : QUEUE_IRQ_DISABLED;
+        auto flags = (irq.has_value() || msix_vector.has_value()) ? QUEUE_IRQ_ENABLED : QUEUE_IRQ_DISABLED;
         flags |= QUEUE_PHY_CONTIGUOUS;
-        // TODO: Eventually move to MSI.
-        // For now using pin based interrupts. Clear the first 16 bits
-        // to use pin-based interrupts.
         sub.create_cq.cq_flags = AK::convert_between_host_and_little_endian(flags & 0xFFFF);
-        submit_admin_command(sub, true);
+        // With pin-based interrupts, the vector has to be 0.
+        if (msix_vector.has_value())
+            sub.create_cq.irq_vector = msix_vector->table_index;
+        if (submit_admin_command(sub, true)) {
+            dbgln_if(NVME_DEBUG, "NVMe: Failed to create IO completion queue {}", qid);
+            return EIO;
+        }
     }
     {
         NVMeSubmission sub {};
@@ -343,13 +437,17 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::create_io_queue(u8 qid, Optional<
         auto flags = QUEUE_PHY_CONTIGUOUS;
         sub.create_sq.cqid = qid;
         sub.create_sq.sq_flags = AK::convert_between_host_and_little_endian(flags);
-        submit_admin_command(sub, true);
+        if (submit_admin_command(sub, true)) {
+            dbgln_if(NVME_DEBUG, "NVMe: Failed to create IO submission queue {}", qid);
+            return EIO;
+        }
     }
 
     auto queue_doorbell_offset = REG_SQ0TDBL_START + ((2 * qid) * (4 << m_dbl_stride));
     auto doorbell_regs = TRY(Memory::map_typed_writable<DoorbellRegister volatile>(PhysicalAddress(m_bar + queue_doorbell_offset)));
 
-    m_queues.append(TRY(NVMeQueue::try_create(qid, irq, IO_QUEUE_SIZE, move(cq_dma_region), cq_dma_pages, move(sq_dma_region), sq_dma_pages, move(doorbell_regs))));
+    m_queues.append(TRY(NVMeQueue::try_create(*this, qid, irq, msix_vector, IO_QUEUE_SIZE, m_max_transfer_size, move(cq_dma_region), cq_dma_pages, move(sq_dma_region), sq_dma_pages, move(doorbell_regs))));
+    free_msix_vector_on_failure.disarm();
     dbgln_if(NVME_DEBUG, "NVMe: Created IO Queue with QID{}", m_queues.size());
     return {};
 }
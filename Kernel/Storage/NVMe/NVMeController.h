@@ -57,9 +57,13 @@ public:
 private:
     NVMeController(PCI::DeviceIdentifier const&, u32 hardware_relative_controller_id);
 
+    ErrorOr<void> identify_controller();
     ErrorOr<void> identify_and_init_namespaces();
     Tuple<u64, u8> get_ns_features(IdentifyNamespace& identify_data_struct);
-    ErrorOr<void> create_admin_queue(Optional<u8> irq);
+    ErrorOr<void> request_io_queues(u16 count);
+    ErrorOr<Optional<NVMeMSIxVector>> allocate_msix_vector(u16 table_index, u32 target_cpu);
+    static void free_msix_vector(Optional<NVMeMSIxVector> const&);
+    ErrorOr<void> create_admin_queue(Optional<u8> irq, Optional<NVMeMSIxVector> msix_vector);
     ErrorOr<void> create_io_queue(u8 qid, Optional<u8> irq);
     void calculate_doorbell_stride()
     {
@@ -74,6 +78,8 @@ private:
     NonnullLockRefPtrVector<NVMeNameSpace> m_namespaces;
     Memory::TypedMapping<ControllerRegister volatile> m_controller_regs;
     bool m_admin_queue_ready { false };
+    bool m_using_msix { false };
+    size_t m_max_transfer_size { PAGE_SIZE };
     size_t m_device_count { 0 };
     AK::Time m_ready_timeout;
     u32 m_bar { 0 };
@@ -55,6 +55,13 @@ static constexpr u32 CAP_TO(u64 cap)
     return (cap & CAP_TO_MASK) >> CAP_TO_SHIFT;
 }
 
+static constexpr u8 CAP_MPSMIN_SHIFT = 48;
+static constexpr u64 CAP_MPSMIN_MASK = 0xfull << CAP_MPSMIN_SHIFT;
+static constexpr u8 CAP_MPSMIN(u64 cap)
+{
+    return (cap & CAP_MPSMIN_MASK) >> CAP_MPSMIN_SHIFT;
+}
+
 // CC – Controller Configuration
 static constexpr u8 CC_EN_BIT = 0x0;
 static constexpr u8 CSTS_RDY_BIT = 0x0;
@@ -98,11 +105,15 @@ static constexpr u16 CQ_STATUS_FIELD(u16 x)
 }
 
 static constexpr u16 IO_QUEUE_SIZE = 64; // TODO:Need to be configurable
+// Upper bound for the data of a single IO command, which is also the size of each queue's DMA buffer.
+static constexpr u32 NVMe_MAX_TRANSFER_SIZE = 128 * KiB;
 
 // IDENTIFY
 static constexpr u16 NVMe_IDENTIFY_SIZE = 4096;
 static constexpr u8 NVMe_CNS_ID_ACTIVE_NS = 0x2;
 static constexpr u8 NVMe_CNS_ID_NS = 0x0;
+static constexpr u8 NVMe_CNS_ID_CTRL = 0x1;
+static constexpr u16 NVMe_ID_CTRL_MDTS_INDEX = 77;
 static constexpr u8 FLBA_SIZE_INDEX = 26;
 static constexpr u8 FLBA_SIZE_MASK = 0xf;
 static constexpr u8 LBA_FORMAT_SUPPORT_INDEX = 128;
@@ -114,8 +125,12 @@ enum AdminCommandOpCode {
     OP_ADMIN_CREATE_COMPLETION_QUEUE = 0x5,
     OP_ADMIN_CREATE_SUBMISSION_QUEUE = 0x1,
     OP_ADMIN_IDENTIFY = 0x6,
+    OP_ADMIN_SET_FEATURES = 0x9,
 };
 
+// FEATURES
+static constexpr u8 FEATURE_NUMBER_OF_QUEUES = 0x7;
+
 // IO opcodes
 enum IOCommandOpcode {
     OP_NVME_WRITE = 0x1,
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <Kernel/Interrupts/MSIxIRQHandler.h>
+#include <Kernel/Storage/NVMe/NVMeQueue.h>
+
+namespace Kernel {
+
+// An interrupt driven queue with its own MSI-X vector, which is steered to the
+// processor that submits to this queue.
+class NVMeMSIxQueue : public NVMeQueue
+    , public MSIxIRQHandler {
+public:
+    NVMeMSIxQueue(PCI::Device&, NVMeMSIxVector const&, NonnullOwnPtr<Memory::Region> rw_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> rw_dma_pages, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<DoorbellRegister volatile> db_regs);
+    virtual ~NVMeMSIxQueue() override {};
+
+    virtual StringView purpose() const override { return "NVMe Queue"sv; }
+
+private:
+    virtual void complete_current_request(u16 status) override;
+    virtual bool handle_irq(RegisterState const&) override;
+};
+}
@@ -8,24 +8,33 @@
 #include <Kernel/StdLib.h>
 #include <Kernel/Storage/NVMe/NVMeController.h>
 #include <Kernel/Storage/NVMe/NVMeInterruptQueue.h>
+#include <Kernel/Storage/NVMe/NVMeMSIxQueue.h>
 #include <Kernel/Storage/NVMe/NVMePollQueue.h>
 #include <Kernel/Storage/NVMe/NVMeQueue.h>
+#include <Kernel/WorkQueue.h>
 
 namespace Kernel {
-ErrorOr<NonnullLockRefPtr<NVMeQueue>> NVMeQueue::try_create(u16 qid, Optional<u8> irq, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<DoorbellRegister volatile> db_regs)
+ErrorOr<NonnullLockRefPtr<NVMeQueue>> NVMeQueue::try_create(PCI::Device& device, u16 qid, Optional<u8> irq, Optional<NVMeMSIxVector> msix_vector, u32 q_depth, size_t max_transfer_size, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<DoorbellRegister volatile> db_regs)
 {
-    // Note: Allocate DMA region for RW operation. For now the requests don't exceed more than 4096 bytes (Storage device takes care of it)
-    RefPtr<Memory::PhysicalPage> rw_dma_page;
-    auto rw_dma_region = TRY(MM.allocate_dma_buffer_page("NVMe Queue Read/Write DMA"sv, Memory::Region::Access::ReadWrite, rw_dma_page));
+    // Note: Allocate DMA region for RW operation, plus one page for the PRP list.
+    //       Requests never exceed max_transfer_size (Storage device takes care of it)
+    VERIFY(max_transfer_size >= PAGE_SIZE && max_transfer_size % PAGE_SIZE == 0);
+    NonnullRefPtrVector<Memory::PhysicalPage> rw_dma_pages;
+    auto rw_dma_region = TRY(MM.allocate_dma_buffer_pages(max_transfer_size + PAGE_SIZE, "NVMe Queue Read/Write DMA"sv, Memory::Region::Access::ReadWrite, rw_dma_pages));
+    if (msix_vector.has_value()) {
+        auto queue = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) NVMeMSIxQueue(device, msix_vector.value(), move(rw_dma_region), move(rw_dma_pages), qid, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
+        TRY(queue->enable_irq());
+        return queue;
+    }
     if (!irq.has_value()) {
-        auto queue = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) NVMePollQueue(move(rw_dma_region), *rw_dma_page, qid, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
+        auto queue = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) NVMePollQueue(move(rw_dma_region), move(rw_dma_pages), qid, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
         return queue;
     }
-    auto queue = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) NVMeInterruptQueue(move(rw_dma_region), *rw_dma_page, qid, irq.value(), q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
+    auto queue = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) NVMeInterruptQueue(move(rw_dma_region), move(rw_dma_pages), qid, irq.value(), q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
     return queue;
 }
 
-UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Memory::PhysicalPage const& rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<DoorbellRegister volatile> db_regs)
+UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> rw_dma_pages, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<DoorbellRegister volatile> db_regs)
     : m_current_request(nullptr)
     , m_rw_dma_region(move(rw_dma_region))
     , m_qid(qid)
@@ -36,11 +45,33 @@ UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_regio
     , m_sq_dma_region(move(sq_dma_region))
     , m_sq_dma_page(sq_dma_page)
     , m_db_regs(move(db_regs))
-    , m_rw_dma_page(rw_dma_page)
+    , m_rw_dma_pages(move(rw_dma_pages))
 
 {
     m_sqe_array = { reinterpret_cast<NVMeSubmission*>(m_sq_dma_region->vaddr().as_ptr()), m_qdepth };
     m_cqe_array = { reinterpret_cast<NVMeCompletion*>(m_cq_dma_region->vaddr().as_ptr()), m_qdepth };
+    fill_prp_list();
+}
+
+void NVMeQueue::fill_prp_list()
+{
+    // The data pages never change, so the list only has to be written once.
+    // PRP1 always points at the first page, so the list starts with the second one.
+    auto* prp_list = reinterpret_cast<LittleEndian<u64>*>(m_rw_dma_region->vaddr().offset(max_transfer_page_count() * PAGE_SIZE).as_ptr());
+    static_assert(NVMe_MAX_TRANSFER_SIZE / PAGE_SIZE <= PAGE_SIZE / sizeof(u64));
+    for (size_t i = 1; i < max_transfer_page_count(); ++i)
+        prp_list[i - 1] = m_rw_dma_pages[i].paddr().get();
+}
+
+void NVMeQueue::set_data_pointer(DataPtr& data_ptr, size_t transfer_size)
+{
+    auto page_count = ceil_div(transfer_size, static_cast<size_t>(PAGE_SIZE));
+    VERIFY(page_count <= max_transfer_page_count());
+    data_ptr.prp1 = m_rw_dma_pages[0].paddr().get();
+    if (page_count == 2)
+        data_ptr.prp2 = m_rw_dma_pages[1].paddr().get();
+    else if (page_count > 2)
+        data_ptr.prp2 = m_rw_dma_pages.last().paddr().get();
 }
 
 bool NVMeQueue::cqe_available()
@@ -115,10 +146,10 @@ u16 NVMeQueue::submit_sync_sqe(NVMeSubmission& sub)
     // For now let's use sq tail as a unique command id.
     u16 cqe_cid;
     u16 cid = m_sq_tail;
+    int index;
 
     submit_sqe(sub);
     do {
-        int index;
         {
             SpinlockLocker lock(m_cq_lock);
             index = m_cq_head - 1;
@@ -129,7 +160,7 @@ u16 NVMeQueue::submit_sync_sqe(NVMeSubmission& sub)
         microseconds_delay(1);
     } while (cid != cqe_cid);
 
-    auto status = CQ_STATUS_FIELD(m_cqe_array[m_cq_head].status);
+    auto status = CQ_STATUS_FIELD(m_cqe_array[index].status);
     return status;
 }
 
@@ -144,7 +175,7 @@ void NVMeQueue::read(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32
     sub.rw.slba = AK::convert_between_host_and_little_endian(index);
     // No. of lbas is 0 based
     sub.rw.length = AK::convert_between_host_and_little_endian((count - 1) & 0xFFFF);
-    sub.rw.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(m_rw_dma_page->paddr().as_ptr()));
+    set_data_pointer(sub.rw.data_ptr, request.buffer_size());
 
     full_memory_barrier();
     submit_sqe(sub);
@@ -165,11 +196,42 @@ void NVMeQueue::write(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32
     sub.rw.slba = AK::convert_between_host_and_little_endian(index);
     // No. of lbas is 0 based
     sub.rw.length = AK::convert_between_host_and_little_endian((count - 1) & 0xFFFF);
-    sub.rw.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(m_rw_dma_page->paddr().as_ptr()));
+    set_data_pointer(sub.rw.data_ptr, request.buffer_size());
 
     full_memory_barrier();
     submit_sqe(sub);
 }
 
+void NVMeQueue::defer_completion_of_current_request(u16 status)
+{
+    VERIFY(m_request_lock.is_locked());
+
+    auto work_item_creation_result = g_io_work->try_queue([this, status]() {
+        SpinlockLocker lock(m_request_lock);
+        auto current_request = m_current_request;
+        m_current_request.clear();
+        if (status) {
+            lock.unlock();
+            current_request->complete(AsyncBlockDeviceRequest::Failure);
+            return;
+        }
+        if (current_request->request_type() == AsyncBlockDeviceRequest::RequestType::Read) {
+            if (auto result = current_request->write_to_buffer(current_request->buffer(), m_rw_dma_region->vaddr().as_ptr(), current_request->buffer_size()); result.is_error()) {
+                lock.unlock();
+                current_request->complete(AsyncDeviceRequest::MemoryFault);
+                return;
+            }
+        }
+        lock.unlock();
+        current_request->complete(AsyncDeviceRequest::Success);
+        return;
+    });
+    if (work_item_creation_result.is_error()) {
+        auto current_request = m_current_request;
+        m_current_request.clear();
+        current_request->complete(AsyncDeviceRequest::OutOfMemory);
+    }
+}
+
 UNMAP_AFTER_INIT NVMeQueue::~NVMeQueue() = default;
 }
@@ -55,6 +55,9 @@ public:
 public:
     virtual u64 max_addressable_block() const { return m_max_addressable_block; }
 
+    // The largest number of blocks a single request may transfer.
+    virtual size_t max_blocks_per_request() const { return m_blocks_per_page; }
+
     // ^BlockDevice
     virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override;
     virtual bool can_read(OpenFileDescription const&, u64) const override;
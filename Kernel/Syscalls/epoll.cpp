@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ScopeGuard.h>
+#include <Kernel/Debug.h>
+#include <Kernel/FileSystem/EPoll.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+ErrorOr<FlatPtr> Process::sys$epoll_create(u32 flags)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    TRY(require_promise(Pledge::stdio));
+
+    if (flags & ~EPOLL_CLOEXEC)
+        return EINVAL;
+
+    auto fd_allocation = TRY(allocate_fd());
+    auto epoll = TRY(EPoll::try_create());
+    auto description = TRY(OpenFileDescription::try_create(move(epoll)));
+    description->set_readable(true);
+
+    return m_fds.with_exclusive([&](auto& fds) -> ErrorOr<FlatPtr> {
+        fds[fd_allocation.fd].set(move(description));
+
+        if (flags & EPOLL_CLOEXEC)
+            fds[fd_allocation.fd].set_flags(fds[fd_allocation.fd].flags() | FD_CLOEXEC);
+
+        return fd_allocation.fd;
+    });
+}
+
+ErrorOr<FlatPtr> Process::sys$epoll_ctl(Userspace<Syscall::SC_epoll_ctl_params const*> user_params)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    TRY(require_promise(Pledge::stdio));
+    auto params = TRY(copy_typed_from_user(user_params));
+
+    auto epoll_description = TRY(open_file_description(params.epoll_fd));
+    if (!epoll_description->is_epoll())
+        return EINVAL;
+    auto* epoll = epoll_description->epoll();
+
+    auto description = TRY(open_file_description(params.fd));
+    if (description.ptr() == epoll_description.ptr())
+        return EINVAL;
+
+    epoll_event event {};
+    if (params.op != EPOLL_CTL_DEL)
+        TRY(copy_from_user(&event, params.event));
+
+    switch (params.op) {
+    case EPOLL_CTL_ADD:
+        TRY(epoll->add_watch(params.fd, *description, event));
+        return 0;
+    case EPOLL_CTL_MOD:
+        TRY(epoll->modify_watch(params.fd, *description, event));
+        return 0;
+    case EPOLL_CTL_DEL:
+        TRY(epoll->remove_watch(params.fd, *description));
+        return 0;
+    default:
+        return EINVAL;
+    }
+}
+
+ErrorOr<FlatPtr> Process::sys$epoll_wait(Userspace<Syscall::SC_epoll_wait_params const*> user_params)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+    auto params = TRY(copy_typed_from_user(user_params));
+
+    if (params.max_events <= 0)
+        return EINVAL;
+
+    auto epoll_description = TRY(open_file_description(params.epoll_fd));
+    if (!epoll_description->is_epoll())
+        return EINVAL;
+    auto* epoll = epoll_description->epoll();
+
+    Thread::BlockTimeout timeout;
+    if (params.timeout) {
+        auto timeout_time = TRY(copy_time_from_user(params.timeout));
+        timeout = Thread::BlockTimeout(false, &timeout_time);
+    }
+
+    sigset_t sigmask = {};
+    if (params.sigmask)
+        TRY(copy_from_user(&sigmask, params.sigmask));
+
+    // It's fine to report fewer events than the caller asked for, the rest
+    // will be picked up by the next call.
+    Vector<epoll_event, 32> events;
+    TRY(events.try_resize(min(static_cast<size_t>(params.max_events), EPoll::max_events_per_wait)));
+
+    auto* current_thread = Thread::current();
+
+    u32 previous_signal_mask = 0;
+    if (params.sigmask)
+        previous_signal_mask = current_thread->update_signal_mask(sigmask);
+    ScopeGuard rollback_signal_mask([&]() {
+        if (params.sigmask)
+            current_thread->update_signal_mask(previous_signal_mask);
+    });
+
+    auto count = TRY(epoll->wait(events.span(), timeout));
+    dbgln_if(POLL_SELECT_DEBUG, "epoll_wait on {} returned {} events", params.epoll_fd, count);
+
+    if (count > 0)
+        TRY(copy_n_to_user(params.events, events.data(), count));
+    return count;
+}
+
+}
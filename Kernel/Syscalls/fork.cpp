@@ -156,7 +156,8 @@ ErrorOr<FlatPtr> Process::sys$fork(RegisterState& regs)
             for (auto& region : parent_space->region_tree().regions()) {
                 dbgln_if(FORK_DEBUG, "fork: cloning Region '{}' @ {}", region.name(), region.vaddr());
                 auto region_clone = TRY(region.try_clone());
-                TRY(region_clone->map(child_space->page_directory(), Memory::ShouldFlushTLB::No));
+                // The child's page tables are only filled in for the regions it actually touches.
+                region_clone->map_on_first_fault(child_space->page_directory());
                 TRY(child_space->region_tree().place_specifically(*region_clone, region.range()));
                 auto* child_region = region_clone.leak_ptr();
 
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/IORing.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+ErrorOr<FlatPtr> Process::sys$io_ring_create(u32 entries, u32 flags)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    TRY(require_promise(Pledge::stdio));
+
+    if (flags & ~IO_RING_CLOEXEC)
+        return EINVAL;
+
+    auto fd_allocation = TRY(allocate_fd());
+    auto ring = TRY(IORing::try_create(entries));
+    auto description = TRY(OpenFileDescription::try_create(move(ring)));
+    description->set_readable(true);
+
+    return m_fds.with_exclusive([&](auto& fds) -> ErrorOr<FlatPtr> {
+        fds[fd_allocation.fd].set(move(description));
+
+        if (flags & IO_RING_CLOEXEC)
+            fds[fd_allocation.fd].set_flags(fds[fd_allocation.fd].flags() | FD_CLOEXEC);
+
+        return fd_allocation.fd;
+    });
+}
+
+ErrorOr<FlatPtr> Process::sys$io_ring_enter(int fd, u32 to_submit, u32 min_complete)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+
+    auto description = TRY(open_file_description(fd));
+    if (!description->is_io_ring())
+        return EINVAL;
+    return TRY(description->io_ring()->enter(*this, to_submit, min_complete));
+}
+
+}
@@ -200,6 +200,10 @@ ErrorOr<FlatPtr> Process::sys$mmap(Userspace<Syscall::SC_mmap_params const*> use
     if (map_anonymous) {
         auto strategy = map_noreserve ? AllocationStrategy::None : AllocationStrategy::Reserve;
 
+        // Let big anonymous mappings start on a large page boundary, so they can be backed by large pages.
+        if (!params.alignment && requested_range.base().is_null() && strategy == AllocationStrategy::Reserve && rounded_size >= Memory::large_page_size)
+            alignment = Memory::large_page_size;
+
         if (flags & MAP_PURGEABLE) {
             vmobject = TRY(Memory::AnonymousVMObject::try_create_purgeable_with_size(rounded_size, strategy));
         } else {
@@ -6,6 +6,7 @@
 
 #include <Kernel/Library/NonnullLockRefPtrVector.h>
 #include <Kernel/Memory/AnonymousVMObject.h>
+#include <Kernel/Memory/CompressedPagePool.h>
 #include <Kernel/Memory/InodeVMObject.h>
 #include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Process.h>
@@ -66,6 +67,10 @@ ErrorOr<FlatPtr> Process::sys$purge(int mode)
             purged_page_count += vmobject.release_all_clean_pages();
         }
     }
+    if (mode & PURGE_COMPRESS_COLD_ANONYMOUS) {
+        // NOTE: Pages have to go unused between two calls to be compressed.
+        purged_page_count += Memory::CompressedPagePool::the().compress_cold_pages(NumericLimits<size_t>::max());
+    }
     return purged_page_count;
 }
 
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/NumericLimits.h>
+#include <Kernel/Debug.h>
+#include <Kernel/FileSystem/Inode.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/Net/Socket.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+// Size of the bounce buffer used when the destination can't take data straight from the inode.
+static constexpr size_t sendfile_bounce_buffer_size = 64 * KiB;
+
+// Returns ENOTSUP (without sending anything) if the socket can't send from an inode.
+static ErrorOr<size_t> send_inode_to_socket(OpenFileDescription& description, Socket& socket, Inode const& inode, off_t offset, size_t count)
+{
+    size_t total_nsent = 0;
+    while (total_nsent < count) {
+        while (!description.can_write()) {
+            if (!description.is_blocking()) {
+                if (total_nsent > 0)
+                    return total_nsent;
+                return EAGAIN;
+            }
+            auto unblock_flags = Thread::FileBlocker::BlockFlags::None;
+            if (Thread::current()->block<Thread::WriteBlocker>({}, description, unblock_flags).was_interrupted()) {
+                if (total_nsent == 0)
+                    return EINTR;
+                return total_nsent;
+            }
+        }
+
+        auto nsent_or_error = socket.send_from_inode(description, inode, offset + total_nsent, count - total_nsent);
+        if (nsent_or_error.is_error()) {
+            if (total_nsent > 0)
+                return total_nsent;
+            if (nsent_or_error.error().code() == EAGAIN)
+                continue;
+            if (nsent_or_error.error().code() == EPIPE)
+                Thread::current()->send_signal(SIGPIPE, &Process::current());
+            return nsent_or_error.release_error();
+        }
+        VERIFY(nsent_or_error.value() > 0);
+        total_nsent += nsent_or_error.value();
+    }
+    return total_nsent;
+}
+
+ErrorOr<FlatPtr> Process::sys$sendfile(Userspace<Syscall::SC_sendfile_params const*> user_params)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    TRY(require_promise(Pledge::stdio));
+    auto params = TRY(copy_typed_from_user(user_params));
+
+    if (params.count > NumericLimits<ssize_t>::max())
+        return EINVAL;
+
+    auto out_description = TRY(open_file_description(params.out_fd));
+    if (!out_description->is_writable())
+        return EBADF;
+    auto in_description = TRY(open_file_description(params.in_fd));
+    if (!in_description->is_readable())
+        return EBADF;
+
+    // The source has to be a regular file, as we read it at arbitrary offsets.
+    auto* inode = in_description->inode();
+    if (!inode || !inode->metadata().is_regular_file())
+        return EINVAL;
+
+    off_t offset = 0;
+    if (params.offset) {
+        TRY(copy_from_user(&offset, params.offset));
+        if (offset < 0)
+            return EINVAL;
+    } else {
+        offset = in_description->offset();
+    }
+
+    auto file_size = static_cast<off_t>(inode->size());
+    size_t count = offset < file_size ? min(params.count, static_cast<size_t>(file_size - offset)) : 0;
+    dbgln_if(IO_DEBUG, "sys$sendfile({}, {}, {}, {})", params.out_fd, params.in_fd, offset, count);
+
+    auto send_through_bounce_buffer = [&]() -> ErrorOr<size_t> {
+        auto buffer = TRY(KBuffer::try_create_with_size("sendfile"sv, min(count, sendfile_bounce_buffer_size)));
+        auto kernel_buffer = UserOrKernelBuffer::for_kernel_buffer(buffer->data());
+        size_t total_nsent = 0;
+        while (total_nsent < count) {
+            auto nread_or_error = inode->read_bytes(offset + total_nsent, min(count - total_nsent, buffer->size()), kernel_buffer, in_description.ptr());
+            if (nread_or_error.is_error()) {
+                if (total_nsent > 0)
+                    break;
+                return nread_or_error.release_error();
+            }
+            if (nread_or_error.value() == 0)
+                break;
+            auto nwritten_or_error = do_write(*out_description, kernel_buffer, nread_or_error.value());
+            if (nwritten_or_error.is_error()) {
+                if (total_nsent > 0)
+                    break;
+                return nwritten_or_error.release_error();
+            }
+            total_nsent += nwritten_or_error.value();
+            if (nwritten_or_error.value() < nread_or_error.value())
+                break;
+        }
+        return total_nsent;
+    };
+
+    size_t nsent = 0;
+    if (count > 0) {
+        auto nsent_or_error = out_description->is_socket()
+            ? send_inode_to_socket(*out_description, *out_description->socket(), *inode, offset, count)
+            : ErrorOr<size_t> { Error::from_errno(ENOTSUP) };
+        if (nsent_or_error.is_error() && nsent_or_error.error().code() == ENOTSUP)
+            nsent_or_error = send_through_bounce_buffer();
+        nsent = TRY(nsent_or_error);
+    }
+
+    if (params.offset) {
+        off_t new_offset = offset + nsent;
+        TRY(copy_to_user(params.offset, &new_offset));
+    } else {
+        TRY(in_description->seek(offset + nsent, SEEK_SET));
+    }
+    return nsent;
+}
+
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/Memory/CompressedPagePool.h>
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Process.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Tasks/PageCompressionTask.h>
+#include <Kernel/Time/TimeManagement.h>
+
+namespace Kernel {
+
+// We start compressing pages once less than this share of physical memory is left to be committed.
+static constexpr size_t low_memory_divisor = 8;
+static constexpr size_t max_pages_compressed_per_second = 1024;
+
+UNMAP_AFTER_INIT void PageCompressionTask::spawn()
+{
+    LockRefPtr<Thread> thread;
+    (void)Process::create_kernel_process(thread, KString::must_create("Page Compression Task"sv), [] {
+        dbgln("PageCompressionTask is running");
+        for (;;) {
+            (void)Thread::current()->sleep(Time::from_seconds(1));
+
+            auto memory_info = MM.get_system_memory_info();
+            auto low_memory_page_count = memory_info.physical_pages / low_memory_divisor;
+            if (memory_info.physical_pages_uncommitted >= low_memory_page_count)
+                continue;
+
+            auto& pool = Memory::CompressedPagePool::the();
+            if (pool.is_full())
+                continue;
+
+            // NOTE: Pages are only compressed once they went unused for a whole pass, so when memory
+            //       first runs low, this pass only marks them, and the next one gets to compress them.
+            auto page_count = min(low_memory_page_count - memory_info.physical_pages_uncommitted, max_pages_compressed_per_second);
+            if (auto compressed_page_count = pool.compress_cold_pages(page_count))
+                dbgln("PageCompressionTask: Compressed {} pages, now holding {} pages in {} bytes", compressed_page_count, pool.page_count(), pool.compressed_size());
+        }
+    });
+}
+
+}
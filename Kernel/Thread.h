@@ -136,6 +136,7 @@ class Thread
     friend class Process;
     friend class Scheduler;
     friend struct ThreadReadyQueue;
+    friend struct ProcessorReadyQueues;
 
 public:
     inline static Thread* current()
@@ -1177,6 +1178,7 @@ private:
 
     IntrusiveListNode<Thread> m_process_thread_list_node;
     int m_runnable_priority { -1 };
+    u32 m_runnable_cpu { 0 };
 
     friend class WaitQueue;
 
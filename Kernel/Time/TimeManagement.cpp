@@ -10,6 +10,7 @@
 #include <AK/Time.h>
 
 #if ARCH(I386) || ARCH(X86_64)
+#    include <Kernel/Arch/x86/ASM_wrapper.h>
 #    include <Kernel/Arch/x86/Time/APICTimer.h>
 #    include <Kernel/Arch/x86/Time/HPET.h>
 #    include <Kernel/Arch/x86/Time/HPETComparator.h>
@@ -242,6 +243,10 @@ UNMAP_AFTER_INIT TimeManagement::TimeManagement()
     : m_time_page_region(MM.allocate_kernel_region(PAGE_SIZE, "Time page"sv, Memory::Region::Access::ReadWrite, AllocationStrategy::AllocateNow).release_value_but_fixme_should_propagate_errors())
 {
 #if ARCH(I386) || ARCH(X86_64)
+    // The time stamp counter must tick at the same rate regardless of the processor's power state,
+    // otherwise it's of no use for keeping time. Whether all processors agree is checked once they're up.
+    m_can_interpolate_time_page = Processor::current().has_feature(CPUFeature::TSC) && Processor::current().has_feature(CPUFeature::NONSTOP_TSC);
+
     bool probe_non_legacy_hardware_timers = !(kernel_command_line().is_legacy_time_enabled());
     if (ACPI::is_enabled()) {
         if (!ACPI::Parser::the()->x86_specific_flags().cmos_rtc_not_present) {
@@ -530,12 +535,141 @@ bool TimeManagement::disable_profile_timer()
     return true;
 }
 
+void TimeManagement::update_tsc_calibration(u64 tsc, u64 monotonic_ns)
+{
+    static constexpr u64 initial_calibration_span_ns = 1'000'000'000;
+    static constexpr u64 maximum_calibration_span_ns = 1024 * initial_calibration_span_ns;
+
+    if (m_tsc_calibration_next_span_ns == 0) {
+        m_tsc_calibration_start_tsc = tsc;
+        m_tsc_calibration_start_ns = monotonic_ns;
+        m_tsc_calibration_next_span_ns = initial_calibration_span_ns;
+        return;
+    }
+
+    auto span_ns = monotonic_ns - m_tsc_calibration_start_ns;
+    if (span_ns < m_tsc_calibration_next_span_ns || tsc <= m_tsc_calibration_start_tsc)
+        return;
+    auto span_tsc = tsc - m_tsc_calibration_start_tsc;
+
+    // Use as many fractional bits as we can, while keeping the multiplier below 2^32,
+    // so that userspace can multiply it with (32-bit) deltas without overflowing.
+    u32 shift = 32;
+    while (shift > 0 && span_ns > (NumericLimits<u64>::max() >> shift))
+        --shift;
+    u64 multiplier = (span_ns << shift) / span_tsc;
+    while (shift > 0 && multiplier > NumericLimits<u32>::max()) {
+        --shift;
+        multiplier >>= 1;
+    }
+
+    m_tsc_multiplier = multiplier;
+    m_tsc_shift = shift;
+    m_tsc_calibration_next_span_ns = m_tsc_calibration_next_span_ns < maximum_calibration_span_ns ? m_tsc_calibration_next_span_ns * 2 : NumericLimits<u64>::max();
+}
+
+#if ARCH(I386) || ARCH(X86_64)
+UNMAP_AFTER_INIT void TimeManagement::check_time_stamp_counter_synchronization()
+{
+    if (!m_can_interpolate_time_page || Processor::count() <= 1)
+        return;
+
+    // We and one other processor take turns reading our time stamp counters, each comparing its reading with the
+    // one that was taken last. If the counters agreed, the readings would never go backwards.
+    static constexpr size_t iterations = 20'000;
+    struct WarpCheck {
+        Spinlock lock { LockRank::None };
+        u64 last_tsc { 0 };
+        bool warped { false };
+        Atomic<bool> started { false };
+        Atomic<bool> finished { false };
+    };
+    auto take_turns = [](WarpCheck& check) {
+        for (size_t i = 0; i < iterations; ++i) {
+            SpinlockLocker locker(check.lock);
+            auto tsc = read_tsc();
+            if (tsc < check.last_tsc)
+                check.warped = true;
+            check.last_tsc = tsc;
+        }
+    };
+
+    auto current_id = Processor::current_id();
+    for (u32 cpu = 0; cpu < Processor::count(); ++cpu) {
+        if (cpu == current_id)
+            continue;
+        WarpCheck check;
+        Processor::smp_unicast(
+            cpu, [&] {
+                check.started = true;
+                take_turns(check);
+                check.finished = true;
+            },
+            true);
+        while (!check.started)
+            Processor::wait_check();
+        take_turns(check);
+        while (!check.finished)
+            Processor::wait_check();
+
+        if (check.warped) {
+            dmesgln("Time: Time stamp counters of CPU #{} and CPU #{} disagree, not interpolating the time page", current_id, cpu);
+            m_can_interpolate_time_page = false;
+            return;
+        }
+    }
+}
+#endif
+
 void TimeManagement::update_time_page()
 {
+    auto coarse_monotonic = monotonic_time(TimePrecision::Coarse);
+    auto monotonic = coarse_monotonic;
+    u64 tsc = 0;
+    u64 tsc_multiplier = 0;
+#if ARCH(I386) || ARCH(X86_64)
+    if (m_can_interpolate_time_page && m_time_keeper_timer) {
+        // Userspace interpolates from this point on, so the time has to be taken together with the counter.
+        auto precise_monotonic = monotonic_time(TimePrecision::Precise);
+        tsc = read_tsc();
+        monotonic = precise_monotonic;
+
+        // Userspace may have interpolated as far as this from the last update, which we mustn't go back on,
+        // even if the multiplier was a bit off, or is about to change.
+        if (m_tsc_multiplier != 0) {
+            auto tsc_delta = tsc > m_time_page_tsc_base ? min(tsc - m_time_page_tsc_base, m_time_page_tsc_max_delta) : 0;
+            auto interpolated_ns = m_time_page_base_ns + ((tsc_delta * m_tsc_multiplier) >> m_tsc_shift);
+            if (static_cast<u64>(monotonic.to_nanoseconds()) < interpolated_ns)
+                monotonic = Time::from_nanoseconds(static_cast<i64>(interpolated_ns));
+        }
+
+        update_tsc_calibration(tsc, static_cast<u64>(precise_monotonic.to_nanoseconds()));
+        tsc_multiplier = m_tsc_multiplier;
+
+        // Interpolation stops a little after the next update is due, as that may pick up from wherever it got to.
+        u64 tsc_max_delta = 0;
+        if (tsc_multiplier != 0) {
+            u64 nanoseconds_per_update = 1'000'000'000 / m_time_keeper_timer->frequency();
+            tsc_max_delta = min(((2 * nanoseconds_per_update) << m_tsc_shift) / tsc_multiplier, static_cast<u64>(NumericLimits<u32>::max()));
+        }
+        m_time_page_base_ns = static_cast<u64>(monotonic.to_nanoseconds());
+        m_time_page_tsc_base = tsc;
+        m_time_page_tsc_max_delta = tsc_max_delta;
+    }
+#endif
+
     auto& page = time_page();
     u32 update_iteration = AK::atomic_fetch_add(&page.update2, 1u, AK::MemoryOrder::memory_order_acquire);
     page.clocks[CLOCK_REALTIME_COARSE] = m_epoch_time;
-    page.clocks[CLOCK_MONOTONIC_COARSE] = monotonic_time(TimePrecision::Coarse).to_timespec();
+    page.clocks[CLOCK_MONOTONIC_COARSE] = coarse_monotonic.to_timespec();
+    // NOTE: The wall clock only moves in ticks, so it gets the same head start as the monotonic clock.
+    page.clocks[CLOCK_REALTIME] = (Time::from_timespec(m_epoch_time) + (monotonic - coarse_monotonic)).to_timespec();
+    page.clocks[CLOCK_MONOTONIC] = monotonic.to_timespec();
+    page.clocks[CLOCK_MONOTONIC_RAW] = page.clocks[CLOCK_MONOTONIC];
+    page.tsc_base = tsc;
+    page.tsc_multiplier = tsc_multiplier;
+    page.tsc_shift = m_tsc_shift;
+    page.tsc_max_delta = m_time_page_tsc_max_delta;
     AK::atomic_store(&page.update1, update_iteration + 1u, AK::MemoryOrder::memory_order_release);
 }
 
@@ -77,9 +77,16 @@ public:
 
     Memory::VMObject& time_page_vmobject();
 
+#if ARCH(I386) || ARCH(X86_64)
+    // Once all processors are up, this makes sure that their time stamp counters agree with each other,
+    // as userspace may read them on any of them. If they don't, the time page isn't interpolated.
+    void check_time_stamp_counter_synchronization();
+#endif
+
 private:
     TimePage& time_page();
     void update_time_page();
+    void update_tsc_calibration(u64 tsc, u64 monotonic_ns);
 
 #if ARCH(I386) || ARCH(X86_64)
     bool probe_and_set_x86_legacy_hardware_timers();
@@ -120,6 +127,21 @@ private:
     LockRefPtr<HardwareTimerBase> m_profile_timer;
 
     NonnullOwnPtr<Memory::Region> m_time_page_region;
+
+    // The time page lets userspace interpolate the precise clocks with the time stamp counter,
+    // which we calibrate against our own clock over increasingly long spans of time.
+    Atomic<bool> m_can_interpolate_time_page { false };
+    // NOTE: These may only be accessed from the BSP, like the time page itself.
+    u64 m_tsc_calibration_start_tsc { 0 };
+    u64 m_tsc_calibration_start_ns { 0 };
+    u64 m_tsc_calibration_next_span_ns { 0 };
+    u64 m_tsc_multiplier { 0 };
+    u32 m_tsc_shift { 0 };
+    // What the time page was last updated with, so that the next update doesn't fall behind what userspace
+    // may have interpolated from it.
+    u64 m_time_page_base_ns { 0 };
+    u64 m_time_page_tsc_base { 0 };
+    u64 m_time_page_tsc_max_delta { 0 };
 };
 
 }
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static constexpr size_t chunk_size = 1024;
+// Enough chunks that the dirty blocks make several runs longer than the longest merged write.
+static constexpr size_t chunk_count = 1024;
+
+static void fill_chunk(Array<u8, chunk_size>& chunk, size_t index, u8 generation)
+{
+    for (size_t i = 0; i < chunk_size; ++i)
+        chunk[i] = static_cast<u8>(index * 7 + i + generation);
+}
+
+static void expect_file_contents(int fd, Function<u8(size_t)> generation_of_chunk)
+{
+    Array<u8, chunk_size> expected;
+    Array<u8, chunk_size> actual;
+    for (size_t index = 0; index < chunk_count; ++index) {
+        fill_chunk(expected, index, generation_of_chunk(index));
+        auto nread = pread(fd, actual.data(), chunk_size, index * chunk_size);
+        EXPECT_EQ(nread, static_cast<ssize_t>(chunk_size));
+        EXPECT(actual == expected);
+    }
+}
+
+TEST_CASE(flushed_writes_read_back_intact)
+{
+    char path[] = "/home/anon/flush-test.XXXXXX";
+    auto fd = mkstemp(path);
+    VERIFY(fd >= 0);
+
+    Array<u8, chunk_size> chunk;
+    for (size_t index = 0; index < chunk_count; ++index) {
+        fill_chunk(chunk, index, 0);
+        EXPECT_EQ(pwrite(fd, chunk.data(), chunk_size, index * chunk_size), static_cast<ssize_t>(chunk_size));
+    }
+    EXPECT_EQ(fsync(fd), 0);
+    expect_file_contents(fd, [](size_t) -> u8 { return 0; });
+
+    // Rewrite runs of different lengths separated by gaps, so the flush has both merged and single-block writes.
+    auto is_rewritten = [](size_t index) { return index % 100 < index / 100 + 1; };
+    for (size_t index = 0; index < chunk_count; ++index) {
+        if (!is_rewritten(index))
+            continue;
+        fill_chunk(chunk, index, 1);
+        EXPECT_EQ(pwrite(fd, chunk.data(), chunk_size, index * chunk_size), static_cast<ssize_t>(chunk_size));
+    }
+    EXPECT_EQ(fsync(fd), 0);
+    expect_file_contents(fd, [&](size_t index) -> u8 { return is_rewritten(index) ? 1 : 0; });
+
+    // Flush again with a single dirty run, after the merge buffer has already been used.
+    for (size_t index = 0; index < chunk_count; ++index) {
+        fill_chunk(chunk, index, 2);
+        EXPECT_EQ(pwrite(fd, chunk.data(), chunk_size, index * chunk_size), static_cast<ssize_t>(chunk_size));
+    }
+    EXPECT_EQ(fsync(fd), 0);
+    expect_file_contents(fd, [](size_t) -> u8 { return 2; });
+
+    EXPECT_EQ(close(fd), 0);
+    EXPECT_EQ(unlink(path), 0);
+}
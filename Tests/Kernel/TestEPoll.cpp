@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+static int wait_for_events(int epoll_fd, epoll_event* events, int max_events)
+{
+    return epoll_wait(epoll_fd, events, max_events, 0);
+}
+
+TEST_CASE(epoll_level_triggered)
+{
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    EXPECT(epoll_fd >= 0);
+
+    epoll_event event { EPOLLIN, { .fd = pipe_fds[0] } };
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, pipe_fds[0], &event), 0);
+
+    epoll_event events[4];
+    EXPECT_EQ(wait_for_events(epoll_fd, events, 4), 0);
+
+    EXPECT_EQ(write(pipe_fds[1], "x", 1), 1);
+    for (int i = 0; i < 2; ++i) {
+        // Level-triggered watches are reported for as long as they are ready.
+        EXPECT_EQ(wait_for_events(epoll_fd, events, 4), 1);
+        EXPECT_EQ(events[0].events, EPOLLIN);
+        EXPECT_EQ(events[0].data.fd, pipe_fds[0]);
+    }
+
+    char buffer;
+    EXPECT_EQ(read(pipe_fds[0], &buffer, 1), 1);
+    EXPECT_EQ(wait_for_events(epoll_fd, events, 4), 0);
+
+    close(epoll_fd);
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+}
+
+TEST_CASE(epoll_edge_triggered_and_oneshot)
+{
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+    int epoll_fd = epoll_create1(0);
+    EXPECT(epoll_fd >= 0);
+
+    epoll_event event { EPOLLIN | EPOLLET, { .fd = pipe_fds[0] } };
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, pipe_fds[0], &event), 0);
+
+    epoll_event events[4];
+    EXPECT_EQ(write(pipe_fds[1], "x", 1), 1);
+    EXPECT_EQ(wait_for_events(epoll_fd, events, 4), 1);
+    EXPECT_EQ(wait_for_events(epoll_fd, events, 4), 0);
+    EXPECT_EQ(write(pipe_fds[1], "x", 1), 1);
+    EXPECT_EQ(wait_for_events(epoll_fd, events, 4), 1);
+
+    event.events = EPOLLIN | EPOLLONESHOT;
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_MOD, pipe_fds[0], &event), 0);
+    EXPECT_EQ(wait_for_events(epoll_fd, events, 4), 1);
+    EXPECT_EQ(wait_for_events(epoll_fd, events, 4), 0);
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_MOD, pipe_fds[0], &event), 0);
+    EXPECT_EQ(wait_for_events(epoll_fd, events, 4), 1);
+
+    close(epoll_fd);
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+}
+
+TEST_CASE(epoll_ctl_errors)
+{
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+    int epoll_fd = epoll_create1(0);
+    EXPECT(epoll_fd >= 0);
+
+    epoll_event event { EPOLLIN, {} };
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_MOD, pipe_fds[0], &event), -1);
+    EXPECT_EQ(errno, ENOENT);
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, pipe_fds[0], &event), 0);
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, pipe_fds[0], &event), -1);
+    EXPECT_EQ(errno, EEXIST);
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, epoll_fd, &event), -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_DEL, pipe_fds[0], nullptr), 0);
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_DEL, pipe_fds[0], nullptr), -1);
+    EXPECT_EQ(errno, ENOENT);
+
+    close(epoll_fd);
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+}
+
+TEST_CASE(epoll_watch_outlives_closed_fd)
+{
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+    int epoll_fd = epoll_create1(0);
+    EXPECT(epoll_fd >= 0);
+
+    epoll_event event { EPOLLIN, { .fd = pipe_fds[0] } };
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, pipe_fds[0], &event), 0);
+
+    // The dup keeps the description (and with it, the watch) alive after the fd is closed.
+    int duplicate_fd = dup(pipe_fds[0]);
+    EXPECT(duplicate_fd >= 0);
+    int watched_fd = pipe_fds[0];
+    EXPECT_EQ(close(watched_fd), 0);
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_DEL, watched_fd, nullptr), -1);
+    EXPECT_EQ(errno, EBADF);
+
+    // A new description that reuses the fd number is a different watch altogether.
+    int reopened_pipe_fds[2];
+    EXPECT_EQ(pipe(reopened_pipe_fds), 0);
+    EXPECT_EQ(reopened_pipe_fds[0], watched_fd);
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_MOD, watched_fd, &event), -1);
+    EXPECT_EQ(errno, ENOENT);
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, watched_fd, &event), 0);
+
+    epoll_event events[4];
+    EXPECT_EQ(write(reopened_pipe_fds[1], "x", 1), 1);
+    EXPECT_EQ(wait_for_events(epoll_fd, events, 4), 1);
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_DEL, watched_fd, nullptr), 0);
+
+    close(epoll_fd);
+    close(duplicate_fd);
+    close(pipe_fds[1]);
+    close(reopened_pipe_fds[0]);
+    close(reopened_pipe_fds[1]);
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibTest/TestCase.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static constexpr size_t mapping_size = 4 * MiB;
+
+static int wait_for(pid_t pid)
+{
+    int status = 0;
+    VERIFY(waitpid(pid, &status, 0) == pid);
+    return status;
+}
+
+TEST_CASE(child_sees_parent_memory_and_does_not_change_it)
+{
+    auto* data = static_cast<u8*>(mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    EXPECT_NE(data, MAP_FAILED);
+    for (size_t i = 0; i < mapping_size; i += PAGE_SIZE)
+        data[i] = static_cast<u8>(i / PAGE_SIZE);
+
+    pid_t pid = fork();
+    EXPECT(pid >= 0);
+    if (pid == 0) {
+        for (size_t i = 0; i < mapping_size; i += PAGE_SIZE) {
+            if (data[i] != static_cast<u8>(i / PAGE_SIZE))
+                _exit(1);
+            data[i] = 0xff;
+        }
+        _exit(0);
+    }
+
+    auto status = wait_for(pid);
+    EXPECT(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+    for (size_t i = 0; i < mapping_size; i += PAGE_SIZE)
+        EXPECT_EQ(data[i], static_cast<u8>(i / PAGE_SIZE));
+
+    EXPECT_EQ(munmap(data, mapping_size), 0);
+}
+
+TEST_CASE(child_still_faults_on_inaccessible_memory)
+{
+    auto* data = static_cast<u8*>(mmap(nullptr, PAGE_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    EXPECT_NE(data, MAP_FAILED);
+
+    pid_t pid = fork();
+    EXPECT(pid >= 0);
+    if (pid == 0) {
+        *const_cast<u8 volatile*>(data) = 1;
+        _exit(0);
+    }
+
+    auto status = wait_for(pid);
+    EXPECT(WIFSIGNALED(status));
+    EXPECT_EQ(WTERMSIG(status), SIGSEGV);
+
+    EXPECT_EQ(munmap(data, PAGE_SIZE), 0);
+}
+
+TEST_CASE(vfork_child_can_exec)
+{
+    pid_t pid = vfork();
+    EXPECT(pid >= 0);
+    if (pid == 0) {
+        execl("/bin/true", "true", nullptr);
+        _exit(127);
+    }
+
+    auto status = wait_for(pid);
+    EXPECT(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
+TEST_CASE(posix_spawn_reports_exit_status)
+{
+    char const* argv[] = { "sh", "-c", "exit 3", nullptr };
+    pid_t pid = 0;
+    EXPECT_EQ(posix_spawn(&pid, "/bin/sh", nullptr, nullptr, const_cast<char**>(argv), environ), 0);
+
+    auto status = wait_for(pid);
+    EXPECT(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 3);
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <Kernel/API/IORing.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <serenity.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+struct Ring {
+    int fd { -1 };
+    u8* base { nullptr };
+    u32 entries { 0 };
+
+    IORingHeader& header() { return *reinterpret_cast<IORingHeader*>(base); }
+    IORingSubmission& submission(u32 index) { return reinterpret_cast<IORingSubmission*>(base + header().submission_offset)[index & header().submission_mask]; }
+    IORingCompletion& completion(u32 index) { return reinterpret_cast<IORingCompletion*>(base + header().completion_offset)[index & header().completion_mask]; }
+
+    void submit(IORingSubmission const& submission)
+    {
+        auto tail = header().submission_tail;
+        this->submission(tail) = submission;
+        AK::atomic_store(&header().submission_tail, tail + 1, AK::memory_order_release);
+    }
+
+    IORingCompletion reap()
+    {
+        auto head = header().completion_head;
+        EXPECT_NE(head, AK::atomic_load(&header().completion_tail, AK::memory_order_acquire));
+        auto completion = this->completion(head);
+        AK::atomic_store(&header().completion_head, head + 1, AK::memory_order_release);
+        return completion;
+    }
+};
+
+static Ring create_ring(u32 entries)
+{
+    Ring ring;
+    ring.entries = entries;
+    ring.fd = io_ring_create(entries, IO_RING_CLOEXEC);
+    EXPECT(ring.fd >= 0);
+    auto* base = mmap(nullptr, io_ring_size(entries), PROT_READ | PROT_WRITE, MAP_SHARED, ring.fd, 0);
+    EXPECT_NE(base, MAP_FAILED);
+    ring.base = static_cast<u8*>(base);
+    return ring;
+}
+
+static void destroy_ring(Ring& ring)
+{
+    munmap(ring.base, io_ring_size(ring.entries));
+    close(ring.fd);
+}
+
+TEST_CASE(io_ring_create_invalid_entries)
+{
+    EXPECT_EQ(io_ring_create(0, 0), -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(io_ring_create(3, 0), -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(io_ring_create(IO_RING_MAX_ENTRIES * 2, 0), -1);
+    EXPECT_EQ(errno, EINVAL);
+}
+
+TEST_CASE(io_ring_write_then_read_pipe)
+{
+    auto ring = create_ring(8);
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+
+    char const message[] = "Hello, ring!";
+    IORingSubmission write_submission {};
+    write_submission.opcode = IORingOpcode::Write;
+    write_submission.fd = pipe_fds[1];
+    write_submission.offset = -1;
+    write_submission.address = reinterpret_cast<FlatPtr>(message);
+    write_submission.length = sizeof(message);
+    write_submission.user_data = 1;
+    ring.submit(write_submission);
+    EXPECT_EQ(io_ring_enter(ring.fd, 1, 1), 1);
+
+    auto write_completion = ring.reap();
+    EXPECT_EQ(write_completion.user_data, 1u);
+    EXPECT_EQ(write_completion.result, static_cast<i64>(sizeof(message)));
+
+    char buffer[sizeof(message)] {};
+    IORingSubmission read_submission {};
+    read_submission.opcode = IORingOpcode::Read;
+    read_submission.fd = pipe_fds[0];
+    read_submission.offset = -1;
+    read_submission.address = reinterpret_cast<FlatPtr>(buffer);
+    read_submission.length = sizeof(buffer);
+    read_submission.user_data = 2;
+    ring.submit(read_submission);
+    EXPECT_EQ(io_ring_enter(ring.fd, 1, 1), 1);
+
+    auto read_completion = ring.reap();
+    EXPECT_EQ(read_completion.user_data, 2u);
+    EXPECT_EQ(read_completion.result, static_cast<i64>(sizeof(message)));
+    EXPECT_EQ(memcmp(buffer, message, sizeof(message)), 0);
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    destroy_ring(ring);
+}
+
+TEST_CASE(io_ring_reports_errors_in_completion)
+{
+    auto ring = create_ring(4);
+
+    IORingSubmission submission {};
+    submission.opcode = IORingOpcode::Fsync;
+    submission.fd = -1;
+    submission.user_data = 42;
+    ring.submit(submission);
+    EXPECT_EQ(io_ring_enter(ring.fd, 1, 1), 1);
+
+    auto completion = ring.reap();
+    EXPECT_EQ(completion.user_data, 42u);
+    EXPECT_EQ(completion.result, static_cast<i64>(-EBADF));
+
+    destroy_ring(ring);
+}
+
+TEST_CASE(io_ring_idle_reads_dont_hold_up_other_requests)
+{
+    // More reads than the ring has workers, none of which can complete before we write to their pipes.
+    constexpr size_t idle_read_count = 8;
+    auto ring = create_ring(16);
+    int idle_pipes[idle_read_count][2];
+    char buffers[idle_read_count][4] {};
+    for (size_t i = 0; i < idle_read_count; ++i) {
+        EXPECT_EQ(pipe(idle_pipes[i]), 0);
+        IORingSubmission read_submission {};
+        read_submission.opcode = IORingOpcode::Read;
+        read_submission.fd = idle_pipes[i][0];
+        read_submission.offset = -1;
+        read_submission.address = reinterpret_cast<FlatPtr>(buffers[i]);
+        read_submission.length = sizeof(buffers[i]);
+        read_submission.user_data = i;
+        ring.submit(read_submission);
+    }
+
+    int pipe_fds[2];
+    EXPECT_EQ(pipe(pipe_fds), 0);
+    char const message[] = "busy";
+    IORingSubmission write_submission {};
+    write_submission.opcode = IORingOpcode::Write;
+    write_submission.fd = pipe_fds[1];
+    write_submission.offset = -1;
+    write_submission.address = reinterpret_cast<FlatPtr>(message);
+    write_submission.length = sizeof(message);
+    write_submission.user_data = 100;
+    ring.submit(write_submission);
+
+    EXPECT_EQ(io_ring_enter(ring.fd, idle_read_count + 1, 1), static_cast<int>(idle_read_count + 1));
+    auto write_completion = ring.reap();
+    EXPECT_EQ(write_completion.user_data, 100u);
+    EXPECT_EQ(write_completion.result, static_cast<i64>(sizeof(message)));
+
+    // Now the reads can go ahead.
+    for (size_t i = 0; i < idle_read_count; ++i)
+        EXPECT_EQ(write(idle_pipes[i][1], "abc", 4), 4);
+    size_t completed = 0;
+    while (completed < idle_read_count) {
+        EXPECT(io_ring_enter(ring.fd, 0, 1) >= 0);
+        while (ring.header().completion_head != AK::atomic_load(&ring.header().completion_tail, AK::memory_order_acquire)) {
+            auto completion = ring.reap();
+            EXPECT(completion.user_data < idle_read_count);
+            EXPECT_EQ(completion.result, 4);
+            EXPECT_EQ(memcmp(buffers[completion.user_data], "abc", 4), 0);
+            ++completed;
+        }
+    }
+
+    for (size_t i = 0; i < idle_read_count; ++i) {
+        close(idle_pipes[i][0]);
+        close(idle_pipes[i][1]);
+    }
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    destroy_ring(ring);
+}
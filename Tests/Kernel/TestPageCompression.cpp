@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
+#include <LibCore/File.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <serenity.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static constexpr size_t page_count = 64;
+
+static u8 expected_byte(size_t page, size_t offset)
+{
+    // Repetitive enough to compress, but different from page to page.
+    return static_cast<u8>(page + offset / 64);
+}
+
+static bool contents_are_intact(u8 const* data)
+{
+    for (size_t page = 0; page < page_count; ++page) {
+        for (size_t offset = 0; offset < PAGE_SIZE; ++offset) {
+            if (data[page * PAGE_SIZE + offset] != expected_byte(page, offset))
+                return false;
+        }
+    }
+    return true;
+}
+
+static u64 compressed_page_count()
+{
+    auto file = Core::File::construct("/sys/kernel/memstat");
+    VERIFY(file->open(Core::OpenMode::ReadOnly));
+    auto json = JsonValue::from_string(file->read_all()).release_value_but_fixme_should_propagate_errors();
+    return json.as_object().get("compressed_pages"sv).to_u64();
+}
+
+static u8* map_and_fill_pages()
+{
+    auto* data = static_cast<u8*>(mmap(nullptr, page_count * PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    VERIFY(data != MAP_FAILED);
+    for (size_t page = 0; page < page_count; ++page) {
+        for (size_t offset = 0; offset < PAGE_SIZE; ++offset)
+            data[page * PAGE_SIZE + offset] = expected_byte(page, offset);
+    }
+    return data;
+}
+
+static bool compress_cold_pages()
+{
+    // The first pass clears the accessed bits, the second one compresses what wasn't touched in between.
+    if (purge(PURGE_COMPRESS_COLD_ANONYMOUS) < 0) {
+        VERIFY(errno == EPERM);
+        warnln("Skipping test, purge() needs superuser privileges");
+        return false;
+    }
+    EXPECT(purge(PURGE_COMPRESS_COLD_ANONYMOUS) >= 0);
+    return true;
+}
+
+TEST_CASE(compressed_pages_are_faulted_back_in)
+{
+    auto* data = map_and_fill_pages();
+    if (!compress_cold_pages())
+        return;
+    EXPECT(compressed_page_count() >= page_count);
+
+    EXPECT(contents_are_intact(data));
+
+    data[0] = 0xff;
+    EXPECT_EQ(data[0], 0xff);
+    data[0] = expected_byte(0, 0);
+    EXPECT(contents_are_intact(data));
+
+    EXPECT_EQ(munmap(data, page_count * PAGE_SIZE), 0);
+}
+
+TEST_CASE(compressed_pages_are_copied_on_fork)
+{
+    auto* data = map_and_fill_pages();
+    if (!compress_cold_pages())
+        return;
+
+    pid_t pid = fork();
+    EXPECT(pid >= 0);
+    if (pid == 0) {
+        if (!contents_are_intact(data))
+            _exit(1);
+        for (size_t page = 0; page < page_count; ++page)
+            data[page * PAGE_SIZE] = 0xff;
+        _exit(0);
+    }
+
+    int status = 0;
+    EXPECT_EQ(waitpid(pid, &status, 0), pid);
+    EXPECT(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+    EXPECT(contents_are_intact(data));
+
+    EXPECT_EQ(munmap(data, page_count * PAGE_SIZE), 0);
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <LibTest/TestCase.h>
+#include <pthread.h>
+
+static constexpr size_t thread_count = 4;
+static constexpr size_t iterations_per_thread = 200'000;
+
+template<typename Callback>
+static void run_on_threads(Callback callback)
+{
+    Array<pthread_t, thread_count> threads;
+    for (auto& thread : threads) {
+        auto rc = pthread_create(
+            &thread, nullptr, [](void* data) -> void* {
+                (*static_cast<Callback*>(data))();
+                return nullptr;
+            },
+            &callback);
+        EXPECT_EQ(rc, 0);
+    }
+    for (auto& thread : threads)
+        pthread_join(thread, nullptr);
+}
+
+// Short critical sections, which is where spinning before going to sleep pays off.
+BENCHMARK_CASE(contended_mutex)
+{
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    size_t counter = 0;
+    run_on_threads([&] {
+        for (size_t i = 0; i < iterations_per_thread; ++i) {
+            pthread_mutex_lock(&mutex);
+            ++counter;
+            pthread_mutex_unlock(&mutex);
+        }
+    });
+    EXPECT_EQ(counter, thread_count * iterations_per_thread);
+}
+
+BENCHMARK_CASE(contended_rwlock_mostly_reads)
+{
+    pthread_rwlock_t lock = PTHREAD_RWLOCK_INITIALIZER;
+    size_t counter = 0;
+    run_on_threads([&] {
+        size_t observed = 0;
+        for (size_t i = 0; i < iterations_per_thread; ++i) {
+            if (i % 64 == 0) {
+                pthread_rwlock_wrlock(&lock);
+                ++counter;
+                pthread_rwlock_unlock(&lock);
+            } else {
+                pthread_rwlock_rdlock(&lock);
+                observed += counter;
+                pthread_rwlock_unlock(&lock);
+            }
+        }
+        (void)observed;
+    });
+    EXPECT_EQ(counter, thread_count * ((iterations_per_thread + 63) / 64));
+}
+
+BENCHMARK_CASE(contended_rwlock_writes)
+{
+    pthread_rwlock_t lock = PTHREAD_RWLOCK_INITIALIZER;
+    size_t counter = 0;
+    run_on_threads([&] {
+        for (size_t i = 0; i < iterations_per_thread; ++i) {
+            pthread_rwlock_wrlock(&lock);
+            ++counter;
+            pthread_rwlock_unlock(&lock);
+        }
+    });
+    EXPECT_EQ(counter, thread_count * iterations_per_thread);
+}
@@ -8,7 +8,9 @@
 
 #include <LibC/mallocdefs.h>
 #include <errno.h>
+#include <pthread.h>
 #include <stdlib.h>
+#include <string.h>
 
 TEST_CASE(malloc_limits)
 {
@@ -38,3 +40,36 @@ TEST_CASE(malloc_limits)
         return Test::Crash::Failure::DidNotCrash;
     });
 }
+
+TEST_CASE(malloc_free_across_threads)
+{
+    // Chunks allocated by one thread and freed by another have to end up back where they came from,
+    // no matter which thread cache they pass through on the way.
+    static constexpr size_t allocation_count = 1000;
+    static void* allocations[allocation_count];
+
+    for (size_t i = 0; i < allocation_count; ++i) {
+        allocations[i] = malloc(16 + (i % 64) * 16);
+        EXPECT_NE(allocations[i], nullptr);
+        memset(allocations[i], 0xaa, 16);
+    }
+
+    pthread_t thread;
+    EXPECT_EQ(pthread_create(
+                  &thread, nullptr, [](void*) -> void* {
+                      for (size_t i = 0; i < allocation_count; ++i)
+                          free(allocations[i]);
+                      // Leave some chunks in this thread's cache when it exits.
+                      for (size_t i = 0; i < allocation_count / 2; ++i)
+                          allocations[i] = malloc(32);
+                      return nullptr;
+                  },
+                  nullptr),
+        0);
+    EXPECT_EQ(pthread_join(thread, nullptr), 0);
+
+    for (size_t i = 0; i < allocation_count / 2; ++i) {
+        EXPECT_NE(allocations[i], nullptr);
+        free(allocations[i]);
+    }
+}
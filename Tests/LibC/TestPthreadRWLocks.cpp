@@ -5,7 +5,10 @@
  */
 
 #include <LibTest/TestCase.h>
+#include <errno.h>
 #include <pthread.h>
+#include <time.h>
+#include <unistd.h>
 
 TEST_CASE(rwlock_init)
 {
@@ -88,3 +91,119 @@ TEST_CASE(rwlock_wrlock_init_in_once)
     result = pthread_rwlock_unlock(&lock);
     EXPECT_EQ(0, result);
 }
+
+TEST_CASE(rwlock_try_while_locked)
+{
+    pthread_rwlock_t lock = PTHREAD_RWLOCK_INITIALIZER;
+
+    EXPECT_EQ(0, pthread_rwlock_tryrdlock(&lock));
+    EXPECT_EQ(EBUSY, pthread_rwlock_trywrlock(&lock));
+    EXPECT_EQ(0, pthread_rwlock_tryrdlock(&lock));
+    EXPECT_EQ(0, pthread_rwlock_unlock(&lock));
+    EXPECT_EQ(0, pthread_rwlock_unlock(&lock));
+
+    EXPECT_EQ(0, pthread_rwlock_trywrlock(&lock));
+    EXPECT_EQ(EBUSY, pthread_rwlock_tryrdlock(&lock));
+    EXPECT_EQ(EBUSY, pthread_rwlock_trywrlock(&lock));
+    EXPECT_EQ(0, pthread_rwlock_unlock(&lock));
+
+    EXPECT_EQ(EINVAL, pthread_rwlock_unlock(&lock));
+}
+
+TEST_CASE(rwlock_timedwrlock_times_out)
+{
+    pthread_rwlock_t lock = PTHREAD_RWLOCK_INITIALIZER;
+    EXPECT_EQ(0, pthread_rwlock_rdlock(&lock));
+
+    timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += 10'000'000;
+    if (deadline.tv_nsec >= 1'000'000'000) {
+        deadline.tv_nsec -= 1'000'000'000;
+        ++deadline.tv_sec;
+    }
+    EXPECT_EQ(ETIMEDOUT, pthread_rwlock_timedwrlock(&lock, &deadline));
+
+    // The writer that gave up must not keep readers out.
+    EXPECT_EQ(0, pthread_rwlock_unlock(&lock));
+    EXPECT_EQ(0, pthread_rwlock_tryrdlock(&lock));
+    EXPECT_EQ(0, pthread_rwlock_unlock(&lock));
+}
+
+TEST_CASE(rwlock_contended_writers)
+{
+    static pthread_rwlock_t lock = PTHREAD_RWLOCK_INITIALIZER;
+    static int counter = 0;
+    static constexpr int iterations = 10'000;
+
+    pthread_t threads[4];
+    for (auto& thread : threads) {
+        auto result = pthread_create(
+            &thread, nullptr, [](void*) -> void* {
+                for (int i = 0; i < iterations; ++i) {
+                    if (i % 2) {
+                        pthread_rwlock_wrlock(&lock);
+                        ++counter;
+                    } else {
+                        pthread_rwlock_rdlock(&lock);
+                    }
+                    pthread_rwlock_unlock(&lock);
+                }
+                return nullptr;
+            },
+            nullptr);
+        EXPECT_EQ(0, result);
+    }
+    for (auto& thread : threads)
+        pthread_join(thread, nullptr);
+
+    EXPECT_EQ(counter, 4 * iterations / 2);
+}
+
+TEST_CASE(rwlock_readers_behind_alternating_writers)
+{
+    static pthread_rwlock_t lock = PTHREAD_RWLOCK_INITIALIZER;
+    static int counter = 0;
+    static constexpr int iterations = 10'000;
+
+    // Hold the lock for writing until the readers are asleep behind it.
+    EXPECT_EQ(0, pthread_rwlock_wrlock(&lock));
+
+    pthread_t readers[4];
+    for (auto& reader : readers) {
+        auto result = pthread_create(
+            &reader, nullptr, [](void*) -> void* {
+                pthread_rwlock_rdlock(&lock);
+                pthread_rwlock_unlock(&lock);
+                return nullptr;
+            },
+            nullptr);
+        EXPECT_EQ(0, result);
+    }
+
+    // The writers hand the lock back and forth between them, and have to let the readers in eventually.
+    pthread_t writers[2];
+    for (auto& writer : writers) {
+        auto result = pthread_create(
+            &writer, nullptr, [](void*) -> void* {
+                for (int i = 0; i < iterations; ++i) {
+                    pthread_rwlock_wrlock(&lock);
+                    ++counter;
+                    pthread_rwlock_unlock(&lock);
+                }
+                return nullptr;
+            },
+            nullptr);
+        EXPECT_EQ(0, result);
+    }
+
+    usleep(10'000);
+    EXPECT_EQ(0, pthread_rwlock_unlock(&lock));
+
+    for (auto& writer : writers)
+        pthread_join(writer, nullptr);
+    for (auto& reader : readers)
+        pthread_join(reader, nullptr);
+
+    EXPECT_EQ(counter, 2 * iterations);
+}
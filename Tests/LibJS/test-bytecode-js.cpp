@@ -5,8 +5,10 @@
  */
 
 #include <LibJS/AST.h>
+#include <LibJS/Bytecode/ExecutableCache.h>
 #include <LibJS/Bytecode/Generator.h>
 #include <LibJS/Bytecode/Interpreter.h>
+#include <LibJS/Bytecode/JIT/Compiler.h>
 #include <LibJS/Interpreter.h>
 #include <LibJS/Runtime/VM.h>
 #include <LibJS/Script.h>
@@ -139,3 +141,105 @@ TEST_CASE(catch_exception)
                             "if (hitCatch !== true) throw new Exception('failed');\n"
                             "if (hitFinally !== true) throw new Exception('failed');");
 }
+
+TEST_CASE(cached_executable)
+{
+    SETUP_AND_PARSE("var sum = 0n;\n"
+                    "var object = { foo: 'foo' };\n"
+                    "for (var i = 0; i < 10; ++i) {\n"
+                    "    try {\n"
+                    "        if (i % 2) throw new Error(object.foo);\n"
+                    "        sum += 12345678901234567890n;\n"
+                    "    } catch (e) {\n"
+                    "        if (e.message !== 'foo') throw new Exception('failed');\n"
+                    "    } finally {\n"
+                    "        object.bar = i;\n"
+                    "    }\n"
+                    "}\n"
+                    "if (sum !== 61728394506172839450n) throw new Exception('failed');\n"
+                    "if (object.bar !== 9) throw new Exception('failed');");
+
+    auto generated_executable = MUST(JS::Bytecode::Generator::generate(program));
+    auto bytes = MUST(JS::Bytecode::ExecutableCache::serialize(*generated_executable));
+    auto executable = MUST(JS::Bytecode::ExecutableCache::deserialize(bytes));
+    EXPECT_EQ(executable->basic_blocks.size(), generated_executable->basic_blocks.size());
+
+    auto result = bytecode_interpreter.run(*executable);
+    EXPECT(!result.is_error());
+    EXPECT_NO_EXCEPTION_WITH_OPTIMIZATIONS(executable);
+}
+
+TEST_CASE(cached_executable_with_functions_and_classes)
+{
+    SETUP_AND_PARSE("function add(a, b) { return a + b; }\n"
+                    "async function* generator() { yield 1; }\n"
+                    "var double = x => x * 2;\n"
+                    "var object = { triple(x) { return x * 3; }, get four() { return 4; } };\n"
+                    "class Base { constructor(x) { this.x = x; } }\n"
+                    "var Derived = class extends Base { get doubled() { return double(this.x); } };\n"
+                    "var values = [1, 2, 3].map(function (value) { return add(value, 1); });\n"
+                    "if (values.join() !== '2,3,4') throw new Exception('failed');\n"
+                    "if (object.triple(double(1)) !== 6 || object.four !== 4) throw new Exception('failed');\n"
+                    "if (new Derived(21).doubled !== 42) throw new Exception('failed');\n"
+                    "if (add.toString() !== 'function add(a, b) { return a + b; }') throw new Exception('failed');\n"
+                    "if (typeof generator !== 'function' || !(new Derived(1) instanceof Base)) throw new Exception('failed');");
+
+    auto generated_executable = MUST(JS::Bytecode::Generator::generate(program));
+    auto bytes = MUST(JS::Bytecode::ExecutableCache::serialize(*generated_executable));
+    auto executable = MUST(JS::Bytecode::ExecutableCache::deserialize(bytes));
+    EXPECT(!executable->ast_nodes.is_empty());
+
+    auto result = bytecode_interpreter.run(*executable);
+    EXPECT(!result.is_error());
+    if (result.is_error())
+        dbgln("Error: {}", MUST(result.throw_completion().value()->to_string(vm)));
+}
+
+TEST_CASE(cached_strict_mode_function)
+{
+    SETUP_AND_PARSE("'use strict';\n"
+                    "var f = function () { return this; };\n"
+                    "if (f() !== undefined) throw new Exception('failed');");
+
+    auto generated_executable = MUST(JS::Bytecode::Generator::generate(program));
+    auto bytes = MUST(JS::Bytecode::ExecutableCache::serialize(*generated_executable));
+    auto executable = MUST(JS::Bytecode::ExecutableCache::deserialize(bytes));
+
+    auto result = bytecode_interpreter.run(*executable);
+    EXPECT(!result.is_error());
+}
+
+TEST_CASE(damaged_cached_executable)
+{
+    SETUP_AND_PARSE("var a = 1;");
+
+    auto executable = MUST(JS::Bytecode::Generator::generate(program));
+    auto bytes = MUST(JS::Bytecode::ExecutableCache::serialize(*executable));
+
+    EXPECT(JS::Bytecode::ExecutableCache::deserialize(bytes.bytes().trim(bytes.size() - 1)).is_error());
+
+    // The layout fingerprint follows the magic and the format version.
+    bytes[8] ^= 1;
+    EXPECT(JS::Bytecode::ExecutableCache::deserialize(bytes).is_error());
+}
+
+TEST_CASE(hot_executable_is_compiled_to_native_code)
+{
+    if (!JS::Bytecode::JIT::Compiler::is_supported() || !JS::Bytecode::JIT::g_jit_enabled)
+        return;
+
+    // Every iteration enters a few basic blocks, so this gets well past the tier-up threshold.
+    SETUP_AND_PARSE("var sum = 0;\n"
+                    "for (var i = 0; i < 5000; ++i) sum += i;\n"
+                    "if (sum !== 12497500) throw new Exception('failed');");
+
+    auto executable = MUST(JS::Bytecode::Generator::generate(program));
+    EXPECT(!executable->native_executable);
+    auto result = bytecode_interpreter.run(*executable);
+    EXPECT(!result.is_error());
+    EXPECT(executable->native_executable);
+
+    // The second time around, the executable runs in native code from the start.
+    auto second_result = bytecode_interpreter.run(*executable);
+    EXPECT(!second_result.is_error());
+}
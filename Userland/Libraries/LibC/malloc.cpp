@@ -51,6 +51,15 @@ constexpr size_t number_of_hot_chunked_blocks_to_keep_around = 16;
 constexpr size_t number_of_cold_chunked_blocks_to_keep_around = 16;
 constexpr size_t number_of_big_blocks_to_keep_around_per_size_class = 8;
 
+// Each thread keeps a cache of free chunks for the smaller size classes, so that most calls to
+// malloc() and free() don't have to take s_malloc_mutex at all. As far as their ChunkedBlock is
+// concerned, cached chunks are still in use. Empty caches are refilled, and full caches flushed,
+// a batch of chunks at a time, so the mutex is only taken once per batch.
+constexpr size_t number_of_thread_cached_size_classes = 7;
+constexpr size_t number_of_chunks_per_thread_cache = 32;
+constexpr size_t number_of_chunks_per_thread_cache_batch = number_of_chunks_per_thread_cache / 2;
+static_assert(size_classes[number_of_thread_cached_size_classes - 1] == 1008);
+
 static bool s_log_malloc = false;
 static bool s_scrub_malloc = true;
 static bool s_scrub_free = true;
@@ -95,8 +104,6 @@ struct MemoryAuditingSuppressor {
 };
 
 struct MallocStats {
-    size_t number_of_malloc_calls;
-
     size_t number_of_big_allocator_hits;
     size_t number_of_big_allocator_purge_hits;
     size_t number_of_big_allocs;
@@ -107,8 +114,6 @@ struct MallocStats {
     size_t number_of_block_allocs;
     size_t number_of_blocks_full;
 
-    size_t number_of_free_calls;
-
     size_t number_of_big_allocator_keeps;
     size_t number_of_big_allocator_frees;
 
@@ -119,6 +124,30 @@ struct MallocStats {
 };
 static MallocStats g_malloc_stats = {};
 
+// These are counted by each thread, and added to g_exited_threads_malloc_stats when it exits.
+struct ThreadMallocStats {
+    size_t number_of_malloc_calls;
+    size_t number_of_free_calls;
+
+    size_t number_of_thread_cache_hits;
+    size_t number_of_thread_cache_refills;
+    size_t number_of_thread_cache_keeps;
+    size_t number_of_thread_cache_flushes;
+};
+static ThreadMallocStats g_exited_threads_malloc_stats = {};
+
+struct ThreadCache {
+    size_t count;
+    void* chunks[number_of_chunks_per_thread_cache];
+};
+
+#ifndef NO_TLS
+static __thread ThreadMallocStats t_malloc_stats;
+static __thread ThreadCache t_thread_caches[number_of_thread_cached_size_classes];
+#else
+static ThreadMallocStats t_malloc_stats;
+#endif
+
 static size_t s_hot_empty_block_count { 0 };
 static ChunkedBlock* s_hot_empty_blocks[number_of_hot_chunked_blocks_to_keep_around] { nullptr };
 static size_t s_cold_empty_block_count { 0 };
@@ -285,6 +314,157 @@ static void* try_allocate_chunk_aligned(size_t align, ChunkedBlock& block)
     return nullptr;
 }
 
+// NOTE: The caller must hold s_malloc_mutex.
+static ErrorOr<void*> allocate_chunk(Allocator& allocator, size_t good_size, size_t align)
+{
+    ChunkedBlock* block = nullptr;
+    void* ptr = nullptr;
+    for (auto& current : allocator.usable_blocks) {
+        if (current.free_chunks()) {
+            ptr = try_allocate_chunk_aligned(align, current);
+            if (ptr) {
+                block = &current;
+                break;
+            }
+        }
+    }
+
+    if (!block && s_hot_empty_block_count) {
+        g_malloc_stats.number_of_hot_empty_block_hits++;
+        block = s_hot_empty_blocks[--s_hot_empty_block_count];
+        if (block->m_size != good_size) {
+            new (block) ChunkedBlock(good_size);
+            ue_notify_chunk_size_changed(block, good_size);
+            char buffer[64];
+            snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
+            set_mmap_name(block, ChunkedBlock::block_size, buffer);
+        }
+        allocator.usable_blocks.append(*block);
+    }
+
+    if (!block && s_cold_empty_block_count) {
+        g_malloc_stats.number_of_cold_empty_block_hits++;
+        block = s_cold_empty_blocks[--s_cold_empty_block_count];
+        int rc = madvise(block, ChunkedBlock::block_size, MADV_SET_NONVOLATILE);
+        bool this_block_was_purged = rc == 1;
+        if (rc < 0) {
+            perror("madvise");
+            VERIFY_NOT_REACHED();
+        }
+        rc = mprotect(block, ChunkedBlock::block_size, PROT_READ | PROT_WRITE);
+        if (rc < 0) {
+            perror("mprotect");
+            VERIFY_NOT_REACHED();
+        }
+        if (this_block_was_purged || block->m_size != good_size) {
+            if (this_block_was_purged)
+                g_malloc_stats.number_of_cold_empty_block_purge_hits++;
+            new (block) ChunkedBlock(good_size);
+            ue_notify_chunk_size_changed(block, good_size);
+        }
+        allocator.usable_blocks.append(*block);
+    }
+
+    if (!block) {
+        g_malloc_stats.number_of_block_allocs++;
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
+        block = (ChunkedBlock*)TRY(os_alloc(ChunkedBlock::block_size, buffer));
+        new (block) ChunkedBlock(good_size);
+        allocator.usable_blocks.append(*block);
+        ++allocator.block_count;
+    }
+
+    if (!ptr) {
+        ptr = try_allocate_chunk_aligned(align, *block);
+    }
+
+    VERIFY(ptr);
+    if (block->is_full()) {
+        g_malloc_stats.number_of_blocks_full++;
+        dbgln_if(MALLOC_DEBUG, "Block {:p} is now full in size class {}", block, good_size);
+        allocator.usable_blocks.remove(*block);
+        allocator.full_blocks.append(*block);
+    }
+    dbgln_if(MALLOC_DEBUG, "LibC: allocated {:p} (chunk in block {:p}, size {})", ptr, block, block->bytes_per_chunk());
+    return ptr;
+}
+
+// NOTE: The caller must hold s_malloc_mutex.
+static void free_chunk(ChunkedBlock& block, void* ptr)
+{
+    auto* entry = (FreelistEntry*)ptr;
+    entry->next = block.m_freelist;
+    block.m_freelist = entry;
+
+    if (block.is_full()) {
+        size_t good_size;
+        auto* allocator = allocator_for_size(block.m_size, good_size);
+        dbgln_if(MALLOC_DEBUG, "Block {:p} no longer full in size class {}", &block, good_size);
+        g_malloc_stats.number_of_freed_full_blocks++;
+        allocator->full_blocks.remove(block);
+        allocator->usable_blocks.prepend(block);
+    }
+
+    ++block.m_free_chunks;
+
+    if (!block.used_chunks()) {
+        size_t good_size;
+        auto* allocator = allocator_for_size(block.m_size, good_size);
+        if (s_hot_empty_block_count < number_of_hot_chunked_blocks_to_keep_around) {
+            dbgln_if(MALLOC_DEBUG, "Keeping hot block {:p} around", &block);
+            g_malloc_stats.number_of_hot_keeps++;
+            allocator->usable_blocks.remove(block);
+            s_hot_empty_blocks[s_hot_empty_block_count++] = &block;
+            return;
+        }
+        if (s_cold_empty_block_count < number_of_cold_chunked_blocks_to_keep_around) {
+            dbgln_if(MALLOC_DEBUG, "Keeping cold block {:p} around", &block);
+            g_malloc_stats.number_of_cold_keeps++;
+            allocator->usable_blocks.remove(block);
+            s_cold_empty_blocks[s_cold_empty_block_count++] = &block;
+            mprotect(&block, ChunkedBlock::block_size, PROT_NONE);
+            madvise(&block, ChunkedBlock::block_size, MADV_SET_VOLATILE);
+            return;
+        }
+        dbgln_if(MALLOC_DEBUG, "Releasing block {:p} for size class {}", &block, good_size);
+        g_malloc_stats.number_of_frees++;
+        allocator->usable_blocks.remove(block);
+        --allocator->block_count;
+        os_free(&block, ChunkedBlock::block_size);
+    }
+}
+
+#ifndef NO_TLS
+// NOTE: The caller must hold s_malloc_mutex.
+static ErrorOr<void> refill_thread_cache(ThreadCache& cache, Allocator& allocator, size_t good_size)
+{
+    t_malloc_stats.number_of_thread_cache_refills++;
+    auto* first_chunk = TRY(allocate_chunk(allocator, good_size, 16));
+    cache.chunks[cache.count++] = first_chunk;
+    while (cache.count < number_of_chunks_per_thread_cache_batch) {
+        auto ptr_or_error = allocate_chunk(allocator, good_size, 16);
+        if (ptr_or_error.is_error())
+            break;
+        cache.chunks[cache.count++] = ptr_or_error.value();
+    }
+    return {};
+}
+
+// NOTE: The caller must hold s_malloc_mutex.
+static void flush_thread_cache(ThreadCache& cache, size_t count)
+{
+    t_malloc_stats.number_of_thread_cache_flushes++;
+    // Give back the chunks that have been in the cache the longest, as they're the least likely to still be in the CPU cache.
+    for (size_t i = 0; i < count; ++i) {
+        auto* ptr = cache.chunks[i];
+        free_chunk(*(ChunkedBlock*)((FlatPtr)ptr & ChunkedBlock::block_mask), ptr);
+    }
+    cache.count -= count;
+    memmove(cache.chunks, cache.chunks + count, cache.count * sizeof(void*));
+}
+#endif
+
 enum class CallerWillInitializeMemory {
     No,
     Yes,
@@ -317,11 +497,31 @@ static ErrorOr<void*> malloc_impl(size_t size, size_t align, CallerWillInitializ
         size = 1;
     }
 
-    g_malloc_stats.number_of_malloc_calls++;
+    t_malloc_stats.number_of_malloc_calls++;
 
     size_t good_size;
     auto* allocator = allocator_for_size(size, good_size, align);
 
+#ifndef NO_TLS
+    // NOTE: Chunks are always 16-byte aligned, anything beyond that has to look for a suitable chunk.
+    if (allocator && align <= 16 && allocator < &allocators()[number_of_thread_cached_size_classes]) {
+        auto& cache = t_thread_caches[allocator - allocators()];
+        if (cache.count == 0) {
+            PthreadMutexLocker locker(s_malloc_mutex);
+            TRY(refill_thread_cache(cache, *allocator, good_size));
+        } else {
+            t_malloc_stats.number_of_thread_cache_hits++;
+        }
+        auto* ptr = cache.chunks[--cache.count];
+
+        if (s_scrub_malloc && caller_will_initialize_memory == CallerWillInitializeMemory::No)
+            memset(ptr, MALLOC_SCRUB_BYTE, good_size);
+
+        ue_notify_malloc(ptr, size);
+        return ptr;
+    }
+#endif
+
     PthreadMutexLocker locker(s_malloc_mutex);
 
     if (!allocator) {
@@ -366,79 +566,10 @@ static ErrorOr<void*> malloc_impl(size_t size, size_t align, CallerWillInitializ
         return ptr;
     }
 
-    ChunkedBlock* block = nullptr;
-    void* ptr = nullptr;
-    for (auto& current : allocator->usable_blocks) {
-        if (current.free_chunks()) {
-            ptr = try_allocate_chunk_aligned(align, current);
-            if (ptr) {
-                block = &current;
-                break;
-            }
-        }
-    }
-
-    if (!block && s_hot_empty_block_count) {
-        g_malloc_stats.number_of_hot_empty_block_hits++;
-        block = s_hot_empty_blocks[--s_hot_empty_block_count];
-        if (block->m_size != good_size) {
-            new (block) ChunkedBlock(good_size);
-            ue_notify_chunk_size_changed(block, good_size);
-            char buffer[64];
-            snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
-            set_mmap_name(block, ChunkedBlock::block_size, buffer);
-        }
-        allocator->usable_blocks.append(*block);
-    }
-
-    if (!block && s_cold_empty_block_count) {
-        g_malloc_stats.number_of_cold_empty_block_hits++;
-        block = s_cold_empty_blocks[--s_cold_empty_block_count];
-        int rc = madvise(block, ChunkedBlock::block_size, MADV_SET_NONVOLATILE);
-        bool this_block_was_purged = rc == 1;
-        if (rc < 0) {
-            perror("madvise");
-            VERIFY_NOT_REACHED();
-        }
-        rc = mprotect(block, ChunkedBlock::block_size, PROT_READ | PROT_WRITE);
-        if (rc < 0) {
-            perror("mprotect");
-            VERIFY_NOT_REACHED();
-        }
-        if (this_block_was_purged || block->m_size != good_size) {
-            if (this_block_was_purged)
-                g_malloc_stats.number_of_cold_empty_block_purge_hits++;
-            new (block) ChunkedBlock(good_size);
-            ue_notify_chunk_size_changed(block, good_size);
-        }
-        allocator->usable_blocks.append(*block);
-    }
-
-    if (!block) {
-        g_malloc_stats.number_of_block_allocs++;
-        char buffer[64];
-        snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
-        block = (ChunkedBlock*)TRY(os_alloc(ChunkedBlock::block_size, buffer));
-        new (block) ChunkedBlock(good_size);
-        allocator->usable_blocks.append(*block);
-        ++allocator->block_count;
-    }
-
-    if (!ptr) {
-        ptr = try_allocate_chunk_aligned(align, *block);
-    }
-
-    VERIFY(ptr);
-    if (block->is_full()) {
-        g_malloc_stats.number_of_blocks_full++;
-        dbgln_if(MALLOC_DEBUG, "Block {:p} is now full in size class {}", block, good_size);
-        allocator->usable_blocks.remove(*block);
-        allocator->full_blocks.append(*block);
-    }
-    dbgln_if(MALLOC_DEBUG, "LibC: allocated {:p} (chunk in block {:p}, size {})", ptr, block, block->bytes_per_chunk());
+    auto* ptr = TRY(allocate_chunk(*allocator, good_size, align));
 
     if (s_scrub_malloc && caller_will_initialize_memory == CallerWillInitializeMemory::No)
-        memset(ptr, MALLOC_SCRUB_BYTE, block->m_size);
+        memset(ptr, MALLOC_SCRUB_BYTE, good_size);
 
     ue_notify_malloc(ptr, size);
     return ptr;
@@ -455,14 +586,13 @@ static void free_impl(void* ptr)
     if (!ptr)
         return;
 
-    g_malloc_stats.number_of_free_calls++;
+    t_malloc_stats.number_of_free_calls++;
 
     void* block_base = (void*)((FlatPtr)ptr & ChunkedBlock::ChunkedBlock::block_mask);
     size_t magic = *(size_t*)block_base;
 
-    PthreadMutexLocker locker(s_malloc_mutex);
-
     if (magic == MAGIC_BIGALLOC_HEADER) {
+        PthreadMutexLocker locker(s_malloc_mutex);
         auto* block = (BigAllocationBlock*)block_base;
 #ifdef RECYCLE_BIG_ALLOCATIONS
         if (auto* allocator = big_allocator_for_size(block->m_size)) {
@@ -495,46 +625,23 @@ static void free_impl(void* ptr)
     if (s_scrub_free)
         memset(ptr, FREE_SCRUB_BYTE, block->bytes_per_chunk());
 
-    auto* entry = (FreelistEntry*)ptr;
-    entry->next = block->m_freelist;
-    block->m_freelist = entry;
-
-    if (block->is_full()) {
-        size_t good_size;
-        auto* allocator = allocator_for_size(block->m_size, good_size);
-        dbgln_if(MALLOC_DEBUG, "Block {:p} no longer full in size class {}", block, good_size);
-        g_malloc_stats.number_of_freed_full_blocks++;
-        allocator->full_blocks.remove(*block);
-        allocator->usable_blocks.prepend(*block);
-    }
-
-    ++block->m_free_chunks;
-
-    if (!block->used_chunks()) {
-        size_t good_size;
-        auto* allocator = allocator_for_size(block->m_size, good_size);
-        if (s_hot_empty_block_count < number_of_hot_chunked_blocks_to_keep_around) {
-            dbgln_if(MALLOC_DEBUG, "Keeping hot block {:p} around", block);
-            g_malloc_stats.number_of_hot_keeps++;
-            allocator->usable_blocks.remove(*block);
-            s_hot_empty_blocks[s_hot_empty_block_count++] = block;
-            return;
-        }
-        if (s_cold_empty_block_count < number_of_cold_chunked_blocks_to_keep_around) {
-            dbgln_if(MALLOC_DEBUG, "Keeping cold block {:p} around", block);
-            g_malloc_stats.number_of_cold_keeps++;
-            allocator->usable_blocks.remove(*block);
-            s_cold_empty_blocks[s_cold_empty_block_count++] = block;
-            mprotect(block, ChunkedBlock::block_size, PROT_NONE);
-            madvise(block, ChunkedBlock::block_size, MADV_SET_VOLATILE);
-            return;
+#ifndef NO_TLS
+    size_t good_size;
+    auto* allocator = allocator_for_size(block->m_size, good_size);
+    if (allocator < &allocators()[number_of_thread_cached_size_classes]) {
+        auto& cache = t_thread_caches[allocator - allocators()];
+        if (cache.count == number_of_chunks_per_thread_cache) {
+            PthreadMutexLocker locker(s_malloc_mutex);
+            flush_thread_cache(cache, number_of_chunks_per_thread_cache_batch);
         }
-        dbgln_if(MALLOC_DEBUG, "Releasing block {:p} for size class {}", block, good_size);
-        g_malloc_stats.number_of_frees++;
-        allocator->usable_blocks.remove(*block);
-        --allocator->block_count;
-        os_free(block, ChunkedBlock::block_size);
+        t_malloc_stats.number_of_thread_cache_keeps++;
+        cache.chunks[cache.count++] = ptr;
+        return;
     }
+#endif
+
+    PthreadMutexLocker locker(s_malloc_mutex);
+    free_chunk(*block, ptr);
 }
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/malloc.html
@@ -683,9 +790,44 @@ void __malloc_init()
     new (&big_allocators()[0])(BigAllocator);
 }
 
+void __malloc_thread_exit()
+{
+    PthreadMutexLocker locker(s_malloc_mutex);
+#ifndef NO_TLS
+    for (auto& cache : t_thread_caches) {
+        if (cache.count)
+            flush_thread_cache(cache, cache.count);
+    }
+#endif
+
+    g_exited_threads_malloc_stats.number_of_malloc_calls += t_malloc_stats.number_of_malloc_calls;
+    g_exited_threads_malloc_stats.number_of_free_calls += t_malloc_stats.number_of_free_calls;
+    g_exited_threads_malloc_stats.number_of_thread_cache_hits += t_malloc_stats.number_of_thread_cache_hits;
+    g_exited_threads_malloc_stats.number_of_thread_cache_refills += t_malloc_stats.number_of_thread_cache_refills;
+    g_exited_threads_malloc_stats.number_of_thread_cache_keeps += t_malloc_stats.number_of_thread_cache_keeps;
+    g_exited_threads_malloc_stats.number_of_thread_cache_flushes += t_malloc_stats.number_of_thread_cache_flushes;
+    t_malloc_stats = {};
+}
+
 void serenity_dump_malloc_stats()
 {
-    dbgln("# malloc() calls: {}", g_malloc_stats.number_of_malloc_calls);
+    // NOTE: The per-thread counters cover this thread and all threads that have exited.
+    ThreadMallocStats thread_stats;
+    {
+        PthreadMutexLocker locker(s_malloc_mutex);
+        thread_stats = g_exited_threads_malloc_stats;
+    }
+    thread_stats.number_of_malloc_calls += t_malloc_stats.number_of_malloc_calls;
+    thread_stats.number_of_free_calls += t_malloc_stats.number_of_free_calls;
+    thread_stats.number_of_thread_cache_hits += t_malloc_stats.number_of_thread_cache_hits;
+    thread_stats.number_of_thread_cache_refills += t_malloc_stats.number_of_thread_cache_refills;
+    thread_stats.number_of_thread_cache_keeps += t_malloc_stats.number_of_thread_cache_keeps;
+    thread_stats.number_of_thread_cache_flushes += t_malloc_stats.number_of_thread_cache_flushes;
+
+    dbgln("# malloc() calls: {}", thread_stats.number_of_malloc_calls);
+    dbgln();
+    dbgln("thread cache hits: {}", thread_stats.number_of_thread_cache_hits);
+    dbgln("thread cache refills: {}", thread_stats.number_of_thread_cache_refills);
     dbgln();
     dbgln("big alloc hits: {}", g_malloc_stats.number_of_big_allocator_hits);
     dbgln("big alloc hits that were purged: {}", g_malloc_stats.number_of_big_allocator_purge_hits);
@@ -697,7 +839,10 @@ void serenity_dump_malloc_stats()
     dbgln("block allocs: {}", g_malloc_stats.number_of_block_allocs);
     dbgln("filled blocks: {}", g_malloc_stats.number_of_blocks_full);
     dbgln();
-    dbgln("# free() calls: {}", g_malloc_stats.number_of_free_calls);
+    dbgln("# free() calls: {}", thread_stats.number_of_free_calls);
+    dbgln();
+    dbgln("thread cache keeps: {}", thread_stats.number_of_thread_cache_keeps);
+    dbgln("thread cache flushes: {}", thread_stats.number_of_thread_cache_flushes);
     dbgln();
     dbgln("big alloc keeps: {}", g_malloc_stats.number_of_big_allocator_keeps);
     dbgln("big alloc frees: {}", g_malloc_stats.number_of_big_allocator_frees);
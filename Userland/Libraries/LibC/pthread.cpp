@@ -22,6 +22,7 @@
 #include <signal.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/internals.h>
 #include <sys/mman.h>
 #include <syscall.h>
 #include <time.h>
@@ -58,6 +59,7 @@ extern "C" {
 [[noreturn]] static void exit_thread(void* code, void* stack_location, size_t stack_size)
 {
     __pthread_key_destroy_for_current_thread();
+    __malloc_thread_exit();
     syscall(SC_exit_thread, code, stack_location, stack_size);
     VERIFY_NOT_REACHED();
 }
@@ -663,8 +665,6 @@ int pthread_equal(pthread_t t1, pthread_t t2)
     return t1 == t2;
 }
 
-// FIXME: Use the fancy futex mechanism above to write an rw lock.
-//        For the time being, let's just use a less-than-good lock to get things working.
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_rwlock_destroy.html
 int pthread_rwlock_destroy(pthread_rwlock_t* rl)
 {
@@ -673,18 +673,40 @@ int pthread_rwlock_destroy(pthread_rwlock_t* rl)
     return 0;
 }
 
-// In a very non-straightforward way, this value is composed of two 32-bit integers
-// the top 32 bits are reserved for the ID of write-locking thread (if any)
-// and the bottom 32 bits are:
-//     top 2 bits (30,31): reader wake mask, writer wake mask
-//     middle 16 bits: information
-//        bit 16: someone is waiting to write
-//        bit 17: locked for write
-//     bottom 16 bits (0..15): reader count
-constexpr static u32 reader_wake_mask = 1 << 30;
-constexpr static u32 writer_wake_mask = 1 << 31;
-constexpr static u32 writer_locked_mask = 1 << 17;
-constexpr static u32 writer_intent_mask = 1 << 16;
+// A pthread_rwlock_t is made up of two 32-bit integers. The low one is the futex word, the
+// high one holds the ID of the thread that has locked it for writing (if any).
+//
+// The futex word is laid out as follows:
+//     bit 31: locked for writing
+//     bit 30: there may be writers waiting for the lock
+//     bit 29: there may be readers waiting for the lock
+//     bits 0..28: the number of readers holding the lock
+//
+// The lock prefers writers: as long as a writer is waiting, no new readers are let in, so
+// a steady stream of readers can't starve writers out. This means that a thread that
+// already holds a read lock must not try to take another one, as that can deadlock with a
+// waiting writer.
+//
+// Readers and writers sleep on the same futex word, but with different bitsets, so that an
+// unlock can choose which of them to wake.
+static constexpr u32 RWLOCK_WRITE_LOCKED = 1u << 31;
+static constexpr u32 RWLOCK_WRITERS_WAITING = 1u << 30;
+static constexpr u32 RWLOCK_READERS_WAITING = 1u << 29;
+static constexpr u32 RWLOCK_READER_COUNT_MASK = RWLOCK_READERS_WAITING - 1;
+
+static constexpr u32 RWLOCK_READER_WAKE_BITSET = 1;
+static constexpr u32 RWLOCK_WRITER_WAKE_BITSET = 2;
+
+static u32* rwlock_futex_word(pthread_rwlock_t* lockp)
+{
+    return reinterpret_cast<u32*>(lockp);
+}
+
+static pid_t* rwlock_writer(pthread_rwlock_t* lockp)
+{
+    return reinterpret_cast<pid_t*>(lockp) + 1;
+}
+
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_rwlock_init.html
 int pthread_rwlock_init(pthread_rwlock_t* __restrict lockp, pthread_rwlockattr_t const* __restrict attr)
 {
@@ -696,100 +718,97 @@ int pthread_rwlock_init(pthread_rwlock_t* __restrict lockp, pthread_rwlockattr_t
     return 0;
 }
 
-// Note that this function does not care about the top 32 bits at all.
-static int rwlock_rdlock_maybe_timed(u32* lockp, const struct timespec* timeout = nullptr, bool only_once = false, int value_if_timeout = -1, int value_if_okay = -2)
-{
-    auto current = AK::atomic_load(lockp);
-    for (; !only_once;) {
-        // First, see if this is locked for writing
-        // if it's not, try to add to the counter.
-        // If someone is waiting to write, and there is one or no other readers, let them have the lock.
-        if (!(current & writer_locked_mask)) {
-            auto count = (u16)current;
-            if (!(current & writer_intent_mask) || count > 1) {
-                ++count;
-                auto desired = (current & 0xffff0000u) | count;
-                auto did_exchange = AK::atomic_compare_exchange_strong(lockp, current, desired, AK::MemoryOrder::memory_order_acquire);
-                if (!did_exchange)
-                    continue; // tough luck, try again.
-                return value_if_okay;
-            }
-        }
+// Sleeps until the futex word changes from `value`, or until someone wakes us through `bitset`.
+static int rwlock_wait(u32* word, u32 value, u32 bitset, const struct timespec* abstime)
+{
+    // NOTE: Timeouts for rwlocks are absolute, and measured against CLOCK_REALTIME.
+    int op = FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG;
+    if (abstime)
+        op |= FUTEX_CLOCK_REALTIME;
+    int rc = futex(word, op, value, abstime, nullptr, bitset);
+    if (rc < 0 && errno == ETIMEDOUT)
+        return ETIMEDOUT;
+    // EAGAIN and EINTR just mean that we have to take another look at the lock.
+    return 0;
+}
 
-        // If no one else is waiting for the read wake bit, set it.
-        if (!(current & reader_wake_mask)) {
-            auto desired = current | reader_wake_mask;
-            auto did_exchange = AK::atomic_compare_exchange_strong(lockp, current, desired, AK::MemoryOrder::memory_order_acquire);
-            if (!did_exchange)
-                continue; // Something interesting happened!
+static int rwlock_wake(u32* word, u32 count, u32 bitset)
+{
+    return futex(word, FUTEX_WAKE_BITSET | FUTEX_PRIVATE_FLAG, count, nullptr, nullptr, bitset);
+}
 
-            current = desired;
-        }
+// Clears RWLOCK_READERS_WAITING before waking the readers, so that any of them that still can't
+// get in set it again, and nobody is left asleep without it.
+static void rwlock_wake_readers(u32* word)
+{
+    AK::atomic_fetch_and(word, ~RWLOCK_READERS_WAITING, AK::memory_order_relaxed);
+    rwlock_wake(word, INT_MAX, RWLOCK_READER_WAKE_BITSET);
+}
 
-        // Seems like someone is writing (or is interested in writing and we let them have the lock)
-        // wait until they're done.
-        auto rc = futex(lockp, FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG, current, timeout, nullptr, reader_wake_mask);
-        if (rc < 0 && errno == ETIMEDOUT && timeout) {
-            return value_if_timeout;
+static int rwlock_rdlock(pthread_rwlock_t* lockp, bool try_only, const struct timespec* abstime = nullptr)
+{
+    auto* word = rwlock_futex_word(lockp);
+    auto current = AK::atomic_load(word, AK::memory_order_relaxed);
+    for (;;) {
+        // Get in line behind any writer that holds the lock or is waiting for it.
+        if (!(current & (RWLOCK_WRITE_LOCKED | RWLOCK_WRITERS_WAITING))) {
+            if ((current & RWLOCK_READER_COUNT_MASK) == RWLOCK_READER_COUNT_MASK)
+                return EAGAIN;
+            if (AK::atomic_compare_exchange_strong(word, current, current + 1, AK::memory_order_acquire))
+                return 0;
+            continue;
         }
-        if (rc < 0 && errno != EAGAIN) {
-            // Something broke. let's just bail out.
-            return errno;
+
+        if (try_only)
+            return EBUSY;
+
+        if (!(current & RWLOCK_READERS_WAITING)) {
+            if (!AK::atomic_compare_exchange_strong(word, current, current | RWLOCK_READERS_WAITING, AK::memory_order_relaxed))
+                continue;
+            current |= RWLOCK_READERS_WAITING;
         }
-        errno = 0;
-        // Reload the 'current' value
-        current = AK::atomic_load(lockp);
+
+        if (auto rc = rwlock_wait(word, current, RWLOCK_READER_WAKE_BITSET, abstime); rc != 0)
+            return rc;
+        current = AK::atomic_load(word, AK::memory_order_relaxed);
     }
-    return value_if_timeout;
-}
-
-static int rwlock_wrlock_maybe_timed(pthread_rwlock_t* lockval_p, const struct timespec* timeout = nullptr, bool only_once = false, int value_if_timeout = -1, int value_if_okay = -2)
-{
-    u32* lockp = reinterpret_cast<u32*>(lockval_p);
-    auto current = AK::atomic_load(lockp);
-    for (; !only_once;) {
-        // First, see if this is locked for writing, and if there are any readers.
-        // if not, lock it.
-        // If someone is waiting to write, let them have the lock.
-        if (!(current & writer_locked_mask) && ((u16)current) == 0) {
-            if (!(current & writer_intent_mask)) {
-                auto desired = current | writer_locked_mask | writer_intent_mask;
-                auto did_exchange = AK::atomic_compare_exchange_strong(lockp, current, desired, AK::MemoryOrder::memory_order_acquire);
-                if (!did_exchange)
-                    continue;
-
-                // Now that we've locked the value, it's safe to set our thread ID.
-                AK::atomic_store(reinterpret_cast<i32*>(lockval_p) + 1, pthread_self());
-                return value_if_okay;
-            }
+}
+
+static int rwlock_wrlock(pthread_rwlock_t* lockp, bool try_only, const struct timespec* abstime = nullptr)
+{
+    auto* word = rwlock_futex_word(lockp);
+    auto current = AK::atomic_load(word, AK::memory_order_relaxed);
+    // Once we have slept, we can't know whether there are other writers still waiting, so we
+    // have to assume that there are, and wake one when we unlock. This is the same trick as
+    // MUTEX_LOCKED_NEED_TO_WAKE plays for mutexes.
+    bool have_waited = false;
+    for (;;) {
+        if (!(current & (RWLOCK_WRITE_LOCKED | RWLOCK_READER_COUNT_MASK))) {
+            auto desired = current | RWLOCK_WRITE_LOCKED;
+            if (have_waited)
+                desired |= RWLOCK_WRITERS_WAITING;
+            if (!AK::atomic_compare_exchange_strong(word, current, desired, AK::memory_order_acquire))
+                continue;
+            AK::atomic_store(rwlock_writer(lockp), gettid(), AK::memory_order_relaxed);
+            return 0;
         }
 
-        // That didn't work, if no one else is waiting for the write bit, set it.
-        if (!(current & writer_wake_mask)) {
-            auto desired = current | writer_wake_mask | writer_intent_mask;
-            auto did_exchange = AK::atomic_compare_exchange_strong(lockp, current, desired, AK::MemoryOrder::memory_order_acquire);
-            if (!did_exchange)
-                continue; // Something interesting happened!
+        if (try_only)
+            return EBUSY;
 
-            current = desired;
+        if (!(current & RWLOCK_WRITERS_WAITING)) {
+            if (!AK::atomic_compare_exchange_strong(word, current, current | RWLOCK_WRITERS_WAITING, AK::memory_order_relaxed))
+                continue;
+            current |= RWLOCK_WRITERS_WAITING;
         }
 
-        // Seems like someone is writing (or is interested in writing and we let them have the lock)
-        // wait until they're done.
-        auto rc = futex(lockp, FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG, current, timeout, nullptr, writer_wake_mask);
-        if (rc < 0 && errno == ETIMEDOUT && timeout) {
-            return value_if_timeout;
-        }
-        if (rc < 0 && errno != EAGAIN) {
-            // Something broke. let's just bail out.
-            return errno;
-        }
-        errno = 0;
-        // Reload the 'current' value
-        current = AK::atomic_load(lockp);
+        // NOTE: If we time out, we leave RWLOCK_WRITERS_WAITING behind. Whoever unlocks next will
+        //       find no writer to wake, and let the readers in instead.
+        if (auto rc = rwlock_wait(word, current, RWLOCK_WRITER_WAKE_BITSET, abstime); rc != 0)
+            return rc;
+        have_waited = true;
+        current = AK::atomic_load(word, AK::memory_order_relaxed);
     }
-
-    return value_if_timeout;
 }
 
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_rwlock_rdlock.html
@@ -798,7 +817,7 @@ int pthread_rwlock_rdlock(pthread_rwlock_t* lockp)
     if (!lockp)
         return EINVAL;
 
-    return rwlock_rdlock_maybe_timed(reinterpret_cast<u32*>(lockp), nullptr, false, 0, 0);
+    return rwlock_rdlock(lockp, false);
 }
 
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_rwlock_timedrdlock.html
@@ -807,12 +826,7 @@ int pthread_rwlock_timedrdlock(pthread_rwlock_t* __restrict lockp, const struct
     if (!lockp)
         return EINVAL;
 
-    auto rc = rwlock_rdlock_maybe_timed(reinterpret_cast<u32*>(lockp), timespec);
-    if (rc == -1) // "ok"
-        return 0;
-    if (rc == -2) // "timed out"
-        return 1;
-    return rc;
+    return rwlock_rdlock(lockp, false, timespec);
 }
 
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_rwlock_timedwrlock.html
@@ -821,12 +835,7 @@ int pthread_rwlock_timedwrlock(pthread_rwlock_t* __restrict lockp, const struct
     if (!lockp)
         return EINVAL;
 
-    auto rc = rwlock_wrlock_maybe_timed(lockp, timespec);
-    if (rc == -1) // "ok"
-        return 0;
-    if (rc == -2) // "timed out"
-        return 1;
-    return rc;
+    return rwlock_wrlock(lockp, false, timespec);
 }
 
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_rwlock_tryrdlock.html
@@ -835,7 +844,7 @@ int pthread_rwlock_tryrdlock(pthread_rwlock_t* lockp)
     if (!lockp)
         return EINVAL;
 
-    return rwlock_rdlock_maybe_timed(reinterpret_cast<u32*>(lockp), nullptr, true, EBUSY, 0);
+    return rwlock_rdlock(lockp, true);
 }
 
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_rwlock_trywrlock.html
@@ -844,51 +853,64 @@ int pthread_rwlock_trywrlock(pthread_rwlock_t* lockp)
     if (!lockp)
         return EINVAL;
 
-    return rwlock_wrlock_maybe_timed(lockp, nullptr, true, EBUSY, 0);
+    return rwlock_wrlock(lockp, true);
 }
 
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_rwlock_unlock.html
-int pthread_rwlock_unlock(pthread_rwlock_t* lockval_p)
+int pthread_rwlock_unlock(pthread_rwlock_t* lockp)
 {
-    if (!lockval_p)
+    if (!lockp)
         return EINVAL;
 
     // This is a weird API, we don't really know whether we're unlocking write or read...
-    auto lockp = reinterpret_cast<u32*>(lockval_p);
-    auto current = AK::atomic_load(lockp, AK::MemoryOrder::memory_order_relaxed);
-    if (current & writer_locked_mask) {
+    auto* word = rwlock_futex_word(lockp);
+    auto current = AK::atomic_load(word, AK::memory_order_relaxed);
+    if (current & RWLOCK_WRITE_LOCKED) {
         // If this lock is locked for writing, its owner better be us!
-        auto owner_id = AK::atomic_load(reinterpret_cast<i32*>(lockval_p) + 1);
-        auto my_id = pthread_self();
-        if (owner_id != my_id)
-            return EINVAL; // you don't own this lock, silly.
-
-        // Now just unlock it.
-        auto desired = current & ~(writer_locked_mask | writer_intent_mask);
-        AK::atomic_store(lockp, desired, AK::MemoryOrder::memory_order_release);
-        // Then wake both readers and writers, if any.
-        auto rc = futex(lockp, FUTEX_WAKE_BITSET | FUTEX_PRIVATE_FLAG, current, nullptr, nullptr, (current & writer_wake_mask) | reader_wake_mask);
-        if (rc < 0)
-            return errno;
+        if (AK::atomic_load(rwlock_writer(lockp), AK::memory_order_relaxed) != gettid())
+            return EINVAL;
+        AK::atomic_store(rwlock_writer(lockp), 0, AK::memory_order_relaxed);
+
+        // Writers go first. If there may be one to wake, it's up to them to let the readers in
+        // once they're done, so we leave RWLOCK_READERS_WAITING in place for them to find.
+        // NOTE: This has to happen in the same step as unlocking, otherwise that writer could
+        //       come and go before the bit is back, and the readers would never be woken.
+        auto previous = current;
+        for (;;) {
+            auto desired = (previous & RWLOCK_WRITERS_WAITING) ? (previous & RWLOCK_READERS_WAITING) : 0u;
+            if (AK::atomic_compare_exchange_strong(word, previous, desired, AK::memory_order_release))
+                break;
+        }
+        if ((previous & RWLOCK_WRITERS_WAITING) && rwlock_wake(word, 1, RWLOCK_WRITER_WAKE_BITSET) > 0)
+            return 0;
+        if (previous & RWLOCK_READERS_WAITING)
+            rwlock_wake_readers(word);
         return 0;
     }
 
     for (;;) {
-        auto count = (u16)current;
+        auto count = current & RWLOCK_READER_COUNT_MASK;
         if (!count) {
             // Are you crazy? this isn't even locked!
             return EINVAL;
         }
-        --count;
-        auto desired = (current & 0xffff0000u) | count;
-        auto did_exchange = AK::atomic_compare_exchange_strong(lockp, current, desired, AK::MemoryOrder::memory_order_release);
-        if (did_exchange)
-            break;
-        // tough luck, try again.
-    }
 
-    // Finally, unlocked at last!
-    return 0;
+        // The last reader out hands the lock over to a waiting writer. As above, the readers
+        // waiting behind that writer stay marked, so that it lets them in when it's done.
+        auto desired = current - 1;
+        bool wake_writer = count == 1 && (current & RWLOCK_WRITERS_WAITING);
+        if (wake_writer)
+            desired &= ~RWLOCK_WRITERS_WAITING;
+        if (!AK::atomic_compare_exchange_strong(word, current, desired, AK::memory_order_release))
+            continue;
+
+        if (wake_writer && rwlock_wake(word, 1, RWLOCK_WRITER_WAKE_BITSET) == 0) {
+            // Nobody was actually waiting to write, so the readers were held back for nothing.
+            if (current & RWLOCK_READERS_WAITING)
+                rwlock_wake_readers(word);
+        }
+        return 0;
+    }
 }
 
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_rwlock_wrlock.html
@@ -897,7 +919,7 @@ int pthread_rwlock_wrlock(pthread_rwlock_t* lockp)
     if (!lockp)
         return EINVAL;
 
-    return rwlock_wrlock_maybe_timed(lockp, nullptr, false, 0, 0);
+    return rwlock_wrlock(lockp, false);
 }
 
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_rwlockattr_destroy.html
@@ -6,6 +6,7 @@
 
 #include <AK/Atomic.h>
 #include <AK/NeverDestroyed.h>
+#include <AK/Platform.h>
 #include <AK/Types.h>
 #include <AK/Vector.h>
 #include <bits/pthread_integration.h>
@@ -97,6 +98,37 @@ static constexpr u32 MUTEX_UNLOCKED = 0;
 static constexpr u32 MUTEX_LOCKED_NO_NEED_TO_WAKE = 1;
 static constexpr u32 MUTEX_LOCKED_NEED_TO_WAKE = 2;
 
+// How many times we poll a contended mutex before going to sleep on it. Most critical
+// sections are short enough for the owner to release the mutex within that time, which
+// saves both us and the owner a trip into the kernel.
+static constexpr int MUTEX_SPIN_COUNT = 100;
+
+static ALWAYS_INLINE void spin_loop_hint()
+{
+#if ARCH(I386) || ARCH(X86_64)
+    __builtin_ia32_pause();
+#elif ARCH(AARCH64)
+    asm volatile("yield");
+#endif
+}
+
+// Spins while the mutex is held by someone who isn't expected to wake anyone up, and
+// claims it if it becomes free in the meantime. Once there are sleeping waiters, the
+// mutex is going to be handed over to one of them anyway, so there's no point in spinning.
+static bool spin_and_try_to_claim(pthread_mutex_t* mutex, u32& value)
+{
+    for (int i = 0; i < MUTEX_SPIN_COUNT && value != MUTEX_LOCKED_NEED_TO_WAKE; ++i) {
+        if (value == MUTEX_UNLOCKED) {
+            if (AK::atomic_compare_exchange_strong(&mutex->lock, value, MUTEX_LOCKED_NO_NEED_TO_WAKE, AK::memory_order_acquire))
+                return true;
+            continue;
+        }
+        spin_loop_hint();
+        value = AK::atomic_load(&mutex->lock, AK::memory_order_relaxed);
+    }
+    return false;
+}
+
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_mutex_init.html
 int pthread_mutex_init(pthread_mutex_t* mutex, pthread_mutexattr_t const* attributes)
 {
@@ -149,14 +181,17 @@ int pthread_mutex_lock(pthread_mutex_t* mutex)
         }
     }
 
-    // Slow path: wait, record the fact that we're going to wait, and always
-    // remember to wake the next thread up once we release the mutex.
-    if (value != MUTEX_LOCKED_NEED_TO_WAKE)
-        value = AK::atomic_exchange(&mutex->lock, MUTEX_LOCKED_NEED_TO_WAKE, AK::memory_order_acquire);
+    // Slow path: spin for a bit, and if that doesn't get us the mutex, wait, record the fact
+    // that we're going to wait, and always remember to wake the next thread up once we
+    // release the mutex.
+    if (!spin_and_try_to_claim(mutex, value)) {
+        if (value != MUTEX_LOCKED_NEED_TO_WAKE)
+            value = AK::atomic_exchange(&mutex->lock, MUTEX_LOCKED_NEED_TO_WAKE, AK::memory_order_acquire);
 
-    while (value != MUTEX_UNLOCKED) {
-        futex_wait(&mutex->lock, value, nullptr, 0, false);
-        value = AK::atomic_exchange(&mutex->lock, MUTEX_LOCKED_NEED_TO_WAKE, AK::memory_order_acquire);
+        while (value != MUTEX_UNLOCKED) {
+            futex_wait(&mutex->lock, value, nullptr, 0, false);
+            value = AK::atomic_exchange(&mutex->lock, MUTEX_LOCKED_NEED_TO_WAKE, AK::memory_order_acquire);
+        }
     }
 
     if (mutex->type == __PTHREAD_MUTEX_RECURSIVE)
@@ -29,6 +29,8 @@ struct posix_spawn_file_actions_state {
 
 extern "C" {
 
+// NOTE: The child is created with vfork(), which skips the atfork handlers. As our vfork() doesn't share
+//       the address space with the parent, the child is free to do more than just exec or _exit.
 [[noreturn]] static void posix_spawn_child(char const* path, posix_spawn_file_actions_t const* file_actions, posix_spawnattr_t const* attr, char* const argv[], char* const envp[], int (*exec)(char const*, char* const[], char* const[]))
 {
     if (attr) {
@@ -102,7 +104,7 @@ extern "C" {
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/posix_spawn.html
 int posix_spawn(pid_t* out_pid, char const* path, posix_spawn_file_actions_t const* file_actions, posix_spawnattr_t const* attr, char* const argv[], char* const envp[])
 {
-    pid_t child_pid = fork();
+    pid_t child_pid = vfork();
     if (child_pid < 0)
         return errno;
 
@@ -117,7 +119,7 @@ int posix_spawn(pid_t* out_pid, char const* path, posix_spawn_file_actions_t con
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/posix_spawnp.html
 int posix_spawnp(pid_t* out_pid, char const* file, posix_spawn_file_actions_t const* file_actions, posix_spawnattr_t const* attr, char* const argv[], char* const envp[])
 {
-    pid_t child_pid = fork();
+    pid_t child_pid = vfork();
     if (child_pid < 0)
         return errno;
 
@@ -447,6 +447,47 @@ static Kernel::TimePage* get_kernel_time_page()
     return s_kernel_time_page;
 }
 
+static bool read_kernel_time_page(Kernel::TimePage const& kernel_time_page, clockid_t clock_id, struct timespec& ts)
+{
+    bool needs_interpolation = Kernel::time_page_clock_needs_interpolation(clock_id);
+#if !ARCH(I386) && !ARCH(X86_64)
+    // FIXME: Interpolate with the architecture's counter, once the kernel calibrates it for us.
+    if (needs_interpolation)
+        return false;
+#endif
+
+    u64 tsc_base;
+    u64 tsc_multiplier;
+    u64 tsc_max_delta;
+    u32 tsc_shift;
+    u32 update_iteration;
+    do {
+        update_iteration = AK::atomic_load(&kernel_time_page.update1, AK::memory_order_acquire);
+        ts = kernel_time_page.clocks[clock_id];
+        tsc_base = kernel_time_page.tsc_base;
+        tsc_multiplier = kernel_time_page.tsc_multiplier;
+        tsc_max_delta = kernel_time_page.tsc_max_delta;
+        tsc_shift = kernel_time_page.tsc_shift;
+    } while (update_iteration != AK::atomic_load(&kernel_time_page.update2, AK::memory_order_acquire));
+
+    if (!needs_interpolation)
+        return true;
+    // NOTE: The kernel only lets us interpolate when the time stamp counter is invariant, and agrees across processors.
+    if (tsc_multiplier == 0)
+        return false;
+
+#if ARCH(I386) || ARCH(X86_64)
+    // NOTE: If we get further than the kernel's next update is due, we were preempted for a long time after reading the page,
+    //       or the update is late. Either way, the clocks mustn't run past where the next update will put them.
+    u64 tsc = __builtin_ia32_rdtsc();
+    u64 tsc_delta = tsc > tsc_base ? min(tsc - tsc_base, tsc_max_delta) : 0;
+    u64 nanoseconds = static_cast<u64>(ts.tv_nsec) + ((tsc_delta * tsc_multiplier) >> tsc_shift);
+    ts.tv_sec += static_cast<time_t>(nanoseconds / 1'000'000'000);
+    ts.tv_nsec = static_cast<long>(nanoseconds % 1'000'000'000);
+#endif
+    return true;
+}
+
 int clock_gettime(clockid_t clock_id, struct timespec* ts)
 {
     if (Kernel::time_page_supports(clock_id)) {
@@ -456,12 +497,8 @@ int clock_gettime(clockid_t clock_id, struct timespec* ts)
         }
 
         if (auto* kernel_time_page = get_kernel_time_page()) {
-            u32 update_iteration;
-            do {
-                update_iteration = AK::atomic_load(&kernel_time_page->update1, AK::memory_order_acquire);
-                *ts = kernel_time_page->clocks[clock_id];
-            } while (update_iteration != AK::atomic_load(&kernel_time_page->update2, AK::memory_order_acquire));
-            return 0;
+            if (read_kernel_time_page(*kernel_time_page, clock_id, *ts))
+                return 0;
         }
     }
 
@@ -107,7 +107,15 @@ pid_t fork()
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/vfork.html
 pid_t vfork()
 {
-    return fork();
+    // The child may only exec or _exit, so unlike fork(), we don't have to run the atfork handlers (and hold up
+    // every other thread while they run). It still gets its own copy of the address space, but the kernel only
+    // builds the page tables of the regions that the child touches on its way to exec.
+    int rc = syscall(SC_fork);
+    if (rc == 0) {
+        s_cached_tid = 0;
+        s_cached_pid = 0;
+    }
+    __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
 // Non-POSIX, but present in BSDs and Linux
@@ -36,6 +36,11 @@
 #include <time.h>
 #include <unistd.h>
 
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+#    include <sys/epoll.h>
+#    define EVENTLOOP_USE_EPOLL
+#endif
+
 #ifdef AK_OS_SERENITY
 #    include <LibCore/Account.h>
 
@@ -74,6 +79,70 @@ static thread_local HashTable<Notifier*>* s_notifiers;
 thread_local int EventLoop::s_wake_pipe_fds[2];
 thread_local bool EventLoop::s_wake_pipe_initialized { false };
 
+#ifdef EVENTLOOP_USE_EPOLL
+// Instead of handing the kernel every notifier's fd on every wait, notifiers are kept in a
+// persistent epoll interest set, so a wakeup only costs as much as the number of ready fds.
+// Notifiers that share an fd have to share its registration.
+static thread_local HashMap<int, Vector<Notifier*, 1>>* s_notifiers_by_fd;
+// Registrations are one-shot and get re-armed after their events have been dispatched. This way,
+// a registration that outlives its fd (e.g. because the fd was closed while a dup of it is still
+// open elsewhere) fires at most once, instead of waking us up forever.
+static thread_local Vector<int>* s_fds_to_rearm;
+// Some fds (e.g. regular files on Linux) can't be watched with epoll, but select() would
+// always consider them ready.
+static thread_local HashTable<int>* s_always_ready_fds;
+static thread_local int s_epoll_fd { -1 };
+
+static void initialize_epoll(int wake_pipe_read_fd)
+{
+    if (s_epoll_fd >= 0)
+        return;
+    s_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    VERIFY(s_epoll_fd >= 0);
+
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.fd = wake_pipe_read_fd;
+    int rc = epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, wake_pipe_read_fd, &event);
+    VERIFY(rc == 0);
+}
+
+static void update_epoll_registration(int fd)
+{
+    u32 events = 0;
+    if (auto it = s_notifiers_by_fd->find(fd); it != s_notifiers_by_fd->end()) {
+        for (auto* notifier : it->value) {
+            if (notifier->event_mask() & Notifier::Read)
+                events |= EPOLLIN;
+            if (notifier->event_mask() & Notifier::Write)
+                events |= EPOLLOUT;
+            if (notifier->event_mask() & Notifier::Exceptional)
+                VERIFY_NOT_REACHED();
+        }
+    }
+
+    if (events == 0) {
+        s_always_ready_fds->remove(fd);
+        // The fd may have been closed already, in which case the kernel dropped the registration.
+        (void)epoll_ctl(s_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        return;
+    }
+
+    epoll_event event {};
+    event.events = events | EPOLLONESHOT;
+    event.data.fd = fd;
+    if (epoll_ctl(s_epoll_fd, EPOLL_CTL_MOD, fd, &event) == 0)
+        return;
+    if (errno == ENOENT && epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0)
+        return;
+    if (errno == EPERM) {
+        s_always_ready_fds->set(fd);
+        return;
+    }
+    dbgln("Core::EventLoop: Failed to watch fd {}: {}", fd, strerror(errno));
+}
+#endif
+
 void EventLoop::initialize_wake_pipes()
 {
     if (!s_wake_pipe_initialized) {
@@ -328,6 +397,11 @@ EventLoop::EventLoop([[maybe_unused]] MakeInspectable make_inspectable)
         s_event_loop_stack = new Vector<EventLoop&>;
         s_timers = new HashMap<int, NonnullOwnPtr<EventLoopTimer>>;
         s_notifiers = new HashTable<Notifier*>;
+#ifdef EVENTLOOP_USE_EPOLL
+        s_notifiers_by_fd = new HashMap<int, Vector<Notifier*, 1>>;
+        s_fds_to_rearm = new Vector<int>;
+        s_always_ready_fds = new HashTable<int>;
+#endif
     }
 
     if (s_event_loop_stack->is_empty()) {
@@ -349,6 +423,9 @@ EventLoop::EventLoop([[maybe_unused]] MakeInspectable make_inspectable)
     }
 
     initialize_wake_pipes();
+#ifdef EVENTLOOP_USE_EPOLL
+    initialize_epoll(s_wake_pipe_fds[0]);
+#endif
 
     dbgln_if(EVENTLOOP_DEBUG, "{} Core::EventLoop constructed :)", getpid());
 }
@@ -665,6 +742,15 @@ void EventLoop::notify_forked(ForkEvent event)
         s_notifiers->clear();
         s_wake_pipe_initialized = false;
         initialize_wake_pipes();
+#ifdef EVENTLOOP_USE_EPOLL
+        // The epoll instance is shared with the parent, so we must not touch its registrations.
+        close(s_epoll_fd);
+        s_epoll_fd = -1;
+        s_notifiers_by_fd->clear();
+        s_fds_to_rearm->clear();
+        s_always_ready_fds->clear();
+        initialize_epoll(s_wake_pipe_fds[0]);
+#endif
         if (auto* info = signals_info<false>()) {
             info->signal_handlers.clear();
             info->next_signal_id = 0;
@@ -678,9 +764,18 @@ void EventLoop::notify_forked(ForkEvent event)
 
 void EventLoop::wait_for_event(WaitMode mode)
 {
+#ifdef EVENTLOOP_USE_EPOLL
+    epoll_event events[64];
+#else
     fd_set rfds;
     fd_set wfds;
+#endif
 retry:
+#ifdef EVENTLOOP_USE_EPOLL
+    for (int fd : *s_fds_to_rearm)
+        update_epoll_registration(fd);
+    s_fds_to_rearm->clear();
+#else
     FD_ZERO(&rfds);
     FD_ZERO(&wfds);
 
@@ -703,6 +798,7 @@ retry:
         if (notifier->event_mask() & Notifier::Exceptional)
             VERIFY_NOT_REACHED();
     }
+#endif
 
     bool queued_events_is_empty;
     {
@@ -726,6 +822,32 @@ retry:
         }
     }
 
+#ifdef EVENTLOOP_USE_EPOLL
+    int timeout_ms = -1;
+    if (!s_always_ready_fds->is_empty())
+        timeout_ms = 0;
+    else if (!should_wait_forever)
+        timeout_ms = timeout.tv_sec * 1000 + (timeout.tv_usec + 999) / 1000;
+
+try_epoll_wait_again:
+    int marked_fd_count = epoll_wait(s_epoll_fd, events, array_size(events), timeout_ms);
+    if (marked_fd_count < 0) {
+        int saved_errno = errno;
+        if (saved_errno == EINTR) {
+            if (m_exit_requested)
+                return;
+            goto try_epoll_wait_again;
+        }
+        dbgln("Core::EventLoop::wait_for_event: {} ({}: {})", marked_fd_count, saved_errno, strerror(saved_errno));
+        VERIFY_NOT_REACHED();
+    }
+
+    bool wake_pipe_is_readable = false;
+    for (int i = 0; i < marked_fd_count; ++i) {
+        if (events[i].data.fd == s_wake_pipe_fds[0])
+            wake_pipe_is_readable = true;
+    }
+#else
 try_select_again:
     int marked_fd_count = select(max_fd + 1, &rfds, &wfds, nullptr, should_wait_forever ? nullptr : &timeout);
     if (marked_fd_count < 0) {
@@ -738,7 +860,10 @@ try_select_again:
         dbgln("Core::EventLoop::wait_for_event: {} ({}: {})", marked_fd_count, saved_errno, strerror(saved_errno));
         VERIFY_NOT_REACHED();
     }
-    if (FD_ISSET(s_wake_pipe_fds[0], &rfds)) {
+
+    bool wake_pipe_is_readable = FD_ISSET(s_wake_pipe_fds[0], &rfds);
+#endif
+    if (wake_pipe_is_readable) {
         int wake_events[8];
         ssize_t nread;
         // We might receive another signal while read()ing here. The signal will go to the handle_signal properly,
@@ -763,8 +888,16 @@ try_select_again:
                 wake_requested = true;
         }
 
-        if (!wake_requested && nread == sizeof(wake_events))
+        if (!wake_requested && nread == sizeof(wake_events)) {
+#ifdef EVENTLOOP_USE_EPOLL
+            // Don't lose the notifier events we already received.
+            for (int i = 0; i < marked_fd_count; ++i) {
+                if (events[i].data.fd != s_wake_pipe_fds[0])
+                    s_fds_to_rearm->append(events[i].data.fd);
+            }
+#endif
             goto retry;
+        }
     }
 
     if (!s_timers->is_empty()) {
@@ -793,6 +926,32 @@ try_select_again:
         }
     }
 
+#ifdef EVENTLOOP_USE_EPOLL
+    auto post_notifier_events = [&](int fd, bool readable, bool writable) {
+        auto it = s_notifiers_by_fd->find(fd);
+        if (it == s_notifiers_by_fd->end())
+            return;
+        for (auto* notifier : it->value) {
+            if (readable && (notifier->event_mask() & Notifier::Event::Read))
+                post_event(*notifier, make<NotifierReadEvent>(fd));
+            if (writable && (notifier->event_mask() & Notifier::Event::Write))
+                post_event(*notifier, make<NotifierWriteEvent>(fd));
+        }
+    };
+
+    for (int fd : *s_always_ready_fds)
+        post_notifier_events(fd, true, true);
+
+    for (int i = 0; i < marked_fd_count; ++i) {
+        int fd = events[i].data.fd;
+        if (fd == s_wake_pipe_fds[0])
+            continue;
+        // Like select(), consider errors and hangups as readable/writable, so that the next read()/write() reports them.
+        auto revents = events[i].events;
+        post_notifier_events(fd, revents & (EPOLLIN | EPOLLHUP | EPOLLERR), revents & (EPOLLOUT | EPOLLERR));
+        s_fds_to_rearm->append(fd);
+    }
+#else
     if (!marked_fd_count)
         return;
 
@@ -806,6 +965,7 @@ try_select_again:
                 post_event(*notifier, make<NotifierWriteEvent>(notifier->fd()));
         }
     }
+#endif
 }
 
 bool EventLoopTimer::has_expired(Time const& now) const
@@ -870,12 +1030,38 @@ void EventLoop::register_notifier(Badge<Notifier>, Notifier& notifier)
 {
     VERIFY_EVENT_LOOP_INITIALIZED();
     s_notifiers->set(&notifier);
+#ifdef EVENTLOOP_USE_EPOLL
+    auto& notifiers = s_notifiers_by_fd->ensure(notifier.fd());
+    if (!notifiers.contains_slow(&notifier))
+        notifiers.append(&notifier);
+    update_epoll_registration(notifier.fd());
+#endif
 }
 
 void EventLoop::unregister_notifier(Badge<Notifier>, Notifier& notifier)
 {
     VERIFY_EVENT_LOOP_INITIALIZED();
     s_notifiers->remove(&notifier);
+#ifdef EVENTLOOP_USE_EPOLL
+    auto it = s_notifiers_by_fd->find(notifier.fd());
+    if (it == s_notifiers_by_fd->end())
+        return;
+    it->value.remove_first_matching([&](auto* entry) { return entry == &notifier; });
+    if (it->value.is_empty())
+        s_notifiers_by_fd->remove(it);
+    update_epoll_registration(notifier.fd());
+#endif
+}
+
+void EventLoop::notifier_event_mask_changed(Badge<Notifier>, Notifier& notifier)
+{
+    VERIFY_EVENT_LOOP_INITIALIZED();
+#ifdef EVENTLOOP_USE_EPOLL
+    if (s_notifiers->contains(&notifier))
+        update_epoll_registration(notifier.fd());
+#else
+    (void)notifier;
+#endif
 }
 
 void EventLoop::wake_current()
@@ -409,6 +409,13 @@ public:
     ErrorOr<void> set_blocking(bool enabled) override { return m_helper.set_blocking(enabled); }
     ErrorOr<void> set_close_on_exec(bool enabled) override { return m_helper.set_close_on_exec(enabled); }
 
+    Optional<int> fd() const
+    {
+        if (!is_open())
+            return {};
+        return m_helper.fd();
+    }
+
     virtual ~TCPSocket() override { close(); }
 
 private:
@@ -951,6 +958,8 @@ public:
 
     virtual size_t buffer_size() const override { return m_helper.buffer_size(); }
 
+    Optional<int> fd() const { return m_helper.stream().fd(); }
+
     virtual ~BufferedSocket() override = default;
 
 private:
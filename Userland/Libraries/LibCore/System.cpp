@@ -24,6 +24,10 @@
 #include <termios.h>
 #include <unistd.h>
 
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+#    include <sys/sendfile.h>
+#endif
+
 #ifdef AK_OS_SERENITY
 #    include <Kernel/API/Unveil.h>
 #    include <LibCore/Account.h>
@@ -525,6 +529,16 @@ ErrorOr<ssize_t> write(int fd, ReadonlyBytes buffer)
     return rc;
 }
 
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+ErrorOr<size_t> sendfile(int out_fd, int in_fd, off_t* offset, size_t count)
+{
+    ssize_t rc = ::sendfile(out_fd, in_fd, offset, count);
+    if (rc < 0)
+        return Error::from_syscall("sendfile"sv, -errno);
+    return rc;
+}
+#endif
+
 ErrorOr<void> kill(pid_t pid, int signal)
 {
     if (::kill(pid, signal) < 0)
@@ -111,6 +111,9 @@ ErrorOr<struct stat> stat(StringView path);
 ErrorOr<struct stat> lstat(StringView path);
 ErrorOr<ssize_t> read(int fd, Bytes buffer);
 ErrorOr<ssize_t> write(int fd, ReadonlyBytes buffer);
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+ErrorOr<size_t> sendfile(int out_fd, int in_fd, off_t* offset, size_t count);
+#endif
 ErrorOr<void> kill(pid_t, int signal);
 ErrorOr<void> killpg(int pgrp, int signal);
 ErrorOr<int> dup(int source_fd);
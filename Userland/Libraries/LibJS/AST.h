@@ -1770,6 +1770,8 @@ public:
     virtual void dump(int indent) const override;
     virtual Bytecode::CodeGenerationErrorOr<void> generate_bytecode(Bytecode::Generator&) const override;
 
+    NonnullRefPtrVector<ObjectProperty> const& properties() const { return m_properties; }
+
 private:
     virtual bool is_object_expression() const override { return true; }
 
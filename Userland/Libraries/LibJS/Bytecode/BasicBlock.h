@@ -9,6 +9,7 @@
 #include <AK/Badge.h>
 #include <AK/DeprecatedString.h>
 #include <AK/NonnullOwnPtrVector.h>
+#include <LibJS/Bytecode/JIT/NativeExecutable.h>
 #include <LibJS/Forward.h>
 
 namespace JS::Bytecode {
@@ -37,11 +38,16 @@ public:
     void grow(size_t additional_size);
 
     void terminate(Badge<Generator>, Instruction const* terminator) { m_terminator = terminator; }
+    void terminate(Badge<ExecutableCache>, Instruction const* terminator) { m_terminator = terminator; }
     bool is_terminated() const { return m_terminator != nullptr; }
     Instruction const* terminator() const { return m_terminator; }
 
     DeprecatedString const& name() const { return m_name; }
 
+    // Set once the executable this block belongs to has been compiled to native code.
+    JIT::NativeBlockFunction native_code() const { return m_native_code; }
+    void set_native_code(Badge<JIT::Compiler>, JIT::NativeBlockFunction native_code) const { m_native_code = native_code; }
+
 private:
     BasicBlock(DeprecatedString name, size_t size);
 
@@ -50,6 +56,7 @@ private:
     size_t m_buffer_capacity { 0 };
     size_t m_buffer_size { 0 };
     DeprecatedString m_name;
+    mutable JIT::NativeBlockFunction m_native_code { nullptr };
 };
 
 }
@@ -8,9 +8,13 @@
 
 #include <AK/FlyString.h>
 #include <AK/NonnullOwnPtrVector.h>
+#include <AK/NonnullRefPtr.h>
 #include <LibJS/Bytecode/BasicBlock.h>
 #include <LibJS/Bytecode/IdentifierTable.h>
+#include <LibJS/Bytecode/JIT/NativeExecutable.h>
+#include <LibJS/Bytecode/PropertyLookupCache.h>
 #include <LibJS/Bytecode/StringTable.h>
+#include <LibJS/Forward.h>
 
 namespace JS::Bytecode {
 
@@ -19,8 +23,18 @@ struct Executable {
     NonnullOwnPtrVector<BasicBlock> basic_blocks;
     NonnullOwnPtr<StringTable> string_table;
     NonnullOwnPtr<IdentifierTable> identifier_table;
+    // Indexed by the instructions that look up properties by name, and updated as they run.
+    mutable Vector<PropertyLookupCache> property_lookup_caches;
+    // Counts the basic blocks entered until the executable is hot enough to be compiled, see JIT::Compiler.
+    mutable u32 jit_tier_up_counter { 0 };
+    mutable OwnPtr<JIT::NativeExecutable> native_executable;
     size_t number_of_registers { 0 };
     bool is_strict_mode { false };
+    // Executables loaded from an ExecutableCache have no Script to keep their AST alive, so they keep the nodes
+    // of the functions and classes they create themselves.
+    Vector<NonnullRefPtr<ASTNode const>> ast_nodes;
+
+    ~Executable();
 
     DeprecatedString const& get_string(StringTableIndex index) const { return string_table->get(index); }
     FlyString const& get_identifier(IdentifierTableIndex index) const { return identifier_table->get(index); }
@@ -0,0 +1,527 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ByteReader.h>
+#include <AK/Debug.h>
+#include <AK/HashMap.h>
+#include <AK/Hex.h>
+#include <LibCore/Stream.h>
+#include <LibCore/System.h>
+#include <LibCrypto/Hash/SHA2.h>
+#include <LibJS/AST.h>
+#include <LibJS/Bytecode/BasicBlock.h>
+#include <LibJS/Bytecode/Executable.h>
+#include <LibJS/Bytecode/ExecutableCache.h>
+#include <LibJS/Bytecode/Instruction.h>
+#include <LibJS/Bytecode/Op.h>
+#include <LibJS/Parser.h>
+#include <unistd.h>
+
+namespace JS::Bytecode {
+
+// A file is made up of this header, the string and identifier tables, and the basic blocks.
+// Each instruction is stored as its type, followed by its fields if it refers to basic blocks or
+// holds anything that isn't plain data, and otherwise by its length and its bytes.
+//
+// Functions and classes generate their bytecode from their AST as they're called, so those are
+// stored as their source text, which is parsed again when the executable is loaded.
+static constexpr u32 magic = 0x4342534a; // "JSBC"
+// Bump this when an instruction's fields change in a way that doesn't change its size.
+static constexpr u32 format_version = 2;
+static constexpr u32 no_block = NumericLimits<u32>::max();
+// The generator starts a new basic block every few KiB, so anything much larger means the file is damaged.
+static constexpr size_t max_basic_block_size = 1 * MiB;
+
+static constexpr u64 layout_fingerprint()
+{
+    // FNV-1a over the size and alignment of everything that is stored as is.
+    u64 fingerprint = 0xcbf29ce484222325;
+    auto mix = [&](u64 value) {
+        fingerprint = (fingerprint ^ value) * 0x100000001b3;
+    };
+    mix(sizeof(void*));
+    mix(sizeof(Value));
+#define __BYTECODE_OP(op)      \
+    mix(sizeof(Op::op));       \
+    mix(alignof(Op::op));
+    ENUMERATE_BYTECODE_OPS(__BYTECODE_OP)
+#undef __BYTECODE_OP
+    return fingerprint;
+}
+
+static constexpr u32 instruction_type_count()
+{
+    u32 count = 0;
+#define __BYTECODE_OP(op) ++count;
+    ENUMERATE_BYTECODE_OPS(__BYTECODE_OP)
+#undef __BYTECODE_OP
+    return count;
+}
+
+namespace {
+
+class Encoder {
+public:
+    ErrorOr<void> write(ReadonlyBytes bytes) { return m_buffer.try_append(bytes); }
+
+    template<Integral T>
+    ErrorOr<void> write(T value) { return m_buffer.try_append(&value, sizeof(value)); }
+
+    ErrorOr<void> write(StringView string)
+    {
+        TRY(write<u32>(string.length()));
+        return write(string.bytes());
+    }
+
+    ErrorOr<void> write(Value value)
+    {
+        // Cells live in the heap of the VM that generated the executable.
+        if (value.is_cell())
+            return AK::Error::from_string_literal("Executable holds a cell");
+        return write<u64>(value.encoded());
+    }
+
+    ByteBuffer release_buffer() { return move(m_buffer); }
+
+private:
+    ByteBuffer m_buffer;
+};
+
+class Decoder {
+public:
+    explicit Decoder(ReadonlyBytes bytes)
+        : m_bytes(bytes)
+    {
+    }
+
+    bool at_end() const { return m_offset == m_bytes.size(); }
+
+    ErrorOr<ReadonlyBytes> read_bytes(size_t count)
+    {
+        if (count > m_bytes.size() - m_offset)
+            return AK::Error::from_string_literal("Unexpected end of executable");
+        auto bytes = m_bytes.slice(m_offset, count);
+        m_offset += count;
+        return bytes;
+    }
+
+    template<Integral T>
+    ErrorOr<T> read()
+    {
+        auto bytes = TRY(read_bytes(sizeof(T)));
+        T value;
+        ByteReader::load(bytes.data(), value);
+        return value;
+    }
+
+    ErrorOr<StringView> read_string()
+    {
+        auto length = TRY(read<u32>());
+        return StringView { TRY(read_bytes(length)) };
+    }
+
+    ErrorOr<Value> read_value()
+    {
+        auto encoded = TRY(read<u64>());
+        auto value = bit_cast<Value>(encoded);
+        if (value.is_cell())
+            return AK::Error::from_string_literal("Executable holds a cell");
+        return value;
+    }
+
+private:
+    ReadonlyBytes m_bytes;
+    size_t m_offset { 0 };
+};
+
+}
+
+static ErrorOr<void> encode_instruction(Encoder& encoder, Instruction const& instruction, HashMap<BasicBlock const*, u32> const& block_indices)
+{
+    auto write_label = [&](Optional<Label> const& label) {
+        return encoder.write<u32>(label.has_value() ? block_indices.get(&label->block()).value() : no_block);
+    };
+
+    TRY(encoder.write<u32>(to_underlying(instruction.type())));
+    switch (instruction.type()) {
+    case Instruction::Type::Jump:
+    case Instruction::Type::JumpConditional:
+    case Instruction::Type::JumpNullish:
+    case Instruction::Type::JumpUndefined: {
+        auto& jump = static_cast<Op::Jump const&>(instruction);
+        TRY(write_label(jump.true_target()));
+        return write_label(jump.false_target());
+    }
+    case Instruction::Type::EnterUnwindContext: {
+        auto& enter = static_cast<Op::EnterUnwindContext const&>(instruction);
+        TRY(write_label(enter.entry_point()));
+        TRY(write_label(enter.handler_target()));
+        return write_label(enter.finalizer_target());
+    }
+    case Instruction::Type::ContinuePendingUnwind:
+        return write_label(static_cast<Op::ContinuePendingUnwind const&>(instruction).resume_target());
+    case Instruction::Type::Yield:
+        return write_label(static_cast<Op::Yield const&>(instruction).continuation());
+    case Instruction::Type::LoadImmediate:
+        return encoder.write(static_cast<Op::LoadImmediate const&>(instruction).value());
+    case Instruction::Type::IteratorClose: {
+        auto& close = static_cast<Op::IteratorClose const&>(instruction);
+        TRY(encoder.write<u32>(to_underlying(close.completion_type())));
+        TRY(encoder.write<u8>(close.completion_value().has_value()));
+        if (close.completion_value().has_value())
+            TRY(encoder.write(*close.completion_value()));
+        return {};
+    }
+    case Instruction::Type::GetVariable:
+        // Leaves out the environment coordinate it may have cached.
+        return encoder.write<u64>(static_cast<Op::GetVariable const&>(instruction).identifier().value());
+    case Instruction::Type::NewBigInt:
+        return encoder.write(static_cast<Op::NewBigInt const&>(instruction).bigint().to_base(10).view());
+    case Instruction::Type::NewClass: {
+        auto& class_expression = static_cast<Op::NewClass const&>(instruction).class_expression();
+        TRY(encoder.write(class_expression.source_text().view()));
+        return encoder.write(class_expression.name());
+    }
+    case Instruction::Type::NewFunction: {
+        auto& function_node = static_cast<Op::NewFunction const&>(instruction).function_node();
+        TRY(encoder.write(function_node.source_text().view()));
+        TRY(encoder.write(function_node.name().view()));
+        return encoder.write<u8>(function_node.is_strict_mode());
+    }
+    case Instruction::Type::PushDeclarativeEnvironment:
+        return AK::Error::from_string_literal("Executable holds variables");
+    default:
+        // Everything else is plain data.
+        TRY(encoder.write<u32>(instruction.length()));
+        return encoder.write({ &instruction, instruction.length() });
+    }
+}
+
+template<typename OpType, typename... Args>
+static ErrorOr<void> append_instruction(BasicBlock& block, Args&&... args)
+{
+    if (!block.can_grow(sizeof(OpType)))
+        return AK::Error::from_string_literal("Instruction doesn't fit its basic block");
+    auto* slot = block.next_slot();
+    block.grow(sizeof(OpType));
+    new (slot) OpType(forward<Args>(args)...);
+    return {};
+}
+
+// Parses the source text of a function or class on its own, and returns the expression made of it.
+static RefPtr<Expression const> parse_expression(StringView prefix, StringView source_text, StringView suffix, bool starts_in_strict_mode)
+{
+    auto source = DeprecatedString::formatted("{}{}{}", prefix, source_text, suffix);
+    auto parser = Parser(Lexer(source));
+    auto program = parser.parse_program(starts_in_strict_mode);
+    if (parser.has_errors() || program->children().size() != 1 || !is<ExpressionStatement>(program->children()[0]))
+        return {};
+    return static_cast<ExpressionStatement const&>(program->children()[0]).expression();
+}
+
+// NOTE: Anonymous functions and classes have a null name, but what we read back is merely empty.
+static bool is_same_name(StringView name, StringView other_name)
+{
+    return name.is_empty() ? other_name.is_empty() : name == other_name;
+}
+
+static ErrorOr<NonnullRefPtr<FunctionExpression const>> parse_function(StringView source_text, StringView name, bool is_strict_mode)
+{
+    auto is_same_function = [&](Expression const* expression) {
+        if (!expression || !is<FunctionExpression>(*expression))
+            return false;
+        auto& function = static_cast<FunctionExpression const&>(*expression);
+        return function.source_text() == source_text && is_same_name(function.name(), name) && function.is_strict_mode() == is_strict_mode;
+    };
+
+    // NOTE: Function declarations come back as function expressions, which is all that NewFunction needs.
+    auto expression = parse_expression("("sv, source_text, ")"sv, is_strict_mode);
+    if (is_same_function(expression.ptr()))
+        return static_cast<FunctionExpression const&>(*expression);
+
+    // Methods of object literals only parse as part of one.
+    expression = parse_expression("({"sv, source_text, "})"sv, is_strict_mode);
+    if (expression && is<ObjectExpression>(*expression)) {
+        auto& properties = static_cast<ObjectExpression const&>(*expression).properties();
+        if (properties.size() == 1 && is_same_function(&properties[0].value()))
+            return static_cast<FunctionExpression const&>(properties[0].value());
+    }
+    return AK::Error::from_string_literal("Function doesn't parse the same on its own");
+}
+
+static ErrorOr<NonnullRefPtr<ClassExpression const>> parse_class(StringView source_text, StringView name)
+{
+    // NOTE: All parts of a class are strict mode code.
+    auto expression = parse_expression("("sv, source_text, ")"sv, true);
+    if (!expression || !is<ClassExpression>(*expression))
+        return AK::Error::from_string_literal("Class doesn't parse the same on its own");
+    auto& class_expression = static_cast<ClassExpression const&>(*expression);
+    if (class_expression.source_text() != source_text || !is_same_name(class_expression.name(), name))
+        return AK::Error::from_string_literal("Class doesn't parse the same on its own");
+    return class_expression;
+}
+
+static ErrorOr<void> decode_instruction(Decoder& decoder, BasicBlock& block, NonnullOwnPtrVector<BasicBlock> const& blocks, Vector<NonnullRefPtr<ASTNode const>>& ast_nodes)
+{
+    auto read_label = [&]() -> ErrorOr<Optional<Label>> {
+        auto index = TRY(decoder.read<u32>());
+        if (index == no_block)
+            return Optional<Label> {};
+        if (index >= blocks.size())
+            return AK::Error::from_string_literal("Label refers to a basic block that doesn't exist");
+        return Label { blocks[index] };
+    };
+    auto read_required_label = [&]() -> ErrorOr<Label> {
+        auto label = TRY(read_label());
+        if (!label.has_value())
+            return AK::Error::from_string_literal("Instruction is missing a label");
+        return *label;
+    };
+
+    auto type_value = TRY(decoder.read<u32>());
+    if (type_value >= instruction_type_count())
+        return AK::Error::from_string_literal("Unknown instruction type");
+    auto type = static_cast<Instruction::Type>(type_value);
+
+    switch (type) {
+    case Instruction::Type::Jump: {
+        auto true_target = TRY(read_label());
+        return append_instruction<Op::Jump>(block, move(true_target), TRY(read_label()));
+    }
+    case Instruction::Type::JumpConditional: {
+        auto true_target = TRY(read_label());
+        return append_instruction<Op::JumpConditional>(block, move(true_target), TRY(read_label()));
+    }
+    case Instruction::Type::JumpNullish: {
+        auto true_target = TRY(read_label());
+        return append_instruction<Op::JumpNullish>(block, move(true_target), TRY(read_label()));
+    }
+    case Instruction::Type::JumpUndefined: {
+        auto true_target = TRY(read_label());
+        return append_instruction<Op::JumpUndefined>(block, move(true_target), TRY(read_label()));
+    }
+    case Instruction::Type::EnterUnwindContext: {
+        auto entry_point = TRY(read_required_label());
+        auto handler_target = TRY(read_label());
+        return append_instruction<Op::EnterUnwindContext>(block, entry_point, move(handler_target), TRY(read_label()));
+    }
+    case Instruction::Type::ContinuePendingUnwind:
+        return append_instruction<Op::ContinuePendingUnwind>(block, TRY(read_required_label()));
+    case Instruction::Type::Yield: {
+        auto continuation = TRY(read_label());
+        if (continuation.has_value())
+            return append_instruction<Op::Yield>(block, *continuation);
+        return append_instruction<Op::Yield>(block, nullptr);
+    }
+    case Instruction::Type::LoadImmediate:
+        return append_instruction<Op::LoadImmediate>(block, TRY(decoder.read_value()));
+    case Instruction::Type::IteratorClose: {
+        auto completion_type = TRY(decoder.read<u32>());
+        if (completion_type > to_underlying(Completion::Type::Throw))
+            return AK::Error::from_string_literal("Unknown completion type");
+        Optional<Value> completion_value;
+        if (TRY(decoder.read<u8>()))
+            completion_value = TRY(decoder.read_value());
+        return append_instruction<Op::IteratorClose>(block, static_cast<Completion::Type>(completion_type), completion_value);
+    }
+    case Instruction::Type::GetVariable:
+        return append_instruction<Op::GetVariable>(block, IdentifierTableIndex { TRY(decoder.read<u64>()) });
+    case Instruction::Type::NewBigInt:
+        return append_instruction<Op::NewBigInt>(block, Crypto::SignedBigInteger::from_base(10, TRY(decoder.read_string())));
+    case Instruction::Type::NewClass: {
+        auto source_text = TRY(decoder.read_string());
+        auto class_expression = TRY(parse_class(source_text, TRY(decoder.read_string())));
+        TRY(ast_nodes.try_append(class_expression));
+        return append_instruction<Op::NewClass>(block, *class_expression);
+    }
+    case Instruction::Type::NewFunction: {
+        auto source_text = TRY(decoder.read_string());
+        auto name = TRY(decoder.read_string());
+        auto function_expression = TRY(parse_function(source_text, name, TRY(decoder.read<u8>()) != 0));
+        TRY(ast_nodes.try_append(function_expression));
+        return append_instruction<Op::NewFunction>(block, static_cast<FunctionNode const&>(*function_expression));
+    }
+    case Instruction::Type::PushDeclarativeEnvironment:
+        return AK::Error::from_string_literal("Instruction can't be stored");
+    default:
+        break;
+    }
+
+    auto length = TRY(decoder.read<u32>());
+    auto bytes = TRY(decoder.read_bytes(length));
+    if (length < sizeof(Instruction) || !block.can_grow(length))
+        return AK::Error::from_string_literal("Instruction has an invalid length");
+    auto* slot = block.next_slot();
+    bytes.copy_to({ slot, length });
+    auto& instruction = *static_cast<Instruction const*>(slot);
+    if (instruction.type() != type || instruction.length() != length)
+        return AK::Error::from_string_literal("Instruction doesn't match its type");
+    block.grow(length);
+    return {};
+}
+
+ErrorOr<ByteBuffer> ExecutableCache::serialize(Executable const& executable)
+{
+    Encoder encoder;
+    TRY(encoder.write<u32>(magic));
+    TRY(encoder.write<u32>(format_version));
+    TRY(encoder.write<u64>(layout_fingerprint()));
+    TRY(encoder.write<u8>(executable.is_strict_mode));
+    TRY(encoder.write<u64>(executable.number_of_registers));
+    TRY(encoder.write<u64>(executable.property_lookup_caches.size()));
+
+    TRY(encoder.write<u32>(executable.string_table->size()));
+    for (size_t i = 0; i < executable.string_table->size(); ++i)
+        TRY(encoder.write(executable.get_string(i).view()));
+    TRY(encoder.write<u32>(executable.identifier_table->size()));
+    for (size_t i = 0; i < executable.identifier_table->size(); ++i)
+        TRY(encoder.write(executable.get_identifier(i).view()));
+
+    HashMap<BasicBlock const*, u32> block_indices;
+    for (size_t i = 0; i < executable.basic_blocks.size(); ++i)
+        TRY(block_indices.try_set(&executable.basic_blocks[i], i));
+
+    // All the blocks come first, so they exist by the time the instructions that jump to them are read.
+    TRY(encoder.write<u32>(executable.basic_blocks.size()));
+    for (auto& block : executable.basic_blocks) {
+        TRY(encoder.write(block.name().view()));
+        TRY(encoder.write<u64>(block.size()));
+    }
+    for (auto& block : executable.basic_blocks) {
+        u32 instruction_count = 0;
+        for (InstructionStreamIterator it(block.instruction_stream()); !it.at_end(); ++it)
+            ++instruction_count;
+        TRY(encoder.write<u32>(instruction_count));
+        for (InstructionStreamIterator it(block.instruction_stream()); !it.at_end(); ++it)
+            TRY(encode_instruction(encoder, *it, block_indices));
+    }
+
+    return encoder.release_buffer();
+}
+
+ErrorOr<NonnullOwnPtr<Executable>> ExecutableCache::deserialize(ReadonlyBytes bytes)
+{
+    Decoder decoder(bytes);
+    if (TRY(decoder.read<u32>()) != magic)
+        return AK::Error::from_string_literal("Not a bytecode executable");
+    if (TRY(decoder.read<u32>()) != format_version || TRY(decoder.read<u64>()) != layout_fingerprint())
+        return AK::Error::from_string_literal("Executable was written by a different build");
+
+    auto is_strict_mode = TRY(decoder.read<u8>()) != 0;
+    auto number_of_registers = TRY(decoder.read<u64>());
+    auto property_lookup_cache_count = TRY(decoder.read<u64>());
+    // Each cache belongs to an instruction, which takes up more than a byte of the file.
+    if (property_lookup_cache_count > bytes.size())
+        return AK::Error::from_string_literal("Executable has too many property lookup caches");
+    Vector<PropertyLookupCache> property_lookup_caches;
+    TRY(property_lookup_caches.try_resize(property_lookup_cache_count));
+
+    auto string_table = TRY(adopt_nonnull_own_or_enomem(new (nothrow) StringTable));
+    auto string_count = TRY(decoder.read<u32>());
+    for (u32 i = 0; i < string_count; ++i) {
+        if (string_table->insert(TRY(decoder.read_string())).value() != i)
+            return AK::Error::from_string_literal("String table has duplicates");
+    }
+    auto identifier_table = TRY(adopt_nonnull_own_or_enomem(new (nothrow) IdentifierTable));
+    auto identifier_count = TRY(decoder.read<u32>());
+    for (u32 i = 0; i < identifier_count; ++i) {
+        if (identifier_table->insert(TRY(decoder.read_string())).value() != i)
+            return AK::Error::from_string_literal("Identifier table has duplicates");
+    }
+
+    NonnullOwnPtrVector<BasicBlock> basic_blocks;
+    Vector<size_t> block_sizes;
+    Vector<NonnullRefPtr<ASTNode const>> ast_nodes;
+    auto block_count = TRY(decoder.read<u32>());
+    for (u32 i = 0; i < block_count; ++i) {
+        auto name = TRY(decoder.read_string());
+        auto size = TRY(decoder.read<u64>());
+        if (size > max_basic_block_size)
+            return AK::Error::from_string_literal("Basic block is too large");
+        TRY(basic_blocks.try_append(BasicBlock::create(name, size)));
+        TRY(block_sizes.try_append(size));
+    }
+    for (u32 i = 0; i < block_count; ++i) {
+        auto& block = basic_blocks[i];
+        auto instruction_count = TRY(decoder.read<u32>());
+        for (u32 j = 0; j < instruction_count; ++j)
+            TRY(decode_instruction(decoder, block, basic_blocks, ast_nodes));
+        if (block.size() != block_sizes[i])
+            return AK::Error::from_string_literal("Basic block has the wrong size");
+
+        for (InstructionStreamIterator it(block.instruction_stream()); !it.at_end(); ++it) {
+            if ((*it).is_terminator()) {
+                block.terminate(Badge<ExecutableCache> {}, &*it);
+                break;
+            }
+        }
+        block.seal();
+    }
+    if (!decoder.at_end())
+        return AK::Error::from_string_literal("Executable has trailing data");
+
+    return TRY(adopt_nonnull_own_or_enomem(new (nothrow) Executable {
+        .name = {},
+        .basic_blocks = move(basic_blocks),
+        .string_table = move(string_table),
+        .identifier_table = move(identifier_table),
+        .property_lookup_caches = move(property_lookup_caches),
+        .jit_tier_up_counter = 0,
+        .native_executable = {},
+        .number_of_registers = number_of_registers,
+        .is_strict_mode = is_strict_mode,
+        .ast_nodes = move(ast_nodes) }));
+}
+
+ExecutableCache::ExecutableCache(DeprecatedString directory)
+    : m_directory(move(directory))
+{
+}
+
+DeprecatedString ExecutableCache::path_for(StringView source) const
+{
+    auto digest = Crypto::Hash::SHA256::hash(source);
+    return DeprecatedString::formatted("{}/{}.jsbc", m_directory, encode_hex(digest.bytes()));
+}
+
+OwnPtr<Executable> ExecutableCache::load(StringView source) const
+{
+    auto path = path_for(source);
+    auto file = Core::Stream::File::open(path, Core::Stream::OpenMode::Read);
+    if (file.is_error())
+        return {};
+    auto bytes = file.value()->read_until_eof();
+    if (bytes.is_error())
+        return {};
+    auto executable = deserialize(bytes.value());
+    if (executable.is_error()) {
+        dbgln_if(JS_BYTECODE_DEBUG, "Bytecode::ExecutableCache: Ignoring {}: {}", path, executable.error());
+        return {};
+    }
+    return executable.release_value();
+}
+
+ErrorOr<void> ExecutableCache::store(StringView source, Executable const& executable) const
+{
+    auto bytes = TRY(serialize(executable));
+    auto path = path_for(source);
+    // Other processes may be reading the same file, so it only appears once it's complete.
+    auto temporary_path = DeprecatedString::formatted("{}.{}", path, getpid());
+    {
+        auto file = TRY(Core::Stream::File::open(temporary_path, Core::Stream::OpenMode::Write | Core::Stream::OpenMode::Truncate));
+        auto result = file->write_entire_buffer(bytes);
+        if (result.is_error()) {
+            (void)Core::System::unlink(temporary_path);
+            return result.release_error();
+        }
+    }
+    auto result = Core::System::rename(temporary_path, path);
+    if (result.is_error())
+        (void)Core::System::unlink(temporary_path);
+    return result;
+}
+
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/ByteBuffer.h>
+#include <AK/DeprecatedString.h>
+#include <AK/Error.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/OwnPtr.h>
+#include <LibJS/Forward.h>
+
+namespace JS::Bytecode {
+
+// Keeps the bytecode generated for scripts on disk, so that running the same script again skips
+// parsing it and generating its bytecode. Each executable is stored in a file named after the
+// SHA-256 digest of the source it was generated from, as it was generated, before it was optimized
+// or run.
+//
+// Functions and classes generate their bytecode from their AST as they run, so the executables that
+// create them keep their source text, and parse it again when they're loaded. Only those are parsed
+// again, and only their own bytecode is generated when they're first called.
+//
+// Most instructions are stored as they are laid out in memory, so only the build of LibJS that
+// wrote a file can read it, and files from any other layout are ignored. Beyond that, files aren't
+// validated, so the cache directory has to be as trusted as the program itself.
+class ExecutableCache {
+public:
+    explicit ExecutableCache(DeprecatedString directory);
+
+    // Returns the executable generated from this exact source before, if there is one.
+    OwnPtr<Executable> load(StringView source) const;
+    ErrorOr<void> store(StringView source, Executable const&) const;
+
+    static ErrorOr<ByteBuffer> serialize(Executable const&);
+    static ErrorOr<NonnullOwnPtr<Executable>> deserialize(ReadonlyBytes);
+
+private:
+    DeprecatedString path_for(StringView source) const;
+
+    DeprecatedString m_directory;
+};
+
+}
@@ -57,7 +57,7 @@ public:
         grow(sizeof(OpType));
         new (slot) OpType(forward<Args>(args)...);
         if constexpr (OpType::IsTerminator)
-            m_current_basic_block->terminate({}, static_cast<Instruction const*>(slot));
+            m_current_basic_block->terminate(Badge<Generator> {}, static_cast<Instruction const*>(slot));
         return *static_cast<OpType*>(slot);
     }
 
@@ -76,7 +76,7 @@ public:
         grow(size_to_allocate);
         new (slot) OpType(forward<Args>(args)...);
         if constexpr (OpType::IsTerminator)
-            m_current_basic_block->terminate({}, static_cast<Instruction const*>(slot));
+            m_current_basic_block->terminate(Badge<Generator> {}, static_cast<Instruction const*>(slot));
         return *static_cast<OpType*>(slot);
     }
 
@@ -122,6 +122,9 @@ public:
         return m_identifier_table->insert(move(string));
     }
 
+    // Each instruction that looks up a property by name gets its own cache in the Executable.
+    u32 next_property_lookup_cache() { return m_next_property_lookup_cache++; }
+
     bool is_in_generator_or_async_function() const { return m_enclosing_function_kind == FunctionKind::Async || m_enclosing_function_kind == FunctionKind::Generator; }
     bool is_in_generator_function() const { return m_enclosing_function_kind == FunctionKind::Generator; }
     bool is_in_async_function() const { return m_enclosing_function_kind == FunctionKind::Async; }
@@ -242,6 +245,7 @@ private:
 
     u32 m_next_register { 2 };
     u32 m_next_block { 1 };
+    u32 m_next_property_lookup_cache { 0 };
     FunctionKind m_enclosing_function_kind { FunctionKind::Normal };
     Vector<LabelableScope> m_continuable_scopes;
     Vector<LabelableScope> m_breakable_scopes;
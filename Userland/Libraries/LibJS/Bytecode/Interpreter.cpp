@@ -9,6 +9,7 @@
 #include <LibJS/Bytecode/BasicBlock.h>
 #include <LibJS/Bytecode/Instruction.h>
 #include <LibJS/Bytecode/Interpreter.h>
+#include <LibJS/Bytecode/JIT/Compiler.h>
 #include <LibJS/Bytecode/Op.h>
 #include <LibJS/Interpreter.h>
 #include <LibJS/Runtime/GlobalEnvironment.h>
@@ -76,9 +77,20 @@ Interpreter::ValueAndFrame Interpreter::run_and_return_frame(Executable const& e
 
         bool will_jump = false;
         bool will_return = false;
+        if (JIT::g_jit_enabled && !m_current_block->native_code())
+            JIT::Compiler::did_enter_block(executable);
+        auto* native_code = JIT::g_jit_enabled ? m_current_block->native_code() : nullptr;
         while (!pc.at_end()) {
-            auto& instruction = *pc;
-            auto ran_or_error = instruction.execute(*this);
+            ThrowCompletionOr<void> ran_or_error;
+            if (native_code) {
+                // The native code runs the whole block, or up to the instruction that we have to handle below.
+                pc.jump(native_code(*this, registers().data()));
+                native_code = nullptr;
+                if (m_native_code_exception.has_value())
+                    ran_or_error = m_native_code_exception.release_value();
+            } else {
+                ran_or_error = (*pc).execute(*this);
+            }
             if (ran_or_error.is_error()) {
                 auto exception_value = *ran_or_error.throw_completion().value();
                 m_saved_exception = make_handle(exception_value);
@@ -61,6 +61,10 @@ public:
     }
     void do_return(Value return_value) { m_return_value = return_value; }
 
+    // Native code runs instructions until one of them throws, or wants to jump or return.
+    bool should_leave_native_code() const { return m_pending_jump.has_value() || !m_return_value.is_empty(); }
+    void did_throw_in_native_code(Completion completion) { m_native_code_exception = move(completion); }
+
     void enter_unwind_context(Optional<Label> handler_target, Optional<Label> finalizer_target);
     void leave_unwind_context();
     ThrowCompletionOr<void> continue_pending_unwind(Label const& resume_label);
@@ -109,6 +113,7 @@ private:
     OwnPtr<JS::Interpreter> m_ast_interpreter;
     BasicBlock const* m_current_block { nullptr };
     InstructionStreamIterator* m_pc { nullptr };
+    Optional<Completion> m_native_code_exception;
 };
 
 extern bool g_dump_bytecode;
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Error.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
+
+namespace JS::Bytecode::JIT {
+
+// Just enough of an x86-64 assembler for JIT::Compiler. All moves are 64 bits wide.
+class Assembler {
+public:
+    enum class Reg : u8 {
+        RAX = 0,
+        RCX = 1,
+        RDX = 2,
+        RBX = 3,
+        RSP = 4,
+        RBP = 5,
+        RSI = 6,
+        RDI = 7,
+        R12 = 12,
+        R13 = 13,
+    };
+
+    // The offset of a rel32 field in the output that is to be patched once its target is known.
+    struct Patch {
+        size_t offset { 0 };
+    };
+
+    explicit Assembler(Vector<u8>& output)
+        : m_output(output)
+    {
+    }
+
+    size_t position() const { return m_output.size(); }
+
+    ErrorOr<void> push(Reg reg)
+    {
+        if (is_extended(reg))
+            TRY(emit8(0x41));
+        return emit8(0x50 | encoding(reg));
+    }
+
+    ErrorOr<void> pop(Reg reg)
+    {
+        if (is_extended(reg))
+            TRY(emit8(0x41));
+        return emit8(0x58 | encoding(reg));
+    }
+
+    ErrorOr<void> ret() { return emit8(0xc3); }
+
+    // mov dst, src
+    ErrorOr<void> mov(Reg dst, Reg src)
+    {
+        TRY(emit_rex_w(src, dst));
+        TRY(emit8(0x89));
+        return emit8(0xc0 | (encoding(src) << 3) | encoding(dst));
+    }
+
+    // mov dst, imm64
+    ErrorOr<void> mov(Reg dst, u64 imm)
+    {
+        TRY(emit8(0x48 | (is_extended(dst) ? 0x01 : 0)));
+        TRY(emit8(0xb8 | encoding(dst)));
+        return emit64(imm);
+    }
+
+    // mov eax, imm32, which zero-extends into rax.
+    ErrorOr<void> mov_eax(u32 imm)
+    {
+        TRY(emit8(0xb8));
+        return emit32(imm);
+    }
+
+    // mov dst, [base + displacement]
+    ErrorOr<void> load(Reg dst, Reg base, i32 displacement)
+    {
+        TRY(emit_rex_w(dst, base));
+        TRY(emit8(0x8b));
+        return emit_memory_operand(dst, base, displacement);
+    }
+
+    // mov [base + displacement], src
+    ErrorOr<void> store(Reg base, i32 displacement, Reg src)
+    {
+        TRY(emit_rex_w(src, base));
+        TRY(emit8(0x89));
+        return emit_memory_operand(src, base, displacement);
+    }
+
+    // call reg
+    ErrorOr<void> call(Reg reg)
+    {
+        if (is_extended(reg))
+            TRY(emit8(0x41));
+        TRY(emit8(0xff));
+        return emit8(0xd0 | encoding(reg));
+    }
+
+    // test al, al
+    ErrorOr<void> test_al() { return emit16(0xc084); }
+
+    // jnz over the next `length` bytes.
+    ErrorOr<void> jump_if_not_zero_over(u8 length)
+    {
+        VERIFY(length < 0x80);
+        TRY(emit8(0x75));
+        return emit8(length);
+    }
+
+    // jmp rel32, to be linked later.
+    ErrorOr<Patch> jump()
+    {
+        TRY(emit8(0xe9));
+        Patch patch { position() };
+        TRY(emit32(0));
+        return patch;
+    }
+
+    void link(Patch patch, size_t target)
+    {
+        auto relative = static_cast<i64>(target) - static_cast<i64>(patch.offset + sizeof(u32));
+        VERIFY(relative >= NumericLimits<i32>::min() && relative <= NumericLimits<i32>::max());
+        auto value = static_cast<u32>(static_cast<i32>(relative));
+        for (size_t i = 0; i < sizeof(u32); ++i)
+            m_output[patch.offset + i] = static_cast<u8>(value >> (i * 8));
+    }
+
+private:
+    static bool is_extended(Reg reg) { return to_underlying(reg) >= 8; }
+    static u8 encoding(Reg reg) { return to_underlying(reg) & 7; }
+
+    ErrorOr<void> emit_rex_w(Reg reg, Reg rm)
+    {
+        return emit8(0x48 | (is_extended(reg) ? 0x04 : 0) | (is_extended(rm) ? 0x01 : 0));
+    }
+
+    // ModRM with a 32-bit displacement. RSP and R12 as a base can only be encoded with a SIB byte.
+    ErrorOr<void> emit_memory_operand(Reg reg, Reg base, i32 displacement)
+    {
+        TRY(emit8(0x80 | (encoding(reg) << 3) | encoding(base)));
+        if (encoding(base) == encoding(Reg::RSP))
+            TRY(emit8(0x24));
+        return emit32(static_cast<u32>(displacement));
+    }
+
+    ErrorOr<void> emit8(u8 value) { return m_output.try_append(value); }
+    ErrorOr<void> emit16(u16 value)
+    {
+        TRY(emit8(value & 0xff));
+        return emit8(value >> 8);
+    }
+    ErrorOr<void> emit32(u32 value)
+    {
+        TRY(emit16(value & 0xffff));
+        return emit16(value >> 16);
+    }
+    ErrorOr<void> emit64(u64 value)
+    {
+        TRY(emit32(value & 0xffffffff));
+        return emit32(value >> 32);
+    }
+
+    Vector<u8>& m_output;
+};
+
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Debug.h>
+#include <AK/Platform.h>
+#include <LibJS/Bytecode/BasicBlock.h>
+#include <LibJS/Bytecode/Executable.h>
+#include <LibJS/Bytecode/Instruction.h>
+#include <LibJS/Bytecode/Interpreter.h>
+#include <LibJS/Bytecode/JIT/Assembler.h>
+#include <LibJS/Bytecode/JIT/Compiler.h>
+#include <LibJS/Bytecode/Op.h>
+#include <errno.h>
+
+namespace JS::Bytecode::JIT {
+
+// Serenity only lets processes map executable memory with the "prot_exec" promise, which our
+// JavaScript hosts don't pledge, so there is no JIT there until they do.
+#if ARCH(X86_64) && !defined(AK_OS_SERENITY)
+bool g_jit_enabled = true;
+#else
+bool g_jit_enabled = false;
+#endif
+
+bool Compiler::is_supported()
+{
+#if ARCH(X86_64)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Compiler::did_enter_block(Executable const& executable)
+{
+    if (executable.jit_tier_up_counter > tier_up_threshold)
+        return;
+    if (++executable.jit_tier_up_counter <= tier_up_threshold)
+        return;
+    // If compiling fails, we just keep interpreting, and won't try again.
+    auto native_executable = compile(executable);
+    if (native_executable.is_error()) {
+        dbgln_if(JS_BYTECODE_DEBUG, "JIT: Could not compile {}: {}", executable.name, native_executable.error());
+        return;
+    }
+    executable.native_executable = native_executable.release_value();
+}
+
+// Native code calls these to run the instructions it doesn't do itself. They return whether
+// the native code may go on to the next instruction.
+template<typename OpType>
+static bool run_instruction(Interpreter& interpreter, OpType const& instruction)
+{
+    auto result = instruction.execute_impl(interpreter);
+    if (result.is_error()) {
+        interpreter.did_throw_in_native_code(result.release_error());
+        return false;
+    }
+    return !interpreter.should_leave_native_code();
+}
+
+static FlatPtr run_instruction_function(Instruction const& instruction)
+{
+#define __BYTECODE_OP(op)       \
+    case Instruction::Type::op: \
+        return bit_cast<FlatPtr>(&run_instruction<Op::op>);
+
+    switch (instruction.type()) {
+        ENUMERATE_BYTECODE_OPS(__BYTECODE_OP)
+    default:
+        VERIFY_NOT_REACHED();
+    }
+
+#undef __BYTECODE_OP
+}
+
+using Reg = Assembler::Reg;
+
+// While a block runs, these hold the arguments the native code was called with.
+static constexpr Reg interpreter_reg = Reg::RBX;
+static constexpr Reg registers_reg = Reg::R12;
+
+static ErrorOr<i32> register_displacement(Register reg)
+{
+    if (reg.index() > NumericLimits<i32>::max() / sizeof(Value))
+        return AK::Error::from_string_literal("Register index is too large to address");
+    return static_cast<i32>(reg.index() * sizeof(Value));
+}
+
+static ErrorOr<void> compile_instruction(Assembler& assembler, Instruction const& instruction, size_t offset, Vector<Assembler::Patch>& exits)
+{
+    switch (instruction.type()) {
+    case Instruction::Type::Load: {
+        auto& load = static_cast<Op::Load const&>(instruction);
+        TRY(assembler.load(Reg::RAX, registers_reg, TRY(register_displacement(load.src()))));
+        return assembler.store(registers_reg, TRY(register_displacement(Register::accumulator())), Reg::RAX);
+    }
+    case Instruction::Type::LoadImmediate: {
+        auto& load_immediate = static_cast<Op::LoadImmediate const&>(instruction);
+        TRY(assembler.mov(Reg::RAX, load_immediate.value().encoded()));
+        return assembler.store(registers_reg, TRY(register_displacement(Register::accumulator())), Reg::RAX);
+    }
+    case Instruction::Type::Store: {
+        auto& store = static_cast<Op::Store const&>(instruction);
+        TRY(assembler.load(Reg::RAX, registers_reg, TRY(register_displacement(Register::accumulator()))));
+        return assembler.store(registers_reg, TRY(register_displacement(store.dst())), Reg::RAX);
+    }
+    default:
+        break;
+    }
+
+    // if (!run_instruction<Op>(interpreter, instruction)) return offset;
+    TRY(assembler.mov(Reg::RDI, interpreter_reg));
+    TRY(assembler.mov(Reg::RSI, bit_cast<FlatPtr>(&instruction)));
+    TRY(assembler.mov(Reg::RAX, run_instruction_function(instruction)));
+    TRY(assembler.call(Reg::RAX));
+    TRY(assembler.test_al());
+    // Skips the mov eax, imm32 (5 bytes) and jmp rel32 (5 bytes) below.
+    TRY(assembler.jump_if_not_zero_over(10));
+    TRY(assembler.mov_eax(static_cast<u32>(offset)));
+    TRY(exits.try_append(TRY(assembler.jump())));
+    return {};
+}
+
+ErrorOr<NonnullOwnPtr<NativeExecutable>> Compiler::compile(Executable const& executable)
+{
+    if (!is_supported())
+        return AK::Error::from_errno(ENOTSUP);
+
+    Vector<u8> code;
+    Assembler assembler(code);
+    Vector<size_t> block_entries;
+    TRY(block_entries.try_ensure_capacity(executable.basic_blocks.size()));
+    Vector<Assembler::Patch> exits;
+
+    for (auto& block : executable.basic_blocks) {
+        block_entries.unchecked_append(assembler.position());
+
+        // One callee-saved register more than we need keeps the stack 16-byte aligned for calls.
+        TRY(assembler.push(Reg::RBX));
+        TRY(assembler.push(Reg::R12));
+        TRY(assembler.push(Reg::R13));
+        TRY(assembler.mov(interpreter_reg, Reg::RDI));
+        TRY(assembler.mov(registers_reg, Reg::RSI));
+
+        size_t last_offset = 0;
+        InstructionStreamIterator it(block.instruction_stream());
+        while (!it.at_end()) {
+            last_offset = it.offset();
+            TRY(compile_instruction(assembler, *it, last_offset, exits));
+            ++it;
+        }
+
+        TRY(assembler.mov_eax(static_cast<u32>(last_offset)));
+        TRY(exits.try_append(TRY(assembler.jump())));
+    }
+
+    // All blocks share the one epilogue.
+    auto epilogue = assembler.position();
+    TRY(assembler.pop(Reg::R13));
+    TRY(assembler.pop(Reg::R12));
+    TRY(assembler.pop(Reg::RBX));
+    TRY(assembler.ret());
+    for (auto& exit : exits)
+        assembler.link(exit, epilogue);
+
+    auto native_executable = TRY(NativeExecutable::create(code));
+    for (size_t i = 0; i < executable.basic_blocks.size(); ++i)
+        executable.basic_blocks[i].set_native_code({}, native_executable->function_at(block_entries[i]));
+
+    dbgln_if(JS_BYTECODE_DEBUG, "JIT: Compiled {} into {} bytes of native code", executable.name, code.size());
+    return native_executable;
+}
+
+}
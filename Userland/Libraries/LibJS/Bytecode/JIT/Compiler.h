@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Error.h>
+#include <AK/NonnullOwnPtr.h>
+#include <LibJS/Bytecode/JIT/NativeExecutable.h>
+#include <LibJS/Forward.h>
+
+namespace JS::Bytecode::JIT {
+
+// A baseline compiler from bytecode to x86-64 machine code. Each basic block becomes a straight line
+// of code that moves values between registers inline, and calls the interpreter's implementation of
+// every other instruction, so nothing about how instructions behave changes. What goes away is the
+// interpreter's dispatch between instructions.
+class Compiler {
+public:
+    // How many basic blocks of an executable the interpreter enters before compiling it.
+    static constexpr u32 tier_up_threshold = 1000;
+
+    static bool is_supported();
+
+    // Called by the interpreter whenever it enters a basic block that has no native code yet.
+    // Compiles the executable once it has become hot enough.
+    static void did_enter_block(Executable const&);
+
+    // On success, every basic block of the executable has its native_code().
+    static ErrorOr<NonnullOwnPtr<NativeExecutable>> compile(Executable const&);
+};
+
+extern bool g_jit_enabled;
+
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibJS/Bytecode/JIT/NativeExecutable.h>
+#include <errno.h>
+#include <sys/mman.h>
+
+namespace JS::Bytecode::JIT {
+
+ErrorOr<NonnullOwnPtr<NativeExecutable>> NativeExecutable::create(ReadonlyBytes code)
+{
+    VERIFY(!code.is_empty());
+    // The code is written while the memory is writable, and only then made executable, never both at once.
+    auto* memory = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (memory == MAP_FAILED)
+        return AK::Error::from_errno(errno);
+    code.copy_to({ memory, code.size() });
+    if (mprotect(memory, code.size(), PROT_READ | PROT_EXEC) < 0) {
+        auto error = AK::Error::from_errno(errno);
+        munmap(memory, code.size());
+        return error;
+    }
+    auto* native_executable = new (nothrow) NativeExecutable(static_cast<u8*>(memory), code.size());
+    if (!native_executable) {
+        munmap(memory, code.size());
+        return AK::Error::from_errno(ENOMEM);
+    }
+    return adopt_own(*native_executable);
+}
+
+NativeExecutable::NativeExecutable(u8* code, size_t size)
+    : m_code(code)
+    , m_size(size)
+{
+}
+
+NativeExecutable::~NativeExecutable()
+{
+    munmap(m_code, m_size);
+}
+
+NativeBlockFunction NativeExecutable::function_at(size_t offset) const
+{
+    VERIFY(offset < m_size);
+    return reinterpret_cast<NativeBlockFunction>(m_code + offset);
+}
+
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Error.h>
+#include <AK/Noncopyable.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Span.h>
+#include <LibJS/Forward.h>
+
+namespace JS::Bytecode::JIT {
+
+// Native code runs the instructions of one basic block, and returns the offset of the last one it ran.
+// It stops early after an instruction that threw or wants to jump or return, and leaves handling that
+// to the interpreter, just like when the instruction was interpreted.
+using NativeBlockFunction = size_t (*)(Interpreter&, Value* registers);
+
+// Executable memory holding the native code for all the basic blocks of one executable.
+class NativeExecutable {
+    AK_MAKE_NONCOPYABLE(NativeExecutable);
+    AK_MAKE_NONMOVABLE(NativeExecutable);
+
+public:
+    static ErrorOr<NonnullOwnPtr<NativeExecutable>> create(ReadonlyBytes code);
+    ~NativeExecutable();
+
+    NativeBlockFunction function_at(size_t offset) const;
+
+private:
+    NativeExecutable(u8* code, size_t size);
+
+    u8* m_code { nullptr };
+    size_t m_size { 0 };
+};
+
+}
@@ -11,6 +11,7 @@
 #include <LibJS/Bytecode/Interpreter.h>
 #include <LibJS/Bytecode/Op.h>
 #include <LibJS/Runtime/AbstractOperations.h>
+#include <LibJS/Runtime/Accessor.h>
 #include <LibJS/Runtime/Array.h>
 #include <LibJS/Runtime/BigInt.h>
 #include <LibJS/Runtime/DeclarativeEnvironment.h>
@@ -492,18 +493,58 @@ ThrowCompletionOr<void> SetVariable::execute_impl(Bytecode::Interpreter& interpr
 ThrowCompletionOr<void> GetById::execute_impl(Bytecode::Interpreter& interpreter) const
 {
     auto& vm = interpreter.vm();
-    auto* object = TRY(interpreter.accumulator().to_object(vm));
-    interpreter.accumulator() = TRY(object->get(interpreter.current_executable().get_identifier(m_property)));
+    auto base_value = interpreter.accumulator();
+    auto* object = TRY(base_value.to_object(vm));
+    auto& cache = interpreter.current_executable().property_lookup_caches[m_cache_index];
+
+    if (auto hit = cache.lookup(*object); hit.has_value()) {
+        auto value = hit->holder->get_direct(hit->offset);
+        if (!value.is_empty()) {
+            if (value.is_accessor()) {
+                auto* getter = value.as_accessor().getter();
+                interpreter.accumulator() = getter ? TRY(call(vm, *getter, Value(object))) : js_undefined();
+            } else {
+                interpreter.accumulator() = value;
+            }
+            return {};
+        }
+    }
+
+    PropertyKey name = interpreter.current_executable().get_identifier(m_property);
+    interpreter.accumulator() = TRY(object->get(name));
+    // Primitives get a new wrapper object every time, so there's no point in remembering anything about it.
+    if (base_value.is_object())
+        cache.update(*object, name, PropertyLookupCache::Access::Get);
     return {};
 }
 
 ThrowCompletionOr<void> PutById::execute_impl(Bytecode::Interpreter& interpreter) const
 {
     auto& vm = interpreter.vm();
-    auto* object = TRY(interpreter.reg(m_base).to_object(vm));
-    PropertyKey name = interpreter.current_executable().get_identifier(m_property);
+    auto base_value = interpreter.reg(m_base);
+    auto* object = TRY(base_value.to_object(vm));
     auto value = interpreter.accumulator();
-    return put_by_property_key(object, value, name, interpreter, m_kind);
+
+    if (m_kind != PropertyKind::KeyValue) {
+        PropertyKey name = interpreter.current_executable().get_identifier(m_property);
+        return put_by_property_key(object, value, name, interpreter, m_kind);
+    }
+
+    auto& cache = interpreter.current_executable().property_lookup_caches[m_cache_index];
+    if (auto hit = cache.lookup(*object); hit.has_value()) {
+        // The cache only remembers writable data properties of the receiver itself,
+        // which is where OrdinarySet would put the value anyway.
+        if (!hit->holder->get_direct(hit->offset).is_accessor()) {
+            hit->holder->put_direct(hit->offset, value);
+            return {};
+        }
+    }
+
+    PropertyKey name = interpreter.current_executable().get_identifier(m_property);
+    TRY(put_by_property_key(object, value, name, interpreter, m_kind));
+    if (base_value.is_object())
+        cache.update(*object, name, PropertyLookupCache::Access::Put);
+    return {};
 }
 
 ThrowCompletionOr<void> DeleteById::execute_impl(Bytecode::Interpreter& interpreter) const
@@ -40,6 +40,8 @@ public:
             m_src = to;
     }
 
+    Register src() const { return m_src; }
+
 private:
     Register m_src;
 };
@@ -57,6 +59,8 @@ public:
     void replace_references_impl(BasicBlock const&, BasicBlock const&) { }
     void replace_references_impl(Register, Register) { }
 
+    Value value() const { return m_value; }
+
 private:
     Value m_value;
 };
@@ -274,6 +278,8 @@ public:
     void replace_references_impl(BasicBlock const&, BasicBlock const&) { }
     void replace_references_impl(Register, Register) { }
 
+    Crypto::SignedBigInteger const& bigint() const { return m_bigint; }
+
 private:
     Crypto::SignedBigInteger m_bigint;
 };
@@ -506,9 +512,10 @@ private:
 
 class GetById final : public Instruction {
 public:
-    explicit GetById(IdentifierTableIndex property)
+    GetById(IdentifierTableIndex property, u32 cache_index)
         : Instruction(Type::GetById)
         , m_property(property)
+        , m_cache_index(cache_index)
     {
     }
 
@@ -519,6 +526,7 @@ public:
 
 private:
     IdentifierTableIndex m_property;
+    u32 m_cache_index { 0 };
 };
 
 enum class PropertyKind {
@@ -531,11 +539,12 @@ enum class PropertyKind {
 
 class PutById final : public Instruction {
 public:
-    explicit PutById(Register base, IdentifierTableIndex property, PropertyKind kind = PropertyKind::KeyValue)
+    PutById(Register base, IdentifierTableIndex property, u32 cache_index, PropertyKind kind = PropertyKind::KeyValue)
         : Instruction(Type::PutById)
         , m_base(base)
         , m_property(property)
         , m_kind(kind)
+        , m_cache_index(cache_index)
     {
     }
 
@@ -552,6 +561,7 @@ private:
     Register m_base;
     IdentifierTableIndex m_property;
     PropertyKind m_kind;
+    u32 m_cache_index { 0 };
 };
 
 class DeleteById final : public Instruction {
@@ -770,6 +780,8 @@ public:
     void replace_references_impl(BasicBlock const&, BasicBlock const&) { }
     void replace_references_impl(Register, Register) { }
 
+    ClassExpression const& class_expression() const { return m_class_expression; }
+
 private:
     ClassExpression const& m_class_expression;
 };
@@ -787,6 +799,8 @@ public:
     void replace_references_impl(BasicBlock const&, BasicBlock const&) { }
     void replace_references_impl(Register, Register) { }
 
+    FunctionNode const& function_node() const { return m_function_node; }
+
 private:
     FunctionNode const& m_function_node;
 };
@@ -1038,6 +1052,9 @@ public:
     void replace_references_impl(BasicBlock const&, BasicBlock const&) { }
     void replace_references_impl(Register, Register) { }
 
+    Completion::Type completion_type() const { return m_completion_type; }
+    Optional<Value> const& completion_value() const { return m_completion_value; }
+
 private:
     Completion::Type m_completion_type { Completion::Type::Normal };
     Optional<Value> m_completion_value;
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibJS/Bytecode/PropertyLookupCache.h>
+#include <LibJS/Runtime/Object.h>
+
+namespace JS::Bytecode {
+
+Optional<PropertyLookupCache::Hit> PropertyLookupCache::lookup(Object& receiver) const
+{
+    for (auto& entry : m_entries) {
+        auto* object = &receiver;
+        for (size_t depth = 0;; ++depth) {
+            auto& shape = object->shape();
+            if (entry.shapes[depth].ptr() != &shape || entry.serial_numbers[depth] != shape.serial_number())
+                break;
+            // Shapes may be shared between ordinary and exotic objects, so this has to be checked every time.
+            if (!object->may_cache_property_lookups())
+                break;
+            if (depth == entry.depth)
+                return Hit { object, entry.offset };
+            // As the shape is the one we saw last time, so is its prototype, which was not null.
+            object = shape.prototype();
+        }
+    }
+    return {};
+}
+
+void PropertyLookupCache::update(Object& receiver, PropertyKey const& property_key, Access access)
+{
+    // Numeric keys live in the indexed properties, not in the shape.
+    if (!property_key.is_string())
+        return;
+    auto key = property_key.to_string_or_symbol();
+
+    Entry entry;
+    auto* object = &receiver;
+    for (size_t depth = 0; depth <= max_prototype_depth; ++depth) {
+        if (!object->may_cache_property_lookups())
+            return;
+        auto& shape = object->shape();
+        entry.shapes[depth] = shape.make_weak_ptr();
+        entry.serial_numbers[depth] = shape.serial_number();
+
+        auto metadata = shape.lookup(key);
+        if (!metadata.has_value()) {
+            if (access == Access::Put)
+                return;
+            object = shape.prototype();
+            if (!object)
+                return;
+            continue;
+        }
+
+        // Intrinsic accessors that haven't been called yet have no value in the storage.
+        auto value = object->get_direct(metadata->offset);
+        if (value.is_empty())
+            return;
+        if (access == Access::Put && (value.is_accessor() || !metadata->attributes.is_writable()))
+            return;
+
+        entry.depth = depth;
+        entry.offset = metadata->offset;
+        m_entries[m_next_entry] = move(entry);
+        m_next_entry = (m_next_entry + 1) % entry_count;
+        return;
+    }
+}
+
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/Optional.h>
+#include <AK/WeakPtr.h>
+#include <LibJS/Forward.h>
+#include <LibJS/Runtime/Shape.h>
+
+namespace JS::Bytecode {
+
+// Remembers where a GetById or PutById instruction found its property on the last few receivers it saw,
+// keyed on the shape of the receiver and of each prototype that had to be looked at on the way there.
+// An object's named properties and prototype are all in its shape, so as long as those shapes haven't
+// changed (see Shape::serial_number()), the property is still in the same place.
+// Only objects that may_cache_property_lookups() take part, as exotic objects don't play by those rules.
+class PropertyLookupCache {
+public:
+    // How many receiver shapes an instruction remembers before it starts forgetting the oldest ones.
+    static constexpr size_t entry_count = 4;
+    // How far up the prototype chain a property may be found and still be remembered.
+    static constexpr size_t max_prototype_depth = 3;
+
+    enum class Access {
+        Get,
+        // Only remembers writable data properties of the receiver itself, as those are the only ones
+        // that can be written to directly.
+        Put,
+    };
+
+    struct Hit {
+        Object* holder { nullptr };
+        u32 offset { 0 };
+    };
+
+    Optional<Hit> lookup(Object& receiver) const;
+
+    // Called after a lookup missed, and the property has been found (or put) the slow way.
+    void update(Object& receiver, PropertyKey const&, Access);
+
+private:
+    struct Entry {
+        AK::Array<WeakPtr<Shape>, max_prototype_depth + 1> shapes;
+        AK::Array<u32, max_prototype_depth + 1> serial_numbers {};
+        u32 depth { 0 };
+        u32 offset { 0 };
+    };
+
+    AK::Array<Entry, entry_count> m_entries;
+    size_t m_next_entry { 0 };
+};
+
+}
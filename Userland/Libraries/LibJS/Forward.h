@@ -293,10 +293,16 @@ class MarkedVector;
 namespace Bytecode {
 class BasicBlock;
 struct Executable;
+class ExecutableCache;
 class Generator;
 class Instruction;
 class Interpreter;
 class Register;
+
+namespace JIT {
+class Compiler;
+class NativeExecutable;
+}
 }
 
 }
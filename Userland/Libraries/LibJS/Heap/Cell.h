@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
 #include <AK/Badge.h>
 #include <AK/Format.h>
 #include <AK/Forward.h>
@@ -35,6 +36,8 @@ public:
 
     bool is_marked() const { return m_mark; }
     void set_marked(bool b) { m_mark = b; }
+    // For when other threads may be marking cells at the same time. Returns whether the cell was already marked.
+    bool test_and_set_marked() { return AK::atomic_exchange(&m_mark, true, AK::memory_order_relaxed); }
 
     enum class State {
         Live,
@@ -97,7 +100,8 @@ protected:
     void set_overrides_must_survive_garbage_collection(bool b) { m_overrides_must_survive_garbage_collection = b; }
 
 private:
-    bool m_mark : 1 { false };
+    // Not a bitfield, so that it can be set atomically without touching the bits next to it.
+    bool m_mark { false };
     bool m_overrides_must_survive_garbage_collection : 1 { false };
     State m_state : 1 { State::Live };
 };
@@ -18,6 +18,9 @@
 #include <LibJS/Runtime/Object.h>
 #include <LibJS/Runtime/WeakContainer.h>
 #include <LibJS/SafeFunction.h>
+#include <LibThreading/ConditionVariable.h>
+#include <LibThreading/Mutex.h>
+#include <LibThreading/Thread.h>
 #include <setjmp.h>
 
 #ifdef AK_OS_SERENITY
@@ -96,7 +99,14 @@ void Heap::collect_garbage(CollectionType collection_type, bool print_report)
     perf_event(PERF_EVENT_SIGNPOST, gc_perf_string_id, global_gc_counter++);
 #endif
 
-    auto collection_measurement_timer = Core::ElapsedTimer::start_new();
+    Core::ElapsedTimer phase_timer { true };
+    phase_timer.start();
+    auto finish_phase = [&](Time& phase_time) {
+        phase_time = phase_timer.elapsed_time();
+        phase_timer.start();
+    };
+
+    CollectionReport report;
     if (collection_type == CollectionType::CollectGarbage) {
         if (m_gc_deferrals) {
             m_should_gc_when_deferral_ends = true;
@@ -104,10 +114,26 @@ void Heap::collect_garbage(CollectionType collection_type, bool print_report)
         }
         HashTable<Cell*> roots;
         gather_roots(roots);
+        report.root_count = roots.size();
+        finish_phase(report.gather_roots_time);
         mark_live_cells(roots);
+        finish_phase(report.mark_time);
     }
     finalize_unmarked_cells();
-    sweep_dead_cells(print_report, collection_measurement_timer);
+    finish_phase(report.finalize_time);
+    sweep_dead_cells(report);
+    finish_phase(report.sweep_time);
+
+    m_allocations_since_last_gc = 0;
+    m_max_allocations_between_gc = max(min_allocations_between_gc, report.live_cells);
+
+    ++m_collection_count;
+    m_total_pause_time += report.pause_time();
+    if (m_longest_pause_time < report.pause_time())
+        m_longest_pause_time = report.pause_time();
+
+    if (print_report)
+        dump_collection_report(report);
 }
 
 void Heap::gather_roots(HashTable<Cell*>& roots)
@@ -203,6 +229,8 @@ __attribute__((no_sanitize("address"))) void Heap::gather_conservative_roots(Has
     }
 }
 
+// Cells are marked from a work list rather than recursively, as object graphs (long linked lists, for example)
+// can easily be deep enough to run us out of stack.
 class MarkingVisitor final : public Cell::Visitor {
 public:
     MarkingVisitor() = default;
@@ -214,18 +242,232 @@ public:
         dbgln_if(HEAP_DEBUG, "  ! {}", &cell);
 
         cell.set_marked(true);
-        cell.visit_edges(*this);
+        m_work_list.append(&cell);
+    }
+
+    void mark_all_reachable_cells()
+    {
+        while (!m_work_list.is_empty())
+            m_work_list.take_last()->visit_edges(*this);
     }
+
+private:
+    Vector<Cell*> m_work_list;
 };
 
-void Heap::mark_live_cells(HashTable<Cell*> const& roots)
+// Each marking thread works off its own work list, and hands over half of it when some other thread has run out of work.
+// Marking is done once all of them have run out.
+class ParallelMarkingState {
+public:
+    explicit ParallelMarkingState(size_t thread_count)
+        : m_thread_count(thread_count)
+    {
+    }
+
+    bool wants_work() const { return m_idle_thread_count.load(AK::memory_order_relaxed) > 0; }
+
+    void give_work(Vector<Cell*>&& work)
+    {
+        Threading::MutexLocker locker(m_mutex);
+        m_shared_work.append(move(work));
+        m_work_available.signal();
+    }
+
+    // Waits for work to be handed over. Returns false once there's none left anywhere.
+    bool take_work(Vector<Cell*>& work_list)
+    {
+        Threading::MutexLocker locker(m_mutex);
+        ++m_idle_thread_count;
+        while (m_shared_work.is_empty()) {
+            if (m_idle_thread_count == m_thread_count) {
+                m_done = true;
+                m_work_available.broadcast();
+            }
+            if (m_done)
+                return false;
+            m_work_available.wait();
+        }
+        --m_idle_thread_count;
+        work_list = m_shared_work.take_last();
+        return true;
+    }
+
+private:
+    Threading::Mutex m_mutex;
+    Threading::ConditionVariable m_work_available { m_mutex };
+    Vector<Vector<Cell*>> m_shared_work;
+    Atomic<size_t> m_idle_thread_count { 0 };
+    size_t const m_thread_count { 0 };
+    bool m_done { false };
+};
+
+class ParallelMarkingVisitor final : public Cell::Visitor {
+public:
+    explicit ParallelMarkingVisitor(ParallelMarkingState& state)
+        : m_state(state)
+    {
+    }
+
+    virtual void visit_impl(Cell& cell) override
+    {
+        if (cell.test_and_set_marked())
+            return;
+        m_work_list.append(&cell);
+    }
+
+    void mark_all_reachable_cells()
+    {
+        do {
+            while (!m_work_list.is_empty()) {
+                m_work_list.take_last()->visit_edges(*this);
+                if (m_work_list.size() >= min_work_to_share && m_state.wants_work())
+                    share_work(m_work_list.size() / 2);
+            }
+        } while (m_state.take_work(m_work_list));
+    }
+
+    void share_work(size_t count)
+    {
+        if (count == 0)
+            return;
+        // The cells at the bottom of the list were found first, so they are the most likely to lead to many more.
+        Vector<Cell*> work;
+        work.ensure_capacity(count);
+        for (size_t i = 0; i < count; ++i)
+            work.unchecked_append(m_work_list[i]);
+        m_work_list.remove(0, count);
+        m_state.give_work(move(work));
+    }
+
+    size_t work_list_size() const { return m_work_list.size(); }
+
+private:
+    static constexpr size_t min_work_to_share = 64;
+
+    ParallelMarkingState& m_state;
+    Vector<Cell*> m_work_list;
+};
+
+// The threads that help the collecting one mark are kept around between collections, as starting new ones every
+// time would easily cost more than the marking itself (and collections can be as frequent as every allocation).
+class MarkingThreadPool {
+    AK_MAKE_NONCOPYABLE(MarkingThreadPool);
+    AK_MAKE_NONMOVABLE(MarkingThreadPool);
+
+public:
+    explicit MarkingThreadPool(size_t thread_count)
+    {
+        for (size_t i = 0; i < thread_count; ++i) {
+            auto thread = Threading::Thread::construct([this]() -> intptr_t {
+                run();
+                return 0;
+            },
+                "GC marker"sv);
+            thread->start();
+            m_threads.append(move(thread));
+        }
+    }
+
+    ~MarkingThreadPool()
+    {
+        {
+            Threading::MutexLocker locker(m_mutex);
+            m_exiting = true;
+            m_marking_started.broadcast();
+        }
+        for (auto& thread : m_threads)
+            (void)thread->join();
+    }
+
+    size_t thread_count() const { return m_threads.size(); }
+
+    // Has every thread of the pool help mark, until wait_until_marking_is_done() returns.
+    void start_marking(ParallelMarkingState& state)
+    {
+        Threading::MutexLocker locker(m_mutex);
+        m_state = &state;
+        m_finished_thread_count = 0;
+        ++m_marking_generation;
+        m_marking_started.broadcast();
+    }
+
+    void wait_until_marking_is_done()
+    {
+        Threading::MutexLocker locker(m_mutex);
+        while (m_finished_thread_count < m_threads.size())
+            m_marking_finished.wait();
+        m_state = nullptr;
+    }
+
+private:
+    void run()
+    {
+        u64 marked_generation = 0;
+        for (;;) {
+            ParallelMarkingState* state = nullptr;
+            {
+                Threading::MutexLocker locker(m_mutex);
+                while (m_marking_generation == marked_generation && !m_exiting)
+                    m_marking_started.wait();
+                if (m_exiting)
+                    return;
+                marked_generation = m_marking_generation;
+                state = m_state;
+            }
+
+            ParallelMarkingVisitor visitor(*state);
+            visitor.mark_all_reachable_cells();
+
+            Threading::MutexLocker locker(m_mutex);
+            if (++m_finished_thread_count == m_threads.size())
+                m_marking_finished.signal();
+        }
+    }
+
+    Vector<NonnullRefPtr<Threading::Thread>> m_threads;
+    Threading::Mutex m_mutex;
+    Threading::ConditionVariable m_marking_started { m_mutex };
+    Threading::ConditionVariable m_marking_finished { m_mutex };
+    ParallelMarkingState* m_state { nullptr };
+    u64 m_marking_generation { 0 };
+    size_t m_finished_thread_count { 0 };
+    bool m_exiting { false };
+};
+
+void Heap::mark_live_cells_in_parallel(HashTable<Cell*> const& roots)
 {
-    dbgln_if(HEAP_DEBUG, "mark_live_cells:");
+    if (!m_marking_thread_pool || m_marking_thread_pool->thread_count() != m_marking_thread_count - 1) {
+        m_marking_thread_pool = nullptr;
+        m_marking_thread_pool = make<MarkingThreadPool>(m_marking_thread_count - 1);
+    }
 
-    MarkingVisitor visitor;
+    ParallelMarkingState state(m_marking_thread_count);
+    ParallelMarkingVisitor visitor(state);
     for (auto* root : roots)
         visitor.visit(root);
 
+    // Deal out the roots, so that the other threads don't have to wait for us to get going.
+    for (size_t i = 1; i < m_marking_thread_count; ++i)
+        visitor.share_work(visitor.work_list_size() / (m_marking_thread_count - i + 1));
+
+    m_marking_thread_pool->start_marking(state);
+    visitor.mark_all_reachable_cells();
+    m_marking_thread_pool->wait_until_marking_is_done();
+}
+
+void Heap::mark_live_cells(HashTable<Cell*> const& roots)
+{
+    dbgln_if(HEAP_DEBUG, "mark_live_cells:");
+
+    if (m_marking_thread_count > 1) {
+        mark_live_cells_in_parallel(roots);
+    } else {
+        MarkingVisitor visitor;
+        for (auto* root : roots)
+            visitor.visit(root);
+        visitor.mark_all_reachable_cells();
+    }
+
     for (auto& inverse_root : m_uprooted_cells)
         inverse_root->set_marked(false);
 
@@ -250,17 +492,12 @@ void Heap::finalize_unmarked_cells()
     });
 }
 
-void Heap::sweep_dead_cells(bool print_report, Core::ElapsedTimer const& measurement_timer)
+void Heap::sweep_dead_cells(CollectionReport& report)
 {
     dbgln_if(HEAP_DEBUG, "sweep_dead_cells:");
     Vector<HeapBlock*, 32> empty_blocks;
     Vector<HeapBlock*, 32> full_blocks_that_became_usable;
 
-    size_t collected_cells = 0;
-    size_t live_cells = 0;
-    size_t collected_cell_bytes = 0;
-    size_t live_cell_bytes = 0;
-
     for_each_block([&](auto& block) {
         bool block_has_live_cells = false;
         bool block_was_full = block.is_full();
@@ -268,13 +505,13 @@ void Heap::sweep_dead_cells(bool print_report, Core::ElapsedTimer const& measure
             if (!cell->is_marked() && !cell_must_survive_garbage_collection(*cell)) {
                 dbgln_if(HEAP_DEBUG, "  ~ {}", cell);
                 block.deallocate(cell);
-                ++collected_cells;
-                collected_cell_bytes += block.cell_size();
+                ++report.collected_cells;
+                report.collected_cell_bytes += block.cell_size();
             } else {
                 cell->set_marked(false);
                 block_has_live_cells = true;
-                ++live_cells;
-                live_cell_bytes += block.cell_size();
+                ++report.live_cells;
+                report.live_cell_bytes += block.cell_size();
             }
         });
         if (!block_has_live_cells)
@@ -304,24 +541,31 @@ void Heap::sweep_dead_cells(bool print_report, Core::ElapsedTimer const& measure
         });
     }
 
-    int time_spent = measurement_timer.elapsed();
+    report.freed_blocks = empty_blocks.size();
+}
 
-    if (print_report) {
-        size_t live_block_count = 0;
-        for_each_block([&](auto&) {
-            ++live_block_count;
-            return IterationDecision::Continue;
-        });
+void Heap::dump_collection_report(CollectionReport const& report)
+{
+    size_t live_block_count = 0;
+    for_each_block([&](auto&) {
+        ++live_block_count;
+        return IterationDecision::Continue;
+    });
 
-        dbgln("Garbage collection report");
-        dbgln("=============================================");
-        dbgln("     Time spent: {} ms", time_spent);
-        dbgln("     Live cells: {} ({} bytes)", live_cells, live_cell_bytes);
-        dbgln("Collected cells: {} ({} bytes)", collected_cells, collected_cell_bytes);
-        dbgln("    Live blocks: {} ({} bytes)", live_block_count, live_block_count * HeapBlock::block_size);
-        dbgln("   Freed blocks: {} ({} bytes)", empty_blocks.size(), empty_blocks.size() * HeapBlock::block_size);
-        dbgln("=============================================");
-    }
+    dbgln("Garbage collection report");
+    dbgln("=============================================");
+    dbgln("     Time spent: {} ms", report.pause_time().to_milliseconds());
+    dbgln("   Gather roots: {} us ({} roots)", report.gather_roots_time.to_microseconds(), report.root_count);
+    dbgln("           Mark: {} us", report.mark_time.to_microseconds());
+    dbgln("       Finalize: {} us", report.finalize_time.to_microseconds());
+    dbgln("          Sweep: {} us", report.sweep_time.to_microseconds());
+    dbgln("     Live cells: {} ({} bytes)", report.live_cells, report.live_cell_bytes);
+    dbgln("Collected cells: {} ({} bytes)", report.collected_cells, report.collected_cell_bytes);
+    dbgln("    Live blocks: {} ({} bytes)", live_block_count, live_block_count * HeapBlock::block_size);
+    dbgln("   Freed blocks: {} ({} bytes)", report.freed_blocks, report.freed_blocks * HeapBlock::block_size);
+    dbgln("    Collections: {} (longest pause {} ms, {} ms in total)", m_collection_count, m_longest_pause_time.to_milliseconds(), m_total_pause_time.to_milliseconds());
+    dbgln("Next collection: after {} allocations", m_max_allocations_between_gc);
+    dbgln("=============================================");
 }
 
 void Heap::did_create_handle(Badge<HandleImpl>, HandleImpl& impl)
@@ -11,6 +11,8 @@
 #include <AK/IntrusiveList.h>
 #include <AK/Noncopyable.h>
 #include <AK/NonnullOwnPtr.h>
+#include <AK/OwnPtr.h>
+#include <AK/Time.h>
 #include <AK/Types.h>
 #include <AK/Vector.h>
 #include <LibCore/Forward.h>
@@ -24,6 +26,8 @@
 
 namespace JS {
 
+class MarkingThreadPool;
+
 class Heap {
     AK_MAKE_NONCOPYABLE(Heap);
     AK_MAKE_NONMOVABLE(Heap);
@@ -62,6 +66,11 @@ public:
     bool should_collect_on_every_allocation() const { return m_should_collect_on_every_allocation; }
     void set_should_collect_on_every_allocation(bool b) { m_should_collect_on_every_allocation = b; }
 
+    // Marking can be spread over several threads, the collecting one included. This relies on every
+    // visit_edges() being safe to run alongside the others, so it's off (set to 1) by default.
+    size_t marking_thread_count() const { return m_marking_thread_count; }
+    void set_marking_thread_count(size_t count) { m_marking_thread_count = max<size_t>(count, 1); }
+
     void did_create_handle(Badge<HandleImpl>, HandleImpl&);
     void did_destroy_handle(Badge<HandleImpl>, HandleImpl&);
 
@@ -79,6 +88,21 @@ public:
     void uproot_cell(Cell* cell);
 
 private:
+    struct CollectionReport {
+        Time gather_roots_time;
+        Time mark_time;
+        Time finalize_time;
+        Time sweep_time;
+        size_t root_count { 0 };
+        size_t live_cells { 0 };
+        size_t live_cell_bytes { 0 };
+        size_t collected_cells { 0 };
+        size_t collected_cell_bytes { 0 };
+        size_t freed_blocks { 0 };
+
+        Time pause_time() const { return gather_roots_time + mark_time + finalize_time + sweep_time; }
+    };
+
     static bool cell_must_survive_garbage_collection(Cell const&);
 
     Cell* allocate_cell(size_t);
@@ -86,8 +110,10 @@ private:
     void gather_roots(HashTable<Cell*>&);
     void gather_conservative_roots(HashTable<Cell*>&);
     void mark_live_cells(HashTable<Cell*> const& live_cells);
+    void mark_live_cells_in_parallel(HashTable<Cell*> const& live_cells);
     void finalize_unmarked_cells();
-    void sweep_dead_cells(bool print_report, Core::ElapsedTimer const&);
+    void sweep_dead_cells(CollectionReport&);
+    void dump_collection_report(CollectionReport const&);
 
     CellAllocator& allocator_for_size(size_t);
 
@@ -100,10 +126,20 @@ private:
         }
     }
 
-    size_t m_max_allocations_between_gc { 100000 };
+    // We collect after at least this many allocations, or after as many allocations as there were cells left
+    // alive by the last collection if that's more. Each collection has to mark everything that's alive, so this
+    // keeps the time spent collecting in proportion to the time spent allocating as the heap grows.
+    static constexpr size_t min_allocations_between_gc = 100000;
+    size_t m_max_allocations_between_gc { min_allocations_between_gc };
     size_t m_allocations_since_last_gc { 0 };
 
+    size_t m_collection_count { 0 };
+    Time m_total_pause_time;
+    Time m_longest_pause_time;
+
     bool m_should_collect_on_every_allocation { false };
+    size_t m_marking_thread_count { 1 };
+    OwnPtr<MarkingThreadPool> m_marking_thread_pool;
 
     VM& m_vm;
 
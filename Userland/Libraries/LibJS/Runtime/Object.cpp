@@ -76,6 +76,7 @@ Object::~Object()
 
 void Object::initialize(Realm&)
 {
+    m_may_cache_property_lookups = has_ordinary_property_lookups();
 }
 
 // 7.2 Testing and Comparison Operations, https://tc39.es/ecma262/#sec-testing-and-comparison-operations
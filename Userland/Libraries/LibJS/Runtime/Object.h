@@ -26,7 +26,23 @@
 
 namespace JS {
 
-#define JS_OBJECT(class_, base_class) JS_CELL(class_, base_class)
+// An object whose class doesn't override any of the internal methods that looking up a property by name goes
+// through finds its named properties in its shape and storage, and its prototype in its shape. Lookups on such
+// objects can be cached by the shapes involved (see Bytecode::PropertyLookupCache).
+#define __JS_OBJECT_HAS_ORDINARY_INTERNAL_METHOD(method) \
+    IsSame<decltype(&RemoveCVReference<decltype(*this)>::method), decltype(&::JS::Object::method)>
+
+#define JS_OBJECT(class_, base_class)                                                      \
+    JS_CELL(class_, base_class)                                                            \
+    virtual bool has_ordinary_property_lookups() const override                            \
+    {                                                                                      \
+        return __JS_OBJECT_HAS_ORDINARY_INTERNAL_METHOD(internal_get_prototype_of)         \
+            && __JS_OBJECT_HAS_ORDINARY_INTERNAL_METHOD(internal_get_own_property)         \
+            && __JS_OBJECT_HAS_ORDINARY_INTERNAL_METHOD(internal_define_own_property)      \
+            && __JS_OBJECT_HAS_ORDINARY_INTERNAL_METHOD(internal_has_property)             \
+            && __JS_OBJECT_HAS_ORDINARY_INTERNAL_METHOD(internal_get)                      \
+            && __JS_OBJECT_HAS_ORDINARY_INTERNAL_METHOD(internal_set);                     \
+    }
 
 struct PrivateElement {
     enum class Kind {
@@ -169,12 +185,16 @@ public:
     // B.3.7 The [[IsHTMLDDA]] Internal Slot, https://tc39.es/ecma262/#sec-IsHTMLDDA-internal-slot
     virtual bool is_htmldda() const { return false; }
 
+    virtual bool has_ordinary_property_lookups() const { return true; }
+    bool may_cache_property_lookups() const { return m_may_cache_property_lookups; }
+
     bool has_parameter_map() const { return m_has_parameter_map; }
     void set_has_parameter_map() { m_has_parameter_map = true; }
 
     virtual void visit_edges(Cell::Visitor&) override;
 
     Value get_direct(size_t index) const { return m_storage[index]; }
+    void put_direct(size_t index, Value value) { m_storage[index] = value; }
 
     IndexedProperties const& indexed_properties() const { return m_indexed_properties; }
     IndexedProperties& indexed_properties() { return m_indexed_properties; }
@@ -217,6 +237,9 @@ private:
     Vector<Value> m_storage;
     IndexedProperties m_indexed_properties;
     OwnPtr<Vector<PrivateElement>> m_private_elements; // [[PrivateElements]]
+
+    // Set in initialize(), as has_ordinary_property_lookups() can't be called from the constructor.
+    bool m_may_cache_property_lookups { false };
 };
 
 }
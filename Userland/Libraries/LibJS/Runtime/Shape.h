@@ -59,6 +59,10 @@ public:
     bool is_unique() const { return m_unique; }
     Shape* create_unique_clone() const;
 
+    // Unique shapes (and the ones set up by Intrinsics) are changed in place rather than transitioned,
+    // so anything that caches what it found in a shape has to check this as well.
+    u32 serial_number() const { return m_serial_number; }
+
     Realm& realm() const { return m_realm; }
 
     Object* prototype() { return m_prototype; }
@@ -75,7 +79,11 @@ public:
 
     Vector<Property> property_table_ordered() const;
 
-    void set_prototype_without_transition(Object* new_prototype) { m_prototype = new_prototype; }
+    void set_prototype_without_transition(Object* new_prototype)
+    {
+        m_prototype = new_prototype;
+        ++m_serial_number;
+    }
 
     void remove_property_from_unique_shape(StringOrSymbol const&, size_t offset);
     void add_property_to_unique_shape(StringOrSymbol const&, PropertyAttributes attributes);
@@ -103,6 +111,7 @@ private:
     StringOrSymbol m_property_key;
     Object* m_prototype { nullptr };
     u32 m_property_count { 0 };
+    u32 m_serial_number { 0 };
 
     PropertyAttributes m_attributes { 0 };
     TransitionType m_transition_type : 6 { TransitionType::Invalid };
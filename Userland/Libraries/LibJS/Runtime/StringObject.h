@@ -22,14 +22,14 @@ public:
     PrimitiveString const& primitive_string() const { return m_string; }
     PrimitiveString& primitive_string() { return m_string; }
 
-protected:
-    StringObject(PrimitiveString&, Object& prototype);
-
-private:
     virtual ThrowCompletionOr<Optional<PropertyDescriptor>> internal_get_own_property(PropertyKey const&) const override;
     virtual ThrowCompletionOr<bool> internal_define_own_property(PropertyKey const&, PropertyDescriptor const&) override;
     virtual ThrowCompletionOr<MarkedVector<Value>> internal_own_property_keys() const override;
 
+protected:
+    StringObject(PrimitiveString&, Object& prototype);
+
+private:
     virtual bool is_string_object() const final { return true; }
     virtual void visit_edges(Visitor&) override;
 
@@ -0,0 +1,75 @@
+// The bytecode interpreter compiles code to native code once it has run often enough, so everything
+// here runs a few thousand times, and has to behave the same before and after that happens.
+const iterations = 5000;
+
+test("loops", () => {
+    let sum = 0;
+    for (let i = 0; i < iterations; ++i) {
+        if (i % 3 === 0) continue;
+        if (i === iterations - 1) break;
+        sum += i;
+    }
+    let expected = 0;
+    for (let i = 0; i < iterations - 1; ++i) if (i % 3 !== 0) expected += i;
+    expect(sum).toBe(expected);
+});
+
+test("calls and returns", () => {
+    const add = (a, b) => a + b;
+    function fibonacci(n) {
+        return n < 2 ? n : fibonacci(n - 1) + fibonacci(n - 2);
+    }
+    let sum = 0;
+    for (let i = 0; i < iterations; ++i) sum = add(sum, 1);
+    expect(sum).toBe(iterations);
+    expect(fibonacci(20)).toBe(6765);
+});
+
+test("exceptions", () => {
+    const check = i => {
+        if (i % 100 === 0) throw new Error(`${i}`);
+        return i;
+    };
+    let caught = 0;
+    let finallies = 0;
+    for (let i = 0; i < iterations; ++i) {
+        try {
+            check(i);
+        } catch (e) {
+            expect(e.message).toBe(`${i}`);
+            ++caught;
+        } finally {
+            ++finallies;
+        }
+    }
+    expect(caught).toBe(iterations / 100);
+    expect(finallies).toBe(iterations);
+
+    const throwing = () => {
+        for (let i = 0; ; ++i) {
+            if (i === iterations) null.foo;
+        }
+    };
+    expect(throwing).toThrow(TypeError);
+});
+
+test("return from finally", () => {
+    const f = i => {
+        try {
+            if (i % 2) return "try";
+        } finally {
+            if (i % 3 === 0) return "finally";
+        }
+        return "end";
+    };
+    for (let i = 0; i < iterations; ++i) expect(f(i)).toBe(i % 3 === 0 ? "finally" : i % 2 ? "try" : "end");
+});
+
+test("generators", () => {
+    function* counter() {
+        for (let i = 0; i < iterations; ++i) yield i;
+    }
+    let expected = 0;
+    for (const value of counter()) expect(value).toBe(expected++);
+    expect(expected).toBe(iterations);
+});
@@ -0,0 +1,151 @@
+// The same property access runs against different objects here, to make sure that whatever
+// the bytecode interpreter remembers about earlier lookups isn't used when it no longer applies.
+
+describe("get", () => {
+    test("objects with different shapes", () => {
+        const get = o => o.foo;
+        const objects = [
+            { foo: 1 },
+            { bar: 0, foo: 2 },
+            { baz: 0, bar: 0, foo: 3 },
+            { foo: 4, bar: 0 },
+            { qux: 0 },
+        ];
+        for (let i = 0; i < 3; ++i) {
+            expect(objects.map(get)).toEqual([1, 2, 3, 4, undefined]);
+        }
+    });
+
+    test("property added to the object after it was found on the prototype", () => {
+        const proto = { foo: "proto" };
+        const o = Object.create(proto);
+        const get = () => o.foo;
+        expect(get()).toBe("proto");
+        o.foo = "own";
+        expect(get()).toBe("own");
+        delete o.foo;
+        expect(get()).toBe("proto");
+    });
+
+    test("property changed on the prototype", () => {
+        class A {
+            method() {
+                return "A";
+            }
+        }
+        const a = new A();
+        const call = () => a.method();
+        expect(call()).toBe("A");
+        A.prototype.method = () => "changed";
+        expect(call()).toBe("changed");
+        delete A.prototype.method;
+        expect(call).toThrow(TypeError);
+    });
+
+    test("prototype of a prototype replaced", () => {
+        const grandparent = { foo: "grandparent" };
+        const parent = Object.create(grandparent);
+        const o = Object.create(parent);
+        const get = () => o.foo;
+        expect(get()).toBe("grandparent");
+        Object.setPrototypeOf(parent, { foo: "replaced" });
+        expect(get()).toBe("replaced");
+    });
+
+    test("data property replaced by a getter", () => {
+        const o = { foo: 1 };
+        const get = () => o.foo;
+        expect(get()).toBe(1);
+        Object.defineProperty(o, "foo", {
+            get() {
+                return this === o ? "getter" : "wrong this";
+            },
+        });
+        expect(get()).toBe("getter");
+    });
+
+    test("getter on the prototype is called with the receiver", () => {
+        const proto = {
+            get foo() {
+                return this.bar;
+            },
+        };
+        const get = o => o.foo;
+        const a = Object.create(proto);
+        a.bar = "a";
+        const b = Object.create(proto);
+        b.bar = "b";
+        expect(get(a)).toBe("a");
+        expect(get(b)).toBe("b");
+    });
+
+    test("proxy with the same prototype as an ordinary object", () => {
+        const proto = { foo: "proto" };
+        const o = Object.create(proto);
+        const proxy = new Proxy(Object.create(proto), { get: () => "proxy" });
+        const get = o => o.foo;
+        expect(get(o)).toBe("proto");
+        expect(get(proxy)).toBe("proxy");
+        expect(get(o)).toBe("proto");
+    });
+});
+
+describe("put", () => {
+    test("objects with different shapes", () => {
+        const put = (o, value) => {
+            o.foo = value;
+        };
+        const a = { foo: 1 };
+        const b = { bar: 0, foo: 1 };
+        put(a, 2);
+        put(b, 3);
+        put(a, 4);
+        expect(a.foo).toBe(4);
+        expect(b.foo).toBe(3);
+    });
+
+    test("property made read-only", () => {
+        "use strict";
+        const o = { foo: 1 };
+        const put = value => {
+            o.foo = value;
+        };
+        put(2);
+        Object.freeze(o);
+        expect(() => put(3)).toThrow(TypeError);
+        expect(o.foo).toBe(2);
+    });
+
+    test("data property replaced by a setter", () => {
+        let set = null;
+        const o = { foo: 1 };
+        const put = value => {
+            o.foo = value;
+        };
+        put(2);
+        Object.defineProperty(o, "foo", {
+            set(value) {
+                set = value;
+            },
+        });
+        put(3);
+        expect(set).toBe(3);
+    });
+
+    test("setter on the prototype", () => {
+        let set = null;
+        const proto = {
+            set foo(value) {
+                set = value;
+            },
+        };
+        const o = Object.create(proto);
+        const put = value => {
+            o.foo = value;
+        };
+        put(1);
+        put(2);
+        expect(set).toBe(2);
+        expect(Object.hasOwn(o, "foo")).toBeFalse();
+    });
+});
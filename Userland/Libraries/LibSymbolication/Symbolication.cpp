@@ -132,15 +132,14 @@ Optional<Symbol> symbolicate(DeprecatedString const& path, FlatPtr address, Incl
     };
 }
 
-Vector<Symbol> symbolicate_thread(pid_t pid, pid_t tid, IncludeSourcePosition include_source_positions)
-{
-    struct RegionWithSymbols {
-        FlatPtr base { 0 };
-        size_t size { 0 };
-        DeprecatedString path;
-    };
+struct RegionWithSymbols {
+    FlatPtr base { 0 };
+    size_t size { 0 };
+    DeprecatedString path;
+};
 
-    Vector<FlatPtr> stack;
+static Optional<Vector<RegionWithSymbols>> load_regions(pid_t pid)
+{
     Vector<RegionWithSymbols> regions;
 
     if (auto maybe_kernel_base = kernel_base(); maybe_kernel_base.has_value()) {
@@ -151,64 +150,51 @@ Vector<Symbol> symbolicate_thread(pid_t pid, pid_t tid, IncludeSourcePosition in
         });
     }
 
-    {
-        auto stack_path = DeprecatedString::formatted("/proc/{}/stacks/{}", pid, tid);
-        auto file_or_error = Core::File::open(stack_path, Core::OpenMode::ReadOnly);
-        if (file_or_error.is_error()) {
-            warnln("Could not open {}: {}", stack_path, file_or_error.error());
-            return {};
-        }
-
-        auto json = JsonValue::from_string(file_or_error.value()->read_all());
-        if (json.is_error() || !json.value().is_array()) {
-            warnln("Invalid contents in {}", stack_path);
-            return {};
-        }
+    auto vm_path = DeprecatedString::formatted("/proc/{}/vm", pid);
+    auto file_or_error = Core::File::open(vm_path, Core::OpenMode::ReadOnly);
+    if (file_or_error.is_error()) {
+        warnln("Could not open {}: {}", vm_path, file_or_error.error());
+        return {};
+    }
 
-        stack.ensure_capacity(json.value().as_array().size());
-        for (auto& value : json.value().as_array().values()) {
-            stack.append(value.to_addr());
-        }
+    auto json = JsonValue::from_string(file_or_error.value()->read_all());
+    if (json.is_error() || !json.value().is_array()) {
+        warnln("Invalid contents in {}", vm_path);
+        return {};
     }
 
-    {
-        auto vm_path = DeprecatedString::formatted("/proc/{}/vm", pid);
-        auto file_or_error = Core::File::open(vm_path, Core::OpenMode::ReadOnly);
-        if (file_or_error.is_error()) {
-            warnln("Could not open {}: {}", vm_path, file_or_error.error());
-            return {};
-        }
+    for (auto& region_value : json.value().as_array().values()) {
+        auto& region = region_value.as_object();
+        auto name = region.get("name"sv).to_deprecated_string();
+        auto address = region.get("address"sv).to_addr();
+        auto size = region.get("size"sv).to_addr();
 
-        auto json = JsonValue::from_string(file_or_error.value()->read_all());
-        if (json.is_error() || !json.value().is_array()) {
-            warnln("Invalid contents in {}", vm_path);
-            return {};
+        DeprecatedString path;
+        if (name == "/usr/lib/Loader.so") {
+            path = name;
+        } else if (name.ends_with(": .text"sv) || name.ends_with(": .rodata"sv)) {
+            auto parts = name.split_view(':');
+            path = parts[0];
+        } else {
+            continue;
         }
 
-        for (auto& region_value : json.value().as_array().values()) {
-            auto& region = region_value.as_object();
-            auto name = region.get("name"sv).to_deprecated_string();
-            auto address = region.get("address"sv).to_addr();
-            auto size = region.get("size"sv).to_addr();
-
-            DeprecatedString path;
-            if (name == "/usr/lib/Loader.so") {
-                path = name;
-            } else if (name.ends_with(": .text"sv) || name.ends_with(": .rodata"sv)) {
-                auto parts = name.split_view(':');
-                path = parts[0];
-            } else {
-                continue;
-            }
-
-            RegionWithSymbols r;
-            r.base = address;
-            r.size = size;
-            r.path = path;
-            regions.append(move(r));
-        }
+        RegionWithSymbols r;
+        r.base = address;
+        r.size = size;
+        r.path = path;
+        regions.append(move(r));
     }
+    return regions;
+}
 
+enum class UnknownFrames {
+    Print,
+    Keep,
+};
+
+static Vector<Symbol> symbolicate_stack(Vector<RegionWithSymbols> const& regions, Vector<FlatPtr> const& stack, IncludeSourcePosition include_source_positions, UnknownFrames unknown_frames)
+{
     Vector<Symbol> symbols;
     bool first_frame = true;
 
@@ -227,7 +213,11 @@ Vector<Symbol> symbolicate_thread(pid_t pid, pid_t tid, IncludeSourcePosition in
         }
 
         if (!found_region) {
-            outln("{:p}  ??", address);
+            if (unknown_frames == UnknownFrames::Print)
+                outln("{:p}  ??", address);
+            else
+                symbols.append(Symbol { .address = address });
+            first_frame = false;
             continue;
         }
 
@@ -265,4 +255,47 @@ Vector<Symbol> symbolicate_thread(pid_t pid, pid_t tid, IncludeSourcePosition in
     return symbols;
 }
 
+Vector<Symbol> symbolicate_thread(pid_t pid, pid_t tid, IncludeSourcePosition include_source_positions)
+{
+    Vector<FlatPtr> stack;
+
+    {
+        auto stack_path = DeprecatedString::formatted("/proc/{}/stacks/{}", pid, tid);
+        auto file_or_error = Core::File::open(stack_path, Core::OpenMode::ReadOnly);
+        if (file_or_error.is_error()) {
+            warnln("Could not open {}: {}", stack_path, file_or_error.error());
+            return {};
+        }
+
+        auto json = JsonValue::from_string(file_or_error.value()->read_all());
+        if (json.is_error() || !json.value().is_array()) {
+            warnln("Invalid contents in {}", stack_path);
+            return {};
+        }
+
+        stack.ensure_capacity(json.value().as_array().size());
+        for (auto& value : json.value().as_array().values()) {
+            stack.append(value.to_addr());
+        }
+    }
+
+    auto regions = load_regions(pid);
+    if (!regions.has_value())
+        return {};
+    return symbolicate_stack(*regions, stack, include_source_positions, UnknownFrames::Print);
+}
+
+Vector<Vector<Symbol>> symbolicate_stacks(pid_t pid, Span<Vector<FlatPtr> const> stacks, IncludeSourcePosition include_source_positions)
+{
+    auto regions = load_regions(pid);
+    if (!regions.has_value())
+        return {};
+
+    Vector<Vector<Symbol>> symbolicated_stacks;
+    symbolicated_stacks.ensure_capacity(stacks.size());
+    for (auto& stack : stacks)
+        symbolicated_stacks.unchecked_append(symbolicate_stack(*regions, stack, include_source_positions, UnknownFrames::Keep));
+    return symbolicated_stacks;
+}
+
 }
@@ -27,6 +27,9 @@ enum class IncludeSourcePosition {
 
 Optional<FlatPtr> kernel_base();
 Vector<Symbol> symbolicate_thread(pid_t pid, pid_t tid, IncludeSourcePosition = IncludeSourcePosition::Yes);
+// Symbolicates stacks that were captured earlier (e.g. by a profiler) against the current address space of the process.
+// The regions of the process are only looked up once, so this is much cheaper than symbolicating the stacks one by one.
+Vector<Vector<Symbol>> symbolicate_stacks(pid_t pid, Span<Vector<FlatPtr> const> stacks, IncludeSourcePosition = IncludeSourcePosition::Yes);
 Optional<Symbol> symbolicate(DeprecatedString const& path, FlatPtr address, IncludeSourcePosition = IncludeSourcePosition::Yes);
 
 }
@@ -127,6 +127,7 @@ static consteval size_t __testjs_last()
 static constexpr auto TOP_LEVEL_TEST_NAME = "__$$TOP_LEVEL$$__";
 extern RefPtr<JS::VM> g_vm;
 extern bool g_collect_on_every_allocation;
+extern size_t g_gc_marking_thread_count;
 extern bool g_run_bytecode;
 extern DeprecatedString g_currently_running_test;
 struct FunctionWithLength {
@@ -312,6 +313,7 @@ inline JSFileResult TestRunner::run_file_test(DeprecatedString const& test_path)
     JS::VM::InterpreterExecutionScope scope(*interpreter);
 
     interpreter->heap().set_should_collect_on_every_allocation(g_collect_on_every_allocation);
+    interpreter->heap().set_marking_thread_count(g_gc_marking_thread_count);
 
     if (g_run_file) {
         auto result = g_run_file(test_path, *interpreter, global_execution_context);
@@ -7,6 +7,7 @@
  */
 
 #include <LibCore/ArgsParser.h>
+#include <LibJS/Bytecode/JIT/Compiler.h>
 #include <LibTest/JavaScriptTestRunner.h>
 #include <signal.h>
 #include <stdio.h>
@@ -19,6 +20,7 @@ namespace JS {
 
 RefPtr<::JS::VM> g_vm;
 bool g_collect_on_every_allocation = false;
+size_t g_gc_marking_thread_count = 1;
 bool g_run_bytecode = false;
 DeprecatedString g_currently_running_test;
 HashMap<DeprecatedString, FunctionWithLength> s_exposed_global_functions;
@@ -88,6 +90,7 @@ int main(int argc, char** argv)
 #endif
     bool print_json = false;
     bool per_file = false;
+    bool disable_jit = false;
     char const* specified_test_root = nullptr;
     DeprecatedString common_path;
     DeprecatedString test_glob;
@@ -112,8 +115,10 @@ int main(int argc, char** argv)
     args_parser.add_option(print_json, "Show results as JSON", "json", 'j');
     args_parser.add_option(per_file, "Show detailed per-file results as JSON (implies -j)", "per-file", 0);
     args_parser.add_option(g_collect_on_every_allocation, "Collect garbage after every allocation", "collect-often", 'g');
+    args_parser.add_option(g_gc_marking_thread_count, "Number of threads to mark live cells with during garbage collection", "gc-marking-threads", 0, "count");
     args_parser.add_option(g_run_bytecode, "Use the bytecode interpreter", "run-bytecode", 'b');
     args_parser.add_option(JS::Bytecode::g_dump_bytecode, "Dump the bytecode", "dump-bytecode", 'd');
+    args_parser.add_option(disable_jit, "Don't compile hot bytecode to native code", "disable-jit", 0);
     args_parser.add_option(test_glob, "Only run tests matching the given glob", "filter", 'f', "glob");
     for (auto& entry : g_extra_args)
         args_parser.add_option(*entry.key, entry.value.get<0>().characters(), entry.value.get<1>().characters(), entry.value.get<2>());
@@ -124,6 +129,9 @@ int main(int argc, char** argv)
     if (per_file)
         print_json = true;
 
+    if (disable_jit)
+        JS::Bytecode::JIT::g_jit_enabled = false;
+
     test_glob = DeprecatedString::formatted("*{}*", test_glob);
 
     if (getenv("DISABLE_DBG_OUTPUT")) {
@@ -18,6 +18,7 @@
 #include <LibCore/FileStream.h>
 #include <LibCore/MappedFile.h>
 #include <LibCore/MimeData.h>
+#include <LibCore/System.h>
 #include <LibHTTP/HttpRequest.h>
 #include <LibHTTP/HttpResponse.h>
 #include <WebServer/Client.h>
@@ -163,13 +164,21 @@ ErrorOr<bool> Client::handle_request(ReadonlyBytes raw_request)
         return false;
     }
 
+    ContentInfo content_info { .type = Core::guess_mime_type_based_on_filename(real_path), .length = TRY(Core::File::size(real_path)) };
+
+    // Anything that doesn't fit in a single copy buffer is handed to the kernel in one go.
+    if (content_info.length > PAGE_SIZE) {
+        TRY(send_file_response(file->fd(), request, content_info));
+        return true;
+    }
+
     Core::InputFileStream stream { file };
 
-    TRY(send_response(stream, request, { .type = Core::guess_mime_type_based_on_filename(real_path), .length = TRY(Core::File::size(real_path)) }));
+    TRY(send_response(stream, request, content_info));
     return true;
 }
 
-ErrorOr<void> Client::send_response(InputStream& response, HTTP::HttpRequest const& request, ContentInfo content_info)
+ErrorOr<void> Client::send_response_headers(HTTP::HttpRequest const& request, ContentInfo const& content_info)
 {
     StringBuilder builder;
     builder.append("HTTP/1.0 200 OK\r\n"sv);
@@ -187,6 +196,12 @@ ErrorOr<void> Client::send_response(InputStream& response, HTTP::HttpRequest con
     auto builder_contents = builder.to_byte_buffer();
     TRY(m_socket->write(builder_contents));
     log_response(200, request);
+    return {};
+}
+
+ErrorOr<void> Client::send_response(InputStream& response, HTTP::HttpRequest const& request, ContentInfo content_info)
+{
+    TRY(send_response_headers(request, content_info));
 
     char buffer[PAGE_SIZE];
     do {
@@ -206,6 +221,32 @@ ErrorOr<void> Client::send_response(InputStream& response, HTTP::HttpRequest con
         }
     } while (true);
 
+    finish_response(request);
+    return {};
+}
+
+ErrorOr<void> Client::send_file_response(int fd, HTTP::HttpRequest const& request, ContentInfo content_info)
+{
+    TRY(send_response_headers(request, content_info));
+
+    // The file contents go straight from the page cache to the socket, without a round trip through our buffers.
+    auto socket_fd = m_socket->fd();
+    if (!socket_fd.has_value())
+        return Error::from_errno(ENOTCONN);
+
+    off_t offset = 0;
+    while (static_cast<size_t>(offset) < content_info.length) {
+        auto nsent = TRY(Core::System::sendfile(*socket_fd, fd, &offset, content_info.length - offset));
+        if (nsent == 0)
+            break;
+    }
+
+    finish_response(request);
+    return {};
+}
+
+void Client::finish_response(HTTP::HttpRequest const& request)
+{
     auto keep_alive = false;
     if (auto it = request.headers().find_if([](auto& header) { return header.name.equals_ignoring_case("Connection"sv); }); !it.is_end()) {
         if (it->value.trim_whitespace().equals_ignoring_case("keep-alive"sv))
@@ -213,8 +254,6 @@ ErrorOr<void> Client::send_response(InputStream& response, HTTP::HttpRequest con
     }
     if (!keep_alive)
         m_socket->close();
-
-    return {};
 }
 
 ErrorOr<void> Client::send_redirect(StringView redirect_path, HTTP::HttpRequest const& request)
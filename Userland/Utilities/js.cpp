@@ -6,14 +6,17 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Debug.h>
 #include <LibCore/ArgsParser.h>
 #include <LibCore/ConfigFile.h>
 #include <LibCore/StandardPaths.h>
 #include <LibCore/Stream.h>
 #include <LibCore/System.h>
 #include <LibJS/Bytecode/BasicBlock.h>
+#include <LibJS/Bytecode/ExecutableCache.h>
 #include <LibJS/Bytecode/Generator.h>
 #include <LibJS/Bytecode/Interpreter.h>
+#include <LibJS/Bytecode/JIT/Compiler.h>
 #include <LibJS/Console.h>
 #include <LibJS/Interpreter.h>
 #include <LibJS/Parser.h>
@@ -75,6 +78,7 @@ private:
 static bool s_dump_ast = false;
 static bool s_run_bytecode = false;
 static bool s_opt_bytecode = false;
+static OwnPtr<JS::Bytecode::ExecutableCache> s_bytecode_cache;
 static bool s_as_module = false;
 static bool s_print_last_result = false;
 static bool s_strip_ansi = false;
@@ -220,6 +224,31 @@ static ErrorOr<bool> parse_and_run(JS::Interpreter& interpreter, StringView sour
 
     JS::ThrowCompletionOr<JS::Value> result { JS::js_undefined() };
 
+    auto run_executable = [&](NonnullOwnPtr<JS::Bytecode::Executable> executable) {
+        executable->name = source_name;
+        if (s_opt_bytecode) {
+            auto& passes = JS::Bytecode::Interpreter::optimization_pipeline(JS::Bytecode::Interpreter::OptimizationLevel::Optimize);
+            passes.perform(*executable);
+            dbgln("Optimisation passes took {}us", passes.elapsed());
+        }
+
+        if (JS::Bytecode::g_dump_bytecode)
+            executable->dump();
+
+        if (s_run_bytecode) {
+            JS::Bytecode::Interpreter bytecode_interpreter(interpreter.realm());
+            auto result_or_error = bytecode_interpreter.run_and_return_frame(*executable, nullptr);
+            if (result_or_error.value.is_error())
+                result = result_or_error.value.release_error();
+            else
+                result = result_or_error.frame->registers[0];
+        } else {
+            return ReturnEarly::Yes;
+        }
+
+        return ReturnEarly::No;
+    };
+
     auto run_script_or_module = [&](auto& script_or_module) {
         if (s_dump_ast)
             script_or_module->parse_node().dump(0);
@@ -232,34 +261,27 @@ static ErrorOr<bool> parse_and_run(JS::Interpreter& interpreter, StringView sour
             }
 
             auto executable = executable_result.release_value();
-            executable->name = source_name;
-            if (s_opt_bytecode) {
-                auto& passes = JS::Bytecode::Interpreter::optimization_pipeline(JS::Bytecode::Interpreter::OptimizationLevel::Optimize);
-                passes.perform(*executable);
-                dbgln("Optimisation passes took {}us", passes.elapsed());
+            if (s_bytecode_cache && !s_as_module) {
+                if (auto stored_or_error = s_bytecode_cache->store(source, *executable); stored_or_error.is_error())
+                    dbgln_if(JS_BYTECODE_DEBUG, "Not caching the bytecode for {}: {}", source_name, stored_or_error.error());
             }
-
-            if (JS::Bytecode::g_dump_bytecode)
-                executable->dump();
-
-            if (s_run_bytecode) {
-                JS::Bytecode::Interpreter bytecode_interpreter(interpreter.realm());
-                auto result_or_error = bytecode_interpreter.run_and_return_frame(*executable, nullptr);
-                if (result_or_error.value.is_error())
-                    result = result_or_error.value.release_error();
-                else
-                    result = result_or_error.frame->registers[0];
-            } else {
-                return ReturnEarly::Yes;
-            }
-        } else {
-            result = interpreter.run(*script_or_module);
+            return run_executable(move(executable));
         }
 
+        result = interpreter.run(*script_or_module);
         return ReturnEarly::No;
     };
 
-    if (!s_as_module) {
+    // A cached executable spares us parsing the script, unless we need its AST.
+    OwnPtr<JS::Bytecode::Executable> cached_executable;
+    if (s_bytecode_cache && !s_as_module && !s_dump_ast && (JS::Bytecode::g_dump_bytecode || s_run_bytecode))
+        cached_executable = s_bytecode_cache->load(source);
+
+    if (cached_executable) {
+        auto return_early = run_executable(cached_executable.release_nonnull());
+        if (return_early == ReturnEarly::Yes)
+            return true;
+    } else if (!s_as_module) {
         auto script_or_error = JS::Script::parse(source, interpreter.realm(), source_name);
         if (script_or_error.is_error()) {
             auto error = script_or_error.error()[0];
@@ -598,9 +620,12 @@ private:
 
 ErrorOr<int> serenity_main(Main::Arguments arguments)
 {
-    TRY(Core::System::pledge("stdio rpath wpath cpath tty sigaction"));
+    TRY(Core::System::pledge("stdio rpath wpath cpath tty sigaction thread"));
 
     bool gc_on_every_allocation = false;
+    size_t gc_marking_thread_count = 1;
+    bool disable_jit = false;
+    StringView bytecode_cache_path;
     bool disable_syntax_highlight = false;
     StringView evaluate_script;
     Vector<StringView> script_paths;
@@ -611,11 +636,14 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     args_parser.add_option(JS::Bytecode::g_dump_bytecode, "Dump the bytecode", "dump-bytecode", 'd');
     args_parser.add_option(s_run_bytecode, "Run the bytecode", "run-bytecode", 'b');
     args_parser.add_option(s_opt_bytecode, "Optimize the bytecode", "optimize-bytecode", 'p');
+    args_parser.add_option(disable_jit, "Don't compile hot bytecode to native code", "disable-jit", 0);
+    args_parser.add_option(bytecode_cache_path, "Keep the bytecode of scripts in this directory, to reuse it when they run again", "bytecode-cache", 0, "path");
     args_parser.add_option(s_as_module, "Treat as module", "as-module", 'm');
     args_parser.add_option(s_print_last_result, "Print last result", "print-last-result", 'l');
     args_parser.add_option(s_strip_ansi, "Disable ANSI colors", "disable-ansi-colors", 'i');
     args_parser.add_option(s_disable_source_location_hints, "Disable source location hints", "disable-source-location-hints", 'h');
     args_parser.add_option(gc_on_every_allocation, "GC on every allocation", "gc-on-every-allocation", 'g');
+    args_parser.add_option(gc_marking_thread_count, "Number of threads to mark live cells with during GC", "gc-marking-threads", 0, "count");
     args_parser.add_option(disable_syntax_highlight, "Disable live syntax highlighting", "no-syntax-highlight", 's');
     args_parser.add_option(evaluate_script, "Evaluate argument as a script", "evaluate", 'c', "script");
     args_parser.add_positional_argument(script_paths, "Path to script files", "scripts", Core::ArgsParser::Required::No);
@@ -623,6 +651,12 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
 
     bool syntax_highlight = !disable_syntax_highlight;
 
+    if (disable_jit)
+        JS::Bytecode::JIT::g_jit_enabled = false;
+
+    if (!bytecode_cache_path.is_empty())
+        s_bytecode_cache = make<JS::Bytecode::ExecutableCache>(bytecode_cache_path);
+
     g_vm = JS::VM::create();
     g_vm->enable_default_host_import_module_dynamically_hook();
 
@@ -653,6 +687,7 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
         ReplConsoleClient console_client(console_object.console());
         console_object.console().set_client(console_client);
         interpreter->heap().set_should_collect_on_every_allocation(gc_on_every_allocation);
+        interpreter->heap().set_marking_thread_count(gc_marking_thread_count);
 
         auto& global_environment = interpreter->realm().global_environment();
 
@@ -864,6 +899,7 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
         ReplConsoleClient console_client(console_object.console());
         console_object.console().set_client(console_client);
         interpreter->heap().set_should_collect_on_every_allocation(gc_on_every_allocation);
+        interpreter->heap().set_marking_thread_count(gc_marking_thread_count);
 
         signal(SIGINT, [](int) {
             sigint_handler();
@@ -4,12 +4,132 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/HashMap.h>
+#include <AK/HashTable.h>
+#include <AK/JsonObject.h>
+#include <AK/QuickSort.h>
 #include <LibCore/ArgsParser.h>
+#include <LibCore/Stream.h>
 #include <LibCore/System.h>
 #include <LibMain/Main.h>
+#include <LibSymbolication/Symbolication.h>
 #include <serenity.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
+
+static constexpr StringView continuous_profiling_path = "/sys/kernel/variables/continuous_profiling"sv;
+static constexpr StringView profile_samples_path = "/sys/kernel/profile_samples"sv;
+
+static bool s_keep_running = true;
+
+static ErrorOr<bool> is_continuous_profiling_enabled()
+{
+    auto file = TRY(Core::Stream::File::open(continuous_profiling_path, Core::Stream::OpenMode::Read));
+    auto buffer = TRY(file->read_until_eof());
+    return StringView { buffer.bytes() }.trim_whitespace() == "1"sv;
+}
+
+static ErrorOr<void> set_continuous_profiling_enabled(bool enabled)
+{
+    auto file = TRY(Core::Stream::File::open(continuous_profiling_path, Core::Stream::OpenMode::Write));
+    TRY(file->write_entire_buffer((enabled ? "1"sv : "0"sv).bytes()));
+    return {};
+}
+
+static DeprecatedString function_name(Symbolication::Symbol const& symbol)
+{
+    if (symbol.name.is_empty())
+        return DeprecatedString::formatted("{:p}", symbol.address);
+    return DeprecatedString::formatted("{}: {}", symbol.object, symbol.name);
+}
+
+// Shows the functions that the system spent the most time in during the last second,
+// both by themselves (the leaf of the stack) and including everything they called.
+static ErrorOr<void> run_top(size_t row_count)
+{
+    bool was_enabled = TRY(is_continuous_profiling_enabled());
+    if (!was_enabled)
+        TRY(set_continuous_profiling_enabled(true));
+    // NOTE: Open the stream after enabling, so the kernel has allocated its rings and we start from what's in them.
+    auto samples_file = TRY(Core::Stream::File::open(profile_samples_path, Core::Stream::OpenMode::Read));
+
+    TRY(Core::System::signal(SIGINT, [](int) { s_keep_running = false; }));
+
+    while (s_keep_running) {
+        sleep(1);
+        if (!s_keep_running)
+            break;
+
+        auto buffer = TRY(samples_file->read_until_eof(64 * KiB));
+
+        HashMap<pid_t, Vector<Vector<FlatPtr>>> stacks_by_pid;
+        size_t sample_count = 0;
+        u64 lost_sample_count = 0;
+        for (auto line : StringView { buffer.bytes() }.split_view('\n')) {
+            auto json = JsonValue::from_string(line);
+            if (json.is_error() || !json.value().is_object())
+                continue;
+            auto const& sample = json.value().as_object();
+            lost_sample_count += sample.get("lost_samples"sv).to_u64();
+            auto const& stack_value = sample.get("stack"sv);
+            if (!stack_value.is_array() || stack_value.as_array().is_empty())
+                continue;
+            auto const& stack_array = stack_value.as_array();
+            Vector<FlatPtr> stack;
+            stack.ensure_capacity(stack_array.size());
+            for (auto& address : stack_array.values())
+                stack.unchecked_append(address.to_addr());
+            stacks_by_pid.ensure(sample.get("pid"sv).to_i32()).append(move(stack));
+            ++sample_count;
+        }
+
+        HashMap<DeprecatedString, size_t> self_counts;
+        HashMap<DeprecatedString, size_t> total_counts;
+        for (auto& it : stacks_by_pid) {
+            for (auto& symbols : Symbolication::symbolicate_stacks(it.key, it.value, Symbolication::IncludeSourcePosition::No)) {
+                if (symbols.is_empty())
+                    continue;
+                self_counts.ensure(function_name(symbols.first()))++;
+                // Recursive functions should only be counted once per sample.
+                HashTable<DeprecatedString> seen_functions;
+                for (auto& symbol : symbols) {
+                    auto name = function_name(symbol);
+                    if (seen_functions.set(name) == HashSetResult::InsertedNewEntry)
+                        total_counts.ensure(name)++;
+                }
+            }
+        }
+
+        struct Row {
+            DeprecatedString name;
+            size_t self_count { 0 };
+            size_t total_count { 0 };
+        };
+        Vector<Row> rows;
+        for (auto& it : total_counts)
+            rows.append({ it.key, self_counts.get(it.key).value_or(0), it.value });
+        quick_sort(rows, [](auto& a, auto& b) {
+            if (a.self_count != b.self_count)
+                return a.self_count > b.self_count;
+            return a.total_count > b.total_count;
+        });
+
+        out("\033[2J\033[H");
+        outln("{} samples, {} lost", sample_count, lost_sample_count);
+        outln();
+        outln("{:>7} {:>7}  {}", "SELF", "TOTAL", "FUNCTION");
+        for (size_t i = 0; i < min(row_count, rows.size()); ++i) {
+            auto& row = rows[i];
+            outln("{:>6.1}% {:>6.1}%  {}", 100.0 * row.self_count / sample_count, 100.0 * row.total_count / sample_count, row.name);
+        }
+    }
+
+    if (!was_enabled)
+        TRY(set_continuous_profiling_enabled(false));
+    return {};
+}
 
 ErrorOr<int> serenity_main(Main::Arguments arguments)
 {
@@ -22,6 +142,8 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     bool enable = false;
     bool disable = false;
     bool all_processes = false;
+    bool top = false;
+    size_t top_row_count = 20;
     u64 event_mask = PERF_EVENT_MMAP | PERF_EVENT_MUNMAP | PERF_EVENT_PROCESS_CREATE
         | PERF_EVENT_PROCESS_EXEC | PERF_EVENT_PROCESS_EXIT | PERF_EVENT_THREAD_CREATE | PERF_EVENT_THREAD_EXIT
         | PERF_EVENT_SIGNPOST;
@@ -33,6 +155,8 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     args_parser.add_option(disable, "Disable", nullptr, 'd');
     args_parser.add_option(free, "Free the profiling buffer for the associated process(es).", nullptr, 'f');
     args_parser.add_option(wait, "Enable profiling and wait for user input to disable.", nullptr, 'w');
+    args_parser.add_option(top, "Continuously show the functions that the system spends the most time in (super-user only).", nullptr, 'T');
+    args_parser.add_option(top_row_count, "Number of functions to show with -T.", nullptr, 'n', "count");
     args_parser.add_option(Core::ArgsParser::Option {
         Core::ArgsParser::OptionArgumentMode::Required,
         "Enable tracking specific event type", nullptr, 't', "event_type",
@@ -71,6 +195,11 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
         exit(0);
     }
 
+    if (top) {
+        TRY(run_top(top_row_count));
+        return 0;
+    }
+
     if (pid_argument.is_empty() && command.is_empty() && !all_processes) {
         args_parser.print_usage(stdout, arguments.argv[0]);
         print_types();
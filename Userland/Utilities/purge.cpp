@@ -15,19 +15,23 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
 
     bool purge_all_volatile = false;
     bool purge_all_clean_inode = false;
+    bool compress_cold_anonymous = false;
 
     Core::ArgsParser args_parser;
     args_parser.add_option(purge_all_volatile, "Mode PURGE_ALL_VOLATILE", nullptr, 'v');
     args_parser.add_option(purge_all_clean_inode, "Mode PURGE_ALL_CLEAN_INODE", nullptr, 'c');
+    args_parser.add_option(compress_cold_anonymous, "Mode PURGE_COMPRESS_COLD_ANONYMOUS", nullptr, 'z');
     args_parser.parse(arguments);
 
-    if (!purge_all_volatile && !purge_all_clean_inode)
+    if (!purge_all_volatile && !purge_all_clean_inode && !compress_cold_anonymous)
         purge_all_volatile = purge_all_clean_inode = true;
 
     if (purge_all_volatile)
         mode |= PURGE_ALL_VOLATILE;
     if (purge_all_clean_inode)
         mode |= PURGE_ALL_CLEAN_INODE;
+    if (compress_cold_anonymous)
+        mode |= PURGE_COMPRESS_COLD_ANONYMOUS;
 
     int purged_page_count = purge(mode);
     if (purged_page_count < 0) {